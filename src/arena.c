@@ -0,0 +1,140 @@
+/*
+ *	Copyright (c) 2024, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#if defined(MOONFIRE_NATIVE) && defined(__linux__)
+#include <sys/mman.h>
+#endif
+#include "arena.h"
+#include "topology.h"
+
+
+#if defined(MOONFIRE_NATIVE) && defined(__linux__)
+#define kArenaHaveMmap
+#endif
+
+size_t
+getArenaAllocationSize(size_t size)
+{
+	return (size + kArenaConstantAlignment - 1) / kArenaConstantAlignment * kArenaConstantAlignment;
+}
+
+Arena *
+createArena(size_t capacity)
+{
+	Arena *	arena = calloc(1, sizeof(Arena));
+
+	if (arena == NULL)
+	{
+		return NULL;
+	}
+
+	capacity = (capacity > 0) ? getArenaAllocationSize(capacity) : kArenaConstantAlignment;
+
+#if defined(kArenaHaveMmap)
+	if (capacity >= kArenaConstantHugePageBytes)
+	{
+		capacity = (capacity + kArenaConstantHugePageBytes - 1) / kArenaConstantHugePageBytes * kArenaConstantHugePageBytes;
+	}
+
+	arena->allocation = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (arena->allocation != MAP_FAILED)
+	{
+		arena->base = arena->allocation;
+		arena->isMapped = true;
+#if defined(MADV_HUGEPAGE)
+		/*
+		 *	Advice only: without transparent huge pages, the arena keeps
+		 *	small pages. A huge page is placed whole on the node of its
+		 *	first writer, so the arena keeps small pages for workers pinned
+		 *	over several nodes, whose slices are far smaller.
+		 */
+		arena->isHugePageAdvised = (capacity >= kArenaConstantHugePageBytes) &&
+						!(isThreadPinningEnabled() && (getThreadTopology()->numberOfNodes > 1)) &&
+						(madvise(arena->allocation, capacity, MADV_HUGEPAGE) == 0);
+#endif
+	}
+	else
+	{
+		arena->allocation = NULL;
+	}
+#endif
+
+	if (arena->allocation == NULL)
+	{
+		arena->allocation = malloc(capacity + kArenaConstantAlignment - 1);
+		if (arena->allocation == NULL)
+		{
+			free(arena);
+
+			return NULL;
+		}
+
+		arena->base = (unsigned char *) getArenaAllocationSize((uintptr_t) arena->allocation);
+	}
+	arena->capacity = capacity;
+	arena->used = 0;
+
+	return arena;
+}
+
+void *
+allocateFromArena(Arena *  arena, size_t size)
+{
+	size_t	allocationSize = getArenaAllocationSize(size);
+	void *	buffer;
+
+	if ((allocationSize < size) || (allocationSize > arena->capacity - arena->used))
+	{
+		return NULL;
+	}
+
+	buffer = arena->base + arena->used;
+	arena->used += allocationSize;
+
+	return buffer;
+}
+
+void
+destroyArena(Arena *  arena)
+{
+	if (arena == NULL)
+	{
+		return;
+	}
+
+#if defined(kArenaHaveMmap)
+	if (arena->isMapped)
+	{
+		munmap(arena->allocation, arena->capacity);
+	}
+	else
+#endif
+	{
+		free(arena->allocation);
+	}
+	free(arena);
+
+	return;
+}
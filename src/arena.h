@@ -0,0 +1,97 @@
+/*
+ *	Copyright (c) 2024, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#pragma once
+#include <stddef.h>
+#include <stdbool.h>
+
+
+/*
+ *	Arena of the buffers of one run, e.g., of a sweep (see `sweep.h`) or of
+ *	the calibration bootstrap (see `calibration.h`).
+ *
+ *	The caller sums the sizes of its buffers with `getArenaAllocationSize()`,
+ *	creates an arena of that capacity, and takes the buffers from it in
+ *	order, each aligned to `kArenaConstantAlignment` bytes, i.e., a cache line
+ *	and the widest vector of the kernels. The buffers are released all at
+ *	once by `destroyArena()`, so a run does one allocation and one free
+ *	however many buffers it has.
+ *
+ *	In native builds on Linux, the arena is mapped with `mmap()`, and arenas
+ *	of at least `kArenaConstantHugePageBytes` are rounded up to whole huge
+ *	pages and advised to be backed by transparent huge pages, so that large
+ *	sample buffers need a few TLB entries instead of one per 4 KiB page.
+ *	Mapped pages are untouched until written, so each page is placed on the
+ *	NUMA node of the thread that writes it first (see `topology.h`). As a
+ *	huge page is placed whole, the slices of workers on other nodes that it
+ *	holds included, arenas are not advised when workers are pinned over
+ *	several nodes. Elsewhere, the arena is one `malloc()`.
+ */
+
+typedef enum
+{
+	kArenaConstantAlignment		= 64,
+	kArenaConstantHugePageBytes	= 2 * 1024 * 1024,
+} ArenaConstant;
+
+typedef struct
+{
+	unsigned char *	base;
+	void *		allocation;
+	size_t		capacity;
+	size_t		used;
+	bool		isMapped;
+	bool		isHugePageAdvised;
+} Arena;
+
+/**
+ *	@brief	Size that a buffer takes in an arena, i.e., rounded up to
+ *		`kArenaConstantAlignment`.
+ *
+ *	@param	size	: Size of the buffer in bytes.
+ *	@return		: The size in the arena in bytes.
+ */
+size_t	getArenaAllocationSize(size_t size);
+
+/**
+ *	@brief	Create an arena.
+ *
+ *	@param	capacity	: Capacity in bytes, e.g., a sum of `getArenaAllocationSize()`.
+ *	@return			: The arena, or `NULL` if it could not be allocated.
+ */
+Arena *	createArena(size_t capacity);
+
+/**
+ *	@brief	Take a buffer from an arena. The buffer is not zeroed.
+ *
+ *	@param	arena	: The arena.
+ *	@param	size	: Size of the buffer in bytes.
+ *	@return		: The buffer, aligned to `kArenaConstantAlignment`, or `NULL` if the arena is full.
+ */
+void *	allocateFromArena(Arena *  arena, size_t size);
+
+/**
+ *	@brief	Free an arena and all of its buffers.
+ *
+ *	@param	arena	: The arena, or `NULL`.
+ */
+void	destroyArena(Arena *  arena);
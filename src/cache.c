@@ -0,0 +1,415 @@
+/*
+ *	Copyright (c) 2024, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "cache.h"
+#include "kernels.h"
+
+
+static const char	kResultCacheHeader[]		= "moonfire-result-cache 1";
+static const uint64_t	kResultCacheFnvOffsetBasis	= 0xCBF29CE484222325ULL;
+static const uint64_t	kResultCacheFnvPrime		= 0x100000001B3ULL;
+
+typedef enum
+{
+	kResultCacheConstantMaximumKeyLength	= 512,
+} ResultCacheConstant;
+
+/**
+ *	@brief	64-bit FNV-1a hash of `size` bytes, continuing from `hash`.
+ *
+ *	@param	hash	: The hash so far, `kResultCacheFnvOffsetBasis` initially.
+ *	@param	bytes	: The bytes.
+ *	@param	size	: Number of bytes.
+ *	@return		: The updated hash.
+ */
+static uint64_t
+hashBytes(uint64_t hash, const void *  bytes, size_t size)
+{
+	const uint8_t *	cursor = bytes;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		hash = (hash ^ cursor[i]) * kResultCacheFnvPrime;
+	}
+
+	return hash;
+}
+
+/**
+ *	@brief	Append to a key, checking that it fits. When the text does not fit,
+ *		`*length` is set to `keySize`, so that the appends that follow are
+ *		skipped.
+ *
+ *	@param	key		: The key.
+ *	@param	keySize		: Size of `key`.
+ *	@param	length		: Pointer to the length of the key, which is updated.
+ *	@param	format		: The `printf()` format of the text to append.
+ */
+static void
+appendToCacheKey(char *  key, size_t keySize, size_t *  length, const char *  format, ...)
+{
+	va_list		arguments;
+	int		ret;
+
+	if (*length >= keySize)
+	{
+		return;
+	}
+
+	va_start(arguments, format);
+	ret = vsnprintf(key + *length, keySize - *length, format, arguments);
+	va_end(arguments);
+
+	*length = ((ret < 0) || ((size_t) ret >= keySize - *length)) ? keySize : (*length + (size_t) ret);
+
+	return;
+}
+
+/**
+ *	@brief	Canonical text form of the parameters that determine a result. Doubles
+ *		are printed in hexadecimal, so that the form is exact. A heterogeneous
+ *		portfolio and a class correlation matrix are represented by hashes
+ *		of their arrays, which are too large to store in full. The sampling
+ *		kernel variant is part of the form, as the variants do not round alike.
+ *
+ *	@param	parameters	: The model parameters.
+ *	@param	key		: Buffer to store the key.
+ *	@param	keySize		: Size of `key`.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError` if the key does not fit, in which case it is truncated.
+ */
+static CommonConstantReturnType
+formatCacheKey(const MoonfireParameters *  parameters, char *  key, size_t keySize)
+{
+	const MoonfirePortfolio *	portfolio = parameters->portfolio;
+	uint64_t			portfolioHash = 0;
+	size_t				length = 0;
+
+	appendToCacheKey(
+		key,
+		keySize,
+		&length,
+		"model=%d engine=%d kernels=%s ",
+		(int) kMoonfireConstantModelVersion,
+		(int) parameters->engine,
+		selectSamplingKernels()->name);
+
+	if (portfolio != NULL)
+	{
+		size_t	arraySize = portfolio->numberOfInvestments * sizeof(double);
+
+		portfolioHash = hashBytes(kResultCacheFnvOffsetBasis, portfolio->alpha, arraySize);
+		portfolioHash = hashBytes(portfolioHash, portfolio->xMin, arraySize);
+		portfolioHash = hashBytes(portfolioHash, portfolio->xMax, arraySize);
+		portfolioHash = hashBytes(portfolioHash, portfolio->weight, arraySize);
+		appendToCacheKey(key, keySize, &length, "portfolio=%016" PRIx64, portfolioHash);
+	}
+	else
+	{
+		appendToCacheKey(
+			key,
+			keySize,
+			&length,
+			"alpha=%a xMin=%a xMax=%a",
+			parameters->alpha,
+			parameters->xMin,
+			parameters->xMax);
+	}
+
+	if (parameters->outcomes != NULL)
+	{
+		size_t		numberOfOutcomes = parameters->numberOfOutcomes;
+		uint64_t	outcomesHash = hashBytes(kResultCacheFnvOffsetBasis, &numberOfOutcomes, sizeof(numberOfOutcomes));
+
+		outcomesHash = hashBytes(outcomesHash, parameters->outcomes, 2 * numberOfOutcomes * sizeof(double));
+		appendToCacheKey(key, keySize, &length, " outcomes=%016" PRIx64, outcomesHash);
+	}
+
+	if (parameters->classCorrelationMatrix != NULL)
+	{
+		size_t		order = parameters->classCorrelationMatrixOrder;
+		uint64_t	matrixHash = hashBytes(kResultCacheFnvOffsetBasis, &order, sizeof(order));
+
+		matrixHash = hashBytes(matrixHash, parameters->classCorrelationMatrix, order * order * sizeof(double));
+		appendToCacheKey(key, keySize, &length, " classCorrelations=%016" PRIx64, matrixHash);
+	}
+
+	appendToCacheKey(
+		key,
+		keySize,
+		&length,
+		" n=%zu iterations=%zu seed=%" PRIu64 " q=%a Q=%a copula=%d rhoM=%a rhoC=%a nu=%zu",
+		parameters->numberOfInvestments,
+		parameters->numberOfIterations,
+		parameters->seed,
+		parameters->lowQuantileProbability,
+		parameters->highQuantileProbability,
+		(int) parameters->copula,
+		parameters->marketCorrelation,
+		parameters->classCorrelation,
+		parameters->degreesOfFreedom);
+
+	/*
+	 *	Reduced precision and the table sampler are only in the keys of the
+	 *	results that use them.
+	 */
+	if (parameters->precision != kMoonfirePrecisionDouble)
+	{
+		appendToCacheKey(key, keySize, &length, " precision=%d", (int) parameters->precision);
+	}
+
+	if (parameters->sampler != kMoonfireSamplerInverseCdf)
+	{
+		appendToCacheKey(key, keySize, &length, " sampler=%d", (int) parameters->sampler);
+	}
+
+	return (length < keySize) ? kCommonConstantReturnTypeSuccess : kCommonConstantReturnTypeError;
+}
+
+/**
+ *	@brief	Path of the cache file of a key, named after the 64-bit FNV-1a hash of the key.
+ *
+ *	@param	directory	: The cache directory.
+ *	@param	key		: The canonical key.
+ *	@param	path		: Buffer to store the path.
+ *	@param	pathSize	: Size of `path`.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError` if the path is too long.
+ */
+static CommonConstantReturnType
+formatCachePath(const char *  directory, const char *  key, char *  path, size_t pathSize)
+{
+	uint64_t	hash = hashBytes(kResultCacheFnvOffsetBasis, key, strlen(key));
+	int		length;
+
+	length = snprintf(path, pathSize, "%s/%016" PRIx64 ".result", directory, hash);
+
+	return ((length > 0) && ((size_t) length < pathSize)) ? kCommonConstantReturnTypeSuccess : kCommonConstantReturnTypeError;
+}
+
+uint64_t
+hashModelParameters(const MoonfireParameters *  parameters)
+{
+	MoonfireParameters	canonicalParameters = *parameters;
+	char			key[kResultCacheConstantMaximumKeyLength];
+	uint64_t		hash;
+
+	/*
+	 *	A key that does not fit is hashed truncated, which only makes
+	 *	the hashes of parameters that differ beyond its end collide.
+	 */
+	canonicalParameters.numberOfIterations = 0;
+	formatCacheKey(&canonicalParameters, key, sizeof(key));
+	hash = hashBytes(kResultCacheFnvOffsetBasis, key, strlen(key));
+
+	if (parameters->parameterDraws != NULL)
+	{
+		hash = hashBytes(hash, &parameters->iterationsPerParameterDraw, sizeof(parameters->iterationsPerParameterDraw));
+		hash = hashBytes(hash, parameters->parameterDraws, 3 * parameters->numberOfParameterDraws * sizeof(double));
+	}
+
+	return hash;
+}
+
+uint64_t
+hashKernelVariant(void)
+{
+	const char *	name = selectSamplingKernels()->name;
+
+	return hashBytes(kResultCacheFnvOffsetBasis, name, strlen(name));
+}
+
+CommonConstantReturnType
+lookupCachedResult(
+	const char *			directory,
+	const MoonfireParameters *	parameters,
+	MoonfireStatistics *		statistics,
+	MoonfireHistogram *		histogram)
+{
+	char				key[kResultCacheConstantMaximumKeyLength];
+	char				path[kCommonConstantMaxCharsPerFilepath];
+	char				line[kResultCacheConstantMaximumKeyLength];
+	FILE *				file;
+	CommonConstantReturnType	result = kCommonConstantReturnTypeError;
+
+	if (parameters->engine != kMoonfireEngineKernels)
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	/*
+	 *	A key that does not fit is a miss.
+	 */
+	if ((formatCacheKey(parameters, key, sizeof(key)) != kCommonConstantReturnTypeSuccess) ||
+		(formatCachePath(directory, key, path, sizeof(path)) != kCommonConstantReturnTypeSuccess))
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	file = fopen(path, "r");
+	if (file == NULL)
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	/*
+	 *	The header and key must match exactly, to exclude hash collisions
+	 *	and other formats or model versions.
+	 */
+	if ((fgets(line, sizeof(line), file) == NULL) || (strcspn(line, "\n") != strlen(kResultCacheHeader)) ||
+		(strncmp(line, kResultCacheHeader, strlen(kResultCacheHeader)) != 0))
+	{
+		fclose(file);
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((fgets(line, sizeof(line), file) == NULL) || (strcspn(line, "\n") != strlen(key)) ||
+		(strncmp(line, key, strlen(key)) != 0))
+	{
+		fclose(file);
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if (fscanf(
+		file,
+		" %la %la %la %la %la %la %la %la",
+		&statistics->portfolioReturn,
+		&statistics->mean,
+		&statistics->variance,
+		&statistics->probabilityOfLoss,
+		&statistics->lowQuantile,
+		&statistics->highQuantile,
+		&histogram->lowerEdge,
+		&histogram->upperEdge) == 8)
+	{
+		result = kCommonConstantReturnTypeSuccess;
+		for (size_t i = 0; i < kMoonfireConstantHistogramNumberOfBins; i++)
+		{
+			if (fscanf(file, " %" SCNu64, &histogram->counts[i]) != 1)
+			{
+				result = kCommonConstantReturnTypeError;
+				break;
+			}
+		}
+	}
+
+	fclose(file);
+
+	return result;
+}
+
+CommonConstantReturnType
+storeCachedResult(
+	const char *			directory,
+	const MoonfireParameters *	parameters,
+	const MoonfireStatistics *	statistics,
+	const MoonfireHistogram *	histogram)
+{
+	char	key[kResultCacheConstantMaximumKeyLength];
+	char	path[kCommonConstantMaxCharsPerFilepath];
+	char	temporaryPath[kCommonConstantMaxCharsPerFilepath];
+	FILE *	file;
+	int	fd;
+	int	writeStatus;
+
+	if (parameters->engine != kMoonfireEngineKernels)
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	/*
+	 *	A key that does not fit is not stored, so that its result is
+	 *	simulated again, like a miss.
+	 */
+	if (formatCacheKey(parameters, key, sizeof(key)) != kCommonConstantReturnTypeSuccess)
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((formatCachePath(directory, key, path, sizeof(path)) != kCommonConstantReturnTypeSuccess) ||
+		(snprintf(temporaryPath, sizeof(temporaryPath), "%s.XXXXXX", path) >= (int) sizeof(temporaryPath)))
+	{
+		fprintf(stderr, "Error: The result cache path is too long.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((mkdir(directory, 0777) != 0) && (errno != EEXIST))
+	{
+		fprintf(stderr, "Error: Could not create the result cache directory \"%s\": %s.\n", directory, strerror(errno));
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	fd = mkstemp(temporaryPath);
+	if (fd < 0)
+	{
+		fprintf(stderr, "Error: Could not create a file in the result cache: %s.\n", strerror(errno));
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	file = fdopen(fd, "w");
+	if (file == NULL)
+	{
+		close(fd);
+		unlink(temporaryPath);
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	fprintf(file, "%s\n%s\n", kResultCacheHeader, key);
+	fprintf(
+		file,
+		"%a %a %a %a %a %a\n%a %a\n",
+		statistics->portfolioReturn,
+		statistics->mean,
+		statistics->variance,
+		statistics->probabilityOfLoss,
+		statistics->lowQuantile,
+		statistics->highQuantile,
+		histogram->lowerEdge,
+		histogram->upperEdge);
+	for (size_t i = 0; i < kMoonfireConstantHistogramNumberOfBins; i++)
+	{
+		fprintf(file, "%" PRIu64 "%c", histogram->counts[i], (i + 1 < kMoonfireConstantHistogramNumberOfBins) ? ' ' : '\n');
+	}
+
+	writeStatus = ferror(file);
+	if ((fclose(file) != 0) || (writeStatus != 0) || (rename(temporaryPath, path) != 0))
+	{
+		fprintf(stderr, "Error: Could not write to the result cache: %s.\n", strerror(errno));
+		unlink(temporaryPath);
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	return kCommonConstantReturnTypeSuccess;
+}
@@ -0,0 +1,93 @@
+/*
+ *	Copyright (c) 2024, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#pragma once
+#include "common.h"
+#include "moonfire.h"
+
+
+/*
+ *	On-disk cache of simulation results (native builds only).
+ *
+ *	Results of the kernels engine are a deterministic function of the model
+ *	parameters (including the seed), of `kMoonfireConstantModelVersion` and
+ *	of the sampling kernel variant (see `kernels.h`), whose rounding differs.
+ *	Each result is stored in its own file in the cache directory, named after
+ *	a hash of a canonical text form of the parameters, the model version and
+ *	the kernel variant. The canonical form is also stored in the file and
+ *	compared on lookup, so hash collisions and results of older model
+ *	versions or of other kernel variants are never returned. Files are
+ *	written to a temporary name and renamed, so concurrent readers and
+ *	writers, in one or several processes, never see partial results.
+ */
+
+/**
+ *	@brief	Look up the result of a simulation in the cache. Parameters whose
+ *		canonical form is too long to be a key are a miss.
+ *
+ *	@param	directory	: The cache directory.
+ *	@param	parameters	: The model parameters.
+ *	@param	statistics	: Pointer to store the cached statistics.
+ *	@param	histogram	: Pointer to store the cached histogram.
+ *	@return			: `kCommonConstantReturnTypeSuccess` on a hit, else `kCommonConstantReturnTypeError`.
+ */
+CommonConstantReturnType	lookupCachedResult(
+					const char *			directory,
+					const MoonfireParameters *	parameters,
+					MoonfireStatistics *		statistics,
+					MoonfireHistogram *		histogram);
+
+/**
+ *	@brief	Store the result of a simulation in the cache. Results of the UxHw
+ *		engine are not deterministic natively and are not stored.
+ *
+ *	@param	directory	: The cache directory.
+ *	@param	parameters	: The model parameters.
+ *	@param	statistics	: The statistics to store.
+ *	@param	histogram	: The histogram to store.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+CommonConstantReturnType	storeCachedResult(
+					const char *			directory,
+					const MoonfireParameters *	parameters,
+					const MoonfireStatistics *	statistics,
+					const MoonfireHistogram *	histogram);
+
+/**
+ *	@brief	Hash of the model parameters that determine the samples of a simulation,
+ *		apart from its iterations, and of the sampling kernel variant, e.g.,
+ *		to check that the processes of a cluster (see `cluster.h`) simulate
+ *		the same model.
+ *
+ *	@param	parameters	: The model parameters.
+ *	@return			: The 64-bit FNV-1a hash of the canonical form of the parameters and of the parameter draws.
+ */
+uint64_t			hashModelParameters(const MoonfireParameters *  parameters);
+
+/**
+ *	@brief	Hash of the name of the sampling kernel variant of this host (see
+ *		`kernels.h`), e.g., to check that the processes of a cluster round
+ *		their samples alike.
+ *
+ *	@return			: The 64-bit FNV-1a hash of the variant name.
+ */
+uint64_t			hashKernelVariant(void);
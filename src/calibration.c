@@ -0,0 +1,477 @@
+/*
+ *	Copyright (c) 2024, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#if defined(MOONFIRE_NATIVE)
+#include <pthread.h>
+#endif
+#include "arena.h"
+#include "calibration.h"
+#include "topology.h"
+
+
+/*
+ *	Search ranges of the parameters. `xMin` is searched relative to the
+ *	largest multiple, on a logarithmic grid that brackets the maximum of the
+ *	profile log-likelihood before the golden-section search refines it, and
+ *	at most equal to it, as the model needs xMin <= xMax.
+ */
+static const double	kCalibrationMinimumAlpha		= 1e-6;
+static const double	kCalibrationMaximumAlpha		= 1e4;
+static const double	kCalibrationMinimumRelativeXMin		= 1e-8;
+static const double	kCalibrationMaximumRelativeXMin		= 1.0;
+static const size_t	kCalibrationXMinGridSize		= 64;
+static const size_t	kCalibrationSearchIterations		= 100;
+
+/*
+ *	Resamples of a bootstrap worker: `firstResample`, `firstResample + step`, ...
+ */
+typedef struct
+{
+	const SamplingKernels *	kernels;
+	const double *		multiples;
+	size_t			count;
+	uint64_t		key;
+	size_t			firstResample;
+	size_t			step;
+	size_t			numberOfResamples;
+	double *		resample;
+	CalibrationEstimate *	estimates;
+	bool *			isFitted;
+} CalibrationWorker;
+
+/**
+ *	@brief	Maximize the log-likelihood over `alpha` for a given `xMin`, by
+ *		bisection on the score in log(alpha).
+ *
+ *	@param	count		: Number of multiples.
+ *	@param	sumOfLogarithms	: Sum of `log(m[i] + xMin)` over the multiples.
+ *	@param	xMin		: The `xMin` parameter.
+ *	@param	xMax		: The `xMax` parameter, the largest multiple.
+ *	@param	estimate	: Pointer to store `alpha`, `xMin`, `xMax` and the log-likelihood.
+ */
+static void
+fitAlpha(size_t count, double sumOfLogarithms, double xMin, double xMax, CalibrationEstimate *  estimate)
+{
+	double	logXMin = log(xMin);
+	double	logBoundRatio = logXMin - log(xMax + xMin);
+	double	meanLogRatio = sumOfLogarithms / (double) count - logXMin;
+	double	lower = log(kCalibrationMinimumAlpha);
+	double	upper = log(kCalibrationMaximumAlpha);
+	double	alpha;
+
+	/*
+	 *	The score per multiple is 1 / alpha - meanLogRatio
+	 *	+ logBoundRatio * r^alpha / (1 - r^alpha), with r the bound ratio,
+	 *	which decreases in alpha.
+	 */
+	for (size_t iteration = 0; iteration < kCalibrationSearchIterations; iteration++)
+	{
+		double	middle = 0.5 * (lower + upper);
+		double	candidate = exp(middle);
+		double	score = 1.0 / candidate - meanLogRatio
+				+ logBoundRatio * exp(candidate * logBoundRatio) / -expm1(candidate * logBoundRatio);
+
+		if (score > 0)
+		{
+			lower = middle;
+		}
+		else
+		{
+			upper = middle;
+		}
+	}
+
+	alpha = exp(0.5 * (lower + upper));
+	estimate->alpha = alpha;
+	estimate->xMin = xMin;
+	estimate->xMax = xMax;
+	estimate->logLikelihood = (double) count * (log(alpha) + alpha * logXMin - log(-expm1(alpha * logBoundRatio)))
+					- (alpha + 1.0) * sumOfLogarithms;
+
+	return;
+}
+
+/**
+ *	@brief	Profile log-likelihood of `xMin`, maximized over `alpha`.
+ *
+ *	@param	kernels		: The sampling kernels.
+ *	@param	multiples	: The multiples.
+ *	@param	count		: Number of multiples.
+ *	@param	xMax		: The largest multiple.
+ *	@param	logXMin		: Logarithm of `xMin`.
+ *	@param	estimate	: Pointer to store the estimate for this `xMin`.
+ *	@return			: The profile log-likelihood.
+ */
+static double
+profileXMin(
+	const SamplingKernels *	kernels,
+	const double *		multiples,
+	size_t			count,
+	double			xMax,
+	double			logXMin,
+	CalibrationEstimate *	estimate)
+{
+	double	xMin = exp(logXMin);
+
+	fitAlpha(count, kernels->sumLogarithms(multiples, count, xMin), xMin, xMax, estimate);
+
+	return estimate->logLikelihood;
+}
+
+/**
+ *	@brief	Maximum likelihood estimate, without reporting errors, for bootstrap resamples.
+ *
+ *	@param	kernels		: The sampling kernels.
+ *	@param	multiples	: The multiples.
+ *	@param	count		: Number of multiples.
+ *	@param	estimate	: Pointer to store the estimate.
+ *	@return			: Whether the multiples have a positive maximum.
+ */
+static bool
+fitMultiples(const SamplingKernels *  kernels, const double *  multiples, size_t count, CalibrationEstimate *  estimate)
+{
+	CalibrationEstimate	candidate;
+	double			xMax = 0.0;
+	double			lower = log(kCalibrationMinimumRelativeXMin);
+	double			step;
+	double			bestLogLikelihood = -HUGE_VAL;
+	size_t			best = 0;
+	double			left;
+	double			right;
+	double			inverseGoldenRatio = 0.5 * (sqrt(5.0) - 1.0);
+	double			x1;
+	double			x2;
+	double			f1;
+	double			f2;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		xMax = (multiples[i] > xMax) ? multiples[i] : xMax;
+	}
+
+	if (!(xMax > 0) || !isfinite(xMax))
+	{
+		return false;
+	}
+
+	/*
+	 *	Bracket the maximum of the profile on the grid, then refine it by
+	 *	golden-section search between the neighbours of the best grid point.
+	 */
+	lower += log(xMax);
+	step = (log(kCalibrationMaximumRelativeXMin) - log(kCalibrationMinimumRelativeXMin)) / (double) (kCalibrationXMinGridSize - 1);
+	for (size_t k = 0; k < kCalibrationXMinGridSize; k++)
+	{
+		double	logLikelihood = profileXMin(kernels, multiples, count, xMax, lower + step * (double) k, &candidate);
+
+		if (logLikelihood > bestLogLikelihood)
+		{
+			bestLogLikelihood = logLikelihood;
+			best = k;
+			*estimate = candidate;
+		}
+	}
+
+	left = lower + step * (double) ((best > 0) ? best - 1 : 0);
+	right = lower + step * (double) ((best + 1 < kCalibrationXMinGridSize) ? best + 1 : best);
+	x1 = right - inverseGoldenRatio * (right - left);
+	x2 = left + inverseGoldenRatio * (right - left);
+	f1 = profileXMin(kernels, multiples, count, xMax, x1, &candidate);
+	f2 = profileXMin(kernels, multiples, count, xMax, x2, &candidate);
+	for (size_t iteration = 0; iteration < kCalibrationSearchIterations; iteration++)
+	{
+		if (f1 > f2)
+		{
+			right = x2;
+			x2 = x1;
+			f2 = f1;
+			x1 = right - inverseGoldenRatio * (right - left);
+			f1 = profileXMin(kernels, multiples, count, xMax, x1, &candidate);
+		}
+		else
+		{
+			left = x1;
+			x1 = x2;
+			f1 = f2;
+			x2 = left + inverseGoldenRatio * (right - left);
+			f2 = profileXMin(kernels, multiples, count, xMax, x2, &candidate);
+		}
+	}
+
+	if (profileXMin(kernels, multiples, count, xMax, 0.5 * (left + right), &candidate) > estimate->logLikelihood)
+	{
+		*estimate = candidate;
+	}
+
+	return true;
+}
+
+/**
+ *	@brief	Fit the resamples of a bootstrap worker.
+ *
+ *	@param	argument	: The `CalibrationWorker`.
+ *	@return			: `NULL`.
+ */
+static void *
+runCalibrationWorker(void *  argument)
+{
+	CalibrationWorker *	worker = argument;
+	size_t			count = worker->count;
+
+	/*
+	 *	The first resample of a worker is its index.
+	 */
+	pinWorkerThread(worker->firstResample);
+
+	for (size_t b = worker->firstResample; b < worker->numberOfResamples; b += worker->step)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			size_t	index = (size_t) (uniformFromCounter(worker->key, (uint64_t) b * count + i) * (double) count);
+
+			worker->resample[i] = worker->multiples[(index < count) ? index : count - 1];
+		}
+
+		worker->isFitted[b] = fitMultiples(worker->kernels, worker->resample, count, &worker->estimates[b]);
+	}
+
+	return NULL;
+}
+
+/**
+ *	@brief	Order doubles for `qsort()`.
+ */
+static int
+compareDoubles(const void *  a, const void *  b)
+{
+	double	x = *(const double *) a;
+	double	y = *(const double *) b;
+
+	return (x > y) - (x < y);
+}
+
+/**
+ *	@brief	Empirical quantile of sorted values, by linear interpolation between order statistics.
+ *
+ *	@param	values		: The sorted values.
+ *	@param	count		: Number of values, at least 1.
+ *	@param	probability	: Quantile probability in (0, 1).
+ *	@return			: The quantile.
+ */
+static double
+calculateSortedQuantile(const double *  values, size_t count, double probability)
+{
+	double	position = probability * (double) (count - 1);
+	size_t	k = (size_t) position;
+
+	if (k + 1 >= count)
+	{
+		return values[count - 1];
+	}
+
+	return values[k] + (position - (double) k) * (values[k + 1] - values[k]);
+}
+
+CommonConstantReturnType
+fitBoundedPareto(
+	const SamplingKernels *	kernels,
+	const double *		multiples,
+	size_t			count,
+	CalibrationEstimate *	estimate)
+{
+	if ((kernels == NULL) || (multiples == NULL) || (estimate == NULL) || (count < 2))
+	{
+		fprintf(stderr, "Error: The calibration needs at least 2 multiples.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if (!fitMultiples(kernels, multiples, count, estimate))
+	{
+		fprintf(stderr, "Error: The calibration needs at least one finite, positive multiple.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+CommonConstantReturnType
+calibrateBoundedPareto(
+	const double *		multiples,
+	size_t			count,
+	size_t			numberOfResamples,
+	double			lowQuantileProbability,
+	double			highQuantileProbability,
+	uint64_t		seed,
+	size_t			numberOfThreads,
+	CalibrationResult *	result)
+{
+	const SamplingKernels *	kernels = selectSamplingKernels();
+	Arena *			arena;
+	CalibrationWorker *	workers;
+	CalibrationEstimate *	estimates;
+	bool *			isFitted;
+	double *		parameters;
+	double *		resamples;
+	size_t			numberOfFitted = 0;
+
+	if ((result == NULL) || (numberOfThreads == 0) || (numberOfResamples > kCalibrationConstantMaximumBootstrapResamples))
+	{
+		fprintf(stderr, "Error: The calibration needs a result, at least one thread and at most %d resamples.\n", (int) kCalibrationConstantMaximumBootstrapResamples);
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	*result = (CalibrationResult) {0};
+	if (fitBoundedPareto(kernels, multiples, count, &result->estimate) != kCommonConstantReturnTypeSuccess)
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	if (numberOfResamples == 0)
+	{
+		return kCommonConstantReturnTypeSuccess;
+	}
+
+	numberOfThreads = (numberOfThreads < numberOfResamples) ? numberOfThreads : numberOfResamples;
+#if !defined(MOONFIRE_NATIVE)
+	numberOfThreads = 1;
+#endif
+	/*
+	 *	The bootstrap buffers come from one arena, freed at once.
+	 */
+	arena = createArena(
+			getArenaAllocationSize(numberOfThreads * sizeof(CalibrationWorker)) +
+			getArenaAllocationSize(numberOfResamples * sizeof(CalibrationEstimate)) +
+			getArenaAllocationSize(numberOfResamples * sizeof(bool)) +
+			getArenaAllocationSize(4 * numberOfResamples * sizeof(double)) +
+			getArenaAllocationSize(numberOfThreads * count * sizeof(double)));
+	if (arena == NULL)
+	{
+		fprintf(stderr, "Error: Could not allocate the bootstrap buffers.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	workers = allocateFromArena(arena, numberOfThreads * sizeof(CalibrationWorker));
+	estimates = allocateFromArena(arena, numberOfResamples * sizeof(CalibrationEstimate));
+	isFitted = allocateFromArena(arena, numberOfResamples * sizeof(bool));
+	parameters = allocateFromArena(arena, 4 * numberOfResamples * sizeof(double));
+	resamples = allocateFromArena(arena, numberOfThreads * count * sizeof(double));
+
+	for (size_t t = 0; t < numberOfThreads; t++)
+	{
+		workers[t] = (CalibrationWorker) {
+			.kernels		= kernels,
+			.multiples		= multiples,
+			.count			= count,
+			.key			= deriveStreamKey(seed),
+			.firstResample		= t,
+			.step			= numberOfThreads,
+			.numberOfResamples	= numberOfResamples,
+			.resample		= resamples + t * count,
+			.estimates		= estimates,
+			.isFitted		= isFitted,
+		};
+	}
+
+#if defined(MOONFIRE_NATIVE)
+	{
+		pthread_t *	threads = calloc(numberOfThreads, sizeof(pthread_t));
+		size_t		numberOfStarted = 0;
+
+		/*
+		 *	The calling thread fits the resamples of the first worker, and
+		 *	any worker whose thread could not be started.
+		 */
+		for (size_t t = 1; (threads != NULL) && (t < numberOfThreads); t++)
+		{
+			if (pthread_create(&threads[t], NULL, runCalibrationWorker, &workers[t]) != 0)
+			{
+				break;
+			}
+			numberOfStarted = t;
+		}
+
+		runCalibrationWorker(&workers[0]);
+		for (size_t t = 1; t <= numberOfStarted; t++)
+		{
+			pthread_join(threads[t], NULL);
+		}
+		for (size_t t = numberOfStarted + 1; t < numberOfThreads; t++)
+		{
+			runCalibrationWorker(&workers[t]);
+		}
+		free(threads);
+	}
+#else
+	runCalibrationWorker(&workers[0]);
+#endif
+
+	/*
+	 *	Resamples without a positive multiple have no estimate, and are
+	 *	left out of the intervals.
+	 */
+	for (size_t b = 0; b < numberOfResamples; b++)
+	{
+		if (isFitted[b])
+		{
+			parameters[numberOfFitted] = estimates[b].alpha;
+			parameters[numberOfResamples + numberOfFitted] = estimates[b].xMin;
+			parameters[2 * numberOfResamples + numberOfFitted] = estimates[b].xMax;
+			parameters[3 * numberOfResamples + numberOfFitted] = estimates[b].logLikelihood;
+			numberOfFitted++;
+		}
+	}
+
+	if (numberOfFitted > 0)
+	{
+		for (size_t k = 0; k < 4; k++)
+		{
+			qsort(parameters + k * numberOfResamples, numberOfFitted, sizeof(double), compareDoubles);
+		}
+
+		result->low = (CalibrationEstimate) {
+			.alpha		= calculateSortedQuantile(parameters, numberOfFitted, lowQuantileProbability),
+			.xMin		= calculateSortedQuantile(parameters + numberOfResamples, numberOfFitted, lowQuantileProbability),
+			.xMax		= calculateSortedQuantile(parameters + 2 * numberOfResamples, numberOfFitted, lowQuantileProbability),
+			.logLikelihood	= calculateSortedQuantile(parameters + 3 * numberOfResamples, numberOfFitted, lowQuantileProbability),
+		};
+		result->high = (CalibrationEstimate) {
+			.alpha		= calculateSortedQuantile(parameters, numberOfFitted, highQuantileProbability),
+			.xMin		= calculateSortedQuantile(parameters + numberOfResamples, numberOfFitted, highQuantileProbability),
+			.xMax		= calculateSortedQuantile(parameters + 2 * numberOfResamples, numberOfFitted, highQuantileProbability),
+			.logLikelihood	= calculateSortedQuantile(parameters + 3 * numberOfResamples, numberOfFitted, highQuantileProbability),
+		};
+	}
+	result->numberOfResamples = numberOfFitted;
+
+	destroyArena(arena);
+
+	return kCommonConstantReturnTypeSuccess;
+}
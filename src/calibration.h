@@ -0,0 +1,122 @@
+/*
+ *	Copyright (c) 2024, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "common.h"
+#include "kernels.h"
+
+
+/*
+ *	Calibration of the bounded Pareto parameters of the model to observed exit
+ *	multiples.
+ *
+ *	In the model, an investment returns the multiple `m = X - xMin` of its
+ *	capital, with `X` distributed as BoundedPareto(alpha, xMin, xMax + xMin).
+ *	The log-likelihood of the multiples `m[i]`, i = 1..n, is
+ *
+ *		n log(alpha) + n alpha log(xMin) - (alpha + 1) sum(log(m[i] + xMin))
+ *			- n log(1 - (xMin / (xMax + xMin))^alpha),
+ *
+ *	which increases as `xMax` decreases to the largest multiple, its maximum
+ *	likelihood estimate. For a given `xMin`, the log-likelihood is concave in
+ *	`alpha` (the bounded Pareto distribution is an exponential family in
+ *	`alpha`), so `alpha` solves its score equation by bisection, without
+ *	revisiting the data. Only the profile over `xMin` needs a pass over the
+ *	multiples per candidate, for the `sumLogarithms` kernel.
+ *
+ *	Confidence intervals come from a nonparametric bootstrap: each resample
+ *	draws `n` multiples with replacement, with counter-based uniforms, so that
+ *	the intervals do not depend on the number of threads that fit the
+ *	resamples.
+ */
+
+typedef enum
+{
+	kCalibrationConstantDefaultBootstrapResamples	= 1000,
+	kCalibrationConstantMaximumBootstrapResamples	= 1000000,
+} CalibrationConstant;
+
+typedef struct
+{
+	double	alpha;
+	double	xMin;
+	double	xMax;
+	double	logLikelihood;
+} CalibrationEstimate;
+
+typedef struct
+{
+	CalibrationEstimate	estimate;
+
+	/*
+	 *	Bootstrap quantiles of each parameter, at the low and high quantile
+	 *	probabilities of the calibration, over the `numberOfResamples`
+	 *	resamples that have an estimate.
+	 */
+	CalibrationEstimate	low;
+	CalibrationEstimate	high;
+	size_t			numberOfResamples;
+} CalibrationResult;
+
+/**
+ *	@brief	Maximum likelihood estimate of the bounded Pareto parameters of the
+ *		observed multiples.
+ *
+ *	@param	kernels		: The sampling kernels.
+ *	@param	multiples	: The `count` observed multiples, at least 0 and not all 0.
+ *	@param	count		: Number of multiples, at least 2.
+ *	@param	estimate	: Pointer to store the estimate.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+CommonConstantReturnType	fitBoundedPareto(
+					const SamplingKernels *	kernels,
+					const double *		multiples,
+					size_t			count,
+					CalibrationEstimate *	estimate);
+
+/**
+ *	@brief	Fit the observed multiples and bootstrap the confidence intervals of
+ *		the parameters, with the resamples split between threads in native
+ *		builds.
+ *
+ *	@param	multiples		: The `count` observed multiples.
+ *	@param	count			: Number of multiples, at least 2.
+ *	@param	numberOfResamples	: Number of bootstrap resamples, or 0 for no intervals.
+ *	@param	lowQuantileProbability	: Probability of the low quantile of the intervals.
+ *	@param	highQuantileProbability	: Probability of the high quantile of the intervals.
+ *	@param	seed			: Seed of the resampling stream.
+ *	@param	numberOfThreads		: Number of threads, at least 1.
+ *	@param	result			: Pointer to store the estimate and the intervals.
+ *	@return				: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+CommonConstantReturnType	calibrateBoundedPareto(
+					const double *		multiples,
+					size_t			count,
+					size_t			numberOfResamples,
+					double			lowQuantileProbability,
+					double			highQuantileProbability,
+					uint64_t		seed,
+					size_t			numberOfThreads,
+					CalibrationResult *	result);
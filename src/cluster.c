@@ -0,0 +1,772 @@
+/*
+ *	Copyright (c) 2024, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
+#include <poll.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include "cache.h"
+#include "cluster.h"
+#include "kernels.h"
+
+/*
+ *	Not all platforms have MSG_NOSIGNAL (e.g., macOS); SIGPIPE is ignored
+ *	by the coordinator anyway.
+ */
+#if !defined(MSG_NOSIGNAL)
+#define MSG_NOSIGNAL	0
+#endif
+
+
+typedef struct
+{
+	size_t	firstIteration;
+	size_t	numberOfIterations;
+} ClusterRange;
+
+typedef struct
+{
+	int		fd;
+	bool		isHelloReceived;
+	ClusterRange	assignment;
+	struct timespec	assignmentTime;
+} ClusterWorker;
+
+/**
+ *	@brief	Send all bytes of a message.
+ *
+ *	@param	fd	: The socket.
+ *	@param	bytes	: The bytes.
+ *	@param	size	: Number of bytes.
+ *	@return		: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+sendBytes(int fd, const void *  bytes, size_t size)
+{
+	const char *	cursor = bytes;
+
+	while (size > 0)
+	{
+		ssize_t	ret = send(fd, cursor, size, MSG_NOSIGNAL);
+
+		if (ret < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+
+			return kCommonConstantReturnTypeError;
+		}
+		cursor += ret;
+		size -= (size_t) ret;
+	}
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+/**
+ *	@brief	Receive all bytes of a message.
+ *
+ *	@param	fd	: The socket.
+ *	@param	bytes	: Buffer to store the bytes.
+ *	@param	size	: Number of bytes.
+ *	@return		: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError` on errors, timeouts and closed connections.
+ */
+static CommonConstantReturnType
+receiveBytes(int fd, void *  bytes, size_t size)
+{
+	char *	cursor = bytes;
+
+	while (size > 0)
+	{
+		ssize_t	ret = recv(fd, cursor, size, 0);
+
+		if (ret <= 0)
+		{
+			if ((ret < 0) && (errno == EINTR))
+			{
+				continue;
+			}
+
+			return kCommonConstantReturnTypeError;
+		}
+		cursor += ret;
+		size -= (size_t) ret;
+	}
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+/**
+ *	@brief	Split a `host:port` address and resolve it.
+ *
+ *	@param	address		: The address. The host may be empty for all interfaces when listening.
+ *	@param	isPassive	: `true` to resolve an address to listen on, `false` to connect to.
+ *	@param	result		: Pointer to store the resolved addresses, to free with `freeaddrinfo()`.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+resolveAddress(const char *  address, bool isPassive, struct addrinfo **  result)
+{
+	char			host[kCommonConstantMaxCharsPerFilepath];
+	const char *		colon = strrchr(address, ':');
+	struct addrinfo		hints = {0};
+	int			ret;
+
+	if ((colon == NULL) || (colon[1] == '\0') || ((size_t) (colon - address) >= sizeof(host)))
+	{
+		fprintf(stderr, "Error: The cluster address \"%s\" is not of the form host:port.\n", address);
+
+		return kCommonConstantReturnTypeError;
+	}
+	memcpy(host, address, (size_t) (colon - address));
+	host[colon - address] = '\0';
+
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = isPassive ? AI_PASSIVE : 0;
+	ret = getaddrinfo((host[0] == '\0') ? NULL : host, colon + 1, &hints, result);
+	if (ret != 0)
+	{
+		fprintf(stderr, "Error: Could not resolve the cluster address \"%s\": %s.\n", address, gai_strerror(ret));
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+/**
+ *	@brief	Create, bind and listen on the TCP socket of the coordinator.
+ *
+ *	@param	address	: `host:port` to listen on, or `NULL` for an ephemeral loopback port.
+ *	@param	port	: Buffer of `NI_MAXSERV` characters to store the port listened on, for the local workers.
+ *	@return		: The listening socket, or -1 on error.
+ */
+static int
+listenOnClusterAddress(const char *  address, char *  port)
+{
+	struct addrinfo *		addresses;
+	struct sockaddr_storage		boundAddress;
+	socklen_t			boundAddressLength = sizeof(boundAddress);
+	int				fd = -1;
+	int				reuse = 1;
+
+	if (resolveAddress((address != NULL) ? address : "127.0.0.1:0", true, &addresses) != kCommonConstantReturnTypeSuccess)
+	{
+		return -1;
+	}
+
+	for (struct addrinfo *  candidate = addresses; (candidate != NULL) && (fd < 0); candidate = candidate->ai_next)
+	{
+		fd = socket(candidate->ai_family, candidate->ai_socktype, candidate->ai_protocol);
+		if (fd < 0)
+		{
+			continue;
+		}
+
+		setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+		if ((bind(fd, candidate->ai_addr, candidate->ai_addrlen) != 0) || (listen(fd, kClusterConstantListenBacklog) != 0))
+		{
+			close(fd);
+			fd = -1;
+		}
+	}
+	freeaddrinfo(addresses);
+
+	if ((fd < 0) ||
+		(getsockname(fd, (struct sockaddr *) &boundAddress, &boundAddressLength) != 0) ||
+		(getnameinfo((struct sockaddr *) &boundAddress, boundAddressLength, NULL, 0, port, NI_MAXSERV, NI_NUMERICSERV) != 0))
+	{
+		fprintf(stderr, "Error: Could not listen on the cluster address \"%s\": %s.\n", (address != NULL) ? address : "127.0.0.1:0", strerror(errno));
+		if (fd >= 0)
+		{
+			close(fd);
+		}
+
+		return -1;
+	}
+
+	return fd;
+}
+
+/**
+ *	@brief	Connect to the coordinator, retrying while it is not listening yet,
+ *		e.g., when the workers of a batch job start before the coordinator.
+ *
+ *	@param	address	: `host:port` of the coordinator.
+ *	@return		: The connected socket, or -1 on error.
+ */
+static int
+connectToCoordinator(const char *  address)
+{
+	struct addrinfo *	addresses;
+	int			fd = -1;
+
+	if (resolveAddress(address, false, &addresses) != kCommonConstantReturnTypeSuccess)
+	{
+		return -1;
+	}
+
+	for (int attempt = 0; (attempt < kClusterConstantConnectAttempts) && (fd < 0); attempt++)
+	{
+		struct timespec	retryDelay = {
+					.tv_sec = 0,
+					.tv_nsec = kClusterConstantConnectRetryMilliseconds * 1000000L,
+				};
+
+		for (struct addrinfo *  candidate = addresses; (candidate != NULL) && (fd < 0); candidate = candidate->ai_next)
+		{
+			fd = socket(candidate->ai_family, candidate->ai_socktype, candidate->ai_protocol);
+			if ((fd >= 0) && (connect(fd, candidate->ai_addr, candidate->ai_addrlen) != 0))
+			{
+				close(fd);
+				fd = -1;
+			}
+		}
+
+		if (fd < 0)
+		{
+			nanosleep(&retryDelay, NULL);
+		}
+	}
+	freeaddrinfo(addresses);
+
+	if (fd < 0)
+	{
+		fprintf(stderr, "Error: Could not connect to the coordinator at \"%s\".\n", address);
+	}
+
+	return fd;
+}
+
+CommonConstantReturnType
+runClusterWorker(const MoonfireParameters *  parameters, const char *  address)
+{
+	MoonfireParameters		workerParameters = *parameters;
+	MoonfireContext *		context = NULL;
+	uint64_t			hello[3];
+	CommonConstantReturnType	result = kCommonConstantReturnTypeSuccess;
+	int				fd;
+
+	/*
+	 *	Workers only simulate chunks of the kernels engine, whatever the
+	 *	iterations on their command line.
+	 */
+	workerParameters.engine = kMoonfireEngineKernels;
+
+	fd = connectToCoordinator(address);
+	if (fd < 0)
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	memcpy(&hello[0], kClusterMagic, sizeof(hello[0]));
+	hello[1] = hashModelParameters(&workerParameters);
+	hello[2] = hashKernelVariant();
+	if (sendBytes(fd, hello, sizeof(hello)) != kCommonConstantReturnTypeSuccess)
+	{
+		fprintf(stderr, "Error: Could not send to the coordinator at \"%s\".\n", address);
+		close(fd);
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	while (result == kCommonConstantReturnTypeSuccess)
+	{
+		uint64_t	assignment[2];
+		uint64_t	header[3];
+		const double *	samples;
+		size_t		numberOfSamples;
+		clock_t		start;
+
+		if (receiveBytes(fd, assignment, sizeof(assignment)) != kCommonConstantReturnTypeSuccess)
+		{
+			fprintf(stderr, "Error: The coordinator at \"%s\" closed the connection, e.g., because the model parameters or sampling kernel variants differ.\n", address);
+			result = kCommonConstantReturnTypeError;
+			break;
+		}
+
+		if (assignment[1] == 0)
+		{
+			break;
+		}
+
+		if ((assignment[1] > kClusterConstantChunkIterations) || (assignment[0] > SIZE_MAX - assignment[1]))
+		{
+			fprintf(stderr, "Error: The coordinator assigned an invalid range of iterations.\n");
+			result = kCommonConstantReturnTypeError;
+			break;
+		}
+
+		/*
+		 *	The context is created for the first chunk and reconfigured for
+		 *	the others, which only allocates for a chunk larger than before.
+		 */
+		workerParameters.firstIteration = (size_t) assignment[0];
+		workerParameters.numberOfIterations = (size_t) assignment[1];
+		if (context == NULL)
+		{
+			context = moonfireCreateContext(&workerParameters);
+			result = (context != NULL) ? kCommonConstantReturnTypeSuccess : kCommonConstantReturnTypeError;
+		}
+		else
+		{
+			result = moonfireSetParameters(context, &workerParameters);
+		}
+
+		start = clock();
+		if ((result != kCommonConstantReturnTypeSuccess) || (moonfireSimulate(context) != kCommonConstantReturnTypeSuccess))
+		{
+			result = kCommonConstantReturnTypeError;
+			break;
+		}
+		samples = moonfireGetSamples(context, &numberOfSamples);
+
+		header[0] = assignment[0];
+		header[1] = assignment[1];
+		header[2] = (uint64_t) (((double) (clock() - start)) / CLOCKS_PER_SEC * 1000000);
+		if ((sendBytes(fd, header, sizeof(header)) != kCommonConstantReturnTypeSuccess) ||
+			(sendBytes(fd, samples, numberOfSamples * sizeof(double)) != kCommonConstantReturnTypeSuccess))
+		{
+			fprintf(stderr, "Error: Could not send to the coordinator at \"%s\".\n", address);
+			result = kCommonConstantReturnTypeError;
+		}
+	}
+
+	moonfireDestroyContext(context);
+	close(fd);
+
+	return result;
+}
+
+/**
+ *	@brief	Take the next range of iterations to simulate: a range of a failed
+ *		worker if any, else the next chunk.
+ *
+ *	@param	failedRanges		: Stack of the ranges of failed workers.
+ *	@param	numberOfFailedRanges	: Pointer to the number of ranges in the stack.
+ *	@param	nextIteration		: Pointer to the first iteration not handed out yet.
+ *	@param	endIteration		: The iteration after the last one of the simulation.
+ *	@param	range			: Pointer to store the range.
+ *	@return				: `true` if there is a range, else `false`.
+ */
+static bool
+takeNextRange(ClusterRange *  failedRanges, size_t *  numberOfFailedRanges, size_t *  nextIteration, size_t endIteration, ClusterRange *  range)
+{
+	if (*numberOfFailedRanges > 0)
+	{
+		*range = failedRanges[--(*numberOfFailedRanges)];
+
+		return true;
+	}
+
+	if (*nextIteration == endIteration)
+	{
+		return false;
+	}
+
+	range->firstIteration = *nextIteration;
+	range->numberOfIterations = ((endIteration - *nextIteration) < kClusterConstantChunkIterations) ?
+					(endIteration - *nextIteration) : kClusterConstantChunkIterations;
+	*nextIteration += range->numberOfIterations;
+
+	return true;
+}
+
+/**
+ *	@brief	Fork the local workers of the coordinator.
+ *
+ *	@param	parameters		: The model parameters.
+ *	@param	numberOfLocalWorkers	: Number of workers to fork.
+ *	@param	listenFd		: The listening socket of the coordinator, which the workers close.
+ *	@param	port			: The port the coordinator listens on.
+ *	@return				: The number of forked workers.
+ */
+static size_t
+forkLocalWorkers(const MoonfireParameters *  parameters, size_t numberOfLocalWorkers, int listenFd, const char *  port)
+{
+	char	address[NI_MAXSERV + 16];
+	size_t	numberOfForkedWorkers = 0;
+
+	snprintf(address, sizeof(address), "127.0.0.1:%s", port);
+
+	/*
+	 *	Flush so that the workers do not inherit buffered output.
+	 */
+	fflush(stdout);
+	fflush(stderr);
+
+	for (; numberOfForkedWorkers < numberOfLocalWorkers; numberOfForkedWorkers++)
+	{
+		pid_t	pid = fork();
+
+		if (pid < 0)
+		{
+			fprintf(stderr, "Warning: Could only fork %zu of %zu local workers: %s.\n", numberOfForkedWorkers, numberOfLocalWorkers, strerror(errno));
+			break;
+		}
+
+		if (pid == 0)
+		{
+			close(listenFd);
+			_exit((runClusterWorker(parameters, address) == kCommonConstantReturnTypeSuccess) ? EXIT_SUCCESS : EXIT_FAILURE);
+		}
+	}
+
+	return numberOfForkedWorkers;
+}
+
+/**
+ *	@brief	Close the connection of a worker that failed or was rejected, and put
+ *		its range back for another worker.
+ *
+ *	@param	worker			: The worker.
+ *	@param	failedRanges		: Stack of the ranges of failed workers.
+ *	@param	numberOfFailedRanges	: Pointer to the number of ranges in the stack.
+ *	@param	report			: The report, whose reassigned chunks are counted.
+ */
+static void
+dropWorker(ClusterWorker *  worker, ClusterRange *  failedRanges, size_t *  numberOfFailedRanges, ClusterReport *  report)
+{
+	if (worker->assignment.numberOfIterations > 0)
+	{
+		fprintf(
+			stderr,
+			"Warning: A worker failed; reassigning iterations %zu to %zu.\n",
+			worker->assignment.firstIteration,
+			worker->assignment.firstIteration + worker->assignment.numberOfIterations - 1);
+		failedRanges[(*numberOfFailedRanges)++] = worker->assignment;
+		report->numberOfReassignedChunks++;
+	}
+
+	close(worker->fd);
+	*worker = (ClusterWorker) {.fd = -1};
+
+	return;
+}
+
+CommonConstantReturnType
+runClusterCoordinator(
+	const MoonfireParameters *	parameters,
+	size_t				numberOfLocalWorkers,
+	const char *			address,
+	double *			samples,
+	ClusterReport *			report)
+{
+	MoonfireParameters		canonicalParameters = *parameters;
+	uint64_t			parametersHash;
+	uint64_t			kernelVariantHash;
+	ClusterWorker *			workers = NULL;
+	struct pollfd *			pollFds = NULL;
+	ClusterRange *			failedRanges = NULL;
+	size_t				numberOfWorkers = 0;
+	size_t				workersCapacity;
+	size_t				numberOfFailedRanges = 0;
+	size_t				numberOfForkedWorkers;
+	size_t				numberOfExitedWorkers = 0;
+	size_t				nextIteration = parameters->firstIteration;
+	size_t				endIteration = parameters->firstIteration + parameters->numberOfIterations;
+	size_t				numberOfCompletedIterations = 0;
+	struct timeval			receiveTimeout = {.tv_sec = kClusterConstantReceiveTimeoutSeconds};
+	char				port[NI_MAXSERV];
+	CommonConstantReturnType	result = kCommonConstantReturnTypeSuccess;
+	int				listenFd;
+
+	*report = (ClusterReport) {0};
+	canonicalParameters.engine = kMoonfireEngineKernels;
+	parametersHash = hashModelParameters(&canonicalParameters);
+	kernelVariantHash = hashKernelVariant();
+
+	if ((numberOfLocalWorkers == 0) && (address == NULL))
+	{
+		fprintf(stderr, "Error: The coordinator needs local workers or an address for remote workers.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	/*
+	 *	Each worker holds at most one range, so at most one range per worker
+	 *	that ever connected can fail. The stack grows with the workers.
+	 */
+	workersCapacity = kClusterConstantInitialWorkersCapacity;
+	workers = malloc(workersCapacity * sizeof(ClusterWorker));
+	pollFds = malloc((workersCapacity + 1) * sizeof(struct pollfd));
+	failedRanges = malloc(workersCapacity * sizeof(ClusterRange));
+	if ((workers == NULL) || (pollFds == NULL) || (failedRanges == NULL))
+	{
+		fprintf(stderr, "Error: Could not allocate the workers of the cluster.\n");
+		free(workers);
+		free(pollFds);
+		free(failedRanges);
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	listenFd = listenOnClusterAddress(address, port);
+	if (listenFd < 0)
+	{
+		free(workers);
+		free(pollFds);
+		free(failedRanges);
+
+		return kCommonConstantReturnTypeError;
+	}
+	signal(SIGPIPE, SIG_IGN);
+
+	numberOfForkedWorkers = forkLocalWorkers(&canonicalParameters, numberOfLocalWorkers, listenFd, port);
+	if (address != NULL)
+	{
+		fprintf(stderr, "Coordinating on port %s with %zu local workers; start remote workers with the same options and -l <host>:%s.\n", port, numberOfForkedWorkers, port);
+	}
+
+	while ((result == kCommonConstantReturnTypeSuccess) && (numberOfCompletedIterations < parameters->numberOfIterations))
+	{
+		size_t		numberOfConnectedWorkers = 0;
+		struct timespec	now;
+		int		ret;
+
+		/*
+		 *	Hand out ranges to the idle workers.
+		 */
+		for (size_t i = 0; i < numberOfWorkers; i++)
+		{
+			ClusterWorker *	worker = &workers[i];
+			uint64_t	assignment[2];
+
+			if ((worker->fd < 0) || !worker->isHelloReceived || (worker->assignment.numberOfIterations > 0) ||
+				!takeNextRange(failedRanges, &numberOfFailedRanges, &nextIteration, endIteration, &worker->assignment))
+			{
+				continue;
+			}
+
+			assignment[0] = worker->assignment.firstIteration;
+			assignment[1] = worker->assignment.numberOfIterations;
+			clock_gettime(CLOCK_MONOTONIC, &worker->assignmentTime);
+			if (sendBytes(worker->fd, assignment, sizeof(assignment)) != kCommonConstantReturnTypeSuccess)
+			{
+				dropWorker(worker, failedRanges, &numberOfFailedRanges, report);
+			}
+		}
+
+		/*
+		 *	Reap the local workers that exited. Without remote workers, the
+		 *	simulation fails when no worker is left.
+		 */
+		while (waitpid(-1, NULL, WNOHANG) > 0)
+		{
+			numberOfExitedWorkers++;
+		}
+
+		pollFds[0] = (struct pollfd) {.fd = listenFd, .events = POLLIN};
+		for (size_t i = 0; i < numberOfWorkers; i++)
+		{
+			pollFds[i + 1] = (struct pollfd) {.fd = workers[i].fd, .events = POLLIN};
+			numberOfConnectedWorkers += (workers[i].fd >= 0);
+		}
+
+		if ((numberOfConnectedWorkers == 0) && (address == NULL) && (numberOfExitedWorkers == numberOfForkedWorkers))
+		{
+			fprintf(stderr, "Error: All workers of the cluster failed.\n");
+			result = kCommonConstantReturnTypeError;
+			break;
+		}
+
+		ret = poll(pollFds, numberOfWorkers + 1, kClusterConstantPollMilliseconds);
+		if (ret < 0)
+		{
+			if (errno != EINTR)
+			{
+				fprintf(stderr, "Error: poll() failed: %s.\n", strerror(errno));
+				result = kCommonConstantReturnTypeError;
+			}
+
+			continue;
+		}
+
+		/*
+		 *	A host that loses power or its network closes no connection, so
+		 *	its socket never becomes readable. Its chunk is reassigned once
+		 *	it is overdue.
+		 */
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		for (size_t i = 0; i < numberOfWorkers; i++)
+		{
+			ClusterWorker *	worker = &workers[i];
+
+			if ((worker->fd >= 0) && (worker->assignment.numberOfIterations > 0) &&
+				(now.tv_sec - worker->assignmentTime.tv_sec > kClusterConstantChunkTimeoutSeconds))
+			{
+				fprintf(stderr, "Warning: A worker did not return its chunk within %d s.\n", (int) kClusterConstantChunkTimeoutSeconds);
+				dropWorker(worker, failedRanges, &numberOfFailedRanges, report);
+			}
+		}
+
+		/*
+		 *	Receive the hellos and results of the workers.
+		 */
+		for (size_t i = 0; i < numberOfWorkers; i++)
+		{
+			ClusterWorker *	worker = &workers[i];
+			uint64_t	header[3];
+
+			if ((worker->fd < 0) || (pollFds[i + 1].revents == 0))
+			{
+				continue;
+			}
+
+			if (!worker->isHelloReceived)
+			{
+				uint64_t	hello[3];
+
+				if ((receiveBytes(worker->fd, hello, sizeof(hello)) != kCommonConstantReturnTypeSuccess) ||
+					(memcmp(&hello[0], kClusterMagic, sizeof(hello[0])) != 0))
+				{
+					fprintf(stderr, "Warning: Rejected a worker that did not send a valid hello.\n");
+					dropWorker(worker, failedRanges, &numberOfFailedRanges, report);
+
+					continue;
+				}
+
+				/*
+				 *	The kernel variant is checked first, as it is also part of
+				 *	the hash of the parameters.
+				 */
+				if (hello[2] != kernelVariantHash)
+				{
+					fprintf(stderr, "Warning: Rejected a worker whose sampling kernel variant differs from that of the coordinator (%s).\n", selectSamplingKernels()->name);
+					dropWorker(worker, failedRanges, &numberOfFailedRanges, report);
+
+					continue;
+				}
+
+				if (hello[1] != parametersHash)
+				{
+					fprintf(stderr, "Warning: Rejected a worker whose model parameters differ from those of the coordinator.\n");
+					dropWorker(worker, failedRanges, &numberOfFailedRanges, report);
+
+					continue;
+				}
+
+				worker->isHelloReceived = true;
+				report->numberOfWorkers++;
+
+				continue;
+			}
+
+			if ((receiveBytes(worker->fd, header, sizeof(header)) != kCommonConstantReturnTypeSuccess) ||
+				(header[0] != worker->assignment.firstIteration) || (header[1] != worker->assignment.numberOfIterations) ||
+				(receiveBytes(
+					worker->fd,
+					samples + (worker->assignment.firstIteration - parameters->firstIteration),
+					worker->assignment.numberOfIterations * sizeof(double)) != kCommonConstantReturnTypeSuccess))
+			{
+				dropWorker(worker, failedRanges, &numberOfFailedRanges, report);
+
+				continue;
+			}
+
+			numberOfCompletedIterations += worker->assignment.numberOfIterations;
+			report->numberOfChunks++;
+			report->cpuTimeMicroseconds += header[2];
+			worker->assignment = (ClusterRange) {0};
+		}
+
+		/*
+		 *	Accept a new worker.
+		 */
+		if (pollFds[0].revents & POLLIN)
+		{
+			int	fd = accept(listenFd, NULL, NULL);
+
+			if (fd < 0)
+			{
+				continue;
+			}
+
+			if (numberOfWorkers == workersCapacity)
+			{
+				size_t			newCapacity = 2 * workersCapacity;
+				ClusterWorker *		newWorkers = realloc(workers, newCapacity * sizeof(ClusterWorker));
+				struct pollfd *		newPollFds = realloc(pollFds, (newCapacity + 1) * sizeof(struct pollfd));
+				ClusterRange *		newFailedRanges = realloc(failedRanges, newCapacity * sizeof(ClusterRange));
+
+				workers = (newWorkers != NULL) ? newWorkers : workers;
+				pollFds = (newPollFds != NULL) ? newPollFds : pollFds;
+				failedRanges = (newFailedRanges != NULL) ? newFailedRanges : failedRanges;
+				if ((newWorkers == NULL) || (newPollFds == NULL) || (newFailedRanges == NULL))
+				{
+					fprintf(stderr, "Error: Could not allocate the workers of the cluster.\n");
+					close(fd);
+					result = kCommonConstantReturnTypeError;
+
+					continue;
+				}
+				workersCapacity = newCapacity;
+			}
+
+			setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &receiveTimeout, sizeof(receiveTimeout));
+			workers[numberOfWorkers++] = (ClusterWorker) {.fd = fd};
+		}
+	}
+
+	/*
+	 *	Stop the workers and wait for the local ones.
+	 */
+	for (size_t i = 0; i < numberOfWorkers; i++)
+	{
+		uint64_t	stop[2] = {0, 0};
+
+		if (workers[i].fd >= 0)
+		{
+			sendBytes(workers[i].fd, stop, sizeof(stop));
+			close(workers[i].fd);
+		}
+	}
+	close(listenFd);
+	while (numberOfExitedWorkers < numberOfForkedWorkers)
+	{
+		if (waitpid(-1, NULL, 0) > 0)
+		{
+			numberOfExitedWorkers++;
+		}
+		else if (errno != EINTR)
+		{
+			break;
+		}
+	}
+
+	free(workers);
+	free(pollFds);
+	free(failedRanges);
+
+	return result;
+}
@@ -0,0 +1,107 @@
+/*
+ *	Copyright (c) 2024, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#pragma once
+#include <stddef.h>
+#include "common.h"
+#include "moonfire.h"
+
+
+/*
+ *	Distributed simulation over TCP (native builds only).
+ *
+ *	A coordinator splits the iterations of a simulation into chunks of
+ *	`kClusterConstantChunkIterations` and hands them out to worker processes,
+ *	one chunk at a time, so faster workers simulate more chunks. Workers are
+ *	processes that the coordinator forks on its own host, or processes on
+ *	other hosts started with the same model options and the address of the
+ *	coordinator. Each worker simulates its chunk from `firstIteration` of
+ *	`MoonfireParameters` and returns the samples of the chunk, which the
+ *	coordinator stores at their place, so the samples are those of a single
+ *	simulation whichever worker simulated each chunk. When a worker dies, its
+ *	connection breaks, or it does not return its chunk within
+ *	`kClusterConstantChunkTimeoutSeconds`, e.g., because its host lost power
+ *	without closing the connection, its chunk is handed out again.
+ *
+ *	Messages are arrays of `uint64_t` (and `double`), in the byte order of the
+ *	hosts, which must therefore agree:
+ *
+ *		worker hello:		`kClusterMagic`, `hashModelParameters()` and
+ *					`hashKernelVariant()` (see `cache.h`)
+ *		assignment:		first iteration, number of iterations (0 to stop)
+ *		result:			first iteration, number of iterations, CPU time in
+ *					microseconds, then the samples of the chunk
+ *
+ *	The coordinator closes the connection of a worker whose parameters or
+ *	sampling kernel variant differ from its own.
+ */
+
+#define kClusterMagic	"MFCLUS02"
+
+typedef enum
+{
+	kClusterConstantChunkIterations			= 65536,
+	kClusterConstantInitialWorkersCapacity		= 16,
+	kClusterConstantListenBacklog			= 64,
+	kClusterConstantConnectAttempts			= 100,
+	kClusterConstantConnectRetryMilliseconds	= 100,
+	kClusterConstantPollMilliseconds		= 1000,
+	kClusterConstantReceiveTimeoutSeconds		= 60,
+	kClusterConstantChunkTimeoutSeconds		= 600,
+} ClusterConstant;
+
+typedef struct
+{
+	size_t		numberOfWorkers;
+	size_t		numberOfChunks;
+	size_t		numberOfReassignedChunks;
+	uint64_t	cpuTimeMicroseconds;
+} ClusterReport;
+
+/**
+ *	@brief	Run a simulation as the coordinator of a cluster, until all of its
+ *		iterations are simulated. Forks `numberOfLocalWorkers` worker processes,
+ *		and, with an address, also accepts workers of other hosts.
+ *
+ *	@param	parameters		: The model parameters, with the kernels engine.
+ *	@param	numberOfLocalWorkers	: Number of worker processes to fork.
+ *	@param	address			: `host:port` to listen on, or `NULL` to listen on an ephemeral loopback port for local workers only.
+ *	@param	samples			: Array of `numberOfIterations` of the parameters to store the samples.
+ *	@param	report			: Pointer to struct to store the workers, chunks and CPU time of the run.
+ *	@return				: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+CommonConstantReturnType	runClusterCoordinator(
+					const MoonfireParameters *	parameters,
+					size_t				numberOfLocalWorkers,
+					const char *			address,
+					double *			samples,
+					ClusterReport *			report);
+
+/**
+ *	@brief	Run a worker of a cluster: connect to the coordinator and simulate the
+ *		chunks it assigns until it stops the worker.
+ *
+ *	@param	parameters	: The model parameters, which must be those of the coordinator apart from the iterations.
+ *	@param	address		: `host:port` of the coordinator.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+CommonConstantReturnType	runClusterWorker(const MoonfireParameters *  parameters, const char *  address);
@@ -1,4 +1,17 @@
 SOURCES	=\
 	main.c\
 	common.c\
-	utilities.c
+	utilities.c\
+	moonfire.c\
+	kernels.c\
+	portfolio.c\
+	copula.c\
+	timeline.c\
+	waterfall.c\
+	optimizer.c\
+	calibration.c\
+	sketch.c\
+	arena.c\
+	scheduler.c\
+	sweep.c\
+	topology.c
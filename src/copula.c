@@ -0,0 +1,253 @@
+/*
+ *	Copyright (c) 2024, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "copula.h"
+
+
+static const double	kCopulaCholeskyTolerance		= 1e-12;
+static const double	kCopulaCholeskyResidualTolerance	= 1e-9;
+
+/**
+ *	@brief	CDF of the Student t distribution with an integer number of degrees of
+ *		freedom, by the closed forms of Abramowitz and Stegun 26.7.3 and 26.7.4,
+ *		with theta = atan(t / sqrt(degreesOfFreedom)). sin(theta) and
+ *		cos(theta) are algebraic in t, so only odd degrees of freedom need atan().
+ *
+ *	@param	t			: The argument.
+ *	@param	degreesOfFreedom	: Degrees of freedom, >= 1.
+ *	@return				: P(T <= t).
+ */
+static double
+studentTCdf(double t, size_t degreesOfFreedom)
+{
+	double	hypotenuse = sqrt((double) degreesOfFreedom + t * t);
+	double	sine = t / hypotenuse;
+	double	cosine = sqrt((double) degreesOfFreedom) / hypotenuse;
+	double	cosineSquared = cosine * cosine;
+	double	term;
+	double	series;
+	double	probabilityWithinT;
+
+	if (degreesOfFreedom % 2 == 0)
+	{
+		/*
+		 *	sin(theta) * (1 + 1/2 cos^2 + (1 * 3)/(2 * 4) cos^4 + ... + cos^(dof - 2) term)
+		 */
+		term = 1.0;
+		series = 1.0;
+		for (size_t k = 2; k < degreesOfFreedom; k += 2)
+		{
+			term *= cosineSquared * (double)(k - 1) / (double) k;
+			series += term;
+		}
+		probabilityWithinT = sine * series;
+	}
+	else
+	{
+		/*
+		 *	2/pi * (theta + sin(theta) * (cos + 2/3 cos^3 + ... + cos^(dof - 2) term))
+		 */
+		term = cosine;
+		series = (degreesOfFreedom > 1) ? cosine : 0.0;
+		for (size_t k = 3; k < degreesOfFreedom; k += 2)
+		{
+			term *= cosineSquared * (double)(k - 1) / (double) k;
+			series += term;
+		}
+		probabilityWithinT = M_2_PI * (atan(t / sqrt((double) degreesOfFreedom)) + sine * series);
+	}
+
+	return 0.5 + 0.5 * probabilityWithinT;
+}
+
+CopulaConstants
+computeCopulaConstants(const MoonfireParameters *  parameters)
+{
+	double	idiosyncraticVariance = 1.0 - parameters->marketCorrelation - parameters->classCorrelation;
+
+	return (CopulaConstants)
+	{
+		.copula			= parameters->copula,
+		.marketLoading		= sqrt(parameters->marketCorrelation),
+		.classLoading		= sqrt(parameters->classCorrelation),
+		.idiosyncraticLoading	= sqrt((idiosyncraticVariance > 0.0) ? idiosyncraticVariance : 0.0),
+		.degreesOfFreedom	= (parameters->copula == kMoonfireCopulaStudentT) ? parameters->degreesOfFreedom : 0,
+	};
+}
+
+uint64_t
+copulaVariatesPerIteration(const CopulaConstants *  constants, size_t numberOfClasses, size_t numberOfInvestments)
+{
+	return 1 + (uint64_t) numberOfClasses + (uint64_t) constants->degreesOfFreedom + (uint64_t) numberOfInvestments;
+}
+
+CommonConstantReturnType
+computeCholeskyFactor(const double *  correlations, size_t order, double *  upper)
+{
+	memset(upper, 0, order * order * sizeof(double));
+
+	/*
+	 *	Cholesky-Crout, computing L = U^T column by column, i.e., U row by row.
+	 */
+	for (size_t j = 0; j < order; j++)
+	{
+		double	diagonal = correlations[j * order + j];
+
+		for (size_t k = 0; k < j; k++)
+		{
+			diagonal -= upper[k * order + j] * upper[k * order + j];
+		}
+
+		if (diagonal < -kCopulaCholeskyTolerance)
+		{
+			return kCommonConstantReturnTypeError;
+		}
+
+		if (diagonal <= kCopulaCholeskyTolerance)
+		{
+			/*
+			 *	Class j is a linear combination of the previous classes.
+			 */
+			continue;
+		}
+
+		upper[j * order + j] = sqrt(diagonal);
+		for (size_t i = j + 1; i < order; i++)
+		{
+			double	value = correlations[i * order + j];
+
+			for (size_t k = 0; k < j; k++)
+			{
+				value -= upper[k * order + i] * upper[k * order + j];
+			}
+			upper[j * order + i] = value / upper[j * order + j];
+		}
+	}
+
+	/*
+	 *	With zero pivots, the factor only reproduces the matrix if the
+	 *	matrix is positive semidefinite, so check the product.
+	 */
+	for (size_t i = 0; i < order; i++)
+	{
+		for (size_t j = 0; j <= i; j++)
+		{
+			double	product = 0.0;
+
+			for (size_t k = 0; k <= j; k++)
+			{
+				product += upper[k * order + i] * upper[k * order + j];
+			}
+
+			if (fabs(product - correlations[i * order + j]) > kCopulaCholeskyResidualTolerance)
+			{
+				return kCommonConstantReturnTypeError;
+			}
+		}
+	}
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+void
+sampleCopulaClassFactors(
+	const SamplingKernels *	kernels,
+	size_t			numberOfClasses,
+	const double *		upper,
+	uint64_t		key,
+	uint64_t		counter,
+	uint64_t		variatesPerIteration,
+	size_t			numberOfIterations,
+	double *		normals,
+	double *		classFactors)
+{
+	double *	independentFactors = (upper != NULL) ? normals : classFactors;
+
+	for (size_t b = 0; b < numberOfIterations; b++)
+	{
+		kernels->sampleStandardNormals(
+				independentFactors + b * numberOfClasses,
+				numberOfClasses,
+				key,
+				counter + b * variatesPerIteration + 1);
+	}
+
+	if (upper != NULL)
+	{
+		kernels->multiplyUpperTriangular(classFactors, normals, numberOfIterations, upper, numberOfClasses);
+	}
+
+	return;
+}
+
+void
+sampleCopulaUniforms(
+	const SamplingKernels *	kernels,
+	const CopulaConstants *	constants,
+	const size_t *		investmentClasses,
+	size_t			numberOfInvestments,
+	size_t			numberOfClasses,
+	const double *		classFactors,
+	uint64_t		key,
+	uint64_t		counter,
+	double *		uniforms)
+{
+	double		marketFactor;
+	double		marketTerm;
+	double		chiSquareNormals[kMoonfireConstantMaximumDegreesOfFreedom];
+
+	kernels->sampleStandardNormals(&marketFactor, 1, key, counter);
+	kernels->sampleStandardNormals(uniforms, numberOfInvestments, key, counter + 1 + numberOfClasses + constants->degreesOfFreedom);
+
+	marketTerm = constants->marketLoading * marketFactor;
+	for (size_t i = 0; i < numberOfInvestments; i++)
+	{
+		uniforms[i] = (marketTerm + constants->classLoading * classFactors[investmentClasses[i]]) +
+				constants->idiosyncraticLoading * uniforms[i];
+	}
+
+	if (constants->copula == kMoonfireCopulaStudentT)
+	{
+		double	chiSquare = 0.0;
+		double	mixingScale;
+
+		kernels->sampleStandardNormals(chiSquareNormals, constants->degreesOfFreedom, key, counter + 1 + numberOfClasses);
+		for (size_t m = 0; m < constants->degreesOfFreedom; m++)
+		{
+			chiSquare += chiSquareNormals[m] * chiSquareNormals[m];
+		}
+		mixingScale = sqrt((double) constants->degreesOfFreedom / chiSquare);
+
+		for (size_t i = 0; i < numberOfInvestments; i++)
+		{
+			uniforms[i] = studentTCdf(uniforms[i] * mixingScale, constants->degreesOfFreedom);
+		}
+
+		return;
+	}
+
+	kernels->standardNormalCdf(uniforms, numberOfInvestments);
+
+	return;
+}
@@ -0,0 +1,142 @@
+/*
+ *	Copyright (c) 2024, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "kernels.h"
+#include "moonfire.h"
+
+
+/*
+ *	Factor-model copulas (see `MoonfireCopula`).
+ */
+
+typedef enum
+{
+	/*
+	 *	Number of iterations whose class factors are sampled together.
+	 */
+	kCopulaConstantIterationBatchSize	= 64,
+} CopulaConstant;
+
+typedef struct
+{
+	MoonfireCopula	copula;
+	double		marketLoading;
+	double		classLoading;
+	double		idiosyncraticLoading;
+
+	/*
+	 *	Degrees of freedom of the Student t copula, 0 for the Gaussian copula.
+	 */
+	size_t		degreesOfFreedom;
+} CopulaConstants;
+
+/**
+ *	@brief	Precompute the factor loadings of a copula.
+ *
+ *	@param	parameters	: The model parameters.
+ *	@return			: The precomputed constants.
+ */
+CopulaConstants	computeCopulaConstants(const MoonfireParameters *  parameters);
+
+/**
+ *	@brief	Number of standard normal variates that one call of
+ *		`sampleCopulaUniforms()` consumes, i.e., the stride between the
+ *		counters of consecutive iterations.
+ *
+ *	@param	constants		: The copula constants.
+ *	@param	numberOfClasses		: Number of portfolio classes.
+ *	@param	numberOfInvestments	: Number of investments.
+ *	@return				: The number of variates.
+ */
+uint64_t	copulaVariatesPerIteration(const CopulaConstants *  constants, size_t numberOfClasses, size_t numberOfInvestments);
+
+/**
+ *	@brief	Factor a class correlation matrix as `R = U^T U`, with `U` upper
+ *		triangular (the transposed Cholesky factor). Positive semidefinite
+ *		matrices, e.g., of perfectly correlated classes, are accepted, with
+ *		zero rows in `U` for the dependent classes.
+ *
+ *	@param	correlations	: The `order` x `order` correlation matrix, row-major.
+ *	@param	order		: Number of classes.
+ *	@param	upper		: Array of `order` x `order` elements to store `U`, row-major.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError` if the matrix is not positive semidefinite.
+ */
+CommonConstantReturnType	computeCholeskyFactor(const double *  correlations, size_t order, double *  upper);
+
+/**
+ *	@brief	Sample the class factors `C` of `numberOfIterations` consecutive
+ *		iterations, starting with the iteration whose first normal variate
+ *		is `counter`. Row `b` of `classFactors` holds the factors of
+ *		iteration `b`, from normal variates `counter + b * variatesPerIteration + 1`
+ *		onwards. With a class correlation matrix, the independent normals of
+ *		all iterations are correlated with one matrix product.
+ *
+ *	@param	kernels			: The sampling kernels.
+ *	@param	numberOfClasses		: Number of portfolio classes.
+ *	@param	upper			: Factor of the class correlation matrix (see `computeCholeskyFactor()`), or `NULL` for independent classes.
+ *	@param	key			: Stream key (see `deriveStreamKey()`).
+ *	@param	counter			: Index of the first normal variate of the first iteration.
+ *	@param	variatesPerIteration	: See `copulaVariatesPerIteration()`.
+ *	@param	numberOfIterations	: Number of iterations, at most `kCopulaConstantIterationBatchSize`.
+ *	@param	normals			: Scratch array of `numberOfIterations` x `numberOfClasses` elements.
+ *	@param	classFactors		: Array to store the `numberOfIterations` x `numberOfClasses` class factors.
+ */
+void		sampleCopulaClassFactors(
+			const SamplingKernels *	kernels,
+			size_t			numberOfClasses,
+			const double *		upper,
+			uint64_t		key,
+			uint64_t		counter,
+			uint64_t		variatesPerIteration,
+			size_t			numberOfIterations,
+			double *		normals,
+			double *		classFactors);
+
+/**
+ *	@brief	Sample the copula uniforms `U` of one iteration, with normal variates
+ *		`counter` to `counter + copulaVariatesPerIteration() - 1` of the
+ *		random stream `key` (see `sampleStandardNormals`), except for the
+ *		class factors, which are sampled in batches by `sampleCopulaClassFactors()`.
+ *
+ *	@param	kernels			: The sampling kernels.
+ *	@param	constants		: The copula constants.
+ *	@param	investmentClasses	: Class index of each investment, in [0, numberOfClasses).
+ *	@param	numberOfInvestments	: Number of investments.
+ *	@param	numberOfClasses		: Number of portfolio classes.
+ *	@param	classFactors		: The `numberOfClasses` class factors of the iteration.
+ *	@param	key			: Stream key (see `deriveStreamKey()`).
+ *	@param	counter			: Index of the first normal variate of the iteration.
+ *	@param	uniforms		: Array to store the `numberOfInvestments` uniforms.
+ */
+void		sampleCopulaUniforms(
+			const SamplingKernels *	kernels,
+			const CopulaConstants *	constants,
+			const size_t *		investmentClasses,
+			size_t			numberOfInvestments,
+			size_t			numberOfClasses,
+			const double *		classFactors,
+			uint64_t		key,
+			uint64_t		counter,
+			double *		uniforms);
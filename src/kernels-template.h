@@ -0,0 +1,1160 @@
+/*
+ *	Copyright (c) 2024, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+/*
+ *	Instruction-set-independent implementation of the sampling kernels.
+ *
+ *	This file has no include guard on purpose: `kernels.c` includes it once per
+ *	instruction-set variant, under a different `#pragma GCC target`, with
+ *	`KERNEL_VARIANT(name)` appending the variant suffix to every name. The
+ *	loops are written so that the compiler vectorizes them without
+ *	`-ffast-math`: the logarithm and exponential are branch-free polynomial
+ *	approximations (accurate to a few ulp) instead of calls to libm.
+ */
+
+static inline uint64_t
+KERNEL_VARIANT(bitsFromDouble)(double value)
+{
+	uint64_t	bits;
+
+	memcpy(&bits, &value, sizeof(bits));
+
+	return bits;
+}
+
+static inline double
+KERNEL_VARIANT(doubleFromBits)(uint64_t bits)
+{
+	double	value;
+
+	memcpy(&value, &bits, sizeof(value));
+
+	return value;
+}
+
+static inline uint32_t
+KERNEL_VARIANT(bitsFromFloat)(float value)
+{
+	uint32_t	bits;
+
+	memcpy(&bits, &value, sizeof(bits));
+
+	return bits;
+}
+
+static inline float
+KERNEL_VARIANT(floatFromBits)(uint32_t bits)
+{
+	float	value;
+
+	memcpy(&value, &bits, sizeof(value));
+
+	return value;
+}
+
+/*
+ *	SplitMix64 output function applied to the position `counter` of the
+ *	stream `key`. The 52 high bits of the result fill the mantissa of a double
+ *	in [1, 2), which is then shifted to (0, 1).
+ */
+static inline double
+KERNEL_VARIANT(uniform)(uint64_t key, uint64_t counter)
+{
+	uint64_t	z = key + (counter + 1) * kSamplingKernelsStreamIncrement;
+
+	z = (z ^ (z >> 30)) * kSamplingKernelsMixMultiplier1;
+	z = (z ^ (z >> 27)) * kSamplingKernelsMixMultiplier2;
+	z = z ^ (z >> 31);
+
+	return KERNEL_VARIANT(doubleFromBits)(kSamplingKernelsExponentOfOne | (z >> 12)) - kSamplingKernelsOneMinusHalfUlp;
+}
+
+/*
+ *	As `uniform`, with the 23 high bits of the SplitMix64 output in the
+ *	mantissa of a float, i.e., the same variate rounded down to a multiple of
+ *	2^-23.
+ */
+static inline float
+KERNEL_VARIANT(uniformFloat)(uint64_t key, uint64_t counter)
+{
+	uint64_t	z = key + (counter + 1) * kSamplingKernelsStreamIncrement;
+
+	z = (z ^ (z >> 30)) * kSamplingKernelsMixMultiplier1;
+	z = (z ^ (z >> 27)) * kSamplingKernelsMixMultiplier2;
+	z = z ^ (z >> 31);
+
+	return KERNEL_VARIANT(floatFromBits)(kSamplingKernelsFloatExponentOfOne | (uint32_t) (z >> 41)) - kSamplingKernelsFloatOneMinusHalfUlp;
+}
+
+/*
+ *	Natural logarithm of a positive normal double. Splits `x` into 2^k * m with
+ *	m in [1, 2) and evaluates log(m) = log(sqrt(2)) + 2 * atanh(s), with
+ *	s = (m - sqrt(2)) / (m + sqrt(2)) in [-0.172, 0.172]. Centering on sqrt(2)
+ *	instead of reducing m to [sqrt(1/2), sqrt(2)) avoids a data-dependent
+ *	select, which the baseline x86-64 instruction set cannot if-convert.
+ */
+static inline double
+KERNEL_VARIANT(logarithm)(double x)
+{
+	uint64_t	bits = KERNEL_VARIANT(bitsFromDouble)(x);
+	double		mantissa = KERNEL_VARIANT(doubleFromBits)((bits & kSamplingKernelsMantissaMask) | kSamplingKernelsExponentOfOne);
+	double		exponent = KERNEL_VARIANT(doubleFromBits)(kSamplingKernelsExponentOfTwoToThe52 | (bits >> 52)) - kSamplingKernelsTwoToThe52PlusBias + 0.5;
+	double		s = (mantissa - M_SQRT2) / (mantissa + M_SQRT2);
+	double		s2 = s * s;
+	double		series;
+
+	series = 1.0 / 21.0;
+	series = series * s2 + 1.0 / 19.0;
+	series = series * s2 + 1.0 / 17.0;
+	series = series * s2 + 1.0 / 15.0;
+	series = series * s2 + 1.0 / 13.0;
+	series = series * s2 + 1.0 / 11.0;
+	series = series * s2 + 1.0 / 9.0;
+	series = series * s2 + 1.0 / 7.0;
+	series = series * s2 + 1.0 / 5.0;
+	series = series * s2 + 1.0 / 3.0;
+
+	return exponent * kSamplingKernelsLn2High + ((exponent * kSamplingKernelsLn2Low + 2.0 * s * s2 * series) + 2.0 * s);
+}
+
+/*
+ *	Exponential of `x` in [-708, 709], i.e., with a normal double result. Splits
+ *	`x` into k * ln(2) + r with |r| <= ln(2) / 2 and evaluates exp(r) with a
+ *	Taylor polynomial of degree 13. There is no range clamping, which would
+ *	need a select: in the bounded Pareto inverse CDF the argument lies in
+ *	[0, log(upperBound / lowerBound)], and in the normal CDF in (-700, 0].
+ */
+static inline double
+KERNEL_VARIANT(exponential)(double x)
+{
+	double		shifted;
+	double		k;
+	double		r;
+	double		polynomial;
+	uint64_t	kBits;
+
+	/*
+	 *	Adding 1.5 * 2^52 rounds to the nearest integer and leaves that
+	 *	integer in the low mantissa bits of `shifted`.
+	 */
+	shifted = x * M_LOG2E + kSamplingKernelsRoundingShift;
+	k = shifted - kSamplingKernelsRoundingShift;
+	kBits = KERNEL_VARIANT(bitsFromDouble)(shifted);
+	r = (x - k * kSamplingKernelsLn2High) - k * kSamplingKernelsLn2Low;
+
+	polynomial = 1.0 / 6227020800.0;
+	polynomial = polynomial * r + 1.0 / 479001600.0;
+	polynomial = polynomial * r + 1.0 / 39916800.0;
+	polynomial = polynomial * r + 1.0 / 3628800.0;
+	polynomial = polynomial * r + 1.0 / 362880.0;
+	polynomial = polynomial * r + 1.0 / 40320.0;
+	polynomial = polynomial * r + 1.0 / 5040.0;
+	polynomial = polynomial * r + 1.0 / 720.0;
+	polynomial = polynomial * r + 1.0 / 120.0;
+	polynomial = polynomial * r + 1.0 / 24.0;
+	polynomial = polynomial * r + 1.0 / 6.0;
+	polynomial = polynomial * r + 0.5;
+	polynomial = polynomial * r + 1.0;
+	polynomial = polynomial * r + 1.0;
+
+	return polynomial * KERNEL_VARIANT(doubleFromBits)((kBits + kSamplingKernelsExponentBias) << 52);
+}
+
+/*
+ *	As `logarithm` and `exponential`, for floats, with the series truncated
+ *	to float accuracy. `exponentialFloat` needs `x` in [-87, 88].
+ */
+static inline float
+KERNEL_VARIANT(logarithmFloat)(float x)
+{
+	uint32_t	bits = KERNEL_VARIANT(bitsFromFloat)(x);
+	float		mantissa = KERNEL_VARIANT(floatFromBits)((bits & kSamplingKernelsFloatMantissaMask) | kSamplingKernelsFloatExponentOfOne);
+	float		exponent = KERNEL_VARIANT(floatFromBits)(kSamplingKernelsFloatExponentOfTwoToThe23 | (bits >> 23)) - kSamplingKernelsFloatTwoToThe23PlusBias + 0.5f;
+	float		s = (mantissa - (float) M_SQRT2) / (mantissa + (float) M_SQRT2);
+	float		s2 = s * s;
+	float		series;
+
+	series = 1.0f / 9.0f;
+	series = series * s2 + 1.0f / 7.0f;
+	series = series * s2 + 1.0f / 5.0f;
+	series = series * s2 + 1.0f / 3.0f;
+
+	return exponent * kSamplingKernelsFloatLn2High + ((exponent * kSamplingKernelsFloatLn2Low + 2.0f * s * s2 * series) + 2.0f * s);
+}
+
+static inline float
+KERNEL_VARIANT(exponentialFloat)(float x)
+{
+	float		shifted = x * (float) M_LOG2E + kSamplingKernelsFloatRoundingShift;
+	float		k = shifted - kSamplingKernelsFloatRoundingShift;
+	uint32_t	kBits = KERNEL_VARIANT(bitsFromFloat)(shifted);
+	float		r = (x - k * kSamplingKernelsFloatLn2High) - k * kSamplingKernelsFloatLn2Low;
+	float		polynomial;
+
+	polynomial = 1.0f / 5040.0f;
+	polynomial = polynomial * r + 1.0f / 720.0f;
+	polynomial = polynomial * r + 1.0f / 120.0f;
+	polynomial = polynomial * r + 1.0f / 24.0f;
+	polynomial = polynomial * r + 1.0f / 6.0f;
+	polynomial = polynomial * r + 0.5f;
+	polynomial = polynomial * r + 1.0f;
+	polynomial = polynomial * r + 1.0f;
+
+	return polynomial * KERNEL_VARIANT(floatFromBits)((kBits + kSamplingKernelsFloatExponentBias) << 23);
+}
+
+/*
+ *	Square root of a positive normal double, as x * rsqrt(x), with rsqrt(x)
+ *	from a bit-level initial estimate refined by four Newton steps. libm's
+ *	sqrt() is not vectorized while it may set errno.
+ */
+static inline double
+KERNEL_VARIANT(squareRoot)(double x)
+{
+	double	halfX = 0.5 * x;
+	double	y = KERNEL_VARIANT(doubleFromBits)(kSamplingKernelsInverseSqrtMagic - (KERNEL_VARIANT(bitsFromDouble)(x) >> 1));
+
+	y = y * (1.5 - halfX * y * y);
+	y = y * (1.5 - halfX * y * y);
+	y = y * (1.5 - halfX * y * y);
+	y = y * (1.5 - halfX * y * y);
+
+	return x * y;
+}
+
+/*
+ *	cos(2 * pi * t) for t in [0, 1], as 2 * sin(h)^2 - 1 with h = pi * (t - 1/2)
+ *	in [-pi/2, pi/2], and sin(h) from its Taylor polynomial of degree 21.
+ */
+static inline double
+KERNEL_VARIANT(cosineTwoPi)(double t)
+{
+	double	h = M_PI * (t - 0.5);
+	double	h2 = h * h;
+	double	polynomial;
+	double	sine;
+
+	polynomial = 1.0 / 51090942171709440000.0;
+	polynomial = polynomial * h2 - 1.0 / 121645100408832000.0;
+	polynomial = polynomial * h2 + 1.0 / 355687428096000.0;
+	polynomial = polynomial * h2 - 1.0 / 1307674368000.0;
+	polynomial = polynomial * h2 + 1.0 / 6227020800.0;
+	polynomial = polynomial * h2 - 1.0 / 39916800.0;
+	polynomial = polynomial * h2 + 1.0 / 362880.0;
+	polynomial = polynomial * h2 - 1.0 / 5040.0;
+	polynomial = polynomial * h2 + 1.0 / 120.0;
+	polynomial = polynomial * h2 - 1.0 / 6.0;
+	polynomial = polynomial * h2 + 1.0;
+	sine = h * polynomial;
+
+	return 2.0 * sine * sine - 1.0;
+}
+
+/*
+ *	Inverse CDF of the bounded Pareto distribution (see `BoundedParetoConstants`).
+ */
+static inline double
+KERNEL_VARIANT(boundedParetoQuantile)(double u, double lowerBound, double oneMinusBoundRatioToAlpha, double negativeInverseAlpha)
+{
+	double	base = 1.0 - u * oneMinusBoundRatioToAlpha;
+
+	return lowerBound * KERNEL_VARIANT(exponential)(negativeInverseAlpha * KERNEL_VARIANT(logarithm)(base));
+}
+
+static void
+KERNEL_VARIANT(sampleBoundedPareto)(
+	double *			output,
+	size_t				count,
+	const BoundedParetoConstants *	constants,
+	uint64_t			key,
+	uint64_t			counter)
+{
+	const double	lowerBound = constants->lowerBound;
+	const double	oneMinusBoundRatioToAlpha = constants->oneMinusBoundRatioToAlpha;
+	const double	negativeInverseAlpha = constants->negativeInverseAlpha;
+	const double	shift = constants->shift;
+	const double	scale = constants->scale;
+
+	for (size_t j = 0; j < count; j++)
+	{
+		double	u = KERNEL_VARIANT(uniform)(key, counter + j);
+		double	x = KERNEL_VARIANT(boundedParetoQuantile)(u, lowerBound, oneMinusBoundRatioToAlpha, negativeInverseAlpha);
+
+		output[j] = (x - shift) * scale;
+	}
+
+	return;
+}
+
+/*
+ *	As `sampleBoundedPareto`, with the base of the inverse CDF split into its
+ *	exponent and the high bits of its mantissa, which index the table (see
+ *	`BoundedParetoTable`). The loads become gathers in the vector variants.
+ */
+static void
+KERNEL_VARIANT(sampleBoundedParetoTable)(
+	double *			output,
+	size_t				count,
+	const BoundedParetoTable *	table,
+	uint64_t			key,
+	uint64_t			counter)
+{
+	const double		oneMinusBoundRatioToAlpha = table->oneMinusBoundRatioToAlpha;
+	const double		shiftTimesScale = table->shiftTimesScale;
+	const double		c1 = table->seriesCoefficients[0];
+	const double		c2 = table->seriesCoefficients[1];
+	const double		c3 = table->seriesCoefficients[2];
+	const uint64_t		exponentOffset = (uint64_t) (kSamplingKernelsExponentBias + table->lowestExponent);
+	const double * restrict	powersOfTwo = table->powersOfTwo;
+	const double * restrict	powersOfMidpoints = table->powersOfMidpoints;
+	const double * restrict	inverseMidpoints = table->inverseMidpoints;
+
+	for (size_t j = 0; j < count; j++)
+	{
+		double		u = KERNEL_VARIANT(uniform)(key, counter + j);
+		uint64_t	bits = KERNEL_VARIANT(bitsFromDouble)(1.0 - u * oneMinusBoundRatioToAlpha);
+		uint64_t	exponentIndex = (bits >> 52) - exponentOffset;
+		uint64_t	mantissaIndex = (bits >> (52 - kBoundedParetoTableMantissaBits)) & (kBoundedParetoTableMantissaEntries - 1);
+		double		mantissa = KERNEL_VARIANT(doubleFromBits)((bits & kSamplingKernelsMantissaMask) | kSamplingKernelsExponentOfOne);
+		double		d = mantissa * inverseMidpoints[mantissaIndex] - 1.0;
+		double		series = 1.0 + d * (c1 + d * (c2 + d * c3));
+
+		output[j] = powersOfTwo[exponentIndex] * powersOfMidpoints[mantissaIndex] * series - shiftTimesScale;
+	}
+
+	return;
+}
+
+/*
+ *	Walker's alias method (see `AliasTable`): one uniform variate, one column
+ *	and one comparison per draw, whatever the number of outcomes.
+ */
+static void
+KERNEL_VARIANT(sampleAlias)(
+	double *			output,
+	size_t				count,
+	const AliasTable *		table,
+	uint64_t			key,
+	uint64_t			counter)
+{
+	const size_t		numberOfOutcomes = table->numberOfOutcomes;
+	const double		columns = (double) numberOfOutcomes;
+	const double * restrict	values = table->values;
+	const double * restrict	thresholds = table->thresholds;
+	const double * restrict	aliasValues = table->aliasValues;
+
+	/*
+	 *	The uniform variates are drawn in a separate pass, so that it
+	 *	vectorizes whether or not the loads of the lookups can.
+	 */
+	for (size_t j = 0; j < count; j++)
+	{
+		output[j] = KERNEL_VARIANT(uniform)(key, counter + j) * columns;
+	}
+
+	for (size_t j = 0; j < count; j++)
+	{
+		double		scaled = output[j];
+		size_t		column = (size_t) scaled;
+		uint64_t	isValue;
+
+		/*
+		 *	`u * numberOfOutcomes` can round up to `numberOfOutcomes` for `u`
+		 *	within an ulp of 1.
+		 */
+		column = (column < numberOfOutcomes) ? column : numberOfOutcomes - 1;
+
+		/*
+		 *	The choice is a mask rather than a branch, which the compilers
+		 *	emit for a conditional and which the fraction makes unpredictable.
+		 */
+		isValue = -(uint64_t) ((scaled - (double) column) < thresholds[column]);
+		output[j] = KERNEL_VARIANT(doubleFromBits)(
+				(KERNEL_VARIANT(bitsFromDouble)(values[column]) & isValue) |
+				(KERNEL_VARIANT(bitsFromDouble)(aliasValues[column]) & ~isValue));
+	}
+
+	return;
+}
+
+static void
+KERNEL_VARIANT(sampleBoundedParetoArrays)(
+	double *				output,
+	size_t					count,
+	const BoundedParetoConstantArrays *	constants,
+	uint64_t				key,
+	uint64_t				counter)
+{
+	const double * restrict	lowerBound = constants->lowerBound;
+	const double * restrict	oneMinusBoundRatioToAlpha = constants->oneMinusBoundRatioToAlpha;
+	const double * restrict	negativeInverseAlpha = constants->negativeInverseAlpha;
+	const double * restrict	shift = constants->shift;
+	const double * restrict	scale = constants->scale;
+
+	for (size_t j = 0; j < count; j++)
+	{
+		double	u = KERNEL_VARIANT(uniform)(key, counter + j);
+		double	x = KERNEL_VARIANT(boundedParetoQuantile)(u, lowerBound[j], oneMinusBoundRatioToAlpha[j], negativeInverseAlpha[j]);
+
+		output[j] = (x - shift[j]) * scale[j];
+	}
+
+	return;
+}
+
+static void
+KERNEL_VARIANT(sampleBoundedParetoFloat)(
+	float *				output,
+	size_t				count,
+	const BoundedParetoConstants *	constants,
+	uint64_t			key,
+	uint64_t			counter)
+{
+	const float	lowerBound = (float) constants->lowerBound;
+	const float	oneMinusBoundRatioToAlpha = (float) constants->oneMinusBoundRatioToAlpha;
+	const float	negativeInverseAlpha = (float) constants->negativeInverseAlpha;
+	const float	shift = (float) constants->shift;
+	const float	scale = (float) constants->scale;
+
+	for (size_t j = 0; j < count; j++)
+	{
+		float	u = KERNEL_VARIANT(uniformFloat)(key, counter + j);
+		float	base = 1.0f - u * oneMinusBoundRatioToAlpha;
+		float	x = lowerBound * KERNEL_VARIANT(exponentialFloat)(negativeInverseAlpha * KERNEL_VARIANT(logarithmFloat)(base));
+
+		output[j] = (x - shift) * scale;
+	}
+
+	return;
+}
+
+static void
+KERNEL_VARIANT(transformBoundedPareto)(
+	double *			values,
+	size_t				count,
+	const BoundedParetoConstants *	constants)
+{
+	const double	lowerBound = constants->lowerBound;
+	const double	oneMinusBoundRatioToAlpha = constants->oneMinusBoundRatioToAlpha;
+	const double	negativeInverseAlpha = constants->negativeInverseAlpha;
+	const double	shift = constants->shift;
+	const double	scale = constants->scale;
+
+	for (size_t j = 0; j < count; j++)
+	{
+		double	x = KERNEL_VARIANT(boundedParetoQuantile)(values[j], lowerBound, oneMinusBoundRatioToAlpha, negativeInverseAlpha);
+
+		values[j] = (x - shift) * scale;
+	}
+
+	return;
+}
+
+static void
+KERNEL_VARIANT(transformBoundedParetoArrays)(
+	double *				values,
+	size_t					count,
+	const BoundedParetoConstantArrays *	constants)
+{
+	const double * restrict	lowerBound = constants->lowerBound;
+	const double * restrict	oneMinusBoundRatioToAlpha = constants->oneMinusBoundRatioToAlpha;
+	const double * restrict	negativeInverseAlpha = constants->negativeInverseAlpha;
+	const double * restrict	shift = constants->shift;
+	const double * restrict	scale = constants->scale;
+
+	for (size_t j = 0; j < count; j++)
+	{
+		double	x = KERNEL_VARIANT(boundedParetoQuantile)(values[j], lowerBound[j], oneMinusBoundRatioToAlpha[j], negativeInverseAlpha[j]);
+
+		values[j] = (x - shift[j]) * scale[j];
+	}
+
+	return;
+}
+
+static void
+KERNEL_VARIANT(sampleUniforms)(double *  output, size_t count, uint64_t key, uint64_t counter)
+{
+	for (size_t j = 0; j < count; j++)
+	{
+		output[j] = KERNEL_VARIANT(uniform)(key, counter + j);
+	}
+
+	return;
+}
+
+static void
+KERNEL_VARIANT(sampleStandardNormals)(double *  output, size_t count, uint64_t key, uint64_t counter)
+{
+	for (size_t j = 0; j < count; j++)
+	{
+		double	u1 = KERNEL_VARIANT(uniform)(key, 2 * (counter + j));
+		double	u2 = KERNEL_VARIANT(uniform)(key, 2 * (counter + j) + 1);
+
+		output[j] = KERNEL_VARIANT(squareRoot)(-2.0 * KERNEL_VARIANT(logarithm)(u1)) * KERNEL_VARIANT(cosineTwoPi)(u2);
+	}
+
+	return;
+}
+
+static void
+KERNEL_VARIANT(sampleLognormals)(double *  output, size_t count, double mu, double sigma, uint64_t key, uint64_t counter)
+{
+	KERNEL_VARIANT(sampleStandardNormals)(output, count, key, counter);
+	for (size_t j = 0; j < count; j++)
+	{
+		output[j] = KERNEL_VARIANT(exponential)(mu + sigma * output[j]);
+	}
+
+	return;
+}
+
+/*
+ *	Phi(z) = 1/2 + sign(z) * (1/2 - erfc(|z| / sqrt(2)) / 2), with erfc from the
+ *	Chebyshev fit of Numerical Recipes (`erfcc`). `copysign()` and `fabs()`
+ *	are bit operations, so the loop has no data-dependent select.
+ */
+static void
+KERNEL_VARIANT(standardNormalCdf)(double *  values, size_t count)
+{
+	for (size_t j = 0; j < count; j++)
+	{
+		double	z = values[j];
+		double	x = fabs(z) * M_SQRT1_2;
+		double	t = 1.0 / (1.0 + 0.5 * x);
+		double	polynomial;
+		double	complementaryError;
+
+		polynomial = 0.17087277;
+		polynomial = polynomial * t - 0.82215223;
+		polynomial = polynomial * t + 1.48851587;
+		polynomial = polynomial * t - 1.13520398;
+		polynomial = polynomial * t + 0.27886807;
+		polynomial = polynomial * t - 0.18628806;
+		polynomial = polynomial * t + 0.09678418;
+		polynomial = polynomial * t + 0.37409196;
+		polynomial = polynomial * t + 1.00002368;
+		polynomial = polynomial * t - 1.26551223;
+		complementaryError = t * KERNEL_VARIANT(exponential)(polynomial - x * x);
+
+		values[j] = 0.5 + copysign(0.5 - 0.5 * complementaryError, z);
+	}
+
+	return;
+}
+
+/*
+ *	Sums into `kSamplingKernelsSumLanes` independent partial sums, which the
+ *	compiler maps onto vector registers without reassociating floating-point
+ *	additions itself.
+ */
+static double
+KERNEL_VARIANT(sum)(const double *  values, size_t count)
+{
+	double	partialSums[kSamplingKernelsSumLanes] = {0};
+	double	sum = 0.0;
+	size_t	i = 0;
+
+	for (; i + kSamplingKernelsSumLanes <= count; i += kSamplingKernelsSumLanes)
+	{
+		for (size_t lane = 0; lane < kSamplingKernelsSumLanes; lane++)
+		{
+			partialSums[lane] += values[i + lane];
+		}
+	}
+
+	for (size_t width = kSamplingKernelsSumLanes / 2; width > 0; width /= 2)
+	{
+		for (size_t lane = 0; lane < width; lane++)
+		{
+			partialSums[lane] += partialSums[lane + width];
+		}
+	}
+
+	sum = partialSums[0];
+	for (; i < count; i++)
+	{
+		sum += values[i];
+	}
+
+	return sum;
+}
+
+/*
+ *	As `sum`, for floats accumulated in double.
+ */
+static double
+KERNEL_VARIANT(sumFloats)(const float *  values, size_t count)
+{
+	double	partialSums[kSamplingKernelsSumLanes] = {0};
+	double	sum = 0.0;
+	size_t	i = 0;
+
+	for (; i + kSamplingKernelsSumLanes <= count; i += kSamplingKernelsSumLanes)
+	{
+		for (size_t lane = 0; lane < kSamplingKernelsSumLanes; lane++)
+		{
+			partialSums[lane] += (double) values[i + lane];
+		}
+	}
+
+	for (size_t width = kSamplingKernelsSumLanes / 2; width > 0; width /= 2)
+	{
+		for (size_t lane = 0; lane < width; lane++)
+		{
+			partialSums[lane] += partialSums[lane + width];
+		}
+	}
+
+	sum = partialSums[0];
+	for (; i < count; i++)
+	{
+		sum += (double) values[i];
+	}
+
+	return sum;
+}
+
+/*
+ *	As `sum`, with `kSamplingKernelsFloatSumLanes` partial sums of floats,
+ *	each with the Kahan compensation of its rounding errors. The partial sums
+ *	and their compensations are combined in double.
+ */
+static double
+KERNEL_VARIANT(sumFloatsCompensated)(const float *  values, size_t count)
+{
+	float	partialSums[kSamplingKernelsFloatSumLanes] = {0};
+	float	compensations[kSamplingKernelsFloatSumLanes] = {0};
+	double	sum = 0.0;
+	size_t	i = 0;
+
+	for (; i + kSamplingKernelsFloatSumLanes <= count; i += kSamplingKernelsFloatSumLanes)
+	{
+		for (size_t lane = 0; lane < kSamplingKernelsFloatSumLanes; lane++)
+		{
+			float	y = values[i + lane] - compensations[lane];
+			float	t = partialSums[lane] + y;
+
+			compensations[lane] = (t - partialSums[lane]) - y;
+			partialSums[lane] = t;
+		}
+	}
+
+	for (size_t lane = 0; lane < kSamplingKernelsFloatSumLanes; lane++)
+	{
+		sum += (double) partialSums[lane] - (double) compensations[lane];
+	}
+
+	for (; i < count; i++)
+	{
+		sum += (double) values[i];
+	}
+
+	return sum;
+}
+
+/*
+ *	As `sum`, for the products of `values` and `weights`.
+ */
+static double
+KERNEL_VARIANT(dot)(const double *  values, const double *  weights, size_t count)
+{
+	double	partialSums[kSamplingKernelsSumLanes] = {0};
+	double	sum = 0.0;
+	size_t	i = 0;
+
+	for (; i + kSamplingKernelsSumLanes <= count; i += kSamplingKernelsSumLanes)
+	{
+		for (size_t lane = 0; lane < kSamplingKernelsSumLanes; lane++)
+		{
+			partialSums[lane] += values[i + lane] * weights[i + lane];
+		}
+	}
+
+	for (size_t width = kSamplingKernelsSumLanes / 2; width > 0; width /= 2)
+	{
+		for (size_t lane = 0; lane < width; lane++)
+		{
+			partialSums[lane] += partialSums[lane + width];
+		}
+	}
+
+	sum = partialSums[0];
+	for (; i < count; i++)
+	{
+		sum += values[i] * weights[i];
+	}
+
+	return sum;
+}
+
+/*
+ *	Adds `value` to the partial sum `*sum` and the rounding error of the
+ *	addition to `*compensation`. The error is recovered exactly whichever
+ *	operand is larger (Knuth's two-sum, the branch-free form of the
+ *	Kahan-Neumaier correction), e.g., for a return close to `xMax`.
+ */
+static inline void
+KERNEL_VARIANT(addCompensated)(double *  sum, double *  compensation, double value)
+{
+	double	total = *sum + value;
+	double	valuePart = total - *sum;
+
+	*compensation += (*sum - (total - valuePart)) + (value - valuePart);
+	*sum = total;
+
+	return;
+}
+
+/*
+ *	As `addCompensated`, for one term per lane. Each step is a separate loop
+ *	over the lanes, so that the compiler vectorizes the steps: as a single
+ *	loop, the partial sums have more than one use and are not vectorized.
+ */
+static inline void
+KERNEL_VARIANT(addCompensatedLanes)(double *  partialSums, double *  compensations, const double *  terms)
+{
+	double	totals[kSamplingKernelsSumLanes];
+	double	termParts[kSamplingKernelsSumLanes];
+
+	for (size_t lane = 0; lane < kSamplingKernelsSumLanes; lane++)
+	{
+		totals[lane] = partialSums[lane] + terms[lane];
+	}
+
+	for (size_t lane = 0; lane < kSamplingKernelsSumLanes; lane++)
+	{
+		termParts[lane] = totals[lane] - partialSums[lane];
+	}
+
+	for (size_t lane = 0; lane < kSamplingKernelsSumLanes; lane++)
+	{
+		compensations[lane] += (partialSums[lane] - (totals[lane] - termParts[lane])) + (terms[lane] - termParts[lane]);
+	}
+
+	for (size_t lane = 0; lane < kSamplingKernelsSumLanes; lane++)
+	{
+		partialSums[lane] = totals[lane];
+	}
+
+	return;
+}
+
+/*
+ *	Combines the compensated partial sums of the `kSamplingKernelsSumLanes`
+ *	lanes pairwise, in the same order as `sum`, and returns their total.
+ */
+static inline double
+KERNEL_VARIANT(reduceCompensatedLanes)(double *  partialSums, double *  compensations)
+{
+	for (size_t width = kSamplingKernelsSumLanes / 2; width > 0; width /= 2)
+	{
+		for (size_t lane = 0; lane < width; lane++)
+		{
+			KERNEL_VARIANT(addCompensated)(&partialSums[lane], &compensations[lane], partialSums[lane + width]);
+			compensations[lane] += compensations[lane + width];
+		}
+	}
+
+	return partialSums[0] + compensations[0];
+}
+
+/*
+ *	As `sum`, with compensated partial sums. The remaining elements are added
+ *	as a last block padded with zeros, so every element goes to the lane of
+ *	its index.
+ */
+static double
+KERNEL_VARIANT(sumCompensated)(const double *  values, size_t count)
+{
+	double	partialSums[kSamplingKernelsSumLanes] = {0};
+	double	compensations[kSamplingKernelsSumLanes] = {0};
+	double	terms[kSamplingKernelsSumLanes] = {0};
+	size_t	i = 0;
+
+	for (; i + kSamplingKernelsSumLanes <= count; i += kSamplingKernelsSumLanes)
+	{
+		KERNEL_VARIANT(addCompensatedLanes)(partialSums, compensations, values + i);
+	}
+
+	if (i < count)
+	{
+		memcpy(terms, values + i, (count - i) * sizeof(double));
+		KERNEL_VARIANT(addCompensatedLanes)(partialSums, compensations, terms);
+	}
+
+	return KERNEL_VARIANT(reduceCompensatedLanes)(partialSums, compensations);
+}
+
+/*
+ *	As `sumCompensated`, for the products of `values` and `weights`. The
+ *	rounding errors of the products are not compensated.
+ */
+static double
+KERNEL_VARIANT(dotCompensated)(const double *  values, const double *  weights, size_t count)
+{
+	double	partialSums[kSamplingKernelsSumLanes] = {0};
+	double	compensations[kSamplingKernelsSumLanes] = {0};
+	double	terms[kSamplingKernelsSumLanes];
+	size_t	i = 0;
+
+	for (; i < count; i += kSamplingKernelsSumLanes)
+	{
+		for (size_t lane = 0; lane < kSamplingKernelsSumLanes; lane++)
+		{
+			terms[lane] = (i + lane < count) ? values[i + lane] * weights[i + lane] : 0.0;
+		}
+
+		KERNEL_VARIANT(addCompensatedLanes)(partialSums, compensations, terms);
+	}
+
+	return KERNEL_VARIANT(reduceCompensatedLanes)(partialSums, compensations);
+}
+
+/*
+ *	As `sumCompensated`, for the squared deviations from `mean`.
+ */
+static double
+KERNEL_VARIANT(sumSquaredDeviations)(const double *  values, size_t count, double mean)
+{
+	double	partialSums[kSamplingKernelsSumLanes] = {0};
+	double	compensations[kSamplingKernelsSumLanes] = {0};
+	double	terms[kSamplingKernelsSumLanes];
+	size_t	i = 0;
+
+	for (; i < count; i += kSamplingKernelsSumLanes)
+	{
+		for (size_t lane = 0; lane < kSamplingKernelsSumLanes; lane++)
+		{
+			double	deviation = (i + lane < count) ? values[i + lane] - mean : 0.0;
+
+			terms[lane] = deviation * deviation;
+		}
+
+		KERNEL_VARIANT(addCompensatedLanes)(partialSums, compensations, terms);
+	}
+
+	return KERNEL_VARIANT(reduceCompensatedLanes)(partialSums, compensations);
+}
+
+/*
+ *	As `sum`, for the logarithms of the shifted values.
+ */
+static double
+KERNEL_VARIANT(sumLogarithms)(const double *  values, size_t count, double shift)
+{
+	double	partialSums[kSamplingKernelsSumLanes] = {0};
+	double	sum = 0.0;
+	size_t	i = 0;
+
+	for (; i + kSamplingKernelsSumLanes <= count; i += kSamplingKernelsSumLanes)
+	{
+		for (size_t lane = 0; lane < kSamplingKernelsSumLanes; lane++)
+		{
+			partialSums[lane] += KERNEL_VARIANT(logarithm)(values[i + lane] + shift);
+		}
+	}
+
+	for (size_t width = kSamplingKernelsSumLanes / 2; width > 0; width /= 2)
+	{
+		for (size_t lane = 0; lane < width; lane++)
+		{
+			partialSums[lane] += partialSums[lane + width];
+		}
+	}
+
+	sum = partialSums[0];
+	for (; i < count; i++)
+	{
+		sum += KERNEL_VARIANT(logarithm)(values[i] + shift);
+	}
+
+	return sum;
+}
+
+/*
+ *	As `dot`, with the condition as a 0.0 or 1.0 factor so that the loop
+ *	vectorizes.
+ */
+static double
+KERNEL_VARIANT(dotAboveThresholds)(
+	const double *	values,
+	const double *	thresholds,
+	const double *	weights,
+	size_t		count,
+	double *	weightSum)
+{
+	double	partialSums[kSamplingKernelsSumLanes] = {0};
+	double	partialWeightSums[kSamplingKernelsSumLanes] = {0};
+	double	sum = 0.0;
+	size_t	i = 0;
+
+	for (; i + kSamplingKernelsSumLanes <= count; i += kSamplingKernelsSumLanes)
+	{
+		for (size_t lane = 0; lane < kSamplingKernelsSumLanes; lane++)
+		{
+			double	weight = (double)(values[i + lane] >= thresholds[i + lane]) * weights[i + lane];
+
+			partialSums[lane] += values[i + lane] * weight;
+			partialWeightSums[lane] += weight;
+		}
+	}
+
+	for (size_t width = kSamplingKernelsSumLanes / 2; width > 0; width /= 2)
+	{
+		for (size_t lane = 0; lane < width; lane++)
+		{
+			partialSums[lane] += partialSums[lane + width];
+			partialWeightSums[lane] += partialWeightSums[lane + width];
+		}
+	}
+
+	sum = partialSums[0];
+	*weightSum = partialWeightSums[0];
+	for (; i < count; i++)
+	{
+		double	weight = (double)(values[i] >= thresholds[i]) * weights[i];
+
+		sum += values[i] * weight;
+		*weightSum += weight;
+	}
+
+	return sum;
+}
+
+/*
+ *	Computes a tile of at most `kSamplingKernelsMatrixTileRows` rows and
+ *	`kSamplingKernelsSumLanes` columns of `output`, starting at row `r0` and
+ *	column `c0`, accumulating over the rows `k <= c` of `upper` that are not
+ *	zero. Full tiles keep their accumulators in vector registers, so that
+ *	each row of `upper` is loaded once per tile and `output` is stored once.
+ */
+static inline void
+KERNEL_VARIANT(multiplyUpperTriangularTile)(
+	double *		output,
+	const double *		input,
+	size_t			r0,
+	size_t			rowCount,
+	const double *		upper,
+	size_t			order,
+	size_t			c0)
+{
+	double	accumulators[kSamplingKernelsMatrixTileRows][kSamplingKernelsSumLanes] = {{0}};
+	size_t	columnCount = (c0 + kSamplingKernelsSumLanes <= order) ? kSamplingKernelsSumLanes : order - c0;
+	size_t	innerEnd = c0 + columnCount;
+
+	if ((rowCount == kSamplingKernelsMatrixTileRows) && (columnCount == kSamplingKernelsSumLanes))
+	{
+		for (size_t k = 0; k < innerEnd; k++)
+		{
+			const double *	upperRow = upper + k * order + c0;
+
+			for (size_t row = 0; row < kSamplingKernelsMatrixTileRows; row++)
+			{
+				double	value = input[(r0 + row) * order + k];
+
+				/*
+				 *	Without this, GCC unrolls the lanes and vectorizes
+				 *	along `k` instead, with strided loads of `upper`.
+				 */
+				#pragma GCC unroll 1
+				for (size_t lane = 0; lane < kSamplingKernelsSumLanes; lane++)
+				{
+					accumulators[row][lane] += value * upperRow[lane];
+				}
+			}
+		}
+	}
+	else
+	{
+		for (size_t k = 0; k < innerEnd; k++)
+		{
+			const double *	upperRow = upper + k * order + c0;
+
+			for (size_t row = 0; row < rowCount; row++)
+			{
+				double	value = input[(r0 + row) * order + k];
+
+				for (size_t lane = 0; lane < columnCount; lane++)
+				{
+					accumulators[row][lane] += value * upperRow[lane];
+				}
+			}
+		}
+	}
+
+	for (size_t row = 0; row < rowCount; row++)
+	{
+		memcpy(output + (r0 + row) * order + c0, accumulators[row], columnCount * sizeof(double));
+	}
+
+	return;
+}
+
+/*
+ *	The tiles of a column block reuse the same `kSamplingKernelsSumLanes`
+ *	columns of `upper`, so column blocks are the outer loop.
+ */
+static void
+KERNEL_VARIANT(multiplyUpperTriangular)(
+	double *		output,
+	const double *		input,
+	size_t			rows,
+	const double *		upper,
+	size_t			order)
+{
+	for (size_t c0 = 0; c0 < order; c0 += kSamplingKernelsSumLanes)
+	{
+		for (size_t r0 = 0; r0 < rows; r0 += kSamplingKernelsMatrixTileRows)
+		{
+			KERNEL_VARIANT(multiplyUpperTriangularTile)(
+				output,
+				input,
+				r0,
+				(r0 + kSamplingKernelsMatrixTileRows <= rows) ? kSamplingKernelsMatrixTileRows : rows - r0,
+				upper,
+				order,
+				c0);
+		}
+	}
+
+	return;
+}
+
+/*
+ *	Branch-free, so that the lanes vectorize: conditions are 0.0 or 1.0
+ *	factors, all evaluated before they are combined (GCC does not if-convert
+ *	the loop otherwise), and the sums use `kSamplingKernelsSumLanes` partial
+ *	sums as `sum`.
+ */
+static void
+KERNEL_VARIANT(sumFundYear)(
+	FundYearSums *			sums,
+	const double *			entryYears,
+	const double *			exitYears,
+	const double *			capital,
+	const double *			values,
+	size_t				count,
+	const FundYearConstants *	constants)
+{
+	double	t = constants->year;
+	double	followOnDelay = constants->followOnDelayYears;
+	double	fundLife = constants->fundLifeYears;
+	double	followOnFraction = constants->followOnFraction;
+	double	initialFraction = 1.0 - followOnFraction;
+	double	paidIn[kSamplingKernelsSumLanes] = {0};
+	double	distributed[kSamplingKernelsSumLanes] = {0};
+	double	netAssetValue[kSamplingKernelsSumLanes] = {0};
+	size_t	numberOfBlocks = (count + kSamplingKernelsSumLanes - 1) / kSamplingKernelsSumLanes;
+
+	for (size_t block = 0; block < numberOfBlocks; block++)
+	{
+		size_t	first = block * kSamplingKernelsSumLanes;
+		size_t	laneCount = (first + kSamplingKernelsSumLanes <= count) ? kSamplingKernelsSumLanes : count - first;
+
+		for (size_t lane = 0; lane < laneCount; lane++)
+		{
+			size_t	i = first + lane;
+			double	entryYear = entryYears[i];
+			double	exitYear = exitYears[i];
+			double	followOnYear = entryYear + followOnDelay;
+			double	isEntered = (double)(entryYear <= t);
+			double	isExited = (double)(exitYear <= t);
+			double	isFollowOnDue = (double)(followOnYear <= t);
+			double	isFollowOnBeforeExit = (double)(followOnYear < exitYear);
+			double	isFollowOnInFundLife = (double)(followOnYear < fundLife);
+			double	isFollowOnMade = isFollowOnBeforeExit * isFollowOnInFundLife;
+			double	investedFraction = initialFraction + followOnFraction * isFollowOnMade * isFollowOnDue;
+			double	finalFraction = initialFraction + followOnFraction * isFollowOnMade;
+			double	progress = (t - entryYear) / (exitYear - entryYear);
+
+			paidIn[lane] += isEntered * investedFraction * capital[i];
+			distributed[lane] += isExited * finalFraction * values[i];
+			netAssetValue[lane] += isEntered * (1.0 - isExited) * investedFraction * (capital[i] + (values[i] - capital[i]) * progress);
+		}
+	}
+
+	for (size_t width = kSamplingKernelsSumLanes / 2; width > 0; width /= 2)
+	{
+		for (size_t lane = 0; lane < width; lane++)
+		{
+			paidIn[lane] += paidIn[lane + width];
+			distributed[lane] += distributed[lane + width];
+			netAssetValue[lane] += netAssetValue[lane + width];
+		}
+	}
+
+	sums->paidIn = paidIn[0];
+	sums->distributed = distributed[0];
+	sums->netAssetValue = netAssetValue[0];
+
+	return;
+}
+
+static void
+KERNEL_VARIANT(carriedInterest)(double *  values, size_t count, const CarriedInterestConstants *  constants)
+{
+	double	hurdleMultiple = constants->hurdleMultiple;
+	double	catchUpWidth = constants->catchUpEndMultiple - constants->hurdleMultiple;
+	double	catchUpShare = constants->catchUpShare;
+	double	carryShare = constants->carryShare;
+
+	for (size_t j = 0; j < count; j++)
+	{
+		double	aboveHurdle = values[j] - hurdleMultiple;
+		double	inCatchUp;
+
+		aboveHurdle = (aboveHurdle > 0.0) ? aboveHurdle : 0.0;
+		inCatchUp = (aboveHurdle < catchUpWidth) ? aboveHurdle : catchUpWidth;
+		values[j] = catchUpShare * inCatchUp + carryShare * (aboveHurdle - inCatchUp);
+	}
+
+	return;
+}
+
+static const SamplingKernels	KERNEL_VARIANT(kSamplingKernels) =
+{
+	.name				= KERNEL_VARIANT_NAME,
+	.sampleBoundedPareto		= KERNEL_VARIANT(sampleBoundedPareto),
+	.sampleBoundedParetoArrays	= KERNEL_VARIANT(sampleBoundedParetoArrays),
+	.sampleBoundedParetoTable	= KERNEL_VARIANT(sampleBoundedParetoTable),
+	.sampleAlias			= KERNEL_VARIANT(sampleAlias),
+	.sampleBoundedParetoFloat	= KERNEL_VARIANT(sampleBoundedParetoFloat),
+	.transformBoundedPareto		= KERNEL_VARIANT(transformBoundedPareto),
+	.transformBoundedParetoArrays	= KERNEL_VARIANT(transformBoundedParetoArrays),
+	.sampleUniforms			= KERNEL_VARIANT(sampleUniforms),
+	.sampleStandardNormals		= KERNEL_VARIANT(sampleStandardNormals),
+	.sampleLognormals		= KERNEL_VARIANT(sampleLognormals),
+	.standardNormalCdf		= KERNEL_VARIANT(standardNormalCdf),
+	.sum				= KERNEL_VARIANT(sum),
+	.sumFloats			= KERNEL_VARIANT(sumFloats),
+	.sumFloatsCompensated		= KERNEL_VARIANT(sumFloatsCompensated),
+	.dot				= KERNEL_VARIANT(dot),
+	.sumCompensated			= KERNEL_VARIANT(sumCompensated),
+	.dotCompensated			= KERNEL_VARIANT(dotCompensated),
+	.sumSquaredDeviations		= KERNEL_VARIANT(sumSquaredDeviations),
+	.sumLogarithms			= KERNEL_VARIANT(sumLogarithms),
+	.dotAboveThresholds		= KERNEL_VARIANT(dotAboveThresholds),
+	.multiplyUpperTriangular	= KERNEL_VARIANT(multiplyUpperTriangular),
+	.sumFundYear			= KERNEL_VARIANT(sumFundYear),
+	.carriedInterest		= KERNEL_VARIANT(carriedInterest),
+};
@@ -0,0 +1,290 @@
+/*
+ *	Copyright (c) 2024, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#include <math.h>
+#include <string.h>
+#include <stdint.h>
+#if defined(MOONFIRE_NATIVE)
+#include <pthread.h>
+#endif
+#include "kernels.h"
+
+
+static const uint64_t	kSamplingKernelsStreamIncrement		= 0x9E3779B97F4A7C15ULL;
+static const uint64_t	kSamplingKernelsMixMultiplier1		= 0xBF58476D1CE4E5B9ULL;
+static const uint64_t	kSamplingKernelsMixMultiplier2		= 0x94D049BB133111EBULL;
+static const uint64_t	kSamplingKernelsExponentOfOne		= 0x3FF0000000000000ULL;
+static const uint64_t	kSamplingKernelsExponentOfTwoToThe52	= 0x4330000000000000ULL;
+static const uint64_t	kSamplingKernelsMantissaMask		= 0x000FFFFFFFFFFFFFULL;
+static const uint64_t	kSamplingKernelsExponentBias		= 1023;
+static const double	kSamplingKernelsOneMinusHalfUlp		= 1.0 - 0x1.0p-53;
+static const double	kSamplingKernelsTwoToThe52PlusBias	= 0x1.0p52 + 1023.0;
+static const double	kSamplingKernelsRoundingShift		= 0x1.8p52;
+static const double	kSamplingKernelsLn2High			= 6.93147180369123816490e-01;
+static const double	kSamplingKernelsLn2Low			= 1.90821492927058770002e-10;
+static const uint64_t	kSamplingKernelsInverseSqrtMagic	= 0x5FE6EB50C7B537A9ULL;
+static const uint32_t	kSamplingKernelsFloatExponentOfOne	= 0x3F800000U;
+static const uint32_t	kSamplingKernelsFloatExponentOfTwoToThe23	= 0x4B000000U;
+static const uint32_t	kSamplingKernelsFloatMantissaMask	= 0x007FFFFFU;
+static const uint32_t	kSamplingKernelsFloatExponentBias	= 127;
+static const float	kSamplingKernelsFloatOneMinusHalfUlp	= 1.0f - 0x1.0p-24f;
+static const float	kSamplingKernelsFloatTwoToThe23PlusBias	= 0x1.0p23f + 127.0f;
+static const float	kSamplingKernelsFloatRoundingShift	= 0x1.8p23f;
+static const float	kSamplingKernelsFloatLn2High		= 6.93145751953125e-01f;
+static const float	kSamplingKernelsFloatLn2Low		= 1.42860682030941723212e-06f;
+
+enum
+{
+	kSamplingKernelsSumLanes	= 8,
+	kSamplingKernelsFloatSumLanes	= 16,
+	kSamplingKernelsMatrixTileRows	= 4,
+};
+
+/*
+ *	Portable variant, compiled for the baseline instruction set of the target.
+ */
+#define KERNEL_VARIANT(name)	name##Generic
+#define KERNEL_VARIANT_NAME	"generic"
+#include "kernels-template.h"
+#undef KERNEL_VARIANT
+#undef KERNEL_VARIANT_NAME
+
+/*
+ *	x86-64 variants. `#pragma GCC target` is GCC-specific, so other compilers
+ *	only get the portable variant.
+ */
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__)
+#define kSamplingKernelsHaveX86Variants
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#define KERNEL_VARIANT(name)	name##Avx2
+#define KERNEL_VARIANT_NAME	"avx2"
+#include "kernels-template.h"
+#undef KERNEL_VARIANT
+#undef KERNEL_VARIANT_NAME
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512dq,avx512vl,avx2,fma")
+#define KERNEL_VARIANT(name)	name##Avx512
+#define KERNEL_VARIANT_NAME	"avx512"
+#include "kernels-template.h"
+#undef KERNEL_VARIANT
+#undef KERNEL_VARIANT_NAME
+#pragma GCC pop_options
+#endif
+
+BoundedParetoConstants
+computeBoundedParetoConstants(double alpha, double lowerBound, double upperBound, double shift, double scale)
+{
+	return (BoundedParetoConstants)
+	{
+		.lowerBound			= lowerBound,
+		.oneMinusBoundRatioToAlpha	= 1.0 - pow(lowerBound / upperBound, alpha),
+		.negativeInverseAlpha		= -1.0 / alpha,
+		.shift				= shift,
+		.scale				= scale,
+	};
+}
+
+void
+computeBoundedParetoTable(const BoundedParetoConstants *  constants, BoundedParetoTable *  table)
+{
+	double	p = constants->negativeInverseAlpha;
+	double	largestD = 0.5 / kBoundedParetoTableMantissaEntries;
+	double	smallestBase = 1.0 - kSamplingKernelsOneMinusHalfUlp * constants->oneMinusBoundRatioToAlpha;
+	int	lowestExponent = ilogb(smallestBase) - 1;
+
+	if (lowestExponent <= -kBoundedParetoTableExponentEntries)
+	{
+		lowestExponent = 1 - kBoundedParetoTableExponentEntries;
+	}
+
+	table->oneMinusBoundRatioToAlpha = constants->oneMinusBoundRatioToAlpha;
+	table->shiftTimesScale = constants->shift * constants->scale;
+	table->seriesCoefficients[0] = p;
+	table->seriesCoefficients[1] = p * (p - 1.0) / 2.0;
+	table->seriesCoefficients[2] = p * (p - 1.0) * (p - 2.0) / 6.0;
+	table->lowestExponent = lowestExponent;
+
+	/*
+	 *	Lagrange remainder of the series, `binomial(p, 4) * d^4 * (1 + t)^(p - 4)`
+	 *	for some `t` between 0 and `d`, and eight ulp for the rounding of the
+	 *	entries and of the evaluation.
+	 */
+	table->maximumRelativeError = fabs(p * (p - 1.0) * (p - 2.0) * (p - 3.0) / 24.0) * pow(largestD, 4.0) * pow(1.0 - largestD, p - 4.0) +
+					8.0 * 0x1.0p-53;
+
+	for (int i = 0; i < kBoundedParetoTableExponentEntries; i++)
+	{
+		table->powersOfTwo[i] = constants->lowerBound * constants->scale * exp2((double) (lowestExponent + i) * p);
+	}
+
+	for (int i = 0; i < kBoundedParetoTableMantissaEntries; i++)
+	{
+		double	midpoint = 1.0 + (i + 0.5) / kBoundedParetoTableMantissaEntries;
+
+		table->powersOfMidpoints[i] = pow(midpoint, p);
+		table->inverseMidpoints[i] = 1.0 / midpoint;
+	}
+
+	return;
+}
+
+void
+computeAliasTable(const double *  weights, size_t count, size_t *  workspace, AliasTable *  table)
+{
+	double	totalWeight = 0.0;
+	size_t	numberOfSmall = 0;
+	size_t	numberOfLarge = 0;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		totalWeight += weights[i];
+	}
+
+	/*
+	 *	`thresholds` first holds the probabilities scaled by `count`, so that
+	 *	each column holds 1. Columns below 1 are stacked from the front of
+	 *	`workspace` and columns of at least 1 from its back: every column is
+	 *	on one of the stacks, so they never overlap.
+	 */
+	for (size_t i = 0; i < count; i++)
+	{
+		table->thresholds[i] = weights[i] * (double) count / totalWeight;
+		table->aliasValues[i] = table->values[i];
+
+		if (table->thresholds[i] < 1.0)
+		{
+			workspace[numberOfSmall++] = i;
+		}
+		else
+		{
+			workspace[count - 1 - numberOfLarge++] = i;
+		}
+	}
+
+	/*
+	 *	Each small column is filled by a large column, which keeps the rest
+	 *	of its probability and moves to the small stack if it drops below 1.
+	 *	The columns left on either stack hold 1 up to rounding.
+	 */
+	while ((numberOfSmall > 0) && (numberOfLarge > 0))
+	{
+		size_t	small = workspace[--numberOfSmall];
+		size_t	large = workspace[count - numberOfLarge--];
+
+		table->aliasValues[small] = table->values[large];
+		table->thresholds[large] = (table->thresholds[large] + table->thresholds[small]) - 1.0;
+
+		if (table->thresholds[large] < 1.0)
+		{
+			workspace[numberOfSmall++] = large;
+		}
+		else
+		{
+			workspace[count - 1 - numberOfLarge++] = large;
+		}
+	}
+
+	while (numberOfSmall > 0)
+	{
+		table->thresholds[workspace[--numberOfSmall]] = 1.0;
+	}
+
+	while (numberOfLarge > 0)
+	{
+		table->thresholds[workspace[count - numberOfLarge--]] = 1.0;
+	}
+
+	table->numberOfOutcomes = count;
+
+	return;
+}
+
+uint64_t
+deriveStreamKey(uint64_t seed)
+{
+	uint64_t	z = seed + kSamplingKernelsStreamIncrement;
+
+	z = (z ^ (z >> 30)) * kSamplingKernelsMixMultiplier1;
+	z = (z ^ (z >> 27)) * kSamplingKernelsMixMultiplier2;
+
+	return z ^ (z >> 31);
+}
+
+double
+uniformFromCounter(uint64_t key, uint64_t counter)
+{
+	return uniformGeneric(key, counter);
+}
+
+static const SamplingKernels *	selectedKernels = NULL;
+
+/**
+ *	@brief	Select the fastest variant of the kernels supported by the executing CPU.
+ */
+static void
+initializeSelectedKernels(void)
+{
+	const SamplingKernels *	kernels = &kSamplingKernelsGeneric;
+
+#if defined(kSamplingKernelsHaveX86Variants)
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl"))
+	{
+		kernels = &kSamplingKernelsAvx512;
+	}
+	else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+	{
+		kernels = &kSamplingKernelsAvx2;
+	}
+#endif
+
+	selectedKernels = kernels;
+
+	return;
+}
+
+const SamplingKernels *
+selectSamplingKernels(void)
+{
+	/*
+	 *	The variants do not round alike, and the workers of the sketch and of
+	 *	the sweep create their contexts concurrently, so the variant is
+	 *	selected once, and published complete, before any caller uses it.
+	 */
+#if defined(MOONFIRE_NATIVE)
+	static pthread_once_t	selectOnce = PTHREAD_ONCE_INIT;
+
+	pthread_once(&selectOnce, initializeSelectedKernels);
+#else
+	if (selectedKernels == NULL)
+	{
+		initializeSelectedKernels();
+	}
+#endif
+
+	return selectedKernels;
+}
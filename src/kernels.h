@@ -0,0 +1,413 @@
+/*
+ *	Copyright (c) 2024, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+
+/*
+ *	Constants of the inverse CDF of an investment return distributed as
+ *	`(BoundedPareto(alpha, lowerBound, upperBound) - shift) * scale`. The
+ *	inverse CDF of the bounded Pareto distribution is
+ *
+ *		Q(u) = lowerBound * (1 - u * (1 - (lowerBound / upperBound)^alpha))^(-1 / alpha).
+ */
+typedef struct
+{
+	double	lowerBound;
+	double	oneMinusBoundRatioToAlpha;
+	double	negativeInverseAlpha;
+	double	shift;
+	double	scale;
+} BoundedParetoConstants;
+
+enum
+{
+	kBoundedParetoTableMantissaBits		= 10,
+	kBoundedParetoTableMantissaEntries	= 1 << kBoundedParetoTableMantissaBits,
+	kBoundedParetoTableExponentEntries	= 64,
+};
+
+/*
+ *	Lookup table of the inverse CDF of fixed `BoundedParetoConstants` (see
+ *	`computeBoundedParetoTable()`), which replaces the logarithm and the
+ *	exponential of each draw by two table loads and a cubic. With
+ *
+ *		1 - u * oneMinusBoundRatioToAlpha = 2^e * m,	m in [1, 2),
+ *
+ *	the quantile is `lowerBound * 2^(e * p) * m^p` with `p = -1 / alpha`.
+ *	`powersOfTwo` holds `lowerBound * scale * 2^(e * p)` for every exponent
+ *	`e` of the base from `lowestExponent`, and `powersOfMidpoints` and
+ *	`inverseMidpoints` hold `m0^p` and `1 / m0` at the midpoint `m0` of each
+ *	of the `kBoundedParetoTableMantissaEntries` intervals of the mantissa.
+ *	`(m / m0)^p = (1 + d)^p`, with `|d| <= 2^-11`, is its binomial series to
+ *	`d^3`. The draws close to `xMax` have the smallest exponents of the base,
+ *	each with its own exact entry, so the relative error is the same over the
+ *	whole range: the truncation of the series, at most
+ *	`|binomial(p, 4)| * 2^-44`, and a few ulp of rounding, together
+ *	`maximumRelativeError`.
+ */
+typedef struct
+{
+	double	oneMinusBoundRatioToAlpha;
+	double	shiftTimesScale;
+	double	seriesCoefficients[3];
+	int64_t	lowestExponent;
+	double	maximumRelativeError;
+	double	powersOfTwo[kBoundedParetoTableExponentEntries];
+	double	powersOfMidpoints[kBoundedParetoTableMantissaEntries];
+	double	inverseMidpoints[kBoundedParetoTableMantissaEntries];
+} BoundedParetoTable;
+
+/*
+ *	Alias table of a discrete distribution of investment returns (Walker's
+ *	alias method, see `computeAliasTable()`). A draw scales its uniform
+ *	variate `u` to `u * numberOfOutcomes`, whose integer part `k` picks a
+ *	column and whose fraction picks `values[k]` if it is below
+ *	`thresholds[k]`, else `aliasValues[k]`, the value of the outcome that
+ *	fills the rest of column `k`.
+ */
+typedef struct
+{
+	size_t		numberOfOutcomes;
+	double *	values;
+	double *	thresholds;
+	double *	aliasValues;
+} AliasTable;
+
+/*
+ *	Per-investment `BoundedParetoConstants` in structure-of-arrays layout, so
+ *	that sampling a heterogeneous portfolio loads each constant with
+ *	contiguous vector loads.
+ */
+typedef struct
+{
+	double *	lowerBound;
+	double *	oneMinusBoundRatioToAlpha;
+	double *	negativeInverseAlpha;
+	double *	shift;
+	double *	scale;
+} BoundedParetoConstantArrays;
+
+/*
+ *	Year of a fund timeline (see `sumFundYear`).
+ */
+typedef struct
+{
+	double	year;
+	double	followOnDelayYears;
+	double	fundLifeYears;
+	double	followOnFraction;
+} FundYearConstants;
+
+/*
+ *	Totals over the investments of a fund in a year, in units of capital.
+ */
+typedef struct
+{
+	double	paidIn;
+	double	distributed;
+	double	netAssetValue;
+} FundYearSums;
+
+/*
+ *	Carried interest of a distribution waterfall, in multiples of paid-in
+ *	capital (see `carriedInterest`).
+ */
+typedef struct
+{
+	double	hurdleMultiple;
+	double	catchUpEndMultiple;
+	double	catchUpShare;
+	double	carryShare;
+} CarriedInterestConstants;
+
+typedef struct
+{
+	/*
+	 *	Name of the instruction-set variant, e.g., "avx2".
+	 */
+	const char *	name;
+
+	/*
+	 *	Writes `count` investment return samples to `output`. Sample `j` uses
+	 *	the uniform variate at position `counter + j` of the random stream
+	 *	identified by `key` (see `uniformFromCounter()`).
+	 */
+	void		(*sampleBoundedPareto)(
+				double *				output,
+				size_t					count,
+				const BoundedParetoConstants *		constants,
+				uint64_t				key,
+				uint64_t				counter);
+
+	/*
+	 *	As `sampleBoundedPareto`, with the constants of sample `j` at index `j`
+	 *	of `constants`.
+	 */
+	void		(*sampleBoundedParetoArrays)(
+				double *				output,
+				size_t					count,
+				const BoundedParetoConstantArrays *	constants,
+				uint64_t				key,
+				uint64_t				counter);
+
+	/*
+	 *	As `sampleBoundedPareto`, with the inverse CDF looked up in `table`.
+	 *	Sample `j` uses the same uniform variate as `sampleBoundedPareto`.
+	 */
+	void		(*sampleBoundedParetoTable)(
+				double *				output,
+				size_t					count,
+				const BoundedParetoTable *		table,
+				uint64_t				key,
+				uint64_t				counter);
+
+	/*
+	 *	Writes draws of the discrete distribution of `table` to `output`, in
+	 *	constant time per draw. Sample `j` uses the same uniform variate as
+	 *	`sampleBoundedPareto`.
+	 */
+	void		(*sampleAlias)(
+				double *				output,
+				size_t					count,
+				const AliasTable *			table,
+				uint64_t				key,
+				uint64_t				counter);
+
+	/*
+	 *	As `sampleBoundedPareto`, in single precision, with twice the vector
+	 *	lanes: sample `j` uses the uniform variate of `sampleBoundedPareto`
+	 *	rounded down to a multiple of 2^-23, and the inverse CDF is evaluated
+	 *	in float with a relative error of a few float ulp, except that the
+	 *	rounding of `1 - u * oneMinusBoundRatioToAlpha` is amplified near the
+	 *	upper bound (see `MoonfirePrecision`).
+	 */
+	void		(*sampleBoundedParetoFloat)(
+				float *					output,
+				size_t					count,
+				const BoundedParetoConstants *		constants,
+				uint64_t				key,
+				uint64_t				counter);
+
+	/*
+	 *	As `sampleBoundedPareto` and `sampleBoundedParetoArrays`, with the
+	 *	uniform variates given in `values` instead of drawn from a random
+	 *	stream. The samples overwrite the variates.
+	 */
+	void		(*transformBoundedPareto)(
+				double *				values,
+				size_t					count,
+				const BoundedParetoConstants *		constants);
+	void		(*transformBoundedParetoArrays)(
+				double *				values,
+				size_t					count,
+				const BoundedParetoConstantArrays *	constants);
+
+	/*
+	 *	Writes the uniform variates at positions `counter` to
+	 *	`counter + count - 1` of the stream `key` to `output`.
+	 */
+	void		(*sampleUniforms)(double *  output, size_t count, uint64_t key, uint64_t counter);
+
+	/*
+	 *	Writes `count` standard normal variates to `output`, by the Box-Muller
+	 *	transform. Variate `j` uses the uniform variates at positions
+	 *	`2 * (counter + j)` and `2 * (counter + j) + 1` of the stream `key`.
+	 */
+	void		(*sampleStandardNormals)(double *  output, size_t count, uint64_t key, uint64_t counter);
+
+	/*
+	 *	Writes `count` lognormal variates `exp(mu + sigma * Z)` to `output`,
+	 *	with `Z` the standard normal variates of `sampleStandardNormals`.
+	 *	`mu + sigma * Z` must lie in [-708, 709] for all `Z` in (-9, 9).
+	 */
+	void		(*sampleLognormals)(double *  output, size_t count, double mu, double sigma, uint64_t key, uint64_t counter);
+
+	/*
+	 *	Replaces each of the `count` elements of `values`, which must lie in
+	 *	(-37, 37), by its standard normal CDF, with a relative error below
+	 *	1.2e-7 for CDF values above 1e-9 and an absolute error below 1e-16
+	 *	otherwise (below the resolution of the uniform variates).
+	 */
+	void		(*standardNormalCdf)(double *  values, size_t count);
+
+	/*
+	 *	Returns the sum of the `count` elements of `values`.
+	 */
+	double		(*sum)(const double *  values, size_t count);
+
+	/*
+	 *	Return the sum of the `count` elements of `values` of single
+	 *	precision: `sumFloats` accumulates them in double, and
+	 *	`sumFloatsCompensated` in float with compensated (Kahan) partial sums,
+	 *	with twice the vector lanes and an error of a few float ulp of the
+	 *	sum of their magnitudes.
+	 */
+	double		(*sumFloats)(const float *  values, size_t count);
+	double		(*sumFloatsCompensated)(const float *  values, size_t count);
+
+	/*
+	 *	Returns the sum of the `count` products `values[i] * weights[i]`.
+	 */
+	double		(*dot)(const double *  values, const double *  weights, size_t count);
+
+	/*
+	 *	As `sum` and `dot`, with the rounding error of each of the partial
+	 *	sums compensated (Kahan-Neumaier), and the partial sums combined
+	 *	pairwise. The error is a few ulp of the sum of the magnitudes for any
+	 *	`count`, and the result depends only on the values and their order.
+	 *	The compensation relies on the order of the additions, so the
+	 *	kernels must not be compiled with `-ffast-math`.
+	 */
+	double		(*sumCompensated)(const double *  values, size_t count);
+	double		(*dotCompensated)(const double *  values, const double *  weights, size_t count);
+
+	/*
+	 *	Returns the sum of the `count` squared deviations
+	 *	`(values[i] - mean)^2`, compensated as `sumCompensated`.
+	 */
+	double		(*sumSquaredDeviations)(const double *  values, size_t count, double mean);
+
+	/*
+	 *	Returns the sum of the `count` logarithms `log(values[i] + shift)`.
+	 *	All `values[i] + shift` must be positive normal doubles.
+	 */
+	double		(*sumLogarithms)(const double *  values, size_t count, double shift);
+
+	/*
+	 *	Returns the sum of the products `values[i] * weights[i]` over the
+	 *	elements with `values[i] >= thresholds[i]`, and stores the sum of
+	 *	their weights in `weightSum`.
+	 */
+	double		(*dotAboveThresholds)(
+				const double *		values,
+				const double *		thresholds,
+				const double *		weights,
+				size_t			count,
+				double *		weightSum);
+
+	/*
+	 *	Computes `output = input * upper` for a `rows` x `order` matrix `input`
+	 *	and an upper-triangular `order` x `order` matrix `upper`, all in
+	 *	row-major order. Elements of `upper` below the diagonal must be zero.
+	 */
+	void		(*multiplyUpperTriangular)(
+				double *		output,
+				const double *		input,
+				size_t			rows,
+				const double *		upper,
+				size_t			order);
+
+	/*
+	 *	Sums the paid-in capital, distributions and net asset value of the
+	 *	`count` investments of one iteration of a fund timeline in
+	 *	`constants->year`. Investment `i` enters in `entryYears[i]` with a
+	 *	fraction `1 - followOnFraction` of its capital `capital[i]`, makes
+	 *	its follow-on `followOnDelayYears` later if it has not exited and the
+	 *	fund life has not ended by then, and exits in `exitYears[i]` (at
+	 *	least one year after entry) with the value `values[i]` at full
+	 *	investment, scaled by its invested fraction. Unexited investments are
+	 *	marked linearly from cost at entry to their value at exit.
+	 */
+	void		(*sumFundYear)(
+				FundYearSums *			sums,
+				const double *			entryYears,
+				const double *			exitYears,
+				const double *			capital,
+				const double *			values,
+				size_t				count,
+				const FundYearConstants *	constants);
+
+	/*
+	 *	Replaces each of the `count` multiples of paid-in capital in `values`
+	 *	by the carried interest on it, per unit of paid-in capital: a share
+	 *	`catchUpShare` of the proceeds between `hurdleMultiple` and
+	 *	`catchUpEndMultiple`, plus a share `carryShare` of the proceeds above
+	 *	`catchUpEndMultiple`.
+	 */
+	void		(*carriedInterest)(double *  values, size_t count, const CarriedInterestConstants *  constants);
+} SamplingKernels;
+
+/**
+ *	@brief	Precompute the inverse-CDF constants of a shifted and scaled bounded Pareto distribution.
+ *
+ *	@param	alpha		: Shape parameter of the bounded Pareto distribution.
+ *	@param	lowerBound	: Lower bound of the bounded Pareto distribution.
+ *	@param	upperBound	: Upper bound of the bounded Pareto distribution.
+ *	@param	shift		: Value subtracted from each sample.
+ *	@param	scale		: Value each shifted sample is multiplied by.
+ *	@return			: The precomputed constants.
+ */
+BoundedParetoConstants	computeBoundedParetoConstants(double alpha, double lowerBound, double upperBound, double shift, double scale);
+
+/**
+ *	@brief	Build the inverse-CDF lookup table of bounded Pareto constants (see
+ *		`BoundedParetoTable`). The uniform variates are at least 2^-53 from
+ *		1, so the base of the inverse CDF is at least about 2^-53 and its
+ *		exponents always fit the table.
+ *
+ *	@param	constants	: The inverse-CDF constants.
+ *	@param	table		: Pointer to the table to build.
+ */
+void			computeBoundedParetoTable(const BoundedParetoConstants *  constants, BoundedParetoTable *  table);
+
+/**
+ *	@brief	Build the alias table of a discrete distribution with Vose's method
+ *		(see `AliasTable`). `table->values` must hold the value of each
+ *		outcome, and its arrays must have `count` elements.
+ *
+ *	@param	weights		: Relative probability of each outcome, at least 0, with a positive sum.
+ *	@param	count		: Number of outcomes.
+ *	@param	workspace	: Workspace of `count` indices.
+ *	@param	table		: Pointer to the table to build.
+ */
+void			computeAliasTable(const double *  weights, size_t count, size_t *  workspace, AliasTable *  table);
+
+/**
+ *	@brief	Derive the key of a random stream from a user-provided seed.
+ *
+ *	@param	seed	: The seed.
+ *	@return		: The stream key.
+ */
+uint64_t		deriveStreamKey(uint64_t seed);
+
+/**
+ *	@brief	Counter-based uniform variate in (0, 1). The same `(key, counter)` always
+ *		yields the same variate, which makes the random streams independent of
+ *		how iterations are split between kernels calls, threads or processes.
+ *
+ *	@param	key	: Stream key (see `deriveStreamKey()`).
+ *	@param	counter	: Position in the stream.
+ *	@return		: Uniform variate in (0, 1).
+ */
+double			uniformFromCounter(uint64_t key, uint64_t counter);
+
+/**
+ *	@brief	Select the fastest sampling kernels supported by the executing CPU. The
+ *		selection uses cpuid and is performed once, on the first call, also when
+ *		threads make their first calls concurrently.
+ *
+ *	@return		: Pointer to the selected kernels.
+ */
+const SamplingKernels *	selectSamplingKernels(void);
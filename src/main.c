@@ -20,80 +20,908 @@
  *	SOFTWARE.
  */
 
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <math.h>
+#include <string.h>
 #include <time.h>
 #include <uxhw.h>
+#include "calibration.h"
+#include "moonfire.h"
+#include "optimizer.h"
+#include "portfolio.h"
+#include "sketch.h"
+#include "sweep.h"
+#include "topology.h"
 #include "utilities.h"
+#if defined(MOONFIRE_NATIVE)
+#include "cluster.h"
+#include "server.h"
+#endif
+
+
+/**
+ *	@brief	Translates the command-line arguments to model parameters.
+ *
+ *	@param	arguments	: Pointer to command-line arguments struct.
+ *	@param	parameters	: Pointer to struct to store the model parameters.
+ */
+static void
+setParametersFromCommandLineArguments(
+	const CommandLineArguments *	arguments,
+	MoonfireParameters *		parameters)
+{
+	*parameters = (MoonfireParameters)
+	{
+		.alpha				= arguments->alpha,
+		.xMin				= arguments->xMin,
+		.xMax				= arguments->xMax,
+		.numberOfInvestments		= arguments->numberOfInvestments,
+		.lowQuantileProbability		= arguments->lowQuantileProbability,
+		.highQuantileProbability	= arguments->highQuantileProbability,
+		.numberOfIterations		= arguments->common.numberOfMonteCarloIterations,
+		.seed				= arguments->seed,
+		.precision			= arguments->precision,
+		.sampler			= arguments->sampler,
+		.copula				= arguments->copula,
+		.marketCorrelation		= arguments->marketCorrelation,
+		.classCorrelation		= arguments->classCorrelation,
+		.degreesOfFreedom		= arguments->degreesOfFreedom,
+		.engine				= arguments->common.isMonteCarloMode ? kMoonfireEngineKernels : kMoonfireEngineUxHw,
+		.fundLifeYears			= arguments->fundLifeYears,
+		.deploymentYears		= arguments->deploymentYears,
+		.minimumHoldingYears		= arguments->minimumHoldingYears,
+		.maximumHoldingYears		= arguments->maximumHoldingYears,
+		.followOnFraction		= arguments->followOnFraction,
+		.followOnDelayYears		= arguments->followOnDelayYears,
+		.waterfall			= arguments->waterfall,
+		.managementFeeRate		= arguments->managementFeeRate,
+		.managementFeeYears		= arguments->managementFeeYears,
+		.carriedInterest		= arguments->carriedInterest,
+		.hurdleRate			= arguments->hurdleRate,
+		.hurdleYears			= arguments->hurdleYears,
+		.catchUp			= arguments->catchUp,
+		.numberOfReserveStrategies	= arguments->numberOfReserveStrategies,
+		.followOnThreshold		= arguments->followOnThreshold,
+		.followOnStepUp			= arguments->followOnStepUp,
+		.followOnSignalNoise		= arguments->followOnSignalNoise,
+		.iterationsPerParameterDraw	= arguments->iterationsPerParameterDraw,
+	};
+
+	memcpy(parameters->reserveRatios, arguments->reserveRatios, sizeof(parameters->reserveRatios));
+
+	/*
+	 *	A shard simulates its own range of the iterations of the random stream.
+	 */
+	moonfireGetIterationRange(
+		arguments->common.numberOfMonteCarloIterations,
+		arguments->numberOfShards,
+		arguments->shardIndex,
+		&parameters->firstIteration,
+		&parameters->numberOfIterations);
+
+	return;
+}
+
+/**
+ *	@brief	Print the decomposition of the variance of the portfolio return into
+ *		parameter uncertainty and investment outcomes.
+ *
+ *	@param	context		: The context, after simulating parameter draws.
+ */
+static void
+printParameterUncertainty(const MoonfireContext *  context)
+{
+	MoonfireParameterUncertainty	uncertainty;
+	double				totalVariance;
+
+	if (moonfireGetParameterUncertainty(context, &uncertainty) != kCommonConstantReturnTypeSuccess)
+	{
+		return;
+	}
+
+	totalVariance = uncertainty.betweenDrawVariance + uncertainty.withinDrawVariance;
+	printf(
+		"Over %zu outer draws of the parameters, parameter uncertainty accounts for a variance of %lf (%.1lf%%) of the portfolio return, "
+		"and investment outcomes for %lf.\n",
+		uncertainty.numberOfOuterDraws,
+		uncertainty.betweenDrawVariance,
+		(totalVariance > 0) ? 100.0 * uncertainty.betweenDrawVariance / totalVariance : 0.0,
+		uncertainty.withinDrawVariance);
+
+	return;
+}
+
+/**
+ *	@brief	Print the accuracy of a simulation in reduced precision or with the
+ *		table sampler against the same simulation in double precision with
+ *		the inverse CDF, which draws the same uniform variates, and the CPU
+ *		time of both.
+ *
+ *	@param	context			: The context, after simulating.
+ *	@param	parameters		: The model parameters.
+ *	@param	cpuTimeInSeconds	: CPU time of the simulation.
+ */
+static void
+printSamplingAccuracy(MoonfireContext *  context, const MoonfireParameters *  parameters, double cpuTimeInSeconds)
+{
+	const char *		name = (parameters->precision == kMoonfirePrecisionFloat) ? "Float" :
+					(parameters->precision == kMoonfirePrecisionMixed) ? "Mixed" : "Table";
+	MoonfireParameters	doubleParameters = *parameters;
+	MoonfireContext *	doubleContext;
+	MoonfireStatistics	statistics;
+	MoonfireStatistics	doubleStatistics;
+	const double *		samples;
+	const double *		doubleSamples;
+	size_t			numberOfSamples;
+	double			largestDifference = 0.0;
+	clock_t			start = clock();
+	double			doubleCpuTimeInSeconds;
+
+	doubleParameters.precision = kMoonfirePrecisionDouble;
+	doubleParameters.sampler = kMoonfireSamplerInverseCdf;
+	doubleContext = moonfireCreateContext(&doubleParameters);
+	if ((doubleContext == NULL) || (moonfireSimulate(doubleContext) != kCommonConstantReturnTypeSuccess))
+	{
+		moonfireDestroyContext(doubleContext);
+
+		return;
+	}
+	doubleCpuTimeInSeconds = ((double)(clock() - start)) / CLOCKS_PER_SEC;
+
+	samples = moonfireGetSamples(context, &numberOfSamples);
+	doubleSamples = moonfireGetSamples(doubleContext, &numberOfSamples);
+	for (size_t i = 0; i < numberOfSamples; i++)
+	{
+		double	difference = fabs(samples[i] - doubleSamples[i]) / fabs(doubleSamples[i]);
+
+		largestDifference = (difference > largestDifference) ? difference : largestDifference;
+	}
+
+	if ((moonfireCalculateSampleStatistics(samples, numberOfSamples, parameters->lowQuantileProbability, parameters->highQuantileProbability, &statistics) ==
+			kCommonConstantReturnTypeSuccess) &&
+		(moonfireCalculateSampleStatistics(doubleSamples, numberOfSamples, parameters->lowQuantileProbability, parameters->highQuantileProbability, &doubleStatistics) ==
+			kCommonConstantReturnTypeSuccess))
+	{
+		printf("Accuracy against double precision with the inverse CDF, with the same draws:\n");
+		printf("Statistic\t\t%s\t\tDouble\t\tRelative difference\n", name);
+		printf("Mean\t\t\t%.9lf\t%.9lf\t%+.3le\n", statistics.mean, doubleStatistics.mean, statistics.mean / doubleStatistics.mean - 1.0);
+		printf(
+			"P(loss)\t\t\t%.9lf\t%.9lf\t%+.3le\n",
+			statistics.probabilityOfLoss,
+			doubleStatistics.probabilityOfLoss,
+			(doubleStatistics.probabilityOfLoss > 0) ? statistics.probabilityOfLoss / doubleStatistics.probabilityOfLoss - 1.0 : 0.0);
+		printf(
+			"%.2lf quantile\t\t%.9lf\t%.9lf\t%+.3le\n",
+			parameters->lowQuantileProbability,
+			statistics.lowQuantile,
+			doubleStatistics.lowQuantile,
+			statistics.lowQuantile / doubleStatistics.lowQuantile - 1.0);
+		printf(
+			"%.2lf quantile\t\t%.9lf\t%.9lf\t%+.3le\n",
+			parameters->highQuantileProbability,
+			statistics.highQuantile,
+			doubleStatistics.highQuantile,
+			statistics.highQuantile / doubleStatistics.highQuantile - 1.0);
+		printf("Largest relative difference of the portfolio return of an iteration: %.3le\n", largestDifference);
+		printf(
+			"CPU time used in double precision: %lf seconds (%.2lfx of this run)\n",
+			doubleCpuTimeInSeconds,
+			(cpuTimeInSeconds > 0) ? doubleCpuTimeInSeconds / cpuTimeInSeconds : 0.0);
+	}
+
+	moonfireDestroyContext(doubleContext);
+
+	return;
+}
+
+/**
+ *	@brief	Print the statistics of the net multiple of the LPs.
+ *
+ *	@param	context		: The context, after simulating a waterfall.
+ *	@param	parameters	: The model parameters.
+ */
+static void
+printNetMultiple(MoonfireContext *  context, const MoonfireParameters *  parameters)
+{
+	MoonfireStatistics	netStatistics;
+
+	if (moonfireGetNetStatistics(context, &netStatistics) != kCommonConstantReturnTypeSuccess)
+	{
+		return;
+	}
+
+	printf(
+		"After fees and carried interest (%s waterfall), the forecast for the net multiple of the LPs is %lf times the commitment.\n",
+		(parameters->waterfall == kMoonfireWaterfallEuropean) ? "european" : "american",
+		netStatistics.mean);
+	printf("The probability of a net loss for the LPs is %lf.\n", netStatistics.probabilityOfLoss);
+	printf("The %lf quantile of the net multiple is %lf.\n", parameters->lowQuantileProbability, netStatistics.lowQuantile);
+	printf("The %lf quantile of the net multiple is %lf.\n", parameters->highQuantileProbability, netStatistics.highQuantile);
+
+	return;
+}
+
+/**
+ *	@brief	Print the statistics of the portfolio return of each reserve strategy,
+ *		one line per strategy.
+ *
+ *	@param	context		: The context, after simulating reserve strategies.
+ *	@param	parameters	: The model parameters.
+ */
+static void
+printReserveStrategies(MoonfireContext *  context, const MoonfireParameters *  parameters)
+{
+	MoonfireStatistics	statistics[kMoonfireConstantMaximumReserveStrategies];
+
+	if (moonfireGetReserveStrategies(context, statistics) != kCommonConstantReturnTypeSuccess)
+	{
+		return;
+	}
+
+	printf(
+		"Reserve strategies (follow-ons into investments signalling at least %.2lf times with log-scale noise %.2lf, at a %.2lf times step-up):\n",
+		parameters->followOnThreshold,
+		parameters->followOnSignalNoise,
+		parameters->followOnStepUp);
+	printf("Reserve\tMean\tP(loss)\t%.2lf quantile\t%.2lf quantile\n", parameters->lowQuantileProbability, parameters->highQuantileProbability);
+	for (size_t s = 0; s < parameters->numberOfReserveStrategies; s++)
+	{
+		printf(
+			"%.2lf\t%.4lf\t%.4lf\t%.4lf\t\t%.4lf\n",
+			parameters->reserveRatios[s],
+			statistics[s].mean,
+			statistics[s].probabilityOfLoss,
+			statistics[s].lowQuantile,
+			statistics[s].highQuantile);
+	}
+
+	return;
+}
+
+/**
+ *	@brief	Print the quantile bands of the fund timeline, one line per year.
+ *
+ *	@param	context		: The context, after simulating a fund timeline.
+ *	@param	parameters	: The model parameters.
+ */
+static void
+printTimeline(MoonfireContext *  context, const MoonfireParameters *  parameters)
+{
+	MoonfireTimelineYear	years[kMoonfireConstantMaximumFundLifeYears];
+
+	if (moonfireGetTimeline(context, years) != kCommonConstantReturnTypeSuccess)
+	{
+		return;
+	}
+
+	printf(
+		"Fund timeline (%.2lf / 0.50 / %.2lf quantiles; net cash flow as a fraction of the commitment):\n",
+		parameters->lowQuantileProbability,
+		parameters->highQuantileProbability);
+	printf("Year\tDPI\t\t\tTVPI\t\t\tNet cash flow\n");
+	for (size_t year = 0; year < parameters->fundLifeYears; year++)
+	{
+		printf(
+			"%zu\t%.2lf / %.2lf / %.2lf\t%.2lf / %.2lf / %.2lf\t%+.2lf / %+.2lf / %+.2lf\n",
+			year + 1,
+			years[year].distributedToPaidIn.low,
+			years[year].distributedToPaidIn.median,
+			years[year].distributedToPaidIn.high,
+			years[year].totalValueToPaidIn.low,
+			years[year].totalValueToPaidIn.median,
+			years[year].totalValueToPaidIn.high,
+			years[year].netCashFlow.low,
+			years[year].netCashFlow.median,
+			years[year].netCashFlow.high);
+	}
+
+	return;
+}
+
+/**
+ *	@brief	Search the portfolio size that optimizes the objective of the
+ *		command-line arguments, and print the candidate sizes.
+ *
+ *	@param	arguments	: Pointer to command-line arguments struct.
+ *	@param	parameters	: The model parameters, with the largest candidate size.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+runOptimizer(const CommandLineArguments *  arguments, const MoonfireParameters *  parameters)
+{
+	OptimizerResult			result;
+	const OptimizerCandidate *	best;
+	const OptimizerCandidate *	chosen;
+	clock_t				start = clock();
+	double				cpuTimeInSeconds;
+
+	if (optimizePortfolioSize(
+			parameters,
+			arguments->optimizerObjective,
+			arguments->minimumNumberOfInvestments,
+			arguments->optimizerTolerance,
+			&result) != kCommonConstantReturnTypeSuccess)
+	{
+		return kCommonConstantReturnTypeError;
+	}
+	cpuTimeInSeconds = ((double)(clock() - start)) / CLOCKS_PER_SEC;
 
+	printf(
+		"Portfolio sizes in [%zu, %zu], on common random numbers (%s objective):\n",
+		arguments->minimumNumberOfInvestments,
+		parameters->numberOfInvestments,
+		optimizerObjectiveName(arguments->optimizerObjective));
+	printf("Size\tMean\tP(loss)\t%.2lf quantile\t%.2lf quantile\n", parameters->lowQuantileProbability, parameters->highQuantileProbability);
+	for (size_t i = 0; i < result.numberOfCandidates; i++)
+	{
+		const OptimizerCandidate *	candidate = &result.candidates[i];
 
-static const double	kMoonfireVentureCapitalConstantsTotalInvestment	= 1.0;
+		printf(
+			"%zu\t%.4lf\t%.4lf\t%.4lf\t\t%.4lf%s\n",
+			candidate->numberOfInvestments,
+			candidate->statistics.mean,
+			candidate->statistics.probabilityOfLoss,
+			candidate->statistics.lowQuantile,
+			candidate->statistics.highQuantile,
+			(i == result.chosenCandidate) ? "\t(chosen)" : ((i == result.bestCandidate) ? "\t(best)" : ""));
+	}
+
+	best = &result.candidates[result.bestCandidate];
+	chosen = &result.candidates[result.chosenCandidate];
+	printf(
+		"The best portfolio size is %zu. The smallest portfolio size within %lf of its %s is %zu.\n",
+		best->numberOfInvestments,
+		arguments->optimizerTolerance,
+		optimizerObjectiveName(arguments->optimizerObjective),
+		chosen->numberOfInvestments);
+
+	if (arguments->common.isTimingEnabled)
+	{
+		printf("CPU time used: %lf seconds\n", cpuTimeInSeconds);
+	}
+
+	return kCommonConstantReturnTypeSuccess;
+}
 
 /**
- *	@brief	Populates the `invesmentReturns` array with the initial Bounded Pareto
- *		distributions. Reads values from the `arguments`.
+ *	@brief	Print the CPU and NUMA topology of the worker threads of the
+ *		command-line arguments.
  *
- *	@param	arguments		: Pointer to command-line arguments struct.
- *	@param	investmentReturns	: The array of input investment returns.
+ *	@param	arguments	: Pointer to command-line arguments struct.
  */
 static void
-loadInvestmentReturns(
-	CommandLineArguments *	arguments,
-	double *		investmentReturns)
+printThreadTopology(const CommandLineArguments *  arguments)
+{
+	const ThreadTopology *	topology = getThreadTopology();
+
+	printf(
+		"Topology: %zu CPUs in %zu NUMA nodes, %zu worker threads%s.\n",
+		topology->numberOfCpus,
+		topology->numberOfNodes,
+		arguments->numberOfThreads,
+		isThreadPinningEnabled() ? ", pinned and spread over the nodes" : ", not pinned");
+
+	return;
+}
+
+/**
+ *	@brief	Simulate the sweep over the portfolio sizes of the command-line
+ *		arguments on their threads, and print the statistics of each size.
+ *
+ *	@param	arguments	: Pointer to command-line arguments struct.
+ *	@param	parameters	: The model parameters.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+runSweep(const CommandLineArguments *  arguments, const MoonfireParameters *  parameters)
+{
+	MoonfireStatistics	statistics[kMoonfireConstantMaximumPortfolioSizes];
+	SchedulerReport		report;
+	clock_t			start = clock();
+	struct timespec		wallStart;
+	struct timespec		wallEnd;
+	double			cpuTimeInSeconds;
+	double			wallTimeInSeconds;
+
+	clock_gettime(CLOCK_MONOTONIC, &wallStart);
+	if (simulateSweep(
+			parameters,
+			arguments->sweepSizes,
+			arguments->numberOfSweepSizes,
+			arguments->numberOfThreads,
+			statistics,
+			&report) != kCommonConstantReturnTypeSuccess)
+	{
+		return kCommonConstantReturnTypeError;
+	}
+	cpuTimeInSeconds = ((double)(clock() - start)) / CLOCKS_PER_SEC;
+	clock_gettime(CLOCK_MONOTONIC, &wallEnd);
+	wallTimeInSeconds = (double) (wallEnd.tv_sec - wallStart.tv_sec) + (double) (wallEnd.tv_nsec - wallStart.tv_nsec) / 1e9;
+
+	printf("Portfolio sizes, each simulated independently with %zu iterations:\n", parameters->numberOfIterations);
+	printf("Size\tMean\tP(loss)\t%.2lf quantile\t%.2lf quantile\n", parameters->lowQuantileProbability, parameters->highQuantileProbability);
+	for (size_t i = 0; i < arguments->numberOfSweepSizes; i++)
+	{
+		printf(
+			"%zu\t%.4lf\t%.4lf\t%.4lf\t\t%.4lf\n",
+			arguments->sweepSizes[i],
+			statistics[i].mean,
+			statistics[i].probabilityOfLoss,
+			statistics[i].lowQuantile,
+			statistics[i].highQuantile);
+	}
+
+	if (arguments->common.isTimingEnabled)
+	{
+		printf("CPU time used: %lf seconds, in %lf seconds of wall time\n", cpuTimeInSeconds, wallTimeInSeconds);
+		printf(
+			"Work-stealing scheduler: %zu tasks on %zu threads, of which %zu were stolen.\n",
+			report.numberOfTasks,
+			report.numberOfThreads,
+			report.numberOfStolenTasks);
+		printThreadTopology(arguments);
+	}
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+/**
+ *	@brief	Calibrate the bounded Pareto parameters to the multiples file of the
+ *		command-line arguments, and print them with their bootstrap intervals.
+ *
+ *	@param	arguments	: Pointer to command-line arguments struct.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+runCalibration(const CommandLineArguments *  arguments)
 {
-	double	perInvestmentValue = kMoonfireVentureCapitalConstantsTotalInvestment / arguments->numberOfInvestments;
-	
-	for (size_t i = 0; i < arguments->numberOfInvestments; i++)
+	CalibrationResult	result;
+	double *		multiples;
+	size_t			numberOfMultiples;
+	clock_t			start;
+	double			cpuTimeInSeconds;
+
+	if (moonfireLoadMultiples(arguments->multiplesPath, &multiples, &numberOfMultiples) != kCommonConstantReturnTypeSuccess)
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	start = clock();
+	if (calibrateBoundedPareto(
+			multiples,
+			numberOfMultiples,
+			arguments->numberOfBootstrapResamples,
+			arguments->lowQuantileProbability,
+			arguments->highQuantileProbability,
+			arguments->seed,
+			arguments->numberOfThreads,
+			&result) != kCommonConstantReturnTypeSuccess)
+	{
+		free(multiples);
+
+		return kCommonConstantReturnTypeError;
+	}
+	cpuTimeInSeconds = ((double)(clock() - start)) / CLOCKS_PER_SEC;
+	free(multiples);
+
+	printf("Maximum likelihood bounded Pareto parameters of %zu multiples (log-likelihood %lf):\n", numberOfMultiples, result.estimate.logLikelihood);
+	if (result.numberOfResamples > 0)
+	{
+		printf(
+			"Parameter\tEstimate\t%.2lf quantile\t%.2lf quantile (of %zu bootstrap resamples)\n",
+			arguments->lowQuantileProbability,
+			arguments->highQuantileProbability,
+			result.numberOfResamples);
+		printf("alpha\t\t%lf\t%lf\t%lf\n", result.estimate.alpha, result.low.alpha, result.high.alpha);
+		printf("xMin\t\t%lf\t%lf\t%lf\n", result.estimate.xMin, result.low.xMin, result.high.xMin);
+		printf("xMax\t\t%lf\t%lf\t%lf\n", result.estimate.xMax, result.low.xMax, result.high.xMax);
+	}
+	else
+	{
+		printf("alpha = %lf, xMin = %lf, xMax = %lf\n", result.estimate.alpha, result.estimate.xMin, result.estimate.xMax);
+	}
+	printf("Simulator arguments: -a %.17g -x %.17g -X %.17g\n", result.estimate.alpha, result.estimate.xMin, result.estimate.xMax);
+
+	if (arguments->common.isTimingEnabled)
 	{
-		investmentReturns[i] = UxHwDoubleBoundedparetoDist(
-			arguments->alpha,
-			arguments->xMin,
-			arguments->xMax + arguments->xMin);
-		investmentReturns[i] -= arguments->xMin;
-		investmentReturns[i] *= perInvestmentValue;
+		printf("CPU time used: %lf seconds\n", cpuTimeInSeconds);
+		printThreadTopology(arguments);
 	}
 
+	return kCommonConstantReturnTypeSuccess;
+}
+
+/**
+ *	@brief	Print the range of iterations of the shard of the command-line arguments.
+ *
+ *	@param	arguments	: Pointer to command-line arguments struct.
+ *	@param	parameters	: The model parameters of the shard.
+ */
+static void
+printShard(const CommandLineArguments *  arguments, const MoonfireParameters *  parameters)
+{
+	printf(
+		"This is shard %zu of %zu: iterations %zu to %zu of %zu. Combine the outputs of all shards with the merge subcommand.\n",
+		arguments->shardIndex,
+		arguments->numberOfShards,
+		parameters->firstIteration,
+		parameters->firstIteration + parameters->numberOfIterations - 1,
+		arguments->common.numberOfMonteCarloIterations);
+
 	return;
 }
 
 /**
- *	@brief	Calculates the portfolio return by summing the returns of each individual investment.
+ *	@brief	Print the probability of loss and the quantiles of the portfolio return
+ *		of a quantile sketch.
+ *
+ *	@param	sketch			: The sketch, not empty.
+ *	@param	lowQuantileProbability	: Probability of the low quantile.
+ *	@param	highQuantileProbability	: Probability of the high quantile.
+ */
+static void
+printQuantileSketch(QuantileSketch *  sketch, double lowQuantileProbability, double highQuantileProbability)
+{
+	/*
+	 *	A loss is a portfolio return of at most the total investment, 1.
+	 */
+	double	probabilityOfLoss = estimateQuantileSketchCumulativeProbability(sketch, 1.0);
+
+	printf("The probability of loss for this portfolio is %lf.\n", probabilityOfLoss);
+	printf("The %lf quantile of the total portfolio return is %lf.\n", lowQuantileProbability, estimateQuantileSketchQuantile(sketch, lowQuantileProbability));
+	printf("The %lf quantile of the total portfolio return is %lf.\n", highQuantileProbability, estimateQuantileSketchQuantile(sketch, highQuantileProbability));
+	printf(
+		"(From a quantile sketch of %.0lf samples with %zu centroids, between %lf and %lf.)\n",
+		sketch->count,
+		sketch->numberOfCentroids,
+		sketch->minimum,
+		sketch->maximum);
+
+	return;
+}
+
+/**
+ *	@brief	Simulate the portfolio return into a quantile sketch on the threads of
+ *		the command-line arguments, write the sketch file and print its statistics.
+ *
+ *	@param	arguments	: Pointer to command-line arguments struct.
+ *	@param	parameters	: The model parameters.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+runSketch(const CommandLineArguments *  arguments, const MoonfireParameters *  parameters)
+{
+	QuantileSketch *	sketch = createQuantileSketch(kQuantileSketchConstantDefaultCompression);
+	clock_t			start = clock();
+	double			cpuTimeInSeconds;
+
+	if ((sketch == NULL) ||
+		(moonfireSimulateSketch(parameters, arguments->numberOfThreads, sketch) != kCommonConstantReturnTypeSuccess) ||
+		(writeQuantileSketch(sketch, arguments->sketchPath) != kCommonConstantReturnTypeSuccess))
+	{
+		destroyQuantileSketch(sketch);
+
+		return kCommonConstantReturnTypeError;
+	}
+	cpuTimeInSeconds = ((double)(clock() - start)) / CLOCKS_PER_SEC;
+
+	printf(
+		"The forecast for the total portfolio return with portfolio size %zu is %lf times the initial total investment.\n",
+		parameters->numberOfInvestments,
+		sketch->sum / sketch->count);
+	printQuantileSketch(sketch, parameters->lowQuantileProbability, parameters->highQuantileProbability);
+	if (arguments->numberOfShards > 1)
+	{
+		printShard(arguments, parameters);
+	}
+
+	if (arguments->common.isTimingEnabled)
+	{
+		printf("CPU time used: %lf seconds\n", cpuTimeInSeconds);
+		printThreadTopology(arguments);
+	}
+
+	destroyQuantileSketch(sketch);
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+/**
+ *	@brief	Merge the sketch files of the `merge` subcommand, e.g., of separate
+ *		processes or hosts, and print the statistics of their combined samples.
+ *
+ *	@param	arguments	: Pointer to the arguments of the subcommand.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+runSketchMerge(const MergeCommandLineArguments *  arguments)
+{
+	QuantileSketch *	merged = NULL;
+
+	for (size_t i = 0; i < arguments->numberOfInputPaths; i++)
+	{
+		QuantileSketch *	sketch = readQuantileSketch(arguments->inputPaths[i]);
+
+		if (sketch == NULL)
+		{
+			destroyQuantileSketch(merged);
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		if (merged == NULL)
+		{
+			merged = sketch;
+
+			continue;
+		}
+
+		mergeQuantileSketch(merged, sketch);
+		destroyQuantileSketch(sketch);
+	}
+
+	if (merged->count == 0)
+	{
+		fprintf(stderr, "Error: The sketch files hold no samples.\n");
+		destroyQuantileSketch(merged);
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if (arguments->isSketchEnabled && (writeQuantileSketch(merged, arguments->sketchPath) != kCommonConstantReturnTypeSuccess))
+	{
+		destroyQuantileSketch(merged);
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	printf("The mean of the total portfolio return of the merged sketches is %lf times the initial total investment.\n", merged->sum / merged->count);
+	printQuantileSketch(merged, arguments->lowQuantileProbability, arguments->highQuantileProbability);
+	destroyQuantileSketch(merged);
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+/**
+ *	@brief	Merge the Monte Carlo output files of shards (`--shard`) for the `merge`
+ *		subcommand: print the exact statistics of their concatenated samples and
+ *		their CPU times, and write the samples and the total CPU time to `data.out`.
+ *
+ *	@param	arguments	: Pointer to the arguments of the subcommand.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+runSampleMerge(const MergeCommandLineArguments *  arguments)
+{
+	double *			merged = NULL;
+	size_t				numberOfMergedSamples = 0;
+	uint64_t			totalCpuTimeMicroseconds = 0;
+	uint64_t			maximumCpuTimeMicroseconds = 0;
+	MoonfireStatistics		statistics;
+	CommonConstantReturnType	result = kCommonConstantReturnTypeSuccess;
+
+	/*
+	 *	The samples are concatenated in the order of the files, so that the
+	 *	shards 0 to N - 1 of a simulation give the samples of a single run.
+	 */
+	for (size_t i = 0; (i < arguments->numberOfInputPaths) && (result == kCommonConstantReturnTypeSuccess); i++)
+	{
+		double *	samples;
+		double *	newMerged;
+		size_t		numberOfSamples;
+		uint64_t	cpuTimeMicroseconds;
+
+		if (moonfireLoadMonteCarloOutput(arguments->inputPaths[i], &samples, &numberOfSamples, &cpuTimeMicroseconds) != kCommonConstantReturnTypeSuccess)
+		{
+			result = kCommonConstantReturnTypeError;
+			break;
+		}
+
+		newMerged = realloc(merged, (numberOfMergedSamples + numberOfSamples) * sizeof(double));
+		if (newMerged == NULL)
+		{
+			fprintf(stderr, "Error: Could not allocate the merged samples.\n");
+			result = kCommonConstantReturnTypeError;
+		}
+		else
+		{
+			merged = newMerged;
+			memcpy(merged + numberOfMergedSamples, samples, numberOfSamples * sizeof(double));
+			numberOfMergedSamples += numberOfSamples;
+			totalCpuTimeMicroseconds += cpuTimeMicroseconds;
+			maximumCpuTimeMicroseconds = (cpuTimeMicroseconds > maximumCpuTimeMicroseconds) ? cpuTimeMicroseconds : maximumCpuTimeMicroseconds;
+		}
+		free(samples);
+	}
+
+	if ((result == kCommonConstantReturnTypeSuccess) &&
+		(moonfireCalculateSampleStatistics(
+			merged,
+			numberOfMergedSamples,
+			arguments->lowQuantileProbability,
+			arguments->highQuantileProbability,
+			&statistics) != kCommonConstantReturnTypeSuccess))
+	{
+		result = kCommonConstantReturnTypeError;
+	}
+
+	/*
+	 *	The merged sketch, if any, summarizes the merged samples.
+	 */
+	if ((result == kCommonConstantReturnTypeSuccess) && arguments->isSketchEnabled)
+	{
+		QuantileSketch *	sketch = createQuantileSketch(kQuantileSketchConstantDefaultCompression);
+
+		if (sketch == NULL)
+		{
+			result = kCommonConstantReturnTypeError;
+		}
+		else
+		{
+			addQuantileSketchValues(sketch, merged, numberOfMergedSamples);
+			result = writeQuantileSketch(sketch, arguments->sketchPath);
+			destroyQuantileSketch(sketch);
+		}
+	}
+
+	if (result != kCommonConstantReturnTypeSuccess)
+	{
+		free(merged);
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	printf(
+		"The mean of the total portfolio return of the %zu merged samples is %lf times the initial total investment.\n",
+		numberOfMergedSamples,
+		statistics.mean);
+	printf("The probability of loss for this portfolio is %lf.\n", statistics.probabilityOfLoss);
+	printf("The %lf quantile of the total portfolio return is %lf.\n", arguments->lowQuantileProbability, statistics.lowQuantile);
+	printf("The %lf quantile of the total portfolio return is %lf.\n", arguments->highQuantileProbability, statistics.highQuantile);
+	printf(
+		"CPU time used: %lf seconds in total, %lf seconds by the slowest shard\n",
+		(double) totalCpuTimeMicroseconds / 1000000,
+		(double) maximumCpuTimeMicroseconds / 1000000);
+
+	saveMonteCarloDoubleDataToDataDotOutFile(merged, totalCpuTimeMicroseconds, numberOfMergedSamples);
+	free(merged);
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+/**
+ *	@brief	Merge the input files of the `merge` subcommand, which are either all
+ *		sketch files or all Monte Carlo output files.
  *
- *	@param	arguments		: Pointer to command-line arguments struct.
- *	@param	investmentReturns	: The array of investment returns to populate.
+ *	@param	arguments	: Pointer to the arguments of the subcommand.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+runMerge(const MergeCommandLineArguments *  arguments)
+{
+	bool	isSketchMerge = isQuantileSketchFile(arguments->inputPaths[0]);
+
+	for (size_t i = 1; i < arguments->numberOfInputPaths; i++)
+	{
+		if (isQuantileSketchFile(arguments->inputPaths[i]) != isSketchMerge)
+		{
+			fprintf(stderr, "Error: The merge subcommand cannot mix sketch files and Monte Carlo output files.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+	}
+
+	return isSketchMerge ? runSketchMerge(arguments) : runSampleMerge(arguments);
+}
+
+#if defined(MOONFIRE_NATIVE)
+/**
+ *	@brief	Run the simulation as the coordinator of a cluster, print the statistics
+ *		of its samples and the distribution of the work, and write `data.out`.
  *
- *	@return				: Returns the calculated portfolio return.
+ *	@param	arguments	: Pointer to command-line arguments struct.
+ *	@param	parameters	: The model parameters.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
  */
-static double
-calculatePortfolioReturn(
-	CommandLineArguments *	arguments,
-	double *		investmentReturns)
+static CommonConstantReturnType
+runCoordinator(const CommandLineArguments *  arguments, const MoonfireParameters *  parameters)
 {
-	double	portfolioReturn = 0.0;
+	double *		samples = malloc(parameters->numberOfIterations * sizeof(double));
+	ClusterReport		report;
+	MoonfireStatistics	statistics;
+	struct timespec		start;
+	struct timespec		end;
+	double			wallTimeInSeconds;
+
+	if (samples == NULL)
+	{
+		fprintf(stderr, "Error: Could not allocate the samples of the cluster.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
 
-	for (size_t i = 0; i < arguments->numberOfInvestments; i++)
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if ((runClusterCoordinator(
+			parameters,
+			arguments->numberOfLocalWorkers,
+			arguments->isClusterAddressEnabled ? arguments->clusterAddress : NULL,
+			samples,
+			&report) != kCommonConstantReturnTypeSuccess) ||
+		(moonfireCalculateSampleStatistics(
+			samples,
+			parameters->numberOfIterations,
+			parameters->lowQuantileProbability,
+			parameters->highQuantileProbability,
+			&statistics) != kCommonConstantReturnTypeSuccess))
 	{
-		portfolioReturn += investmentReturns[i];
+		free(samples);
+
+		return kCommonConstantReturnTypeError;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	wallTimeInSeconds = (double) (end.tv_sec - start.tv_sec) + (double) (end.tv_nsec - start.tv_nsec) / 1e9;
+
+	printf("The forecast for the total portfolio return with portfolio size %zu is %lf times the initial total investment.\n", parameters->numberOfInvestments, statistics.mean);
+	printf("The probability of loss for this portfolio is %lf.\n", statistics.probabilityOfLoss);
+	printf("The %lf quantile of the total portfolio return is %lf.\n", parameters->lowQuantileProbability, statistics.lowQuantile);
+	printf("The %lf quantile of the total portfolio return is %lf.\n", parameters->highQuantileProbability, statistics.highQuantile);
+	if (arguments->numberOfShards > 1)
+	{
+		printShard(arguments, parameters);
+	}
+	printf(
+		"%zu workers simulated %zu chunks of at most %d iterations; %zu chunks were reassigned from failed workers.\n",
+		report.numberOfWorkers,
+		report.numberOfChunks,
+		(int) kClusterConstantChunkIterations,
+		report.numberOfReassignedChunks);
+
+	if (arguments->common.isTimingEnabled)
+	{
+		printf("CPU time used: %lf seconds by the workers, in %lf seconds of wall time\n", (double) report.cpuTimeMicroseconds / 1000000, wallTimeInSeconds);
 	}
 
-	return portfolioReturn;
+	saveMonteCarloDoubleDataToDataDotOutFile(samples, report.cpuTimeMicroseconds, parameters->numberOfIterations);
+	free(samples);
+
+	return kCommonConstantReturnTypeSuccess;
 }
+#endif
 
 int
 main(int argc, char *  argv[])
 {
 	CommandLineArguments	arguments = {0};
-	double *		investmentReturns;
+	MoonfireParameters	parameters;
+	MoonfirePortfolio	portfolio = {0};
+	double *		classCorrelationMatrix = NULL;
+	double *		parameterDraws = NULL;
+	double *		outcomes = NULL;
+	MoonfireContext *	context;
+	MoonfireStatistics	statistics = {0};
 	double			portfolioReturn;
-	double			probabilityOfLoss;
-	double			lowQuantile;
-	double			highQuantile;
-	double *		monteCarloOutputSamples;
+	const double *		monteCarloOutputSamples;
+	size_t			numberOfMonteCarloOutputSamples;
 	clock_t			start = 0;
 	clock_t			end = 0;
-	double			cpuTimeInSeconds;
-	MeanAndVariance		monteCarloOutputMeanAndVariance = {0};
+	double			cpuTimeInSeconds = 0.0;
+
+	/*
+	 *	The merge subcommand merges sketch files or Monte Carlo output files
+	 *	instead of simulating.
+	 */
+	if ((argc > 1) && (strcmp(argv[1], "merge") == 0))
+	{
+		MergeCommandLineArguments	mergeArguments;
+
+		if (getMergeCommandLineArguments(argc, argv, &mergeArguments) != kCommonConstantReturnTypeSuccess)
+		{
+			return EXIT_FAILURE;
+		}
+
+		return (runMerge(&mergeArguments) == kCommonConstantReturnTypeSuccess) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
 
 	/*
 	 *	Get command-line arguments.
@@ -102,75 +930,169 @@ main(int argc, char *  argv[])
 	{
 		return EXIT_FAILURE;
 	}
+	setThreadPinning(arguments.isThreadPinningEnabled);
 
-	if (arguments.common.isMonteCarloMode)
+	/*
+	 *	In calibration mode, fit the model parameters instead of simulating.
+	 */
+	if (arguments.isCalibrationEnabled)
 	{
-		monteCarloOutputSamples =
-			(double *) checkedMalloc(
-					arguments.common.numberOfMonteCarloIterations * sizeof(double),
-					__FILE__,
-					__LINE__);
+		return (runCalibration(&arguments) == kCommonConstantReturnTypeSuccess) ? EXIT_SUCCESS : EXIT_FAILURE;
 	}
 
-	/* 
-	 *	Allocate `investmentReturns` array.
-	 */
-	investmentReturns = (double *) checkedMalloc(
-					sizeof(double) * arguments.numberOfInvestments,
-					__FILE__,
-					__LINE__);
+	setParametersFromCommandLineArguments(&arguments, &parameters);
 
 	/*
-	 *	Start timing if timing is enabled or in benchmarking mode.
+	 *	Load the heterogeneous portfolio of the portfolio file, if given.
 	 */
-	if ((arguments.common.isTimingEnabled) || (arguments.common.isBenchmarkingMode))
+	if (arguments.common.isInputFromFileEnabled)
 	{
-		start = clock();
+		if (moonfireLoadPortfolio(arguments.common.inputFilePath, &portfolio) != kCommonConstantReturnTypeSuccess)
+		{
+			return EXIT_FAILURE;
+		}
+
+		parameters.portfolio = &portfolio;
+		parameters.numberOfInvestments = portfolio.numberOfInvestments;
 	}
 
-	for (size_t i = 0; i < arguments.common.numberOfMonteCarloIterations; ++i)
+	/*
+	 *	Load the correlation matrix of the portfolio classes, if given.
+	 */
+	if (arguments.isClassCorrelationMatrixEnabled)
 	{
-		/*
-		 *	Load distributions for investment retruns.
-		 */
-		loadInvestmentReturns(&arguments, investmentReturns);
+		if (moonfireLoadCorrelationMatrix(
+				arguments.classCorrelationMatrixPath,
+				&classCorrelationMatrix,
+				&parameters.classCorrelationMatrixOrder) != kCommonConstantReturnTypeSuccess)
+		{
+			return EXIT_FAILURE;
+		}
 
-		/*
-		 *	Calculate the distribution for the total portfolio return and determine statisctical quantities.
-		 */
-		portfolioReturn = calculatePortfolioReturn(&arguments, investmentReturns);
+		parameters.classCorrelationMatrix = classCorrelationMatrix;
+	}
 
-		/*
-		 *	Doesn't calculate quantiles and probability of loss when in benchmarking mode.
-		 *	Only calculates portfolio return.
-		 */
-		if (!arguments.common.isBenchmarkingMode)
+	/*
+	 *	Load the draws of the bounded Pareto parameters, if given.
+	 */
+	if (arguments.isParameterDrawsEnabled)
+	{
+		if (moonfireLoadParameterDraws(
+				arguments.parameterDrawsPath,
+				&parameterDraws,
+				&parameters.numberOfParameterDraws) != kCommonConstantReturnTypeSuccess)
 		{
-			probabilityOfLoss = 1.0 - UxHwDoubleProbabilityGT(portfolioReturn, kMoonfireVentureCapitalConstantsTotalInvestment);
+			return EXIT_FAILURE;
+		}
+
+		parameters.parameterDraws = parameterDraws;
+	}
 
-			lowQuantile = UxHwDoubleQuantile(portfolioReturn, arguments.lowQuantileProbability);
-			highQuantile = UxHwDoubleQuantile(portfolioReturn, arguments.highQuantileProbability);
+	/*
+	 *	Load the outcome buckets, if given.
+	 */
+	if (arguments.isOutcomesEnabled)
+	{
+		if (moonfireLoadOutcomes(arguments.outcomesPath, &outcomes, &parameters.numberOfOutcomes) != kCommonConstantReturnTypeSuccess)
+		{
+			return EXIT_FAILURE;
 		}
 
-		/*
-		 *	For Monte Carlo mode, save portfolioReturn.
-		 */
-		if (arguments.common.isMonteCarloMode)
+		parameters.outcomes = outcomes;
+	}
+
+#if defined(MOONFIRE_NATIVE)
+	/*
+	 *	In server mode, the command-line arguments are the defaults of the queries.
+	 */
+	if (arguments.isServerModeEnabled)
+	{
+		if (!arguments.common.isMonteCarloMode)
 		{
-			monteCarloOutputSamples[i] = portfolioReturn;
+			parameters.numberOfIterations = kServerConstantDefaultIterations;
 		}
+
+		return (runServer(
+				arguments.serverSocketPath,
+				&parameters,
+				arguments.numberOfThreads,
+				arguments.isResultCacheEnabled ? arguments.resultCacheDirectory : NULL) == kCommonConstantReturnTypeSuccess) ? EXIT_SUCCESS : EXIT_FAILURE;
 	}
 
 	/*
-	 *	If not doing Laplace version, then approximate the cost of the third phase of
-	 *	Monte Carlo (post-processing), by calculating the mean and variance.
+	 *	In cluster mode, the coordinator distributes the iterations between
+	 *	workers, and a worker simulates the chunks that its coordinator assigns.
 	 */
-	if (arguments.common.isMonteCarloMode)
+	if (arguments.isCoordinatorEnabled)
+	{
+		return (runCoordinator(&arguments, &parameters) == kCommonConstantReturnTypeSuccess) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	if (arguments.isClusterAddressEnabled)
+	{
+		return (runClusterWorker(&parameters, arguments.clusterAddress) == kCommonConstantReturnTypeSuccess) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+#endif
+
+	/*
+	 *	In optimizer mode, `-n` is the largest candidate portfolio size.
+	 */
+	if (arguments.optimizerObjective != kOptimizerObjectiveNone)
+	{
+		return (runOptimizer(&arguments, &parameters) == kCommonConstantReturnTypeSuccess) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	/*
+	 *	In sweep mode, `-n` lists several portfolio sizes.
+	 */
+	if (arguments.numberOfSweepSizes > 0)
+	{
+		return (runSweep(&arguments, &parameters) == kCommonConstantReturnTypeSuccess) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	/*
+	 *	In sketch mode, the samples are summarized by a quantile sketch
+	 *	instead of being kept, so there is no output file of samples.
+	 */
+	if (arguments.isSketchEnabled)
+	{
+		return (runSketch(&arguments, &parameters) == kCommonConstantReturnTypeSuccess) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	/*
+	 *	Create the model context, which allocates all buffers of the simulation.
+	 */
+	context = moonfireCreateContext(&parameters);
+	if (context == NULL)
+	{
+		return EXIT_FAILURE;
+	}
+
+	/*
+	 *	Start timing if timing is enabled or in benchmarking mode.
+	 */
+	if ((arguments.common.isTimingEnabled) || (arguments.common.isBenchmarkingMode))
+	{
+		start = clock();
+	}
+
+	if (moonfireSimulate(context) != kCommonConstantReturnTypeSuccess)
+	{
+		moonfireDestroyContext(context);
+
+		return EXIT_FAILURE;
+	}
+
+	/*
+	 *	Doesn't calculate quantiles and probability of loss when in benchmarking mode.
+	 *	Only calculates portfolio return. Printing probabilities in Monte Carlo mode
+	 *	does not make sense, because the values are particles, so they are also
+	 *	not calculated in Monte Carlo mode.
+	 */
+	portfolioReturn = moonfireGetPortfolioReturn(context);
+	if ((!arguments.common.isBenchmarkingMode) && (!arguments.common.isMonteCarloMode))
 	{
-		monteCarloOutputMeanAndVariance = calculateMeanAndVarianceOfDoubleSamples(
-							monteCarloOutputSamples,
-							arguments.common.numberOfMonteCarloIterations);
-		portfolioReturn = monteCarloOutputMeanAndVariance.mean;
+		moonfireGetStatistics(context, &statistics);
 	}
 
 	/*
@@ -198,16 +1120,41 @@ main(int argc, char *  argv[])
 		 */
 		if (!arguments.common.isOutputJSONMode)
 		{
-			printf("The forecast for the total portfolio return with portfolio size %zu is %lf times the initial total investment.\n", arguments.numberOfInvestments, portfolioReturn);
+			printf("The forecast for the total portfolio return with portfolio size %zu is %lf times the initial total investment.\n", parameters.numberOfInvestments, portfolioReturn);
+
+			if (arguments.numberOfShards > 1)
+			{
+				printShard(&arguments, &parameters);
+			}
 
 			/*
 			 *	Printing probabilities in MonteCarlo Mode, does not make sense, because the values are particles.
 			 */
 			if (!arguments.common.isMonteCarloMode)
 			{
-				printf("The probability of loss for this portfolio is %"SignaloidParticleModifier"lf.\n", probabilityOfLoss);
-				printf("The %"SignaloidParticleModifier"lf quantile of the total portfolio return is %"SignaloidParticleModifier"lf.\n", arguments.lowQuantileProbability, lowQuantile);
-				printf("The %"SignaloidParticleModifier"lf quantile of the total portfolio return is %"SignaloidParticleModifier"lf.\n", arguments.highQuantileProbability, highQuantile);
+				printf("The probability of loss for this portfolio is %"SignaloidParticleModifier"lf.\n", statistics.probabilityOfLoss);
+				printf("The %"SignaloidParticleModifier"lf quantile of the total portfolio return is %"SignaloidParticleModifier"lf.\n", arguments.lowQuantileProbability, statistics.lowQuantile);
+				printf("The %"SignaloidParticleModifier"lf quantile of the total portfolio return is %"SignaloidParticleModifier"lf.\n", arguments.highQuantileProbability, statistics.highQuantile);
+			}
+
+			if (parameters.parameterDraws != NULL)
+			{
+				printParameterUncertainty(context);
+			}
+
+			if (parameters.waterfall != kMoonfireWaterfallNone)
+			{
+				printNetMultiple(context, &parameters);
+			}
+
+			if (parameters.numberOfReserveStrategies > 0)
+			{
+				printReserveStrategies(context, &parameters);
+			}
+
+			if (parameters.fundLifeYears > 0)
+			{
+				printTimeline(context, &parameters);
 			}
 		}
 		/*
@@ -234,22 +1181,31 @@ main(int argc, char *  argv[])
 		if ((arguments.common.isTimingEnabled) && (!arguments.common.isOutputJSONMode))
 		{
 			printf("CPU time used: %lf seconds\n", cpuTimeInSeconds);
+			printf("Sampling kernel variant: %s\n", moonfireGetKernelVariantName(context));
+			if ((parameters.precision != kMoonfirePrecisionDouble) || (parameters.sampler != kMoonfireSamplerInverseCdf))
+			{
+				printSamplingAccuracy(context, &parameters, cpuTimeInSeconds);
+			}
 		}
 	}
 
 	/*
-	 *	Free allocated dynamic memory.
-	 */
-	free(investmentReturns);
-
-	/*
-	 *	Save Monte Carlo outputs in an output file and free allocated dynamic memory.
+	 *	Save Monte Carlo outputs in an output file.
 	 */
 	if (arguments.common.isMonteCarloMode)
 	{
-		saveMonteCarloDoubleDataToDataDotOutFile(monteCarloOutputSamples, (uint64_t)(cpuTimeInSeconds*1000000), arguments.common.numberOfMonteCarloIterations);
-		free(monteCarloOutputSamples);
+		monteCarloOutputSamples = moonfireGetSamples(context, &numberOfMonteCarloOutputSamples);
+		saveMonteCarloDoubleDataToDataDotOutFile((double *) monteCarloOutputSamples, (uint64_t)(cpuTimeInSeconds*1000000), numberOfMonteCarloOutputSamples);
 	}
 
+	/*
+	 *	Free allocated dynamic memory.
+	 */
+	moonfireDestroyContext(context);
+	moonfireFreePortfolio(&portfolio);
+	free(classCorrelationMatrix);
+	free(parameterDraws);
+	free(outcomes);
+
 	return EXIT_SUCCESS;
 }
@@ -0,0 +1,2662 @@
+/*
+ *	Copyright (c) 2024, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#if defined(MOONFIRE_NATIVE)
+#include <pthread.h>
+#endif
+#include <uxhw.h>
+#include "copula.h"
+#include "kernels.h"
+#include "moonfire.h"
+#include "timeline.h"
+#include "topology.h"
+#include "waterfall.h"
+
+
+static const double	kMoonfireVentureCapitalConstantsTotalInvestment	= 1.0;
+
+/*
+ *	Range of the follow-on threshold, so that the exponent of the lognormal
+ *	thresholds stays within the domain of `sampleLognormals`.
+ */
+static const double	kMoonfireMinimumFollowOnThreshold		= 1e-100;
+static const double	kMoonfireMaximumFollowOnThreshold		= 1e100;
+
+/*
+ *	Parameters of an investment and its index, for grouping investments by class.
+ */
+typedef struct
+{
+	double	alpha;
+	double	xMin;
+	double	xMax;
+	size_t	index;
+} MoonfireInvestmentClassKey;
+
+/*
+ *	Consecutive investments of a portfolio with the same parameters.
+ */
+typedef struct
+{
+	size_t			first;
+	size_t			count;
+	BoundedParetoConstants	constants;
+} MoonfirePortfolioSegment;
+
+/*
+ *	Iterations of a worker of `moonfireSimulateSketch()`: `numberOfIterations`
+ *	iterations from `firstIteration`, added to `sketch`.
+ */
+typedef struct
+{
+	const MoonfireParameters *	parameters;
+	size_t				thread;
+	size_t				firstIteration;
+	size_t				numberOfIterations;
+	QuantileSketch *		sketch;
+	CommonConstantReturnType	result;
+} MoonfireSketchWorker;
+
+struct MoonfireContext
+{
+	MoonfireParameters		parameters;
+	const SamplingKernels *		kernels;
+	BoundedParetoConstants		constants;
+	BoundedParetoTable *		boundedParetoTable;
+	AliasTable			outcomeTable;
+	double *			outcomeWeights;
+	size_t *			outcomeWorkspace;
+	size_t				outcomeTableCapacity;
+	BoundedParetoConstantArrays	portfolioConstants;
+	size_t				portfolioConstantsCapacity;
+	MoonfirePortfolioSegment *	portfolioSegments;
+	size_t				numberOfPortfolioSegments;
+	size_t				portfolioSegmentsCapacity;
+	bool				isPortfolioSegmented;
+	CopulaConstants			copulaConstants;
+	uint64_t			copulaVariatesPerIteration;
+	size_t *			investmentClasses;
+	size_t				investmentClassesCapacity;
+	size_t				numberOfClasses;
+	double *			classFactors;
+	double *			classNormals;
+	size_t				classFactorsCapacity;
+	double *			classCorrelations;
+	double *			classCholeskyFactor;
+	size_t				classCorrelationsCapacity;
+	size_t				classCorrelationsOrder;
+	double *			capital;
+	double *			inverseCapital;
+	double *			investmentMultiples;
+	size_t				capitalCapacity;
+	TimelineSchedule		timelineSchedule;
+	double *			timelineEntryYears;
+	size_t				timelineInvestmentsCapacity;
+	double *			timelineValues;
+	double *			timelineExitYears;
+	size_t				timelineBatchCapacity;
+	size_t				timelineBatchIterations;
+	double *			timelineMetrics;
+	size_t				timelineMetricsCapacity;
+	uint64_t			timelineKey;
+	WaterfallConstants		waterfallConstants;
+	double *			netSamples;
+	size_t				netSamplesCapacity;
+	MoonfireStatistics		netStatistics;
+	bool				hasNetStatistics;
+	double *			followOnMultiples;
+	double *			strategySamples;
+	size_t				reserveSamplesCapacity;
+	double *			followOnThresholds;
+	size_t				followOnThresholdsCapacity;
+	uint64_t			reserveKey;
+	double *			sizeSamples;
+	size_t				sizeSamplesCapacity;
+	uint64_t			key;
+	double *			investmentReturns;
+	size_t				investmentReturnsCapacity;
+	double *			samples;
+	double *			scratch;
+	size_t				samplesCapacity;
+	MoonfireStatistics		statistics;
+	bool				hasSimulated;
+	bool				hasTailStatistics;
+};
+
+/**
+ *	@brief	Build the distribution of the return of one investment over the
+ *		outcome buckets, as a chain of two-component mixtures from the last
+ *		bucket: bucket `k` is mixed into the buckets after it with its share
+ *		of their total weight.
+ *
+ *	@param	context	: The context, with outcome buckets.
+ *	@return		: The distribution of the investment return.
+ */
+static double
+outcomeDistribution(const MoonfireContext *  context)
+{
+	const AliasTable *	table = &context->outcomeTable;
+	size_t			last = table->numberOfOutcomes - 1;
+	double			distribution = table->values[last];
+	double			tailWeight = context->outcomeWeights[last];
+
+	for (size_t k = last; k-- > 0;)
+	{
+		double	weight = context->outcomeWeights[k];
+
+		tailWeight += weight;
+		if (weight > 0)
+		{
+			distribution = UxHwDoubleMixture(table->values[k], distribution, weight / tailWeight);
+		}
+	}
+
+	return distribution;
+}
+
+/**
+ *	@brief	Populates the `invesmentReturns` array with the initial Bounded Pareto
+ *		distributions, or the distributions of the outcome buckets. Reads values
+ *		from the parameters of the context.
+ *
+ *	@param	context			: The context.
+ *	@param	investmentReturns	: The array of input investment returns.
+ */
+static void
+loadInvestmentReturns(
+	const MoonfireContext *	context,
+	double *		investmentReturns)
+{
+	const MoonfireParameters *	parameters = &context->parameters;
+	const MoonfirePortfolio *	portfolio = parameters->portfolio;
+	double				perInvestmentValue = kMoonfireVentureCapitalConstantsTotalInvestment / parameters->numberOfInvestments;
+
+	if (portfolio != NULL)
+	{
+		for (size_t i = 0; i < parameters->numberOfInvestments; i++)
+		{
+			investmentReturns[i] = UxHwDoubleBoundedparetoDist(
+				portfolio->alpha[i],
+				portfolio->xMin[i],
+				portfolio->xMax[i] + portfolio->xMin[i]);
+			investmentReturns[i] -= portfolio->xMin[i];
+			investmentReturns[i] *= context->portfolioConstants.scale[i];
+		}
+
+		return;
+	}
+
+	/*
+	 *	Each investment gets its own mixture, so that their returns are
+	 *	independent.
+	 */
+	if (parameters->outcomes != NULL)
+	{
+		for (size_t i = 0; i < parameters->numberOfInvestments; i++)
+		{
+			investmentReturns[i] = outcomeDistribution(context);
+		}
+
+		return;
+	}
+
+	for (size_t i = 0; i < parameters->numberOfInvestments; i++)
+	{
+		investmentReturns[i] = UxHwDoubleBoundedparetoDist(
+			parameters->alpha,
+			parameters->xMin,
+			parameters->xMax + parameters->xMin);
+		investmentReturns[i] -= parameters->xMin;
+		investmentReturns[i] *= perInvestmentValue;
+	}
+
+	return;
+}
+
+/**
+ *	@brief	Populates the `invesmentReturns` array with the samples of Monte Carlo
+ *		iteration `iteration`, drawn from the same distributions as in
+ *		`loadInvestmentReturns()` using the vectorized sampling kernels.
+ *
+ *	@param	context			: The context.
+ *	@param	iteration		: Index of the Monte Carlo iteration, from `firstIteration` of the parameters.
+ *	@param	investmentReturns	: The array of input investment returns.
+ */
+static void
+loadInvestmentReturnSamples(
+	const MoonfireContext *	context,
+	size_t			iteration,
+	double *		investmentReturns)
+{
+	uint64_t	streamIteration = context->parameters.firstIteration + iteration;
+
+	/*
+	 *	With a copula, the uniforms come from the factor model, and are then
+	 *	transformed in the same layouts as the independent draws below.
+	 */
+	if (context->parameters.copula != kMoonfireCopulaIndependent)
+	{
+		size_t	batchIndex = iteration % kCopulaConstantIterationBatchSize;
+
+		/*
+		 *	Iterations are loaded in order, so the class factors of a batch
+		 *	are sampled when its first iteration is loaded.
+		 */
+		if (batchIndex == 0)
+		{
+			size_t	remainingIterations = context->parameters.numberOfIterations - iteration;
+
+			sampleCopulaClassFactors(
+				context->kernels,
+				context->numberOfClasses,
+				(context->parameters.classCorrelationMatrix != NULL) ? context->classCholeskyFactor : NULL,
+				context->key,
+				streamIteration * context->copulaVariatesPerIteration,
+				context->copulaVariatesPerIteration,
+				(remainingIterations < kCopulaConstantIterationBatchSize) ? remainingIterations : kCopulaConstantIterationBatchSize,
+				context->classNormals,
+				context->classFactors);
+		}
+
+		sampleCopulaUniforms(
+				context->kernels,
+				&context->copulaConstants,
+				context->investmentClasses,
+				context->parameters.numberOfInvestments,
+				context->numberOfClasses,
+				context->classFactors + batchIndex * context->numberOfClasses,
+				context->key,
+				streamIteration * context->copulaVariatesPerIteration,
+				investmentReturns);
+
+		if (context->isPortfolioSegmented)
+		{
+			for (size_t i = 0; i < context->numberOfPortfolioSegments; i++)
+			{
+				const MoonfirePortfolioSegment *	segment = &context->portfolioSegments[i];
+
+				context->kernels->transformBoundedPareto(investmentReturns + segment->first, segment->count, &segment->constants);
+			}
+		}
+		else if (context->parameters.portfolio != NULL)
+		{
+			context->kernels->transformBoundedParetoArrays(investmentReturns, context->parameters.numberOfInvestments, &context->portfolioConstants);
+		}
+		else
+		{
+			context->kernels->transformBoundedPareto(investmentReturns, context->parameters.numberOfInvestments, &context->constants);
+		}
+
+		return;
+	}
+
+	if (context->isPortfolioSegmented)
+	{
+		for (size_t i = 0; i < context->numberOfPortfolioSegments; i++)
+		{
+			const MoonfirePortfolioSegment *	segment = &context->portfolioSegments[i];
+
+			context->kernels->sampleBoundedPareto(
+					investmentReturns + segment->first,
+					segment->count,
+					&segment->constants,
+					context->key,
+					streamIteration * context->parameters.numberOfInvestments + segment->first);
+		}
+
+		return;
+	}
+
+	if (context->parameters.portfolio != NULL)
+	{
+		context->kernels->sampleBoundedParetoArrays(
+				investmentReturns,
+				context->parameters.numberOfInvestments,
+				&context->portfolioConstants,
+				context->key,
+				streamIteration * context->parameters.numberOfInvestments);
+
+		return;
+	}
+
+	if (context->parameters.outcomes != NULL)
+	{
+		context->kernels->sampleAlias(
+				investmentReturns,
+				context->parameters.numberOfInvestments,
+				&context->outcomeTable,
+				context->key,
+				streamIteration * context->parameters.numberOfInvestments);
+
+		return;
+	}
+
+	if (context->parameters.sampler == kMoonfireSamplerTable)
+	{
+		context->kernels->sampleBoundedParetoTable(
+				investmentReturns,
+				context->parameters.numberOfInvestments,
+				context->boundedParetoTable,
+				context->key,
+				streamIteration * context->parameters.numberOfInvestments);
+
+		return;
+	}
+
+	context->kernels->sampleBoundedPareto(
+			investmentReturns,
+			context->parameters.numberOfInvestments,
+			&context->constants,
+			context->key,
+			streamIteration * context->parameters.numberOfInvestments);
+
+	return;
+}
+
+/**
+ *	@brief	At the first iteration of each outer draw of parameter uncertainty,
+ *		compute the inverse-CDF constants, and the table of the table
+ *		sampler, of the parameters of the draw.
+ *
+ *	@param	context		: The context, with parameter draws.
+ *	@param	iteration	: Index of the Monte Carlo iteration, from `firstIteration` of the parameters.
+ */
+static void
+loadParameterDraw(MoonfireContext *  context, size_t iteration)
+{
+	const MoonfireParameters *	parameters = &context->parameters;
+	size_t				streamIteration = parameters->firstIteration + iteration;
+	const double *			draw;
+
+	if ((iteration != 0) && (streamIteration % parameters->iterationsPerParameterDraw != 0))
+	{
+		return;
+	}
+
+	draw = parameters->parameterDraws + 3 * ((streamIteration / parameters->iterationsPerParameterDraw) % parameters->numberOfParameterDraws);
+	context->constants = computeBoundedParetoConstants(
+				draw[0],
+				draw[1],
+				draw[2] + draw[1],
+				draw[1],
+				kMoonfireVentureCapitalConstantsTotalInvestment / parameters->numberOfInvestments);
+	if (parameters->sampler == kMoonfireSamplerTable)
+	{
+		computeBoundedParetoTable(&context->constants, context->boundedParetoTable);
+	}
+
+	return;
+}
+
+/**
+ *	@brief	Calculates the portfolio return by summing the returns of each individual investment.
+ *		Segment-sampled returns are not yet weighted, so they are summed by weight.
+ *
+ *	@param	context			: The context.
+ *	@param	investmentReturns	: The array of investment returns to populate.
+ *
+ *	@return				: Returns the calculated portfolio return.
+ */
+static double
+calculatePortfolioReturn(
+	const MoonfireContext *	context,
+	double *		investmentReturns)
+{
+	/*
+	 *	The UxHw engine keeps the plain, in-order sum of the original model:
+	 *	on Signaloid cores the returns are distributions, for which the
+	 *	compensation would only add terms.
+	 */
+	if (context->parameters.engine == kMoonfireEngineUxHw)
+	{
+		double	portfolioReturn = 0.0;
+
+		for (size_t i = 0; i < context->parameters.numberOfInvestments; i++)
+		{
+			portfolioReturn += investmentReturns[i];
+		}
+
+		return portfolioReturn;
+	}
+
+	if (context->isPortfolioSegmented)
+	{
+		return context->kernels->dotCompensated(investmentReturns, context->portfolioConstants.scale, context->parameters.numberOfInvestments);
+	}
+
+	return context->kernels->sumCompensated(investmentReturns, context->parameters.numberOfInvestments);
+}
+
+/**
+ *	@brief	Calculates the portfolio return of Monte Carlo iteration `iteration`
+ *		in reduced precision (see `MoonfirePrecision`). The investment
+ *		returns are sampled as floats into the buffer of the investment
+ *		returns, which holds twice as many floats as doubles.
+ *
+ *	@param	context		: The context.
+ *	@param	iteration	: Index of the Monte Carlo iteration, from `firstIteration` of the parameters.
+ *
+ *	@return			: Returns the calculated portfolio return.
+ */
+static double
+calculateReducedPrecisionPortfolioReturn(const MoonfireContext *  context, size_t iteration)
+{
+	float *		investmentReturns = (float *) context->investmentReturns;
+	size_t		numberOfInvestments = context->parameters.numberOfInvestments;
+	uint64_t	streamIteration = context->parameters.firstIteration + iteration;
+
+	context->kernels->sampleBoundedParetoFloat(
+			investmentReturns,
+			numberOfInvestments,
+			&context->constants,
+			context->key,
+			streamIteration * numberOfInvestments);
+
+	if (context->parameters.precision == kMoonfirePrecisionFloat)
+	{
+		return context->kernels->sumFloatsCompensated(investmentReturns, numberOfInvestments);
+	}
+
+	return context->kernels->sumFloats(investmentReturns, numberOfInvestments);
+}
+
+/**
+ *	@brief	Add the investment returns of an iteration to the current timeline
+ *		batch, and simulate the timeline of the batch when it is full or the
+ *		iteration is the last one.
+ *
+ *	@param	context			: The context, with a fund timeline.
+ *	@param	iteration		: Index of the Monte Carlo iteration.
+ *	@param	investmentReturns	: The investment returns of the iteration, in the row of the batch.
+ */
+static void
+addTimelineIteration(
+	const MoonfireContext *	context,
+	size_t			iteration,
+	double *		investmentReturns)
+{
+	size_t	numberOfIterations = context->parameters.numberOfIterations;
+	size_t	batchIterations = context->timelineBatchIterations;
+	size_t	firstIteration = iteration - iteration % batchIterations;
+	size_t	metricsSize = context->parameters.fundLifeYears * numberOfIterations;
+
+	/*
+	 *	Segment-sampled returns are multiples, not yet weighted.
+	 */
+	if (context->isPortfolioSegmented)
+	{
+		for (size_t i = 0; i < context->parameters.numberOfInvestments; i++)
+		{
+			investmentReturns[i] *= context->capital[i];
+		}
+	}
+
+	if ((iteration + 1 - firstIteration < batchIterations) && (iteration + 1 < numberOfIterations))
+	{
+		return;
+	}
+
+	simulateTimelineBatch(
+		context->kernels,
+		&context->timelineSchedule,
+		context->timelineValues,
+		iteration + 1 - firstIteration,
+		context->timelineKey,
+		(uint64_t) (context->parameters.firstIteration + firstIteration) * context->parameters.numberOfInvestments,
+		firstIteration,
+		context->timelineExitYears,
+		numberOfIterations,
+		context->timelineMetrics,
+		context->timelineMetrics + metricsSize,
+		context->timelineMetrics + 2 * metricsSize);
+
+	return;
+}
+
+/**
+ *	@brief	Load the investment returns of an iteration as multiples of the capital
+ *		of each investment into `investmentMultiples`.
+ *
+ *	@param	context			: The context, with the capital of the investments.
+ *	@param	investmentReturns	: The investment returns of the iteration.
+ */
+static void
+loadInvestmentMultiples(const MoonfireContext *  context, const double *  investmentReturns)
+{
+	size_t	n = context->parameters.numberOfInvestments;
+
+	/*
+	 *	Segment-sampled returns are already multiples.
+	 */
+	if (context->isPortfolioSegmented)
+	{
+		memcpy(context->investmentMultiples, investmentReturns, n * sizeof(double));
+
+		return;
+	}
+
+	for (size_t i = 0; i < n; i++)
+	{
+		context->investmentMultiples[i] = investmentReturns[i] * context->inverseCapital[i];
+	}
+
+	return;
+}
+
+/**
+ *	@brief	Calculate the multiple earned by follow-on capital in an iteration (see
+ *		`reserveRatios` of `MoonfireParameters`).
+ *
+ *	@param	context		: The context, with reserve strategies and the investment multiples of the iteration.
+ *	@param	iteration	: Index of the Monte Carlo iteration, from `firstIteration` of the parameters.
+ *	@return			: The follow-on multiple.
+ */
+static double
+calculateFollowOnMultiple(const MoonfireContext *  context, size_t iteration)
+{
+	size_t	n = context->parameters.numberOfInvestments;
+	double	followOnCapital;
+	double	followOnReturn;
+
+	if (context->parameters.followOnSignalNoise > 0)
+	{
+		context->kernels->sampleLognormals(
+				context->followOnThresholds,
+				n,
+				log(context->parameters.followOnThreshold),
+				context->parameters.followOnSignalNoise,
+				context->reserveKey,
+				(uint64_t) (context->parameters.firstIteration + iteration) * n);
+	}
+
+	followOnReturn = context->kernels->dotAboveThresholds(
+				context->investmentMultiples,
+				context->followOnThresholds,
+				context->capital,
+				n,
+				&followOnCapital);
+
+	return (followOnCapital > 0) ? followOnReturn / (followOnCapital * context->parameters.followOnStepUp) : 1.0;
+}
+
+/**
+ *	@brief	Partially sort `values` so that `values[k]` is the k-th smallest value,
+ *		with smaller values before it and larger values after it.
+ *
+ *	@param	values	: The values.
+ *	@param	count	: Number of values.
+ *	@param	k	: 0-indexed rank to select.
+ */
+static void
+selectKthSmallest(double *  values, size_t count, size_t k)
+{
+	size_t	left = 0;
+	size_t	right = count - 1;
+
+	while (left < right)
+	{
+		double	pivot = values[left + (right - left) / 2];
+		size_t	i = left;
+		size_t	j = right;
+
+		while (i <= j)
+		{
+			while (values[i] < pivot)
+			{
+				i++;
+			}
+			while (values[j] > pivot)
+			{
+				j--;
+			}
+			if (i <= j)
+			{
+				double	swap = values[i];
+
+				values[i] = values[j];
+				values[j] = swap;
+				i++;
+				if (j == 0)
+				{
+					break;
+				}
+				j--;
+			}
+		}
+
+		if (k <= j)
+		{
+			right = j;
+		}
+		else if (k >= i)
+		{
+			left = i;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	return;
+}
+
+/**
+ *	@brief	Compute the mean and the sample variance of samples with the
+ *		compensated sums of the kernels, so that the moments of millions of
+ *		heavy-tailed samples keep their precision, and depend only on the
+ *		samples and their order, not on the threads or shards that drew them.
+ *
+ *	@param	samples		: The samples.
+ *	@param	numberOfSamples	: Number of samples, at least 2.
+ *	@return			: The mean and the sample variance.
+ */
+static MeanAndVariance
+calculateMeanAndVariance(const double *  samples, size_t numberOfSamples)
+{
+	const SamplingKernels *	kernels = selectSamplingKernels();
+	double			mean = kernels->sumCompensated(samples, numberOfSamples) / (double) numberOfSamples;
+
+	return (MeanAndVariance)
+	{
+		.mean		= mean,
+		.variance	= kernels->sumSquaredDeviations(samples, numberOfSamples, mean) / (double) (numberOfSamples - 1),
+	};
+}
+
+/**
+ *	@brief	Empirical quantile of `values` by linear interpolation between order
+ *		statistics. Only reorders `values[first..count)`, and leaves values
+ *		before the returned quantile's rank in `values[first..rank)`.
+ *
+ *	@param	values		: The values.
+ *	@param	count		: Number of values.
+ *	@param	first		: Index of the first value that may be reordered; all values before it are smaller.
+ *	@param	probability	: Quantile probability in (0, 1).
+ *	@param	rank		: Pointer to store the lower order statistic used.
+ *	@return			: The quantile.
+ */
+static double
+calculateEmpiricalQuantile(double *  values, size_t count, size_t first, double probability, size_t *  rank)
+{
+	double	position = probability * (double)(count - 1);
+	size_t	k = (size_t) position;
+	double	fraction = position - (double) k;
+	double	next;
+
+	if (k < first)
+	{
+		k = first;
+		fraction = 0.0;
+	}
+
+	selectKthSmallest(values + first, count - first, k - first);
+	*rank = k;
+
+	if (k + 1 >= count)
+	{
+		return values[k];
+	}
+
+	next = values[k + 1];
+	for (size_t i = k + 2; i < count; i++)
+	{
+		next = (values[i] < next) ? values[i] : next;
+	}
+
+	return values[k] + fraction * (next - values[k]);
+}
+
+/**
+ *	@brief	Compute the probability of loss and the quantiles of samples.
+ *
+ *	@param	samples			: The samples.
+ *	@param	numberOfSamples		: Number of samples, at least 1.
+ *	@param	lowQuantileProbability	: Probability of the low quantile.
+ *	@param	highQuantileProbability	: Probability of the high quantile, at least that of the low quantile.
+ *	@param	scratch			: Scratch array of `numberOfSamples` elements.
+ *	@param	statistics		: Pointer to struct to store the probability of loss and the quantiles.
+ */
+static void
+calculateSampleTailStatistics(
+	const double *		samples,
+	size_t			numberOfSamples,
+	double			lowQuantileProbability,
+	double			highQuantileProbability,
+	double *		scratch,
+	MoonfireStatistics *	statistics)
+{
+	size_t	numberOfLosses = 0;
+	size_t	lowRank;
+	size_t	highRank;
+
+	for (size_t i = 0; i < numberOfSamples; i++)
+	{
+		numberOfLosses += (samples[i] <= kMoonfireVentureCapitalConstantsTotalInvestment);
+	}
+
+	memcpy(scratch, samples, numberOfSamples * sizeof(double));
+	statistics->probabilityOfLoss = (double) numberOfLosses / (double) numberOfSamples;
+	statistics->lowQuantile = calculateEmpiricalQuantile(
+					scratch,
+					numberOfSamples,
+					0,
+					lowQuantileProbability,
+					&lowRank);
+	statistics->highQuantile = calculateEmpiricalQuantile(
+					scratch,
+					numberOfSamples,
+					lowRank,
+					highQuantileProbability,
+					&highRank);
+
+	return;
+}
+
+/**
+ *	@brief	Compute the probability of loss and the quantiles of the samples of
+ *		the last simulation, using the scratch buffer of the context.
+ *
+ *	@param	context		: The context.
+ *	@param	samples		: The `numberOfIterations` samples.
+ *	@param	statistics	: Pointer to struct to store the probability of loss and the quantiles.
+ */
+static void
+calculateTailStatistics(const MoonfireContext *  context, const double *  samples, MoonfireStatistics *  statistics)
+{
+	calculateSampleTailStatistics(
+		samples,
+		context->parameters.numberOfIterations,
+		context->parameters.lowQuantileProbability,
+		context->parameters.highQuantileProbability,
+		context->scratch,
+		statistics);
+
+	return;
+}
+
+/**
+ *	@brief	Split a portfolio into segments of consecutive investments of the same
+ *		class, and decide whether the kernels engine samples it by segment:
+ *		only when segments are long enough that per-call overhead is amortized.
+ *		Segment constants are unscaled, as weights are applied when summing.
+ *
+ *	@param	context		: The context.
+ *	@param	parameters	: The new model parameters, with a portfolio.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+computePortfolioSegments(MoonfireContext *  context, const MoonfireParameters *  parameters)
+{
+	const MoonfirePortfolio *	portfolio = parameters->portfolio;
+	size_t				n = portfolio->numberOfInvestments;
+	size_t				numberOfSegments = 1;
+
+	context->isPortfolioSegmented = false;
+	if (parameters->engine != kMoonfireEngineKernels)
+	{
+		return kCommonConstantReturnTypeSuccess;
+	}
+
+	for (size_t i = 1; i < n; i++)
+	{
+		numberOfSegments += (portfolio->alpha[i] != portfolio->alpha[i - 1]) ||
+					(portfolio->xMin[i] != portfolio->xMin[i - 1]) ||
+					(portfolio->xMax[i] != portfolio->xMax[i - 1]);
+	}
+
+	if (n < numberOfSegments * kMoonfireConstantMinimumMeanSegmentLength)
+	{
+		return kCommonConstantReturnTypeSuccess;
+	}
+
+	if (numberOfSegments > context->portfolioSegmentsCapacity)
+	{
+		MoonfirePortfolioSegment *	segments = realloc(context->portfolioSegments, numberOfSegments * sizeof(MoonfirePortfolioSegment));
+
+		if (segments == NULL)
+		{
+			fprintf(stderr, "Error: Could not allocate the portfolio segments buffer.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		context->portfolioSegments = segments;
+		context->portfolioSegmentsCapacity = numberOfSegments;
+	}
+
+	context->numberOfPortfolioSegments = 0;
+	for (size_t i = 0; i < n; i++)
+	{
+		if ((i > 0) &&
+			(portfolio->alpha[i] == portfolio->alpha[i - 1]) &&
+			(portfolio->xMin[i] == portfolio->xMin[i - 1]) &&
+			(portfolio->xMax[i] == portfolio->xMax[i - 1]))
+		{
+			context->portfolioSegments[context->numberOfPortfolioSegments - 1].count++;
+			continue;
+		}
+
+		context->portfolioSegments[context->numberOfPortfolioSegments++] = (MoonfirePortfolioSegment)
+		{
+			.first		= i,
+			.count		= 1,
+			.constants	= computeBoundedParetoConstants(
+						portfolio->alpha[i],
+						portfolio->xMin[i],
+						portfolio->xMax[i] + portfolio->xMin[i],
+						portfolio->xMin[i],
+						1.0),
+		};
+	}
+	context->isPortfolioSegmented = true;
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+static int
+compareInvestmentClassKeys(const void *  a, const void *  b)
+{
+	const MoonfireInvestmentClassKey *	keyA = a;
+	const MoonfireInvestmentClassKey *	keyB = b;
+
+	if (keyA->alpha != keyB->alpha)
+	{
+		return (keyA->alpha < keyB->alpha) ? -1 : 1;
+	}
+	if (keyA->xMin != keyB->xMin)
+	{
+		return (keyA->xMin < keyB->xMin) ? -1 : 1;
+	}
+	if (keyA->xMax != keyB->xMax)
+	{
+		return (keyA->xMax < keyB->xMax) ? -1 : 1;
+	}
+
+	return (keyA->index < keyB->index) ? -1 : (keyA->index > keyB->index);
+}
+
+/**
+ *	@brief	Factor the class correlation matrix of the parameters, unless it
+ *		equals the matrix of the cached factor. Factoring costs
+ *		O(number of classes^3), which would dominate short simulations
+ *		of services that query the same matrix repeatedly.
+ *
+ *	@param	context		: The context, with the investment classes of `parameters`.
+ *	@param	parameters	: The new model parameters, with a class correlation matrix.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+computeClassCholeskyFactor(MoonfireContext *  context, const MoonfireParameters *  parameters)
+{
+	size_t	order = parameters->classCorrelationMatrixOrder;
+	size_t	matrixSize = order * order * sizeof(double);
+
+	if (order != context->numberOfClasses)
+	{
+		fprintf(
+			stderr,
+			"Error: The class correlation matrix has %zu rows, but the portfolio has %zu classes.\n",
+			order,
+			context->numberOfClasses);
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((order == context->classCorrelationsOrder) &&
+		(memcmp(context->classCorrelations, parameters->classCorrelationMatrix, matrixSize) == 0))
+	{
+		return kCommonConstantReturnTypeSuccess;
+	}
+
+	if (order > context->classCorrelationsCapacity)
+	{
+		/*
+		 *	The matrix and its factor share one allocation, owned through
+		 *	`classCorrelations`.
+		 */
+		double *	block = realloc(context->classCorrelations, 2 * matrixSize);
+
+		if (block == NULL)
+		{
+			fprintf(stderr, "Error: Could not allocate the class correlation matrix buffer.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		context->classCorrelations = block;
+		context->classCorrelationsCapacity = order;
+	}
+	context->classCholeskyFactor = context->classCorrelations + order * order;
+
+	context->classCorrelationsOrder = 0;
+	if (computeCholeskyFactor(parameters->classCorrelationMatrix, order, context->classCholeskyFactor) != kCommonConstantReturnTypeSuccess)
+	{
+		fprintf(stderr, "Error: The class correlation matrix is not positive semidefinite.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	memcpy(context->classCorrelations, parameters->classCorrelationMatrix, matrixSize);
+	context->classCorrelationsOrder = order;
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+/**
+ *	@brief	Assign each investment the index of its class, numbering classes in order
+ *		of (alpha, xMin, xMax), and size the buffers of the copula. A
+ *		homogeneous portfolio is a single class.
+ *
+ *	@param	context		: The context.
+ *	@param	parameters	: The new model parameters, with a copula.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+computeInvestmentClasses(MoonfireContext *  context, const MoonfireParameters *  parameters)
+{
+	const MoonfirePortfolio *	portfolio = parameters->portfolio;
+	size_t				n = parameters->numberOfInvestments;
+
+	if (n > context->investmentClassesCapacity)
+	{
+		size_t *	investmentClasses = realloc(context->investmentClasses, n * sizeof(size_t));
+
+		if (investmentClasses == NULL)
+		{
+			fprintf(stderr, "Error: Could not allocate the investment classes buffer.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		context->investmentClasses = investmentClasses;
+		context->investmentClassesCapacity = n;
+	}
+
+	context->numberOfClasses = 1;
+	if (portfolio == NULL)
+	{
+		memset(context->investmentClasses, 0, n * sizeof(size_t));
+	}
+	else
+	{
+		MoonfireInvestmentClassKey *	keys = malloc(n * sizeof(MoonfireInvestmentClassKey));
+
+		if (keys == NULL)
+		{
+			fprintf(stderr, "Error: Could not allocate the investment classes buffer.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		for (size_t i = 0; i < n; i++)
+		{
+			keys[i] = (MoonfireInvestmentClassKey) {.alpha = portfolio->alpha[i], .xMin = portfolio->xMin[i], .xMax = portfolio->xMax[i], .index = i};
+		}
+		qsort(keys, n, sizeof(MoonfireInvestmentClassKey), compareInvestmentClassKeys);
+
+		context->investmentClasses[keys[0].index] = 0;
+		for (size_t i = 1; i < n; i++)
+		{
+			if ((keys[i].alpha != keys[i - 1].alpha) || (keys[i].xMin != keys[i - 1].xMin) || (keys[i].xMax != keys[i - 1].xMax))
+			{
+				context->numberOfClasses++;
+			}
+			context->investmentClasses[keys[i].index] = context->numberOfClasses - 1;
+		}
+
+		free(keys);
+	}
+
+	if (context->numberOfClasses > context->classFactorsCapacity)
+	{
+		size_t		batchSize = kCopulaConstantIterationBatchSize * context->numberOfClasses * sizeof(double);
+		double *	classFactors = realloc(context->classFactors, batchSize);
+		double *	classNormals;
+
+		if (classFactors == NULL)
+		{
+			fprintf(stderr, "Error: Could not allocate the class factors buffer.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+		context->classFactors = classFactors;
+
+		classNormals = realloc(context->classNormals, batchSize);
+		if (classNormals == NULL)
+		{
+			fprintf(stderr, "Error: Could not allocate the class factors buffer.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+		context->classNormals = classNormals;
+		context->classFactorsCapacity = context->numberOfClasses;
+	}
+
+	if ((parameters->classCorrelationMatrix != NULL) &&
+		(computeClassCholeskyFactor(context, parameters) != kCommonConstantReturnTypeSuccess))
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	context->copulaConstants = computeCopulaConstants(parameters);
+	context->copulaVariatesPerIteration = copulaVariatesPerIteration(&context->copulaConstants, context->numberOfClasses, n);
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+/**
+ *	@brief	Compute the per-investment inverse-CDF constants of a heterogeneous
+ *		portfolio, growing their buffer if needed.
+ *
+ *	@param	context		: The context.
+ *	@param	portfolio	: The portfolio.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+computePortfolioConstants(MoonfireContext *  context, const MoonfirePortfolio *  portfolio)
+{
+	BoundedParetoConstantArrays *	constants = &context->portfolioConstants;
+	size_t				n = portfolio->numberOfInvestments;
+	double				totalWeight = 0.0;
+
+	if (n > context->portfolioConstantsCapacity)
+	{
+		/*
+		 *	All five arrays share one allocation, owned through `lowerBound`.
+		 */
+		double *	block = realloc(constants->lowerBound, 5 * n * sizeof(double));
+
+		if (block == NULL)
+		{
+			fprintf(stderr, "Error: Could not allocate the portfolio constants buffer.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		constants->lowerBound = block;
+		constants->oneMinusBoundRatioToAlpha = block + n;
+		constants->negativeInverseAlpha = block + 2 * n;
+		constants->shift = block + 3 * n;
+		constants->scale = block + 4 * n;
+		context->portfolioConstantsCapacity = n;
+	}
+
+	for (size_t i = 0; i < n; i++)
+	{
+		totalWeight += portfolio->weight[i];
+	}
+
+	for (size_t i = 0; i < n; i++)
+	{
+		BoundedParetoConstants	investmentConstants = computeBoundedParetoConstants(
+							portfolio->alpha[i],
+							portfolio->xMin[i],
+							portfolio->xMax[i] + portfolio->xMin[i],
+							portfolio->xMin[i],
+							kMoonfireVentureCapitalConstantsTotalInvestment * portfolio->weight[i] / totalWeight);
+
+		constants->lowerBound[i] = investmentConstants.lowerBound;
+		constants->oneMinusBoundRatioToAlpha[i] = investmentConstants.oneMinusBoundRatioToAlpha;
+		constants->negativeInverseAlpha[i] = investmentConstants.negativeInverseAlpha;
+		constants->shift[i] = investmentConstants.shift;
+		constants->scale[i] = investmentConstants.scale;
+	}
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+/**
+ *	@brief	Grow the capital buffers if needed, and compute the share of each
+ *		investment in the total investment, and its inverse (0 for investments
+ *		without capital). The buffers include the investment multiples of
+ *		`loadInvestmentMultiples()`.
+ *
+ *	@param	context		: The context, with the portfolio constants of `parameters`.
+ *	@param	parameters	: The new model parameters.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+computeInvestmentCapital(MoonfireContext *  context, const MoonfireParameters *  parameters)
+{
+	size_t	n = parameters->numberOfInvestments;
+
+	if (n > context->capitalCapacity)
+	{
+		/*
+		 *	The arrays share one allocation, owned through `capital`.
+		 */
+		double *	block = realloc(context->capital, 3 * n * sizeof(double));
+
+		if (block == NULL)
+		{
+			fprintf(stderr, "Error: Could not allocate the capital buffers.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		context->capital = block;
+		context->capitalCapacity = n;
+	}
+	context->inverseCapital = context->capital + n;
+	context->investmentMultiples = context->capital + 2 * n;
+
+	for (size_t i = 0; i < n; i++)
+	{
+		context->capital[i] = (parameters->portfolio != NULL) ?
+					context->portfolioConstants.scale[i] :
+					kMoonfireVentureCapitalConstantsTotalInvestment / n;
+		context->inverseCapital[i] = (context->capital[i] > 0) ? 1.0 / context->capital[i] : 0.0;
+	}
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+/**
+ *	@brief	Grow the waterfall buffers if needed, and compute the waterfall constants.
+ *
+ *	@param	context		: The context.
+ *	@param	parameters	: The new model parameters, with a waterfall.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+configureWaterfall(MoonfireContext *  context, const MoonfireParameters *  parameters)
+{
+	if (parameters->numberOfIterations > context->netSamplesCapacity)
+	{
+		double *	netSamples = realloc(context->netSamples, parameters->numberOfIterations * sizeof(double));
+
+		if (netSamples == NULL)
+		{
+			fprintf(stderr, "Error: Could not allocate the waterfall buffers.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		context->netSamples = netSamples;
+		context->netSamplesCapacity = parameters->numberOfIterations;
+	}
+
+	context->waterfallConstants = computeWaterfallConstants(parameters);
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+/**
+ *	@brief	Grow the reserve strategy buffers if needed.
+ *
+ *	@param	context		: The context.
+ *	@param	parameters	: The new model parameters, with reserve strategies.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+configureReserves(MoonfireContext *  context, const MoonfireParameters *  parameters)
+{
+	if (parameters->numberOfIterations > context->reserveSamplesCapacity)
+	{
+		/*
+		 *	Both arrays share one allocation, owned through `followOnMultiples`.
+		 */
+		double *	block = realloc(context->followOnMultiples, 2 * parameters->numberOfIterations * sizeof(double));
+
+		if (block == NULL)
+		{
+			fprintf(stderr, "Error: Could not allocate the reserve strategy buffers.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		context->followOnMultiples = block;
+		context->reserveSamplesCapacity = parameters->numberOfIterations;
+	}
+	context->strategySamples = context->followOnMultiples + parameters->numberOfIterations;
+
+	if (parameters->numberOfInvestments > context->followOnThresholdsCapacity)
+	{
+		double *	thresholds = realloc(context->followOnThresholds, parameters->numberOfInvestments * sizeof(double));
+
+		if (thresholds == NULL)
+		{
+			fprintf(stderr, "Error: Could not allocate the reserve strategy buffers.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		context->followOnThresholds = thresholds;
+		context->followOnThresholdsCapacity = parameters->numberOfInvestments;
+	}
+
+	/*
+	 *	Without signal noise, the thresholds are constant.
+	 */
+	for (size_t i = 0; i < parameters->numberOfInvestments; i++)
+	{
+		context->followOnThresholds[i] = parameters->followOnThreshold;
+	}
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+/**
+ *	@brief	Grow the outcome buffers if needed, and build the alias table of the
+ *		outcome buckets, with the value of each bucket in units of the total
+ *		investment.
+ *
+ *	@param	context		: The context.
+ *	@param	parameters	: The new model parameters, with outcome buckets.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+configureOutcomes(MoonfireContext *  context, const MoonfireParameters *  parameters)
+{
+	size_t	count = parameters->numberOfOutcomes;
+	double	perInvestmentValue = kMoonfireVentureCapitalConstantsTotalInvestment / parameters->numberOfInvestments;
+
+	if (count > context->outcomeTableCapacity)
+	{
+		/*
+		 *	The arrays of the table and the weights share one allocation,
+		 *	owned through `outcomeTable.values`.
+		 */
+		double *	block = realloc(context->outcomeTable.values, 4 * count * sizeof(double));
+		size_t *	workspace;
+
+		if (block == NULL)
+		{
+			fprintf(stderr, "Error: Could not allocate the outcome buffers.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+		context->outcomeTable.values = block;
+
+		workspace = realloc(context->outcomeWorkspace, count * sizeof(size_t));
+		if (workspace == NULL)
+		{
+			fprintf(stderr, "Error: Could not allocate the outcome buffers.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+		context->outcomeWorkspace = workspace;
+		context->outcomeTableCapacity = count;
+	}
+	context->outcomeTable.thresholds = context->outcomeTable.values + count;
+	context->outcomeTable.aliasValues = context->outcomeTable.values + 2 * count;
+	context->outcomeWeights = context->outcomeTable.values + 3 * count;
+
+	for (size_t k = 0; k < count; k++)
+	{
+		context->outcomeTable.values[k] = parameters->outcomes[2 * k] * perInvestmentValue;
+		context->outcomeWeights[k] = parameters->outcomes[2 * k + 1];
+	}
+
+	computeAliasTable(context->outcomeWeights, count, context->outcomeWorkspace, &context->outcomeTable);
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+/**
+ *	@brief	Grow the timeline buffers if needed, and compute the timeline schedule.
+ *
+ *	@param	context		: The context, with the capital of the investments of `parameters`.
+ *	@param	parameters	: The new model parameters, with a fund timeline.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+configureTimeline(MoonfireContext *  context, const MoonfireParameters *  parameters)
+{
+	size_t	n = parameters->numberOfInvestments;
+	size_t	batchIterations = timelineBatchIterations(n);
+	size_t	batchSize = batchIterations * n;
+	size_t	metricsSize = 3 * parameters->fundLifeYears * parameters->numberOfIterations;
+
+	if (n > context->timelineInvestmentsCapacity)
+	{
+		double *	entryYears = realloc(context->timelineEntryYears, n * sizeof(double));
+
+		if (entryYears == NULL)
+		{
+			fprintf(stderr, "Error: Could not allocate the timeline buffers.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		context->timelineEntryYears = entryYears;
+		context->timelineInvestmentsCapacity = n;
+	}
+
+	if (batchSize > context->timelineBatchCapacity)
+	{
+		double *	values = realloc(context->timelineValues, batchSize * sizeof(double));
+		double *	exitYears;
+
+		if (values == NULL)
+		{
+			fprintf(stderr, "Error: Could not allocate the timeline buffers.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+		context->timelineValues = values;
+
+		exitYears = realloc(context->timelineExitYears, batchSize * sizeof(double));
+		if (exitYears == NULL)
+		{
+			fprintf(stderr, "Error: Could not allocate the timeline buffers.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+		context->timelineExitYears = exitYears;
+		context->timelineBatchCapacity = batchSize;
+	}
+
+	if (metricsSize > context->timelineMetricsCapacity)
+	{
+		double *	metrics = realloc(context->timelineMetrics, metricsSize * sizeof(double));
+
+		if (metrics == NULL)
+		{
+			fprintf(stderr, "Error: Could not allocate the timeline buffers.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		context->timelineMetrics = metrics;
+		context->timelineMetricsCapacity = metricsSize;
+	}
+
+	computeTimelineEntryYears(parameters, context->timelineEntryYears);
+
+	context->timelineBatchIterations = batchIterations;
+	context->timelineSchedule = (TimelineSchedule)
+	{
+		.numberOfInvestments	= n,
+		.fundLifeYears		= parameters->fundLifeYears,
+		.followOnFraction	= parameters->followOnFraction,
+		.followOnDelayYears	= (double) parameters->followOnDelayYears,
+		.minimumHoldingYears	= parameters->minimumHoldingYears,
+		.numberOfHoldingYears	= parameters->maximumHoldingYears - parameters->minimumHoldingYears + 1,
+		.entryYears		= context->timelineEntryYears,
+		.capital		= context->capital,
+	};
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+/**
+ *	@brief	Compute the per-context state derived from the parameters and grow the
+ *		buffers if needed.
+ *
+ *	@param	context		: The context.
+ *	@param	parameters	: The new model parameters.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+configureContext(MoonfireContext *  context, const MoonfireParameters *  parameters)
+{
+	if (moonfireValidateParameters(parameters) != kCommonConstantReturnTypeSuccess)
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	if (parameters->numberOfInvestments > context->investmentReturnsCapacity)
+	{
+		double *	investmentReturns = realloc(context->investmentReturns, parameters->numberOfInvestments * sizeof(double));
+
+		if (investmentReturns == NULL)
+		{
+			fprintf(stderr, "Error: Could not allocate the investment returns buffer.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		context->investmentReturns = investmentReturns;
+		context->investmentReturnsCapacity = parameters->numberOfInvestments;
+	}
+
+	if (parameters->numberOfIterations > context->samplesCapacity)
+	{
+		double *	samples = realloc(context->samples, parameters->numberOfIterations * sizeof(double));
+		double *	scratch;
+
+		if (samples == NULL)
+		{
+			fprintf(stderr, "Error: Could not allocate the samples buffer.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+		context->samples = samples;
+
+		scratch = realloc(context->scratch, parameters->numberOfIterations * sizeof(double));
+		if (scratch == NULL)
+		{
+			fprintf(stderr, "Error: Could not allocate the scratch buffer.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+		context->scratch = scratch;
+		context->samplesCapacity = parameters->numberOfIterations;
+	}
+
+	context->isPortfolioSegmented = false;
+	if ((parameters->portfolio != NULL) &&
+		((computePortfolioConstants(context, parameters->portfolio) != kCommonConstantReturnTypeSuccess) ||
+		(computePortfolioSegments(context, parameters) != kCommonConstantReturnTypeSuccess)))
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((parameters->copula != kMoonfireCopulaIndependent) &&
+		(computeInvestmentClasses(context, parameters) != kCommonConstantReturnTypeSuccess))
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	if (((parameters->fundLifeYears > 0) || (parameters->waterfall != kMoonfireWaterfallNone) || (parameters->numberOfReserveStrategies > 0)) &&
+		(computeInvestmentCapital(context, parameters) != kCommonConstantReturnTypeSuccess))
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((parameters->fundLifeYears > 0) &&
+		(configureTimeline(context, parameters) != kCommonConstantReturnTypeSuccess))
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((parameters->waterfall != kMoonfireWaterfallNone) &&
+		(configureWaterfall(context, parameters) != kCommonConstantReturnTypeSuccess))
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((parameters->numberOfReserveStrategies > 0) &&
+		(configureReserves(context, parameters) != kCommonConstantReturnTypeSuccess))
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((parameters->outcomes != NULL) &&
+		(configureOutcomes(context, parameters) != kCommonConstantReturnTypeSuccess))
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	context->parameters = *parameters;
+	context->constants = computeBoundedParetoConstants(
+				parameters->alpha,
+				parameters->xMin,
+				parameters->xMax + parameters->xMin,
+				parameters->xMin,
+				kMoonfireVentureCapitalConstantsTotalInvestment / parameters->numberOfInvestments);
+	context->key = deriveStreamKey(parameters->seed);
+	context->timelineKey = deriveStreamKey(context->key);
+	context->reserveKey = deriveStreamKey(context->timelineKey);
+	if (parameters->sampler == kMoonfireSamplerTable)
+	{
+		if (context->boundedParetoTable == NULL)
+		{
+			context->boundedParetoTable = malloc(sizeof(BoundedParetoTable));
+			if (context->boundedParetoTable == NULL)
+			{
+				fprintf(stderr, "Error: Could not allocate the inverse-CDF table.\n");
+
+				return kCommonConstantReturnTypeError;
+			}
+		}
+
+		computeBoundedParetoTable(&context->constants, context->boundedParetoTable);
+	}
+	context->hasSimulated = false;
+	context->hasTailStatistics = false;
+	context->hasNetStatistics = false;
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+CommonConstantReturnType
+moonfireValidateParameters(const MoonfireParameters *  parameters)
+{
+	if (parameters == NULL)
+	{
+		fprintf(stderr, "Error: The provided pointer to parameters is NULL.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((parameters->portfolio == NULL) &&
+		(!(parameters->alpha > 0) || !(parameters->xMin > 0) || !(parameters->xMax >= parameters->xMin)))
+	{
+		fprintf(stderr, "Error: The bounded Pareto parameters must satisfy alpha > 0 and 0 < xMin <= xMax.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if (parameters->portfolio != NULL)
+	{
+		const MoonfirePortfolio *	portfolio = parameters->portfolio;
+		double				totalWeight = 0.0;
+
+		if (portfolio->numberOfInvestments != parameters->numberOfInvestments)
+		{
+			fprintf(stderr, "Error: The number of investments must equal the size of the portfolio.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		for (size_t i = 0; i < portfolio->numberOfInvestments; i++)
+		{
+			if (!(portfolio->alpha[i] > 0) || !(portfolio->xMin[i] > 0) || !(portfolio->xMax[i] >= portfolio->xMin[i]) ||
+				!(portfolio->weight[i] >= 0) || !isfinite(portfolio->xMax[i]) || !isfinite(portfolio->weight[i]))
+			{
+				fprintf(stderr, "Error: Investment %zu of the portfolio must satisfy alpha > 0, 0 < xMin <= xMax and weight >= 0.\n", i);
+
+				return kCommonConstantReturnTypeError;
+			}
+			totalWeight += portfolio->weight[i];
+		}
+
+		if (!(totalWeight > 0))
+		{
+			fprintf(stderr, "Error: The weights of the portfolio must not all be zero.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+	}
+
+	if (parameters->numberOfInvestments < 1)
+	{
+		fprintf(stderr, "Error: The number of investments must be >= 1.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if (!(parameters->lowQuantileProbability > 0) || !(parameters->highQuantileProbability < 1) ||
+		(parameters->highQuantileProbability < parameters->lowQuantileProbability))
+	{
+		fprintf(stderr, "Error: The quantile probabilities must satisfy 0 < low <= high < 1.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if (parameters->numberOfIterations < 1)
+	{
+		fprintf(stderr, "Error: The number of iterations must be >= 1.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if (parameters->firstIteration > SIZE_MAX - parameters->numberOfIterations)
+	{
+		fprintf(stderr, "Error: The first iteration plus the number of iterations must fit a size_t.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((parameters->engine != kMoonfireEngineUxHw) && (parameters->engine != kMoonfireEngineKernels))
+	{
+		fprintf(stderr, "Error: Unknown engine %d.\n", (int) parameters->engine);
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((parameters->copula != kMoonfireCopulaIndependent) && (parameters->copula != kMoonfireCopulaGaussian) &&
+		(parameters->copula != kMoonfireCopulaStudentT))
+	{
+		fprintf(stderr, "Error: Unknown copula %d.\n", (int) parameters->copula);
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((parameters->copula != kMoonfireCopulaIndependent) && (parameters->engine != kMoonfireEngineKernels))
+	{
+		fprintf(stderr, "Error: Copulas need the kernels engine (Monte Carlo mode).\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((parameters->precision != kMoonfirePrecisionDouble) && (parameters->precision != kMoonfirePrecisionMixed) &&
+		(parameters->precision != kMoonfirePrecisionFloat))
+	{
+		fprintf(stderr, "Error: Unknown precision %d.\n", (int) parameters->precision);
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((parameters->precision != kMoonfirePrecisionDouble) &&
+		((parameters->engine != kMoonfireEngineKernels) || (parameters->portfolio != NULL) || (parameters->copula != kMoonfireCopulaIndependent) ||
+		(parameters->fundLifeYears > 0) || (parameters->waterfall != kMoonfireWaterfallNone) || (parameters->numberOfReserveStrategies > 0)))
+	{
+		fprintf(
+			stderr,
+			"Error: Reduced precision needs the kernels engine, a homogeneous portfolio, independent investments, "
+			"and no fund timeline, waterfall or reserve strategies.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((parameters->sampler != kMoonfireSamplerInverseCdf) && (parameters->sampler != kMoonfireSamplerTable))
+	{
+		fprintf(stderr, "Error: Unknown sampler %d.\n", (int) parameters->sampler);
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((parameters->sampler == kMoonfireSamplerTable) &&
+		((parameters->engine != kMoonfireEngineKernels) || (parameters->portfolio != NULL) || (parameters->copula != kMoonfireCopulaIndependent) ||
+		(parameters->precision != kMoonfirePrecisionDouble)))
+	{
+		fprintf(stderr, "Error: The table sampler needs the kernels engine, a homogeneous portfolio, independent investments and double precision.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((parameters->copula != kMoonfireCopulaIndependent) &&
+		(!(parameters->marketCorrelation >= 0) || !(parameters->classCorrelation >= 0) ||
+		!(parameters->marketCorrelation + parameters->classCorrelation <= 1)))
+	{
+		fprintf(stderr, "Error: The copula correlations must be in [0, 1], with a sum of at most 1.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((parameters->copula == kMoonfireCopulaStudentT) &&
+		((parameters->degreesOfFreedom < 1) || (parameters->degreesOfFreedom > kMoonfireConstantMaximumDegreesOfFreedom)))
+	{
+		fprintf(stderr, "Error: The degrees of freedom of the t copula must be in [1, %d].\n", (int) kMoonfireConstantMaximumDegreesOfFreedom);
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((parameters->fundLifeYears > 0) &&
+		((parameters->engine != kMoonfireEngineKernels) || (parameters->fundLifeYears > kMoonfireConstantMaximumFundLifeYears) ||
+		(parameters->deploymentYears < 1) || (parameters->deploymentYears > parameters->fundLifeYears) ||
+		(parameters->minimumHoldingYears < 1) || (parameters->minimumHoldingYears > parameters->maximumHoldingYears) ||
+		(parameters->maximumHoldingYears > kMoonfireConstantMaximumFundLifeYears) ||
+		!(parameters->followOnFraction >= 0) || !(parameters->followOnFraction < 1) || (parameters->followOnDelayYears < 1)))
+	{
+		fprintf(
+			stderr,
+			"Error: The fund timeline needs the kernels engine, a fund life of at most %d years, deployment within the fund life, "
+			"holding periods in [1, %d] years, a follow-on fraction in [0, 1) and a follow-on delay of at least 1 year.\n",
+			(int) kMoonfireConstantMaximumFundLifeYears,
+			(int) kMoonfireConstantMaximumFundLifeYears);
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((parameters->waterfall != kMoonfireWaterfallNone) &&
+		((parameters->engine != kMoonfireEngineKernels) ||
+		!(parameters->managementFeeRate >= 0) || !(parameters->managementFeeRate * (double) parameters->managementFeeYears < 1) ||
+		!(parameters->carriedInterest >= 0) || !(parameters->carriedInterest < 1) ||
+		!(parameters->hurdleRate >= 0) || !isfinite(parameters->hurdleRate) ||
+		!((parameters->catchUp == 0) || ((parameters->catchUp > parameters->carriedInterest) && (parameters->catchUp <= 1)))))
+	{
+		fprintf(
+			stderr,
+			"Error: The waterfall needs the kernels engine, total management fees in [0, 1) of the commitment, "
+			"carried interest in [0, 1), a hurdle rate >= 0 and a catch-up of 0 or in (carried interest, 1].\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if (parameters->numberOfReserveStrategies > kMoonfireConstantMaximumReserveStrategies)
+	{
+		fprintf(stderr, "Error: At most %d reserve strategies are supported.\n", (int) kMoonfireConstantMaximumReserveStrategies);
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if (parameters->numberOfReserveStrategies > 0)
+	{
+		bool	areReserveRatiosValid = true;
+
+		for (size_t s = 0; s < parameters->numberOfReserveStrategies; s++)
+		{
+			areReserveRatiosValid &= (parameters->reserveRatios[s] >= 0) && (parameters->reserveRatios[s] <= 1);
+		}
+
+		if ((parameters->engine != kMoonfireEngineKernels) || !areReserveRatiosValid ||
+			!(parameters->followOnThreshold >= kMoonfireMinimumFollowOnThreshold) || !(parameters->followOnThreshold <= kMoonfireMaximumFollowOnThreshold) ||
+			!(parameters->followOnStepUp >= 1) || !isfinite(parameters->followOnStepUp) ||
+			!(parameters->followOnSignalNoise >= 0) || !(parameters->followOnSignalNoise <= kMoonfireConstantMaximumFollowOnSignalNoise))
+		{
+			fprintf(
+				stderr,
+				"Error: Reserve strategies need the kernels engine, reserve ratios in [0, 1], a follow-on threshold in [%g, %g], "
+				"a follow-on step-up of at least 1 and a follow-on signal noise in [0, %d].\n",
+				kMoonfireMinimumFollowOnThreshold,
+				kMoonfireMaximumFollowOnThreshold,
+				(int) kMoonfireConstantMaximumFollowOnSignalNoise);
+
+			return kCommonConstantReturnTypeError;
+		}
+	}
+
+	if (parameters->parameterDraws != NULL)
+	{
+		bool	areParameterDrawsValid = true;
+
+		for (size_t d = 0; d < parameters->numberOfParameterDraws; d++)
+		{
+			const double *	draw = parameters->parameterDraws + 3 * d;
+
+			areParameterDrawsValid &= (draw[0] > 0) && (draw[1] > 0) && (draw[2] >= draw[1]) && isfinite(draw[0]) && isfinite(draw[2]);
+		}
+
+		if ((parameters->engine != kMoonfireEngineKernels) || (parameters->portfolio != NULL) ||
+			(parameters->numberOfParameterDraws < 1) || (parameters->iterationsPerParameterDraw < 1) || !areParameterDrawsValid)
+		{
+			fprintf(
+				stderr,
+				"Error: Parameter draws need the kernels engine, a homogeneous portfolio, at least one draw with "
+				"alpha > 0 and 0 < xMin <= xMax, and at least one iteration per draw.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+	}
+
+	if (parameters->outcomes != NULL)
+	{
+		bool	areOutcomesValid = true;
+		double	totalWeight = 0.0;
+
+		for (size_t k = 0; k < parameters->numberOfOutcomes; k++)
+		{
+			const double *	outcome = parameters->outcomes + 2 * k;
+
+			areOutcomesValid &= (outcome[0] >= 0) && (outcome[1] >= 0) && isfinite(outcome[0]) && isfinite(outcome[1]);
+			totalWeight += outcome[1];
+		}
+
+		if ((parameters->portfolio != NULL) || (parameters->copula != kMoonfireCopulaIndependent) || (parameters->parameterDraws != NULL) ||
+			(parameters->precision != kMoonfirePrecisionDouble) || (parameters->sampler != kMoonfireSamplerInverseCdf))
+		{
+			fprintf(
+				stderr,
+				"Error: Outcome buckets need a homogeneous portfolio, independent investments, fixed parameters, "
+				"double precision and the inverse-CDF sampler.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		if ((parameters->numberOfOutcomes < 1) || !areOutcomesValid || !(totalWeight > 0) || !isfinite(totalWeight))
+		{
+			fprintf(stderr, "Error: Outcome buckets need at least one bucket, multiples and weights >= 0, and a positive total weight.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+	}
+
+	if (parameters->classCorrelationMatrix != NULL)
+	{
+		size_t		order = parameters->classCorrelationMatrixOrder;
+		const double *	matrix = parameters->classCorrelationMatrix;
+
+		if ((parameters->copula == kMoonfireCopulaIndependent) || (order < 1))
+		{
+			fprintf(stderr, "Error: A class correlation matrix needs a copula and at least one class.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		for (size_t i = 0; i < order; i++)
+		{
+			if (matrix[i * order + i] != 1.0)
+			{
+				fprintf(stderr, "Error: The diagonal of the class correlation matrix must be 1.\n");
+
+				return kCommonConstantReturnTypeError;
+			}
+
+			for (size_t j = 0; j < i; j++)
+			{
+				if (!(fabs(matrix[i * order + j]) <= 1.0) || (matrix[i * order + j] != matrix[j * order + i]))
+				{
+					fprintf(stderr, "Error: The class correlation matrix must be symmetric, with elements in [-1, 1].\n");
+
+					return kCommonConstantReturnTypeError;
+				}
+			}
+		}
+	}
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+MoonfireContext *
+moonfireCreateContext(const MoonfireParameters *  parameters)
+{
+	MoonfireContext *	context = calloc(1, sizeof(MoonfireContext));
+
+	if (context == NULL)
+	{
+		fprintf(stderr, "Error: Could not allocate the context.\n");
+
+		return NULL;
+	}
+
+	context->kernels = selectSamplingKernels();
+
+	if (configureContext(context, parameters) != kCommonConstantReturnTypeSuccess)
+	{
+		moonfireDestroyContext(context);
+
+		return NULL;
+	}
+
+	return context;
+}
+
+CommonConstantReturnType
+moonfireSetParameters(MoonfireContext *  context, const MoonfireParameters *  parameters)
+{
+	if (context == NULL)
+	{
+		fprintf(stderr, "Error: The provided pointer to context is NULL.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	return configureContext(context, parameters);
+}
+
+CommonConstantReturnType
+moonfireSimulate(MoonfireContext *  context)
+{
+	MoonfireParameters *	parameters;
+	double			portfolioReturn = 0.0;
+
+	if (context == NULL)
+	{
+		fprintf(stderr, "Error: The provided pointer to context is NULL.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	parameters = &context->parameters;
+
+	for (size_t i = 0; i < parameters->numberOfIterations; ++i)
+	{
+		/*
+		 *	With a fund timeline, the investment returns of each iteration
+		 *	are kept in its row of the timeline batch.
+		 */
+		double *	investmentReturns = context->investmentReturns;
+
+		if (parameters->fundLifeYears > 0)
+		{
+			investmentReturns = context->timelineValues + (i % context->timelineBatchIterations) * parameters->numberOfInvestments;
+		}
+
+		if (parameters->parameterDraws != NULL)
+		{
+			loadParameterDraw(context, i);
+		}
+
+		/*
+		 *	In reduced precision, the investment returns are sampled and
+		 *	summed as floats, and nothing else uses them.
+		 */
+		if (parameters->precision != kMoonfirePrecisionDouble)
+		{
+			context->samples[i] = calculateReducedPrecisionPortfolioReturn(context, i);
+			continue;
+		}
+
+		/*
+		 *	Load distributions for investment retruns.
+		 */
+		if (parameters->engine == kMoonfireEngineKernels)
+		{
+			loadInvestmentReturnSamples(context, i, investmentReturns);
+		}
+		else
+		{
+			loadInvestmentReturns(context, investmentReturns);
+		}
+
+		/*
+		 *	Calculate the distribution for the total portfolio return.
+		 */
+		portfolioReturn = calculatePortfolioReturn(context, investmentReturns);
+		context->samples[i] = portfolioReturn;
+
+		/*
+		 *	Reserve strategies and the deal-by-deal waterfall share the
+		 *	investment multiples of the iteration.
+		 */
+		if ((parameters->numberOfReserveStrategies > 0) || (parameters->waterfall == kMoonfireWaterfallAmerican))
+		{
+			loadInvestmentMultiples(context, investmentReturns);
+		}
+
+		if (parameters->numberOfReserveStrategies > 0)
+		{
+			context->followOnMultiples[i] = calculateFollowOnMultiple(context, i);
+		}
+
+		if (parameters->waterfall == kMoonfireWaterfallAmerican)
+		{
+			context->netSamples[i] = applyAmericanWaterfall(
+							context->kernels,
+							&context->waterfallConstants,
+							context->investmentMultiples,
+							context->capital,
+							parameters->numberOfInvestments,
+							portfolioReturn);
+		}
+
+		if (parameters->fundLifeYears > 0)
+		{
+			addTimelineIteration(context, i, investmentReturns);
+		}
+	}
+
+	/*
+	 *	The whole-fund waterfall only depends on the portfolio return, so it
+	 *	is applied to all iterations in one pass.
+	 */
+	if (parameters->waterfall == kMoonfireWaterfallEuropean)
+	{
+		applyEuropeanWaterfall(
+			context->kernels,
+			&context->waterfallConstants,
+			context->samples,
+			parameters->numberOfIterations,
+			context->scratch,
+			context->netSamples);
+	}
+
+	/*
+	 *	With more than one iteration, approximate the cost of the third phase of
+	 *	Monte Carlo (post-processing), by calculating the mean and variance.
+	 */
+	context->statistics = (MoonfireStatistics) {0};
+	if (parameters->numberOfIterations > 1)
+	{
+		MeanAndVariance	meanAndVariance = calculateMeanAndVariance(context->samples, parameters->numberOfIterations);
+
+		context->statistics.mean = meanAndVariance.mean;
+		context->statistics.variance = meanAndVariance.variance;
+	}
+	else
+	{
+		context->statistics.mean = portfolioReturn;
+	}
+
+	context->statistics.portfolioReturn = (parameters->engine == kMoonfireEngineUxHw) ? portfolioReturn : context->statistics.mean;
+	context->hasSimulated = true;
+	context->hasTailStatistics = false;
+	context->hasNetStatistics = false;
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+CommonConstantReturnType
+moonfireGetStatistics(MoonfireContext *  context, MoonfireStatistics *  statistics)
+{
+	MoonfireParameters *	parameters;
+
+	if ((context == NULL) || (statistics == NULL))
+	{
+		fprintf(stderr, "Error: The provided pointer to context or statistics is NULL.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if (!context->hasSimulated)
+	{
+		fprintf(stderr, "Error: Statistics requested before simulating.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	parameters = &context->parameters;
+
+	if (!context->hasTailStatistics)
+	{
+		if ((parameters->engine == kMoonfireEngineUxHw) && (parameters->numberOfIterations == 1))
+		{
+			double	portfolioReturn = context->statistics.portfolioReturn;
+
+			context->statistics.probabilityOfLoss = 1.0 - UxHwDoubleProbabilityGT(portfolioReturn, kMoonfireVentureCapitalConstantsTotalInvestment);
+			context->statistics.lowQuantile = UxHwDoubleQuantile(portfolioReturn, parameters->lowQuantileProbability);
+			context->statistics.highQuantile = UxHwDoubleQuantile(portfolioReturn, parameters->highQuantileProbability);
+		}
+		else
+		{
+			calculateTailStatistics(context, context->samples, &context->statistics);
+		}
+
+		context->hasTailStatistics = true;
+	}
+
+	*statistics = context->statistics;
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+CommonConstantReturnType
+moonfireGetNetStatistics(MoonfireContext *  context, MoonfireStatistics *  statistics)
+{
+	if ((context == NULL) || (statistics == NULL) || !context->hasSimulated || (context->parameters.waterfall == kMoonfireWaterfallNone))
+	{
+		fprintf(stderr, "Error: Net statistics requested before simulating a waterfall.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if (!context->hasNetStatistics)
+	{
+		context->netStatistics = (MoonfireStatistics) {0};
+		if (context->parameters.numberOfIterations > 1)
+		{
+			MeanAndVariance	meanAndVariance = calculateMeanAndVariance(context->netSamples, context->parameters.numberOfIterations);
+
+			context->netStatistics.mean = meanAndVariance.mean;
+			context->netStatistics.variance = meanAndVariance.variance;
+		}
+		else
+		{
+			context->netStatistics.mean = context->netSamples[0];
+		}
+
+		context->netStatistics.portfolioReturn = context->netStatistics.mean;
+		calculateTailStatistics(context, context->netSamples, &context->netStatistics);
+		context->hasNetStatistics = true;
+	}
+
+	*statistics = context->netStatistics;
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+CommonConstantReturnType
+moonfireGetReserveStrategies(MoonfireContext *  context, MoonfireStatistics *  statistics)
+{
+	size_t	numberOfSamples;
+
+	if ((context == NULL) || (statistics == NULL) || !context->hasSimulated || (context->parameters.numberOfReserveStrategies == 0))
+	{
+		fprintf(stderr, "Error: Reserve strategies requested before simulating reserve strategies.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	numberOfSamples = context->parameters.numberOfIterations;
+	for (size_t s = 0; s < context->parameters.numberOfReserveStrategies; s++)
+	{
+		double	reserveRatio = context->parameters.reserveRatios[s];
+
+		for (size_t i = 0; i < numberOfSamples; i++)
+		{
+			context->strategySamples[i] = (1.0 - reserveRatio) * context->samples[i] + reserveRatio * context->followOnMultiples[i];
+		}
+
+		statistics[s] = (MoonfireStatistics) {0};
+		if (numberOfSamples > 1)
+		{
+			MeanAndVariance	meanAndVariance = calculateMeanAndVariance(context->strategySamples, numberOfSamples);
+
+			statistics[s].mean = meanAndVariance.mean;
+			statistics[s].variance = meanAndVariance.variance;
+		}
+		else
+		{
+			statistics[s].mean = context->strategySamples[0];
+		}
+
+		statistics[s].portfolioReturn = statistics[s].mean;
+		calculateTailStatistics(context, context->strategySamples, &statistics[s]);
+	}
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+CommonConstantReturnType
+moonfireSimulatePortfolioSizes(
+	MoonfireContext *	context,
+	const size_t *		sizes,
+	size_t			numberOfSizes,
+	MoonfireStatistics *	statistics)
+{
+	const MoonfireParameters *	parameters;
+	size_t				numberOfSamples;
+
+	if ((context == NULL) || (sizes == NULL) || (statistics == NULL))
+	{
+		fprintf(stderr, "Error: The provided pointer to context, sizes or statistics is NULL.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	parameters = &context->parameters;
+	if ((parameters->engine != kMoonfireEngineKernels) || (parameters->portfolio != NULL) || (parameters->precision != kMoonfirePrecisionDouble))
+	{
+		fprintf(stderr, "Error: Portfolio sizes need the kernels engine, a homogeneous portfolio and double precision.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((numberOfSizes == 0) || (numberOfSizes > kMoonfireConstantMaximumPortfolioSizes))
+	{
+		fprintf(stderr, "Error: The number of portfolio sizes must be in [1, %d].\n", (int) kMoonfireConstantMaximumPortfolioSizes);
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	for (size_t k = 0; k < numberOfSizes; k++)
+	{
+		if ((sizes[k] == 0) || (sizes[k] > parameters->numberOfInvestments) || ((k > 0) && (sizes[k] <= sizes[k - 1])))
+		{
+			fprintf(stderr, "Error: The portfolio sizes must be increasing and in [1, number of investments].\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+	}
+
+	numberOfSamples = parameters->numberOfIterations;
+	if (numberOfSizes * numberOfSamples > context->sizeSamplesCapacity)
+	{
+		double *	sizeSamples = realloc(context->sizeSamples, numberOfSizes * numberOfSamples * sizeof(double));
+
+		if (sizeSamples == NULL)
+		{
+			fprintf(stderr, "Error: Could not allocate the portfolio size samples buffer.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		context->sizeSamples = sizeSamples;
+		context->sizeSamplesCapacity = numberOfSizes * numberOfSamples;
+	}
+
+	/*
+	 *	The investment returns are in units of the total investment of the
+	 *	largest portfolio, so the return of the first `n` investments is
+	 *	their running sum rescaled to a total investment of 1.
+	 */
+	for (size_t i = 0; i < numberOfSamples; i++)
+	{
+		double	runningSum = 0.0;
+		double	runningCompensation = 0.0;
+		size_t	first = 0;
+
+		if (parameters->parameterDraws != NULL)
+		{
+			loadParameterDraw(context, i);
+		}
+
+		loadInvestmentReturnSamples(context, i, context->investmentReturns);
+		/*
+		 *	The running sum is compensated as in `calculatePortfolioReturn()`:
+		 *	each investment return is added with TwoSum, and the rounding
+		 *	errors are carried across the sizes in `runningCompensation`.
+		 */
+		for (size_t k = 0; k < numberOfSizes; k++)
+		{
+			for (size_t j = first; j < sizes[k]; j++)
+			{
+				double	investmentReturn = context->investmentReturns[j];
+				double	total = runningSum + investmentReturn;
+				double	returnPart = total - runningSum;
+
+				runningCompensation += (runningSum - (total - returnPart)) + (investmentReturn - returnPart);
+				runningSum = total;
+			}
+
+			context->sizeSamples[k * numberOfSamples + i] = (runningSum + runningCompensation) * (double) parameters->numberOfInvestments / (double) sizes[k];
+			first = sizes[k];
+		}
+	}
+
+	for (size_t k = 0; k < numberOfSizes; k++)
+	{
+		double *	samples = context->sizeSamples + k * numberOfSamples;
+
+		statistics[k] = (MoonfireStatistics) {0};
+		if (numberOfSamples > 1)
+		{
+			MeanAndVariance	meanAndVariance = calculateMeanAndVariance(samples, numberOfSamples);
+
+			statistics[k].mean = meanAndVariance.mean;
+			statistics[k].variance = meanAndVariance.variance;
+		}
+		else
+		{
+			statistics[k].mean = samples[0];
+		}
+
+		statistics[k].portfolioReturn = statistics[k].mean;
+		calculateTailStatistics(context, samples, &statistics[k]);
+	}
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+/**
+ *	@brief	Simulate the iterations of a sketch worker, one chunk at a time, and add
+ *		their portfolio returns to the sketch of the worker.
+ *
+ *	@param	argument	: The `MoonfireSketchWorker`.
+ *	@return			: `NULL`.
+ */
+static void *
+runSketchWorker(void *  argument)
+{
+	MoonfireSketchWorker *	worker = argument;
+	MoonfireParameters	parameters = *worker->parameters;
+	MoonfireContext *	context;
+
+	/*
+	 *	Pin before creating the context, so that its buffers are first
+	 *	touched on the node of the worker.
+	 */
+	pinWorkerThread(worker->thread);
+	parameters.numberOfIterations = (worker->numberOfIterations < kMoonfireConstantSketchChunkIterations) ?
+						worker->numberOfIterations : kMoonfireConstantSketchChunkIterations;
+	context = moonfireCreateContext(&parameters);
+	worker->result = (context != NULL) ? kCommonConstantReturnTypeSuccess : kCommonConstantReturnTypeError;
+
+	for (size_t done = 0; (worker->result == kCommonConstantReturnTypeSuccess) && (done < worker->numberOfIterations); )
+	{
+		size_t	remainingIterations = worker->numberOfIterations - done;
+
+		/*
+		 *	Without a timeline, waterfall or reserves, nothing else of the
+		 *	context depends on the iterations, so chunks only move them.
+		 */
+		context->parameters.firstIteration = worker->firstIteration + done;
+		context->parameters.numberOfIterations = (remainingIterations < parameters.numberOfIterations) ? remainingIterations : parameters.numberOfIterations;
+
+		worker->result = moonfireSimulate(context);
+		if (worker->result == kCommonConstantReturnTypeSuccess)
+		{
+			addQuantileSketchValues(worker->sketch, context->samples, context->parameters.numberOfIterations);
+		}
+		done += context->parameters.numberOfIterations;
+	}
+
+	moonfireDestroyContext(context);
+
+	return NULL;
+}
+
+CommonConstantReturnType
+moonfireSimulateSketch(
+	const MoonfireParameters *	parameters,
+	size_t				numberOfThreads,
+	QuantileSketch *		sketch)
+{
+	MoonfireSketchWorker *		workers;
+	CommonConstantReturnType	result = kCommonConstantReturnTypeSuccess;
+
+	if ((sketch == NULL) || (numberOfThreads == 0))
+	{
+		fprintf(stderr, "Error: The sketch simulation needs a sketch and at least one thread.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if (moonfireValidateParameters(parameters) != kCommonConstantReturnTypeSuccess)
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((parameters->engine != kMoonfireEngineKernels) || (parameters->fundLifeYears > 0) ||
+		(parameters->waterfall != kMoonfireWaterfallNone) || (parameters->numberOfReserveStrategies > 0))
+	{
+		fprintf(stderr, "Error: Quantile sketches need the kernels engine, and no fund timeline, waterfall or reserve strategies.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	numberOfThreads = (numberOfThreads < parameters->numberOfIterations) ? numberOfThreads : parameters->numberOfIterations;
+#if !defined(MOONFIRE_NATIVE)
+	numberOfThreads = 1;
+#endif
+	workers = calloc(numberOfThreads, sizeof(MoonfireSketchWorker));
+	if (workers == NULL)
+	{
+		fprintf(stderr, "Error: Could not allocate the sketch workers.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	/*
+	 *	The first worker adds to the sketch of the caller, and the others to
+	 *	their own sketches, which are merged into it in order.
+	 */
+	for (size_t t = 0; t < numberOfThreads; t++)
+	{
+		workers[t] = (MoonfireSketchWorker) {
+			.parameters	= parameters,
+			.thread		= t,
+			.sketch		= (t == 0) ? sketch : createQuantileSketch(sketch->compression),
+		};
+		moonfireGetIterationRange(parameters->numberOfIterations, numberOfThreads, t, &workers[t].firstIteration, &workers[t].numberOfIterations);
+		workers[t].firstIteration += parameters->firstIteration;
+
+		if (workers[t].sketch == NULL)
+		{
+			result = kCommonConstantReturnTypeError;
+		}
+	}
+
+#if defined(MOONFIRE_NATIVE)
+	if (result == kCommonConstantReturnTypeSuccess)
+	{
+		pthread_t *	threads = calloc(numberOfThreads, sizeof(pthread_t));
+		size_t		numberOfStarted = 0;
+
+		/*
+		 *	The calling thread runs the first worker, and any worker whose
+		 *	thread could not be started.
+		 */
+		for (size_t t = 1; (threads != NULL) && (t < numberOfThreads); t++)
+		{
+			if (pthread_create(&threads[t], NULL, runSketchWorker, &workers[t]) != 0)
+			{
+				break;
+			}
+			numberOfStarted = t;
+		}
+
+		runSketchWorker(&workers[0]);
+		for (size_t t = 1; t <= numberOfStarted; t++)
+		{
+			pthread_join(threads[t], NULL);
+		}
+		for (size_t t = numberOfStarted + 1; t < numberOfThreads; t++)
+		{
+			runSketchWorker(&workers[t]);
+		}
+		free(threads);
+	}
+#else
+	runSketchWorker(&workers[0]);
+#endif
+
+	for (size_t t = 0; t < numberOfThreads; t++)
+	{
+		if (workers[t].result != kCommonConstantReturnTypeSuccess)
+		{
+			result = kCommonConstantReturnTypeError;
+		}
+
+		if (t > 0)
+		{
+			if (result == kCommonConstantReturnTypeSuccess)
+			{
+				mergeQuantileSketch(sketch, workers[t].sketch);
+			}
+			destroyQuantileSketch(workers[t].sketch);
+		}
+	}
+	free(workers);
+
+	return result;
+}
+
+void
+moonfireGetIterationRange(
+	size_t		numberOfIterations,
+	size_t		numberOfParts,
+	size_t		part,
+	size_t *	firstIteration,
+	size_t *	numberOfPartIterations)
+{
+	size_t	share = numberOfIterations / numberOfParts;
+	size_t	remainder = numberOfIterations % numberOfParts;
+
+	*firstIteration = part * share + ((part < remainder) ? part : remainder);
+	*numberOfPartIterations = share + ((part < remainder) ? 1 : 0);
+
+	return;
+}
+
+CommonConstantReturnType
+moonfireCalculateSampleStatistics(
+	const double *		samples,
+	size_t			numberOfSamples,
+	double			lowQuantileProbability,
+	double			highQuantileProbability,
+	MoonfireStatistics *	statistics)
+{
+	double *	scratch;
+
+	if ((samples == NULL) || (statistics == NULL) || (numberOfSamples == 0) ||
+		!(lowQuantileProbability >= 0) || !(highQuantileProbability >= lowQuantileProbability) || !(highQuantileProbability <= 1))
+	{
+		fprintf(stderr, "Error: Sample statistics need at least one sample and quantile probabilities 0 <= low <= high <= 1.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	scratch = malloc(numberOfSamples * sizeof(double));
+	if (scratch == NULL)
+	{
+		fprintf(stderr, "Error: Could not allocate the scratch buffer.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	*statistics = (MoonfireStatistics) {0};
+	if (numberOfSamples > 1)
+	{
+		MeanAndVariance	meanAndVariance = calculateMeanAndVariance(samples, numberOfSamples);
+
+		statistics->mean = meanAndVariance.mean;
+		statistics->variance = meanAndVariance.variance;
+	}
+	else
+	{
+		statistics->mean = samples[0];
+	}
+	statistics->portfolioReturn = statistics->mean;
+	calculateSampleTailStatistics(samples, numberOfSamples, lowQuantileProbability, highQuantileProbability, scratch, statistics);
+	free(scratch);
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+CommonConstantReturnType
+moonfireGetParameterUncertainty(const MoonfireContext *  context, MoonfireParameterUncertainty *  uncertainty)
+{
+	size_t	numberOfSamples;
+	size_t	blockSize;
+	double	mean;
+
+	if ((context == NULL) || (uncertainty == NULL) || !context->hasSimulated || (context->parameters.parameterDraws == NULL))
+	{
+		fprintf(stderr, "Error: Parameter uncertainty requested before simulating parameter draws.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	numberOfSamples = context->parameters.numberOfIterations;
+	blockSize = context->parameters.iterationsPerParameterDraw;
+	mean = context->statistics.mean;
+	*uncertainty = (MoonfireParameterUncertainty) {0};
+
+	/*
+	 *	Population variances, weighted by the number of iterations of each
+	 *	outer draw, so that the two parts sum to the variance of all samples.
+	 *	Outer draws start at multiples of `iterationsPerParameterDraw` of the
+	 *	stream, so the samples of a part that starts within an outer draw
+	 *	begin with the rest of that draw.
+	 */
+	for (size_t first = 0, end = blockSize - context->parameters.firstIteration % blockSize; first < numberOfSamples; first = end, end += blockSize)
+	{
+		size_t	count = ((end < numberOfSamples) ? end : numberOfSamples) - first;
+		double	blockMean = context->kernels->sumCompensated(context->samples + first, count) / (double) count;
+
+		uncertainty->betweenDrawVariance += (double) count * (blockMean - mean) * (blockMean - mean);
+		uncertainty->withinDrawVariance += context->kernels->sumSquaredDeviations(context->samples + first, count, blockMean);
+		uncertainty->numberOfOuterDraws++;
+	}
+
+	uncertainty->betweenDrawVariance /= (double) numberOfSamples;
+	uncertainty->withinDrawVariance /= (double) numberOfSamples;
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+CommonConstantReturnType
+moonfireGetHistogram(const MoonfireContext *  context, MoonfireHistogram *  histogram)
+{
+	size_t		numberOfSamples;
+	double		logLowerEdge;
+	double		inverseLogBinWidth;
+
+	if ((context == NULL) || (histogram == NULL) || !context->hasSimulated)
+	{
+		fprintf(stderr, "Error: Histogram requested before simulating.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	numberOfSamples = context->parameters.numberOfIterations;
+	*histogram = (MoonfireHistogram) {0};
+	histogram->lowerEdge = context->samples[0];
+	histogram->upperEdge = context->samples[0];
+	for (size_t i = 1; i < numberOfSamples; i++)
+	{
+		histogram->lowerEdge = (context->samples[i] < histogram->lowerEdge) ? context->samples[i] : histogram->lowerEdge;
+		histogram->upperEdge = (context->samples[i] > histogram->upperEdge) ? context->samples[i] : histogram->upperEdge;
+	}
+
+	/*
+	 *	Degenerate ranges, which cannot be binned in log space, go in the first bin.
+	 */
+	if (!(histogram->lowerEdge > 0) || !(histogram->upperEdge > histogram->lowerEdge))
+	{
+		histogram->counts[0] = numberOfSamples;
+
+		return kCommonConstantReturnTypeSuccess;
+	}
+
+	logLowerEdge = log(histogram->lowerEdge);
+	inverseLogBinWidth = kMoonfireConstantHistogramNumberOfBins / (log(histogram->upperEdge) - logLowerEdge);
+	for (size_t i = 0; i < numberOfSamples; i++)
+	{
+		size_t	bin = (size_t)((log(context->samples[i]) - logLowerEdge) * inverseLogBinWidth);
+
+		histogram->counts[(bin < kMoonfireConstantHistogramNumberOfBins) ? bin : kMoonfireConstantHistogramNumberOfBins - 1]++;
+	}
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+CommonConstantReturnType
+moonfireGetTimeline(MoonfireContext *  context, MoonfireTimelineYear *  years)
+{
+	size_t	numberOfSamples;
+	size_t	fundLifeYears;
+
+	if ((context == NULL) || (years == NULL) || !context->hasSimulated || (context->parameters.fundLifeYears == 0))
+	{
+		fprintf(stderr, "Error: Timeline requested before simulating a fund timeline.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	numberOfSamples = context->parameters.numberOfIterations;
+	fundLifeYears = context->parameters.fundLifeYears;
+	for (size_t year = 0; year < fundLifeYears; year++)
+	{
+		MoonfireQuantileBand *	bands[] = {&years[year].distributedToPaidIn, &years[year].totalValueToPaidIn, &years[year].netCashFlow};
+
+		for (size_t metric = 0; metric < sizeof(bands) / sizeof(bands[0]); metric++)
+		{
+			double *	samples = context->timelineMetrics + (metric * fundLifeYears + year) * numberOfSamples;
+			size_t		rank;
+
+			/*
+			 *	The quantile probabilities need not bracket 0.5, so each
+			 *	selection starts from the first sample.
+			 */
+			bands[metric]->low = calculateEmpiricalQuantile(samples, numberOfSamples, 0, context->parameters.lowQuantileProbability, &rank);
+			bands[metric]->median = calculateEmpiricalQuantile(samples, numberOfSamples, 0, 0.5, &rank);
+			bands[metric]->high = calculateEmpiricalQuantile(samples, numberOfSamples, 0, context->parameters.highQuantileProbability, &rank);
+		}
+	}
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+double
+moonfireGetPortfolioReturn(const MoonfireContext *  context)
+{
+	return context->statistics.portfolioReturn;
+}
+
+const double *
+moonfireGetSamples(const MoonfireContext *  context, size_t *  numberOfSamples)
+{
+	*numberOfSamples = context->hasSimulated ? context->parameters.numberOfIterations : 0;
+
+	return context->samples;
+}
+
+const char *
+moonfireGetKernelVariantName(const MoonfireContext *  context)
+{
+	return context->kernels->name;
+}
+
+void
+moonfireDestroyContext(MoonfireContext *  context)
+{
+	if (context == NULL)
+	{
+		return;
+	}
+
+	free(context->investmentReturns);
+	free(context->samples);
+	free(context->scratch);
+	free(context->boundedParetoTable);
+	free(context->outcomeTable.values);
+	free(context->outcomeWorkspace);
+	free(context->portfolioConstants.lowerBound);
+	free(context->portfolioSegments);
+	free(context->investmentClasses);
+	free(context->classFactors);
+	free(context->classNormals);
+	free(context->classCorrelations);
+	free(context->capital);
+	free(context->timelineEntryYears);
+	free(context->timelineValues);
+	free(context->timelineExitYears);
+	free(context->timelineMetrics);
+	free(context->netSamples);
+	free(context->followOnMultiples);
+	free(context->followOnThresholds);
+	free(context->sizeSamples);
+	free(context);
+
+	return;
+}
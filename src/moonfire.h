@@ -0,0 +1,665 @@
+/*
+ *	Copyright (c) 2024, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "common.h"
+#include "sketch.h"
+
+
+/*
+ *	libmoonfire: the portfolio model, independent of the command-line interface.
+ *
+ *	A `MoonfireContext` owns the model parameters, the random stream and all
+ *	buffers of a simulation. Contexts do not share state, so a multi-threaded
+ *	service can run one context per thread, and reuse it across queries with
+ *	`moonfireSetParameters()` without reallocating.
+ */
+
+typedef enum
+{
+	/*
+	 *	Version of the model. Increment it with every change that alters the
+	 *	results of a simulation for the same parameters, so that cached
+	 *	results of older versions are not reused.
+	 */
+	kMoonfireConstantModelVersion		= 3,
+	kMoonfireConstantHistogramNumberOfBins	= 64,
+
+	/*
+	 *	Minimum mean number of investments per class (see `MoonfirePortfolio`)
+	 *	for the kernels engine to sample a portfolio class by class.
+	 */
+	kMoonfireConstantMinimumMeanSegmentLength	= 8,
+	kMoonfireConstantMaximumDegreesOfFreedom	= 100,
+	kMoonfireConstantMaximumFundLifeYears		= 30,
+	kMoonfireConstantMaximumReserveStrategies	= 8,
+	kMoonfireConstantMaximumFollowOnSignalNoise	= 10,
+	kMoonfireConstantMaximumPortfolioSizes		= 64,
+
+	/*
+	 *	Iterations that a worker of `moonfireSimulateSketch()` simulates at
+	 *	a time, so that its buffers do not grow with the number of iterations.
+	 */
+	kMoonfireConstantSketchChunkIterations		= 65536,
+} MoonfireConstant;
+
+typedef enum
+{
+	/*
+	 *	Evaluate the model with the UxHw API. On Signaloid cores, a single
+	 *	iteration yields the full distribution of the portfolio return. In
+	 *	native builds, each iteration yields one sample.
+	 */
+	kMoonfireEngineUxHw	= 0,
+
+	/*
+	 *	Native Monte Carlo evaluation with the vectorized sampling kernels.
+	 */
+	kMoonfireEngineKernels	= 1,
+} MoonfireEngine;
+
+/*
+ *	Floating-point precision of the sampling of the kernels engine. The
+ *	reduced precisions draw the uniform variates of `kMoonfirePrecisionDouble`
+ *	rounded to float, and evaluate the bounded Pareto inverse CDF in float,
+ *	with twice the vector lanes of double, so each iteration simulates the
+ *	same draws as in double precision up to rounding. The relative error of
+ *	an investment return is a few float ulp (about 1e-6) for most draws, and
+ *	grows towards `xMax`, where `1 - u * (1 - (xMin / xMax)^alpha)` loses
+ *	the bits of `u` to cancellation: with the default model, the portfolio
+ *	return of an iteration differs from double precision by up to about
+ *	2e-4 relative, and the mean by about 1e-6. They need a homogeneous portfolio,
+ *	independent investments, and no fund timeline, waterfall or reserve
+ *	strategies.
+ */
+typedef enum
+{
+	kMoonfirePrecisionDouble	= 0,
+
+	/*
+	 *	Investment returns in float, summed in double.
+	 */
+	kMoonfirePrecisionMixed		= 1,
+
+	/*
+	 *	Investment returns in float, summed in float with compensated
+	 *	partial sums.
+	 */
+	kMoonfirePrecisionFloat		= 2,
+} MoonfirePrecision;
+
+/*
+ *	Sampler of the bounded Pareto inverse CDF of the kernels engine, in
+ *	double precision. Both samplers draw the same uniform variates.
+ */
+typedef enum
+{
+	/*
+	 *	Polynomial logarithm and exponential of each draw.
+	 */
+	kMoonfireSamplerInverseCdf	= 0,
+
+	/*
+	 *	Lookup table of the inverse CDF, built once for the parameters (see
+	 *	`BoundedParetoTable`), with a relative error of at most
+	 *	`|binomial(-1 / alpha, 4)| * 2^-44` and a few ulp over the whole
+	 *	range, e.g., 5e-14 for alpha 1.05 and 3e-13 for alpha 0.5. It needs a
+	 *	homogeneous portfolio and independent investments.
+	 */
+	kMoonfireSamplerTable		= 1,
+} MoonfireSampler;
+
+/*
+ *	Dependence between investment returns. With a copula, investment `i`
+ *	returns the bounded Pareto quantile of `U[i]`, with `U[i]` a function of
+ *	the latent factor model
+ *
+ *		Z[i] = sqrt(marketCorrelation) * M + sqrt(classCorrelation) * C[class(i)]
+ *			+ sqrt(1 - marketCorrelation - classCorrelation) * E[i],
+ *
+ *	where the market factor `M`, one factor `C` per portfolio class (see
+ *	`MoonfirePortfolio`) and the idiosyncratic `E` are standard normals. The
+ *	class factors are independent, or have the correlation matrix
+ *	`classCorrelationMatrix` of `MoonfireParameters`, so that investments of
+ *	classes `a` and `b` have latent correlation
+ *	`marketCorrelation + classCorrelation * classCorrelationMatrix[a][b]`.
+ *	Sampling costs O(number of investments + number of classes^2) per
+ *	iteration, instead of O(number of investments^2) for a dense Cholesky
+ *	factor of the investment correlation matrix. Copulas need the kernels
+ *	engine.
+ */
+typedef enum
+{
+	/*
+	 *	Independent investments.
+	 */
+	kMoonfireCopulaIndependent	= 0,
+
+	/*
+	 *	U[i] = Phi(Z[i]), with Phi the standard normal CDF.
+	 */
+	kMoonfireCopulaGaussian		= 1,
+
+	/*
+	 *	U[i] = T(Z[i] / sqrt(W / degreesOfFreedom)), with T the CDF of the
+	 *	Student t distribution and W a chi-square variate with
+	 *	`degreesOfFreedom` degrees of freedom shared by all investments. The
+	 *	shared W makes extreme outcomes coincide (tail dependence), e.g.,
+	 *	simultaneous losses in a down market.
+	 */
+	kMoonfireCopulaStudentT		= 2,
+} MoonfireCopula;
+
+/*
+ *	Distribution waterfall between the limited partners (LPs) and the general
+ *	partner (GP) of the fund, applied to the simulated proceeds of each
+ *	iteration to give the net multiple of the LPs on their commitment.
+ *
+ *	Management fees of `managementFeeRate` of the commitment per year for
+ *	`managementFeeYears` years are paid out of the commitment, and the rest
+ *	is invested, so the proceeds are the portfolio return times the invested
+ *	fraction. The proceeds first return the paid-in capital (the
+ *	commitment) to the LPs, then a preferred return of `hurdleRate` per year,
+ *	compounded over `hurdleYears` years. With a catch-up, the GP then receives
+ *	a share `catchUp` of the proceeds until it holds `carriedInterest` of the
+ *	profits, and the remaining proceeds are split `carriedInterest` to the GP
+ *	and the rest to the LPs. Without a catch-up (`catchUp` of 0), the GP only
+ *	receives `carriedInterest` of the proceeds above the preferred return.
+ */
+typedef enum
+{
+	/*
+	 *	No fees or carried interest.
+	 */
+	kMoonfireWaterfallNone		= 0,
+
+	/*
+	 *	Whole-fund waterfall: carried interest on the proceeds of the fund.
+	 */
+	kMoonfireWaterfallEuropean	= 1,
+
+	/*
+	 *	Deal-by-deal waterfall: carried interest on the proceeds of each
+	 *	investment, with its capital and its share of the fees as paid-in
+	 *	capital, and no clawback of the carried interest of winners by the
+	 *	losses of other investments.
+	 */
+	kMoonfireWaterfallAmerican	= 2,
+} MoonfireWaterfall;
+
+/*
+ *	Per-investment parameters of a heterogeneous portfolio, in
+ *	structure-of-arrays layout. Investments with the same `alpha`, `xMin` and
+ *	`xMax` form a class, and consecutive investments of the same class form a
+ *	segment, which the kernels engine samples in one constant-parameter batch. Investment `i` returns
+ *	`(BoundedPareto(alpha[i], xMin[i], xMax[i] + xMin[i]) - xMin[i]) * w[i]`,
+ *	where `w[i]` is `weight[i]` normalized so that the weights sum to the
+ *	total investment. See `portfolio.h` for loading portfolios from files.
+ */
+typedef struct
+{
+	size_t		numberOfInvestments;
+	double *	alpha;
+	double *	xMin;
+	double *	xMax;
+	double *	weight;
+} MoonfirePortfolio;
+
+typedef struct
+{
+	double		alpha;
+	double		xMin;
+	double		xMax;
+	size_t		numberOfInvestments;
+	double		lowQuantileProbability;
+	double		highQuantileProbability;
+	size_t		numberOfIterations;
+	uint64_t	seed;
+	MoonfireEngine	engine;
+
+	/*
+	 *	Precision of the kernels engine (see `MoonfirePrecision`).
+	 */
+	MoonfirePrecision	precision;
+
+	/*
+	 *	Sampler of the kernels engine (see `MoonfireSampler`).
+	 */
+	MoonfireSampler		sampler;
+
+	/*
+	 *	Index of the first iteration in the random streams of the kernels
+	 *	engine, so that simulating iterations [firstIteration,
+	 *	firstIteration + numberOfIterations) of a larger simulation, e.g., in
+	 *	a worker thread or on another host, gives the same samples as the
+	 *	larger simulation. 0 for a whole simulation.
+	 */
+	size_t		firstIteration;
+
+	/*
+	 *	Dependence between investments (see `MoonfireCopula`). The
+	 *	correlations are in [0, 1] with a sum of at most 1, and
+	 *	`degreesOfFreedom`, used by `kMoonfireCopulaStudentT` only, is in
+	 *	[1, kMoonfireConstantMaximumDegreesOfFreedom].
+	 */
+	MoonfireCopula	copula;
+	double		marketCorrelation;
+	double		classCorrelation;
+	size_t		degreesOfFreedom;
+
+	/*
+	 *	Correlation matrix of the class factors of a copula, row-major, with
+	 *	one row per portfolio class in order of (alpha, xMin, xMax), or `NULL`
+	 *	for independent class factors. `classCorrelationMatrixOrder` must
+	 *	equal the number of classes of the portfolio. The context copies the
+	 *	matrix and reuses its Cholesky factor while the matrix is unchanged.
+	 */
+	const double *	classCorrelationMatrix;
+	size_t		classCorrelationMatrixOrder;
+
+	/*
+	 *	Fund timeline (see `MoonfireTimelineYear`), simulated when
+	 *	`fundLifeYears` is in [1, kMoonfireConstantMaximumFundLifeYears], or
+	 *	0 to only simulate the terminal portfolio return. The timeline needs
+	 *	the kernels engine. `deploymentYears` is in [1, fundLifeYears],
+	 *	holding periods are in [1, kMoonfireConstantMaximumFundLifeYears],
+	 *	`followOnFraction` is in [0, 1) and `followOnDelayYears` >= 1.
+	 */
+	size_t		fundLifeYears;
+	size_t		deploymentYears;
+	size_t		minimumHoldingYears;
+	size_t		maximumHoldingYears;
+	double		followOnFraction;
+	size_t		followOnDelayYears;
+
+	/*
+	 *	Fee and carried-interest waterfall (see `MoonfireWaterfall`). A
+	 *	waterfall needs the kernels engine. `managementFeeRate` times
+	 *	`managementFeeYears` is in [0, 1), `carriedInterest` is in [0, 1),
+	 *	`hurdleRate` >= 0, and `catchUp` is 0 or in (carriedInterest, 1].
+	 */
+	MoonfireWaterfall	waterfall;
+	double			managementFeeRate;
+	size_t			managementFeeYears;
+	double			carriedInterest;
+	double			hurdleRate;
+	size_t			hurdleYears;
+	double			catchUp;
+
+	/*
+	 *	Follow-on reserve strategies, evaluated on the same draws as the
+	 *	portfolio return. Strategy `s` holds back a fraction
+	 *	`reserveRatios[s]` in [0, 1] of the total investment, and invests
+	 *	the rest as the portfolio. The reserve then follows on into the
+	 *	investments that look like winners at the follow-on round, pro rata
+	 *	to their capital, at a price `followOnStepUp` times that of the
+	 *	initial investment, so that follow-on capital earns the multiple of
+	 *	the investment divided by `followOnStepUp`. An investment looks like
+	 *	a winner when its multiple is at least `followOnThreshold` times
+	 *	`exp(followOnSignalNoise * Z)`, with `Z` a standard normal per
+	 *	investment and iteration, so that 0 is perfect information. When no
+	 *	investment looks like a winner, the reserve is returned. Strategies
+	 *	need the kernels engine, `followOnThreshold` > 0, `followOnStepUp` >= 1
+	 *	and `followOnSignalNoise` in [0, kMoonfireConstantMaximumFollowOnSignalNoise].
+	 */
+	double			reserveRatios[kMoonfireConstantMaximumReserveStrategies];
+	size_t			numberOfReserveStrategies;
+	double			followOnThreshold;
+	double			followOnStepUp;
+	double			followOnSignalNoise;
+
+	/*
+	 *	Parameter uncertainty, or `NULL` for the fixed `alpha`, `xMin` and
+	 *	`xMax`. `parameterDraws` holds `numberOfParameterDraws` draws of
+	 *	(alpha, xMin, xMax), row-major, e.g., a prior or posterior sample.
+	 *	Iterations are simulated in outer draws of `iterationsPerParameterDraw`
+	 *	iterations, and outer draw `d` uses the parameters of draw
+	 *	`d % numberOfParameterDraws`, so that the inverse-CDF constants are
+	 *	computed once per outer draw. Needs the kernels engine and a
+	 *	homogeneous portfolio. The context does not copy the draws.
+	 */
+	const double *	parameterDraws;
+	size_t		numberOfParameterDraws;
+	size_t		iterationsPerParameterDraw;
+
+	/*
+	 *	Discrete outcome buckets, or `NULL` for the bounded Pareto
+	 *	distribution. `outcomes` holds `numberOfOutcomes` rows of (multiple,
+	 *	weight), row-major, e.g., the empirical 0x, 1x, 3x, 10x and 100x
+	 *	buckets of a vintage, and each investment returns `multiple` times its
+	 *	cheque with probability proportional to `weight`. The kernels engine
+	 *	samples them with an alias table (see `AliasTable`), the UxHw engine
+	 *	as a mixture. Needs a homogeneous portfolio, independent investments,
+	 *	fixed parameters, double precision and the inverse-CDF sampler. The
+	 *	context does not copy the outcomes.
+	 */
+	const double *	outcomes;
+	size_t		numberOfOutcomes;
+
+	/*
+	 *	Heterogeneous portfolio, or `NULL` for `numberOfInvestments` equal
+	 *	investments with parameters `alpha`, `xMin` and `xMax`. When set, it
+	 *	replaces `alpha`, `xMin` and `xMax`, and `numberOfInvestments` must
+	 *	equal `portfolio->numberOfInvestments`. The context does not copy the
+	 *	portfolio, which must outlive its use.
+	 */
+	const MoonfirePortfolio *	portfolio;
+} MoonfireParameters;
+
+typedef struct
+{
+	/*
+	 *	With the UxHw engine, the portfolio return of the last iteration,
+	 *	which on Signaloid cores carries the full distribution. With the
+	 *	kernels engine, the Monte Carlo mean of the portfolio return.
+	 */
+	double	portfolioReturn;
+	double	mean;
+	double	variance;
+	double	probabilityOfLoss;
+	double	lowQuantile;
+	double	highQuantile;
+} MoonfireStatistics;
+
+/*
+ *	Histogram of the portfolio return, with bins uniform in log(portfolio return)
+ *	between `lowerEdge` and `upperEdge`, the smallest and largest sample.
+ */
+typedef struct
+{
+	double		lowerEdge;
+	double		upperEdge;
+	uint64_t	counts[kMoonfireConstantHistogramNumberOfBins];
+} MoonfireHistogram;
+
+/*
+ *	Quantiles of a fund metric over the iterations, at the low and high
+ *	quantile probabilities of the parameters and at 0.5.
+ */
+typedef struct
+{
+	double	low;
+	double	median;
+	double	high;
+} MoonfireQuantileBand;
+
+/*
+ *	Metrics of the fund at the end of a year of the fund timeline, relative to
+ *	the total commitment.
+ *
+ *	Initial investments are staged evenly over the first `deploymentYears`
+ *	years, in portfolio order. A fraction `followOnFraction` of the capital of
+ *	each investment is reserved for a follow-on `followOnDelayYears` later,
+ *	which is only called if the investment has not exited by then and the
+ *	fund life has not ended. Each investment exits after a holding period
+ *	uniform in [minimumHoldingYears, maximumHoldingYears] whole years, drawn
+ *	independently of its return, and returns its sampled multiple of the
+ *	capital invested in it. Until its exit, it is marked linearly from cost to
+ *	its exit value. Investments that exit after the fund life remain in the
+ *	net asset value of the last year.
+ */
+typedef struct
+{
+	/*
+	 *	Distributions to paid-in capital (DPI).
+	 */
+	MoonfireQuantileBand	distributedToPaidIn;
+
+	/*
+	 *	Distributions plus net asset value, to paid-in capital (TVPI).
+	 */
+	MoonfireQuantileBand	totalValueToPaidIn;
+
+	/*
+	 *	Cumulative distributions minus paid-in capital, as a fraction of the
+	 *	commitment. Its median over the years traces the J-curve.
+	 */
+	MoonfireQuantileBand	netCashFlow;
+} MoonfireTimelineYear;
+
+/*
+ *	Decomposition of the variance of the portfolio return over the outer draws
+ *	of parameter uncertainty, by the law of total variance: the variance of the
+ *	means of the outer draws (parameter uncertainty) plus the mean of the
+ *	variances within the outer draws (investment outcomes).
+ */
+typedef struct
+{
+	size_t	numberOfOuterDraws;
+	double	betweenDrawVariance;
+	double	withinDrawVariance;
+} MoonfireParameterUncertainty;
+
+typedef struct MoonfireContext	MoonfireContext;
+
+/**
+ *	@brief	Check that model parameters are within their valid ranges.
+ *
+ *	@param	parameters	: The parameters to check.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if valid, else `kCommonConstantReturnTypeError`.
+ */
+CommonConstantReturnType	moonfireValidateParameters(const MoonfireParameters *  parameters);
+
+/**
+ *	@brief	Create a context and allocate all buffers needed to simulate `parameters`.
+ *
+ *	@param	parameters	: The model parameters.
+ *	@return			: The new context, or `NULL` if the parameters are invalid or allocation failed.
+ */
+MoonfireContext *		moonfireCreateContext(const MoonfireParameters *  parameters);
+
+/**
+ *	@brief	Replace the parameters of a context. Buffers are only reallocated when
+ *		they need to grow, so reusing a context across queries does not allocate.
+ *
+ *	@param	context		: The context.
+ *	@param	parameters	: The new model parameters.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+CommonConstantReturnType	moonfireSetParameters(MoonfireContext *  context, const MoonfireParameters *  parameters);
+
+/**
+ *	@brief	Run all iterations of the simulation.
+ *
+ *	@param	context		: The context.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+CommonConstantReturnType	moonfireSimulate(MoonfireContext *  context);
+
+/**
+ *	@brief	Get the statistics of the portfolio return of the last simulation. The
+ *		probability of loss and the quantiles are computed on the first call
+ *		after each simulation.
+ *
+ *	@param	context		: The context.
+ *	@param	statistics	: Pointer to struct to store the statistics.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+CommonConstantReturnType	moonfireGetStatistics(MoonfireContext *  context, MoonfireStatistics *  statistics);
+
+/**
+ *	@brief	Get the statistics of the net multiple of the LPs of the last
+ *		simulation, for parameters with a waterfall. `portfolioReturn` and
+ *		`mean` are the mean net multiple, and the probability of loss is
+ *		the probability of a net multiple of at most 1.
+ *
+ *	@param	context		: The context.
+ *	@param	statistics	: Pointer to struct to store the statistics.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+CommonConstantReturnType	moonfireGetNetStatistics(MoonfireContext *  context, MoonfireStatistics *  statistics);
+
+/**
+ *	@brief	Get the statistics of the portfolio return of each reserve strategy of
+ *		the last simulation, with `portfolioReturn` and `mean` the mean
+ *		portfolio return of the strategy.
+ *
+ *	@param	context		: The context.
+ *	@param	statistics	: Array to store the statistics of the `numberOfReserveStrategies` strategies.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+CommonConstantReturnType	moonfireGetReserveStrategies(MoonfireContext *  context, MoonfireStatistics *  statistics);
+
+/**
+ *	@brief	Simulate the portfolio return of several portfolio sizes on common
+ *		random numbers. The portfolio of size `sizes[k]` is made of the first
+ *		`sizes[k]` investments of the portfolio of `numberOfInvestments`
+ *		investments of the parameters, so that all sizes share their draws,
+ *		and all sizes cost a single simulation of the largest portfolio.
+ *		Needs the kernels engine and a homogeneous portfolio. Does not change
+ *		the results of `moonfireSimulate()`.
+ *
+ *	@param	context		: The context.
+ *	@param	sizes		: The `numberOfSizes` portfolio sizes, increasing, in [1, numberOfInvestments].
+ *	@param	numberOfSizes	: Number of portfolio sizes, in [1, kMoonfireConstantMaximumPortfolioSizes].
+ *	@param	statistics	: Array to store the statistics of the portfolio return of each size.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+CommonConstantReturnType	moonfireSimulatePortfolioSizes(
+					MoonfireContext *	context,
+					const size_t *		sizes,
+					size_t			numberOfSizes,
+					MoonfireStatistics *	statistics);
+
+/**
+ *	@brief	Simulate the portfolio return of the parameters into a quantile sketch,
+ *		without keeping the samples. The iterations are split between
+ *		`numberOfThreads` workers in native builds, each with its own context
+ *		and sketch, simulating its contiguous range of iterations in chunks of
+ *		`kMoonfireConstantSketchChunkIterations`. The sketches of the workers
+ *		are then merged in order, so the result depends on the number of
+ *		threads only through the error of the sketch. Needs the kernels engine,
+ *		and no fund timeline, waterfall or reserve strategies.
+ *
+ *	@param	parameters	: The model parameters.
+ *	@param	numberOfThreads	: Number of worker threads, at least 1.
+ *	@param	sketch		: The sketch to add the portfolio returns to.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+CommonConstantReturnType	moonfireSimulateSketch(
+					const MoonfireParameters *	parameters,
+					size_t				numberOfThreads,
+					QuantileSketch *		sketch);
+
+/**
+ *	@brief	Split the iterations of a simulation into contiguous parts of nearly
+ *		equal size, e.g., between threads or shards (see `firstIteration` of
+ *		`MoonfireParameters`). The first `numberOfIterations % numberOfParts`
+ *		parts have one iteration more than the others.
+ *
+ *	@param	numberOfIterations	: Number of iterations of the simulation.
+ *	@param	numberOfParts		: Number of parts, at least 1.
+ *	@param	part			: Index of the part, in [0, numberOfParts).
+ *	@param	firstIteration		: Pointer to store the index of the first iteration of the part.
+ *	@param	numberOfPartIterations	: Pointer to store the number of iterations of the part.
+ */
+void				moonfireGetIterationRange(
+					size_t		numberOfIterations,
+					size_t		numberOfParts,
+					size_t		part,
+					size_t *	firstIteration,
+					size_t *	numberOfPartIterations);
+
+/**
+ *	@brief	Compute the statistics of samples of the portfolio return, e.g., the
+ *		samples of several shards of a simulation, as `moonfireGetStatistics()`
+ *		does for the samples of a context.
+ *
+ *	@param	samples			: The samples.
+ *	@param	numberOfSamples		: Number of samples, at least 1.
+ *	@param	lowQuantileProbability	: Probability of the low quantile, in [0, 1].
+ *	@param	highQuantileProbability	: Probability of the high quantile, in [lowQuantileProbability, 1].
+ *	@param	statistics		: Pointer to struct to store the statistics.
+ *	@return				: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+CommonConstantReturnType	moonfireCalculateSampleStatistics(
+					const double *		samples,
+					size_t			numberOfSamples,
+					double			lowQuantileProbability,
+					double			highQuantileProbability,
+					MoonfireStatistics *	statistics);
+
+/**
+ *	@brief	Get the variance decomposition of the portfolio return of the last
+ *		simulation over its outer draws, for parameters with parameter draws.
+ *
+ *	@param	context		: The context.
+ *	@param	uncertainty	: Pointer to struct to store the decomposition.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+CommonConstantReturnType	moonfireGetParameterUncertainty(const MoonfireContext *  context, MoonfireParameterUncertainty *  uncertainty);
+
+/**
+ *	@brief	Get the histogram of the portfolio return of the last simulation.
+ *
+ *	@param	context		: The context.
+ *	@param	histogram	: Pointer to struct to store the histogram.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+CommonConstantReturnType	moonfireGetHistogram(const MoonfireContext *  context, MoonfireHistogram *  histogram);
+
+/**
+ *	@brief	Get the fund timeline of the last simulation, for parameters with a
+ *		fund timeline. Selecting the quantiles reorders the per-year samples,
+ *		which the timeline owns, so repeated calls return the same result.
+ *
+ *	@param	context		: The context.
+ *	@param	years		: Array to store the `fundLifeYears` years.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+CommonConstantReturnType	moonfireGetTimeline(MoonfireContext *  context, MoonfireTimelineYear *  years);
+
+/**
+ *	@brief	Get the portfolio return of the last simulation, without computing the
+ *		probability of loss and the quantiles. See `MoonfireStatistics`.
+ *
+ *	@param	context		: The context.
+ *	@return			: The portfolio return.
+ */
+double				moonfireGetPortfolioReturn(const MoonfireContext *  context);
+
+/**
+ *	@brief	Get the per-iteration portfolio returns of the last simulation.
+ *
+ *	@param	context		: The context.
+ *	@param	numberOfSamples	: Pointer to store the number of samples.
+ *	@return			: The samples, owned by the context.
+ */
+const double *			moonfireGetSamples(const MoonfireContext *  context, size_t *  numberOfSamples);
+
+/**
+ *	@brief	Get the name of the sampling kernel variant used by the kernels engine.
+ *
+ *	@param	context		: The context.
+ *	@return			: The variant name.
+ */
+const char *			moonfireGetKernelVariantName(const MoonfireContext *  context);
+
+/**
+ *	@brief	Free a context and all its buffers.
+ *
+ *	@param	context		: The context. May be `NULL`.
+ */
+void				moonfireDestroyContext(MoonfireContext *  context);
@@ -0,0 +1,255 @@
+/*
+ *	Copyright (c) 2024, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+
+#include <math.h>
+#include <stdio.h>
+#include "optimizer.h"
+
+
+/**
+ *	@brief	Metric of the objective, with the sign that makes larger values better.
+ *
+ *	@param	objective	: The objective.
+ *	@param	statistics	: The statistics of the candidate.
+ *	@return			: The signed metric.
+ */
+static double
+calculateSignedMetric(OptimizerObjective objective, const MoonfireStatistics *  statistics)
+{
+	if (objective == kOptimizerObjectiveProbabilityOfLoss)
+	{
+		return -statistics->probabilityOfLoss;
+	}
+
+	return (objective == kOptimizerObjectiveLowQuantile) ? statistics->lowQuantile : statistics->highQuantile;
+}
+
+/**
+ *	@brief	Evaluate the candidate sizes of a pass and merge them, in increasing
+ *		size, into the candidates of the result. Sizes already evaluated are
+ *		skipped, as they have the same statistics on common random numbers.
+ *
+ *	@param	context		: The context, with `maximumNumberOfInvestments` investments.
+ *	@param	sizes		: The `numberOfSizes` candidate sizes, increasing.
+ *	@param	numberOfSizes	: Number of candidate sizes, at most `kOptimizerConstantGridSize`.
+ *	@param	result		: The result to merge the candidates into.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+evaluateCandidates(
+	MoonfireContext *	context,
+	const size_t *		sizes,
+	size_t			numberOfSizes,
+	OptimizerResult *	result)
+{
+	MoonfireStatistics	statistics[kOptimizerConstantGridSize];
+	OptimizerCandidate	merged[kOptimizerConstantMaximumCandidates];
+	size_t			numberOfMerged = 0;
+	size_t			i = 0;
+	size_t			k = 0;
+
+	if (moonfireSimulatePortfolioSizes(context, sizes, numberOfSizes, statistics) != kCommonConstantReturnTypeSuccess)
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	while ((i < result->numberOfCandidates) || (k < numberOfSizes))
+	{
+		if ((k == numberOfSizes) || ((i < result->numberOfCandidates) && (result->candidates[i].numberOfInvestments <= sizes[k])))
+		{
+			if ((k < numberOfSizes) && (result->candidates[i].numberOfInvestments == sizes[k]))
+			{
+				k++;
+			}
+			merged[numberOfMerged++] = result->candidates[i++];
+		}
+		else
+		{
+			merged[numberOfMerged++] = (OptimizerCandidate) {
+				.numberOfInvestments	= sizes[k],
+				.statistics		= statistics[k],
+			};
+			k++;
+		}
+	}
+
+	for (i = 0; i < numberOfMerged; i++)
+	{
+		result->candidates[i] = merged[i];
+	}
+	result->numberOfCandidates = numberOfMerged;
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+/**
+ *	@brief	Find the best candidate, and the smallest candidate within `tolerance` of it.
+ *
+ *	@param	objective	: The objective.
+ *	@param	tolerance	: Tolerance on the metric.
+ *	@param	result		: The result, with its candidates.
+ */
+static void
+chooseCandidate(OptimizerObjective objective, double tolerance, OptimizerResult *  result)
+{
+	double	bestValue = calculateSignedMetric(objective, &result->candidates[0].statistics);
+
+	result->bestCandidate = 0;
+	for (size_t i = 1; i < result->numberOfCandidates; i++)
+	{
+		double	value = calculateSignedMetric(objective, &result->candidates[i].statistics);
+
+		if (value > bestValue)
+		{
+			bestValue = value;
+			result->bestCandidate = i;
+		}
+	}
+
+	for (size_t i = 0; i < result->numberOfCandidates; i++)
+	{
+		if (calculateSignedMetric(objective, &result->candidates[i].statistics) >= bestValue - tolerance)
+		{
+			result->chosenCandidate = i;
+
+			break;
+		}
+	}
+
+	return;
+}
+
+CommonConstantReturnType
+optimizePortfolioSize(
+	const MoonfireParameters *	parameters,
+	OptimizerObjective		objective,
+	size_t				minimumNumberOfInvestments,
+	double				tolerance,
+	OptimizerResult *		result)
+{
+	MoonfireContext *	context;
+	size_t			sizes[kOptimizerConstantGridSize];
+	size_t			numberOfSizes = 0;
+	size_t			maximumNumberOfInvestments;
+	size_t			lowerSize;
+	size_t			upperSize;
+	double			ratio;
+
+	if ((parameters == NULL) || (result == NULL))
+	{
+		fprintf(stderr, "Error: The provided pointer to parameters or result is NULL.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	maximumNumberOfInvestments = parameters->numberOfInvestments;
+	if ((objective == kOptimizerObjectiveNone) ||
+		(minimumNumberOfInvestments == 0) || (minimumNumberOfInvestments > maximumNumberOfInvestments) || !(tolerance >= 0))
+	{
+		fprintf(stderr, "Error: The optimizer needs an objective, a minimum size in [1, number of investments] and a tolerance >= 0.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	context = moonfireCreateContext(parameters);
+	if (context == NULL)
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	/*
+	 *	First pass: geometric grid over the search range.
+	 */
+	ratio = (double) maximumNumberOfInvestments / (double) minimumNumberOfInvestments;
+	for (size_t k = 0; k < kOptimizerConstantGridSize; k++)
+	{
+		size_t	size = (size_t) llround((double) minimumNumberOfInvestments * pow(ratio, (double) k / (double) (kOptimizerConstantGridSize - 1)));
+
+		size = (size < minimumNumberOfInvestments) ? minimumNumberOfInvestments : size;
+		size = (size > maximumNumberOfInvestments) ? maximumNumberOfInvestments : size;
+		if ((numberOfSizes == 0) || (size > sizes[numberOfSizes - 1]))
+		{
+			sizes[numberOfSizes++] = size;
+		}
+	}
+
+	result->numberOfCandidates = 0;
+	if (evaluateCandidates(context, sizes, numberOfSizes, result) != kCommonConstantReturnTypeSuccess)
+	{
+		moonfireDestroyContext(context);
+
+		return kCommonConstantReturnTypeError;
+	}
+	chooseCandidate(objective, tolerance, result);
+
+	/*
+	 *	Second pass: linear grid between the chosen size and the grid size
+	 *	below it, where the metric crosses the tolerance.
+	 */
+	upperSize = result->candidates[result->chosenCandidate].numberOfInvestments;
+	lowerSize = (result->chosenCandidate > 0) ? result->candidates[result->chosenCandidate - 1].numberOfInvestments : upperSize;
+	if (upperSize - lowerSize > 1)
+	{
+		numberOfSizes = 0;
+		for (size_t k = 1; k <= kOptimizerConstantGridSize; k++)
+		{
+			size_t	size = lowerSize + ((upperSize - lowerSize) * k + kOptimizerConstantGridSize - 1) / kOptimizerConstantGridSize;
+
+			if ((size < upperSize) && ((numberOfSizes == 0) || (size > sizes[numberOfSizes - 1])))
+			{
+				sizes[numberOfSizes++] = size;
+			}
+		}
+
+		if (evaluateCandidates(context, sizes, numberOfSizes, result) != kCommonConstantReturnTypeSuccess)
+		{
+			moonfireDestroyContext(context);
+
+			return kCommonConstantReturnTypeError;
+		}
+		chooseCandidate(objective, tolerance, result);
+	}
+
+	moonfireDestroyContext(context);
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+const char *
+optimizerObjectiveName(OptimizerObjective objective)
+{
+	if (objective == kOptimizerObjectiveProbabilityOfLoss)
+	{
+		return "loss";
+	}
+	else if (objective == kOptimizerObjectiveLowQuantile)
+	{
+		return "low-quantile";
+	}
+	else if (objective == kOptimizerObjectiveHighQuantile)
+	{
+		return "high-quantile";
+	}
+
+	return "none";
+}
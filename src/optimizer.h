@@ -0,0 +1,117 @@
+/*
+ *	Copyright (c) 2024, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+
+#pragma once
+#include <stddef.h>
+#include "common.h"
+#include "moonfire.h"
+
+
+/*
+ *	Search for the portfolio size that optimizes a risk metric of the
+ *	portfolio return.
+ *
+ *	Candidate sizes are evaluated with `moonfireSimulatePortfolioSizes()`, so
+ *	that all candidates share their draws (common random numbers) and the
+ *	differences between candidates are not masked by sampling noise. A first
+ *	pass evaluates a geometric grid of sizes over the search range, and a
+ *	second pass a linear grid between the chosen size and the grid size below
+ *	it. Both passes sample the same portfolio of `maximumNumberOfInvestments`
+ *	investments, so the candidates of both passes are consistent.
+ *
+ *	The chosen size is the smallest candidate whose metric is within
+ *	`tolerance` of the best metric over all candidates, i.e., where the metric
+ *	flattens out, as larger portfolios usually only improve it marginally.
+ */
+
+typedef enum
+{
+	/*
+	 *	Number of candidate sizes of each pass of the search.
+	 */
+	kOptimizerConstantGridSize		= 32,
+	kOptimizerConstantMaximumCandidates	= 2 * kOptimizerConstantGridSize,
+} OptimizerConstant;
+
+typedef enum
+{
+	kOptimizerObjectiveNone			= 0,
+
+	/*
+	 *	Minimize the probability of loss.
+	 */
+	kOptimizerObjectiveProbabilityOfLoss	= 1,
+
+	/*
+	 *	Maximize the low quantile of the portfolio return.
+	 */
+	kOptimizerObjectiveLowQuantile		= 2,
+
+	/*
+	 *	Maximize the high quantile of the portfolio return.
+	 */
+	kOptimizerObjectiveHighQuantile		= 3,
+} OptimizerObjective;
+
+typedef struct
+{
+	size_t			numberOfInvestments;
+	MoonfireStatistics	statistics;
+} OptimizerCandidate;
+
+typedef struct
+{
+	/*
+	 *	The evaluated candidates, in increasing size.
+	 */
+	OptimizerCandidate	candidates[kOptimizerConstantMaximumCandidates];
+	size_t			numberOfCandidates;
+	size_t			bestCandidate;
+	size_t			chosenCandidate;
+} OptimizerResult;
+
+/**
+ *	@brief	Search for the portfolio size in [minimumNumberOfInvestments,
+ *		numberOfInvestments of the parameters] that optimizes `objective`.
+ *
+ *	@param	parameters			: The model parameters, with the kernels engine and a homogeneous portfolio.
+ *	@param	objective			: The metric to optimize.
+ *	@param	minimumNumberOfInvestments	: Smallest candidate size, in [1, numberOfInvestments].
+ *	@param	tolerance			: Tolerance on the metric of the chosen size, >= 0.
+ *	@param	result				: Pointer to struct to store the candidates and the chosen size.
+ *	@return					: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+CommonConstantReturnType	optimizePortfolioSize(
+					const MoonfireParameters *	parameters,
+					OptimizerObjective		objective,
+					size_t				minimumNumberOfInvestments,
+					double				tolerance,
+					OptimizerResult *		result);
+
+/**
+ *	@brief	Name of an objective, as given on the command line.
+ *
+ *	@param	objective	: The objective.
+ *	@return			: The name.
+ */
+const char *			optimizerObjectiveName(OptimizerObjective objective);
@@ -0,0 +1,794 @@
+/*
+ *	Copyright (c) 2024, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <ctype.h>
+#include <math.h>
+#include "portfolio.h"
+
+
+typedef enum
+{
+	kPortfolioConstantMaximumLineLength	= 1024,
+	kPortfolioConstantInitialCapacity	= 64,
+	kPortfolioConstantNumberOfColumns	= 4,
+} PortfolioConstant;
+
+typedef struct
+{
+	double	alpha;
+	double	xMin;
+	double	xMax;
+	double	weight;
+	size_t	index;
+} PortfolioInvestment;
+
+static int
+compareInvestmentClasses(const void *  a, const void *  b)
+{
+	const PortfolioInvestment *	investmentA = a;
+	const PortfolioInvestment *	investmentB = b;
+
+	if (investmentA->alpha != investmentB->alpha)
+	{
+		return (investmentA->alpha < investmentB->alpha) ? -1 : 1;
+	}
+	if (investmentA->xMin != investmentB->xMin)
+	{
+		return (investmentA->xMin < investmentB->xMin) ? -1 : 1;
+	}
+	if (investmentA->xMax != investmentB->xMax)
+	{
+		return (investmentA->xMax < investmentB->xMax) ? -1 : 1;
+	}
+
+	return (investmentA->index < investmentB->index) ? -1 : (investmentA->index > investmentB->index);
+}
+
+/**
+ *	@brief	Reorder the investments of a portfolio so that each class of equal
+ *		`alpha`, `xMin` and `xMax` is contiguous, keeping the file order within
+ *		each class. The model then samples each class as one segment.
+ *
+ *	@param	portfolio	: The portfolio.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+groupPortfolioByClass(MoonfirePortfolio *  portfolio)
+{
+	PortfolioInvestment *	investments = malloc(portfolio->numberOfInvestments * sizeof(PortfolioInvestment));
+
+	if (investments == NULL)
+	{
+		fprintf(stderr, "Error: Could not allocate the portfolio.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	for (size_t i = 0; i < portfolio->numberOfInvestments; i++)
+	{
+		investments[i] = (PortfolioInvestment)
+		{
+			.alpha	= portfolio->alpha[i],
+			.xMin	= portfolio->xMin[i],
+			.xMax	= portfolio->xMax[i],
+			.weight	= portfolio->weight[i],
+			.index	= i,
+		};
+	}
+
+	qsort(investments, portfolio->numberOfInvestments, sizeof(PortfolioInvestment), compareInvestmentClasses);
+
+	for (size_t i = 0; i < portfolio->numberOfInvestments; i++)
+	{
+		portfolio->alpha[i] = investments[i].alpha;
+		portfolio->xMin[i] = investments[i].xMin;
+		portfolio->xMax[i] = investments[i].xMax;
+		portfolio->weight[i] = investments[i].weight;
+	}
+
+	free(investments);
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+/**
+ *	@brief	Grow the arrays of a portfolio to hold `capacity` investments.
+ *
+ *	@param	portfolio	: The portfolio.
+ *	@param	capacity	: The new capacity.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+reservePortfolio(MoonfirePortfolio *  portfolio, size_t capacity)
+{
+	double **	columns[kPortfolioConstantNumberOfColumns] = {&portfolio->alpha, &portfolio->xMin, &portfolio->xMax, &portfolio->weight};
+
+	if (capacity > SIZE_MAX / sizeof(double))
+	{
+		fprintf(stderr, "Error: The portfolio is too large.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	for (size_t i = 0; i < kPortfolioConstantNumberOfColumns; i++)
+	{
+		double *	column = realloc(*columns[i], capacity * sizeof(double));
+
+		if (column == NULL)
+		{
+			fprintf(stderr, "Error: Could not allocate the portfolio.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+		*columns[i] = column;
+	}
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+/**
+ *	@brief	Load a binary portfolio file, positioned after its magic.
+ *
+ *	@param	file		: The file.
+ *	@param	path		: Path of the file, for error messages.
+ *	@param	portfolio	: Pointer to store the portfolio.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+loadBinaryPortfolio(FILE *  file, const char *  path, MoonfirePortfolio *  portfolio)
+{
+	double *	columns[kPortfolioConstantNumberOfColumns];
+	uint64_t	numberOfInvestments;
+	long		headerSize;
+	long		fileSize;
+
+	if (fread(&numberOfInvestments, sizeof(numberOfInvestments), 1, file) != 1)
+	{
+		fprintf(stderr, "Error: The portfolio file \"%s\" is truncated.\n", path);
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	/*
+	 *	Check the size of the file before allocating, so that a corrupt count
+	 *	cannot cause a huge allocation.
+	 */
+	headerSize = ftell(file);
+	if ((fseek(file, 0, SEEK_END) != 0) || ((fileSize = ftell(file)) < 0) || (fseek(file, headerSize, SEEK_SET) != 0) ||
+		(numberOfInvestments == 0) ||
+		(numberOfInvestments != (uint64_t)(fileSize - headerSize) / (kPortfolioConstantNumberOfColumns * sizeof(double))) ||
+		((uint64_t)(fileSize - headerSize) % (kPortfolioConstantNumberOfColumns * sizeof(double)) != 0))
+	{
+		fprintf(stderr, "Error: The size of the portfolio file \"%s\" does not match its number of investments.\n", path);
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if (reservePortfolio(portfolio, (size_t) numberOfInvestments) != kCommonConstantReturnTypeSuccess)
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	columns[0] = portfolio->alpha;
+	columns[1] = portfolio->xMin;
+	columns[2] = portfolio->xMax;
+	columns[3] = portfolio->weight;
+	for (size_t i = 0; i < kPortfolioConstantNumberOfColumns; i++)
+	{
+		if (fread(columns[i], sizeof(double), (size_t) numberOfInvestments, file) != (size_t) numberOfInvestments)
+		{
+			fprintf(stderr, "Error: The portfolio file \"%s\" is truncated.\n", path);
+
+			return kCommonConstantReturnTypeError;
+		}
+	}
+	portfolio->numberOfInvestments = (size_t) numberOfInvestments;
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+/**
+ *	@brief	Load a CSV portfolio file, positioned at its start.
+ *
+ *	@param	file		: The file.
+ *	@param	path		: Path of the file, for error messages.
+ *	@param	portfolio	: Pointer to store the portfolio.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+loadCsvPortfolio(FILE *  file, const char *  path, MoonfirePortfolio *  portfolio)
+{
+	char	line[kPortfolioConstantMaximumLineLength];
+	size_t	capacity = 0;
+	size_t	lineNumber = 0;
+	bool	isHeaderAllowed = true;
+
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		double		values[kPortfolioConstantNumberOfColumns];
+		const char *	cursor = line;
+		char *		end;
+		bool		isWellFormed = true;
+
+		lineNumber++;
+		if ((strchr(line, '\n') == NULL) && !feof(file))
+		{
+			fprintf(stderr, "Error: Line %zu of the portfolio file \"%s\" is too long.\n", lineNumber, path);
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		while (isspace((unsigned char) *cursor))
+		{
+			cursor++;
+		}
+		if ((*cursor == '\0') || (*cursor == '#'))
+		{
+			continue;
+		}
+
+		for (size_t i = 0; (i < kPortfolioConstantNumberOfColumns) && isWellFormed; i++)
+		{
+			values[i] = strtod(cursor, &end);
+			isWellFormed = (end != cursor);
+			cursor = end;
+			while ((*cursor == ' ') || (*cursor == '\t'))
+			{
+				cursor++;
+			}
+			if (isWellFormed && (i + 1 < kPortfolioConstantNumberOfColumns))
+			{
+				isWellFormed = (*cursor == ',');
+				cursor++;
+			}
+		}
+		while (isWellFormed && isspace((unsigned char) *cursor))
+		{
+			cursor++;
+		}
+
+		if (!isWellFormed || (*cursor != '\0'))
+		{
+			/*
+			 *	A first line that does not parse is a header.
+			 */
+			if (isHeaderAllowed)
+			{
+				isHeaderAllowed = false;
+				continue;
+			}
+
+			fprintf(stderr, "Error: Line %zu of the portfolio file \"%s\" is not of the form alpha,xMin,xMax,weight.\n", lineNumber, path);
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		isHeaderAllowed = false;
+		if (portfolio->numberOfInvestments == capacity)
+		{
+			capacity = (capacity == 0) ? kPortfolioConstantInitialCapacity : 2 * capacity;
+			if (reservePortfolio(portfolio, capacity) != kCommonConstantReturnTypeSuccess)
+			{
+				return kCommonConstantReturnTypeError;
+			}
+		}
+
+		portfolio->alpha[portfolio->numberOfInvestments] = values[0];
+		portfolio->xMin[portfolio->numberOfInvestments] = values[1];
+		portfolio->xMax[portfolio->numberOfInvestments] = values[2];
+		portfolio->weight[portfolio->numberOfInvestments] = values[3];
+		portfolio->numberOfInvestments++;
+	}
+
+	if (ferror(file) || (portfolio->numberOfInvestments == 0))
+	{
+		fprintf(stderr, "Error: Could not read any investment from the portfolio file \"%s\".\n", path);
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+CommonConstantReturnType
+moonfireLoadPortfolio(const char *  path, MoonfirePortfolio *  portfolio)
+{
+	char				magic[sizeof(kMoonfirePortfolioBinaryMagic) - 1];
+	FILE *				file;
+	CommonConstantReturnType	result;
+
+	*portfolio = (MoonfirePortfolio) {0};
+
+	file = fopen(path, "rb");
+	if (file == NULL)
+	{
+		fprintf(stderr, "Error: Could not open the portfolio file \"%s\": %s.\n", path, strerror(errno));
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((fread(magic, sizeof(magic), 1, file) == 1) && (memcmp(magic, kMoonfirePortfolioBinaryMagic, sizeof(magic)) == 0))
+	{
+		result = loadBinaryPortfolio(file, path, portfolio);
+	}
+	else
+	{
+		rewind(file);
+		result = loadCsvPortfolio(file, path, portfolio);
+	}
+
+	fclose(file);
+
+	if (result == kCommonConstantReturnTypeSuccess)
+	{
+		result = groupPortfolioByClass(portfolio);
+	}
+
+	if (result != kCommonConstantReturnTypeSuccess)
+	{
+		moonfireFreePortfolio(portfolio);
+	}
+
+	return result;
+}
+
+void
+moonfireFreePortfolio(MoonfirePortfolio *  portfolio)
+{
+	free(portfolio->alpha);
+	free(portfolio->xMin);
+	free(portfolio->xMax);
+	free(portfolio->weight);
+	*portfolio = (MoonfirePortfolio) {0};
+
+	return;
+}
+
+/**
+ *	@brief	Parse the comma-separated numbers of one line of a CSV matrix.
+ *
+ *	@param	line		: The line.
+ *	@param	values		: Array to store at most `capacity` numbers, or `NULL` to only count them.
+ *	@param	capacity	: Capacity of `values`.
+ *	@param	count		: Pointer to store the number of numbers.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if the line is well formed, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+parseCsvNumbers(const char *  line, double *  values, size_t capacity, size_t *  count)
+{
+	const char *	cursor = line;
+	char *		end;
+
+	*count = 0;
+	while (true)
+	{
+		double	value = strtod(cursor, &end);
+
+		if (end == cursor)
+		{
+			return kCommonConstantReturnTypeError;
+		}
+
+		if ((values != NULL) && (*count < capacity))
+		{
+			values[*count] = value;
+		}
+		(*count)++;
+
+		cursor = end;
+		while ((*cursor == ' ') || (*cursor == '\t'))
+		{
+			cursor++;
+		}
+		if (*cursor != ',')
+		{
+			break;
+		}
+		cursor++;
+	}
+
+	while (isspace((unsigned char) *cursor))
+	{
+		cursor++;
+	}
+
+	return (*cursor == '\0') ? kCommonConstantReturnTypeSuccess : kCommonConstantReturnTypeError;
+}
+
+/**
+ *	@brief	Read a line of any length, growing `*line` as needed.
+ *
+ *	@param	file		: The file.
+ *	@param	line		: Pointer to the line buffer, `NULL` initially; free with `free()`.
+ *	@param	capacity	: Pointer to the capacity of the line buffer, 0 initially.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if a line was read, else `kCommonConstantReturnTypeError` at the end of the file or on errors.
+ */
+static CommonConstantReturnType
+readLine(FILE *  file, char **  line, size_t *  capacity)
+{
+	size_t	length = 0;
+
+	while (true)
+	{
+		if (*capacity - length < 2)
+		{
+			size_t	newCapacity = (*capacity == 0) ? kPortfolioConstantMaximumLineLength : 2 * *capacity;
+			char *	newLine = realloc(*line, newCapacity);
+
+			if (newLine == NULL)
+			{
+				return kCommonConstantReturnTypeError;
+			}
+			*line = newLine;
+			*capacity = newCapacity;
+		}
+
+		if (fgets(*line + length, (int) (*capacity - length), file) == NULL)
+		{
+			return (length > 0) ? kCommonConstantReturnTypeSuccess : kCommonConstantReturnTypeError;
+		}
+
+		length += strlen(*line + length);
+		if ((*line)[length - 1] == '\n')
+		{
+			return kCommonConstantReturnTypeSuccess;
+		}
+	}
+}
+
+CommonConstantReturnType
+moonfireLoadCorrelationMatrix(const char *  path, double **  matrix, size_t *  order)
+{
+	FILE *				file;
+	char *				line = NULL;
+	size_t				lineCapacity = 0;
+	size_t				lineNumber = 0;
+	size_t				numberOfRows = 0;
+	bool				isHeaderAllowed = true;
+	CommonConstantReturnType	result = kCommonConstantReturnTypeSuccess;
+
+	*matrix = NULL;
+	*order = 0;
+
+	file = fopen(path, "r");
+	if (file == NULL)
+	{
+		fprintf(stderr, "Error: Could not open the correlation matrix file \"%s\": %s.\n", path, strerror(errno));
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	while ((result == kCommonConstantReturnTypeSuccess) && (readLine(file, &line, &lineCapacity) == kCommonConstantReturnTypeSuccess))
+	{
+		const char *	cursor = line;
+		size_t		count;
+
+		lineNumber++;
+		while (isspace((unsigned char) *cursor))
+		{
+			cursor++;
+		}
+		if ((*cursor == '\0') || (*cursor == '#'))
+		{
+			continue;
+		}
+
+		/*
+		 *	The first row sets the order of the matrix.
+		 */
+		if (*matrix == NULL)
+		{
+			if (parseCsvNumbers(cursor, NULL, 0, &count) != kCommonConstantReturnTypeSuccess)
+			{
+				if (isHeaderAllowed)
+				{
+					isHeaderAllowed = false;
+					continue;
+				}
+
+				fprintf(stderr, "Error: Line %zu of the correlation matrix file \"%s\" is not a comma-separated row of numbers.\n", lineNumber, path);
+				result = kCommonConstantReturnTypeError;
+				break;
+			}
+
+			if (count > SIZE_MAX / sizeof(double) / count)
+			{
+				fprintf(stderr, "Error: The correlation matrix is too large.\n");
+				result = kCommonConstantReturnTypeError;
+				break;
+			}
+
+			*matrix = malloc(count * count * sizeof(double));
+			if (*matrix == NULL)
+			{
+				fprintf(stderr, "Error: Could not allocate the correlation matrix.\n");
+				result = kCommonConstantReturnTypeError;
+				break;
+			}
+			*order = count;
+		}
+
+		isHeaderAllowed = false;
+		if ((numberOfRows == *order) ||
+			(parseCsvNumbers(cursor, *matrix + numberOfRows * *order, *order, &count) != kCommonConstantReturnTypeSuccess) ||
+			(count != *order))
+		{
+			fprintf(stderr, "Error: Line %zu of the correlation matrix file \"%s\" is not row %zu of a %zu x %zu matrix.\n", lineNumber, path, numberOfRows + 1, *order, *order);
+			result = kCommonConstantReturnTypeError;
+			break;
+		}
+		numberOfRows++;
+	}
+
+	if ((result == kCommonConstantReturnTypeSuccess) && (ferror(file) || (numberOfRows == 0) || (numberOfRows != *order)))
+	{
+		fprintf(stderr, "Error: The correlation matrix file \"%s\" does not contain a square matrix.\n", path);
+		result = kCommonConstantReturnTypeError;
+	}
+
+	free(line);
+	fclose(file);
+
+	if (result != kCommonConstantReturnTypeSuccess)
+	{
+		free(*matrix);
+		*matrix = NULL;
+		*order = 0;
+	}
+
+	return result;
+}
+
+/**
+ *	@brief	Load a CSV file with the same number of numbers on each line, skipping
+ *		empty lines, comments and a header. On success, `*values` is allocated,
+ *		row-major, and must be freed with `free()`.
+ *
+ *	@param	path		: Path of the file.
+ *	@param	description	: Description of the file for error messages, e.g., "multiples".
+ *	@param	numberOfColumns	: Number of numbers per line, at most `kPortfolioConstantNumberOfColumns`.
+ *	@param	values		: Pointer to store the values.
+ *	@param	numberOfRows	: Pointer to store the number of lines of numbers.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+loadCsvRows(const char *  path, const char *  description, size_t numberOfColumns, double **  values, size_t *  numberOfRows)
+{
+	FILE *				file;
+	char *				line = NULL;
+	size_t				lineCapacity = 0;
+	size_t				lineNumber = 0;
+	size_t				capacity = 0;
+	bool				isHeaderAllowed = true;
+	CommonConstantReturnType	result = kCommonConstantReturnTypeSuccess;
+
+	*values = NULL;
+	*numberOfRows = 0;
+
+	file = fopen(path, "r");
+	if (file == NULL)
+	{
+		fprintf(stderr, "Error: Could not open the %s file \"%s\": %s.\n", description, path, strerror(errno));
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	while ((result == kCommonConstantReturnTypeSuccess) && (readLine(file, &line, &lineCapacity) == kCommonConstantReturnTypeSuccess))
+	{
+		const char *	cursor = line;
+		double		row[kPortfolioConstantNumberOfColumns];
+		size_t		count;
+
+		lineNumber++;
+		while (isspace((unsigned char) *cursor))
+		{
+			cursor++;
+		}
+		if ((*cursor == '\0') || (*cursor == '#'))
+		{
+			continue;
+		}
+
+		if ((parseCsvNumbers(cursor, row, numberOfColumns, &count) != kCommonConstantReturnTypeSuccess) || (count != numberOfColumns))
+		{
+			if (isHeaderAllowed)
+			{
+				isHeaderAllowed = false;
+				continue;
+			}
+
+			fprintf(stderr, "Error: Line %zu of the %s file \"%s\" is not a row of %zu comma-separated numbers.\n", lineNumber, description, path, numberOfColumns);
+			result = kCommonConstantReturnTypeError;
+			break;
+		}
+		isHeaderAllowed = false;
+
+		if (*numberOfRows == capacity)
+		{
+			size_t		newCapacity = (capacity == 0) ? kPortfolioConstantInitialCapacity : 2 * capacity;
+			double *	newValues = realloc(*values, newCapacity * numberOfColumns * sizeof(double));
+
+			if (newValues == NULL)
+			{
+				fprintf(stderr, "Error: Could not allocate the %s.\n", description);
+				result = kCommonConstantReturnTypeError;
+				break;
+			}
+			*values = newValues;
+			capacity = newCapacity;
+		}
+		memcpy(*values + *numberOfRows * numberOfColumns, row, numberOfColumns * sizeof(double));
+		(*numberOfRows)++;
+	}
+
+	if ((result == kCommonConstantReturnTypeSuccess) && (ferror(file) || (*numberOfRows == 0)))
+	{
+		fprintf(stderr, "Error: The %s file \"%s\" does not contain any rows.\n", description, path);
+		result = kCommonConstantReturnTypeError;
+	}
+
+	free(line);
+	fclose(file);
+
+	if (result != kCommonConstantReturnTypeSuccess)
+	{
+		free(*values);
+		*values = NULL;
+		*numberOfRows = 0;
+	}
+
+	return result;
+}
+
+CommonConstantReturnType
+moonfireLoadMultiples(const char *  path, double **  multiples, size_t *  count)
+{
+	if (loadCsvRows(path, "multiples", 1, multiples, count) != kCommonConstantReturnTypeSuccess)
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	for (size_t i = 0; i < *count; i++)
+	{
+		if (!((*multiples)[i] >= 0) || !isfinite((*multiples)[i]))
+		{
+			fprintf(stderr, "Error: Multiple %zu of the multiples file \"%s\" is not a finite multiple of at least 0.\n", i + 1, path);
+			free(*multiples);
+			*multiples = NULL;
+			*count = 0;
+
+			return kCommonConstantReturnTypeError;
+		}
+	}
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+CommonConstantReturnType
+moonfireLoadParameterDraws(const char *  path, double **  draws, size_t *  count)
+{
+	return loadCsvRows(path, "parameter draws", 3, draws, count);
+}
+
+CommonConstantReturnType
+moonfireLoadOutcomes(const char *  path, double **  outcomes, size_t *  count)
+{
+	return loadCsvRows(path, "outcomes", 2, outcomes, count);
+}
+
+CommonConstantReturnType
+moonfireLoadMonteCarloOutput(const char *  path, double **  samples, size_t *  count, uint64_t *  cpuTimeMicroseconds)
+{
+	FILE *				file;
+	char *				line = NULL;
+	char *				end;
+	size_t				lineCapacity = 0;
+	size_t				lineNumber = 1;
+	size_t				capacity = 0;
+	CommonConstantReturnType	result = kCommonConstantReturnTypeSuccess;
+
+	*samples = NULL;
+	*count = 0;
+
+	file = fopen(path, "r");
+	if (file == NULL)
+	{
+		fprintf(stderr, "Error: Could not open the Monte Carlo output file \"%s\": %s.\n", path, strerror(errno));
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	/*
+	 *	The first line is the CPU time of the run.
+	 */
+	if ((readLine(file, &line, &lineCapacity) != kCommonConstantReturnTypeSuccess) || !isdigit((unsigned char) line[0]))
+	{
+		fprintf(stderr, "Error: The Monte Carlo output file \"%s\" does not start with a CPU time in microseconds.\n", path);
+		result = kCommonConstantReturnTypeError;
+	}
+	else
+	{
+		errno = 0;
+		*cpuTimeMicroseconds = strtoull(line, &end, 10);
+		while (isspace((unsigned char) *end))
+		{
+			end++;
+		}
+		if ((errno != 0) || (*end != '\0'))
+		{
+			fprintf(stderr, "Error: The Monte Carlo output file \"%s\" does not start with a CPU time in microseconds.\n", path);
+			result = kCommonConstantReturnTypeError;
+		}
+	}
+
+	while ((result == kCommonConstantReturnTypeSuccess) && (readLine(file, &line, &lineCapacity) == kCommonConstantReturnTypeSuccess))
+	{
+		double	sample;
+		size_t	numberOfValues;
+
+		lineNumber++;
+		if ((parseCsvNumbers(line, &sample, 1, &numberOfValues) != kCommonConstantReturnTypeSuccess) || (numberOfValues != 1) || !isfinite(sample))
+		{
+			fprintf(stderr, "Error: Line %zu of the Monte Carlo output file \"%s\" is not a finite sample.\n", lineNumber, path);
+			result = kCommonConstantReturnTypeError;
+			break;
+		}
+
+		if (*count == capacity)
+		{
+			size_t		newCapacity = (capacity == 0) ? kPortfolioConstantInitialCapacity : 2 * capacity;
+			double *	newSamples = realloc(*samples, newCapacity * sizeof(double));
+
+			if (newSamples == NULL)
+			{
+				fprintf(stderr, "Error: Could not allocate the Monte Carlo samples.\n");
+				result = kCommonConstantReturnTypeError;
+				break;
+			}
+			*samples = newSamples;
+			capacity = newCapacity;
+		}
+		(*samples)[(*count)++] = sample;
+	}
+
+	if ((result == kCommonConstantReturnTypeSuccess) && (ferror(file) || (*count == 0)))
+	{
+		fprintf(stderr, "Error: The Monte Carlo output file \"%s\" does not contain any samples.\n", path);
+		result = kCommonConstantReturnTypeError;
+	}
+
+	free(line);
+	fclose(file);
+
+	if (result != kCommonConstantReturnTypeSuccess)
+	{
+		free(*samples);
+		*samples = NULL;
+		*count = 0;
+	}
+
+	return result;
+}
@@ -0,0 +1,165 @@
+/*
+ *	Copyright (c) 2024, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#pragma once
+#include "common.h"
+#include "moonfire.h"
+
+
+/*
+ *	Portfolio files.
+ *
+ *	A CSV portfolio file has one investment per line, as
+ *
+ *		alpha,xMin,xMax,weight
+ *
+ *	Empty lines, lines starting with `#` and a first line that does not start
+ *	with a number (a header) are skipped. Weights are relative cheque sizes
+ *	and are normalized by the model, so they need not sum to one.
+ *
+ *	Loaded investments are grouped by class (see `MoonfirePortfolio`): the
+ *	investments of each class are made contiguous, in file order.
+ *
+ *	A binary portfolio file, for portfolios too large to parse as text quickly,
+ *	is `kMoonfirePortfolioBinaryMagic`, the number of investments as a
+ *	`uint64_t`, and the `alpha`, `xMin`, `xMax` and `weight` arrays of
+ *	`double`, one after the other, all in the byte order of the host. The
+ *	format is recognized by its magic.
+ */
+
+/*
+ *	A correlation matrix file is a CSV file with one row of the matrix per
+ *	line, e.g., for the classes of a portfolio (see `classCorrelationMatrix`
+ *	of `MoonfireParameters`). Empty lines, lines starting with `#` and a
+ *	header line are skipped as in portfolio files.
+ */
+
+/*
+ *	A multiples file is a CSV file with one observed exit multiple of an
+ *	investment (its proceeds over its invested capital, at least 0) per line,
+ *	for calibrating the bounded Pareto parameters (see `calibration.h`).
+ *	Empty lines, lines starting with `#` and a header line are skipped as in
+ *	portfolio files.
+ */
+
+/*
+ *	A parameter draws file is a CSV file with one draw of the bounded Pareto
+ *	parameters per line, as
+ *
+ *		alpha,xMin,xMax
+ *
+ *	e.g., a prior or posterior sample (see `parameterDraws` of
+ *	`MoonfireParameters`). The draws are checked by the model.
+ */
+
+/*
+ *	An outcomes file is a CSV file with one outcome bucket of an investment
+ *	per line, as
+ *
+ *		multiple,weight
+ *
+ *	e.g., `0,0.5`, `1,0.2`, `3,0.15`, `10,0.1` and `100,0.05` (see `outcomes`
+ *	of `MoonfireParameters`). Weights are relative probabilities, so they
+ *	need not sum to one. The buckets are checked by the model.
+ */
+
+/*
+ *	A Monte Carlo output file is the `data.out` file of a native Monte Carlo
+ *	run (`-M`): the CPU time of the run in microseconds on the first line,
+ *	then one sample of the portfolio return per line. The `merge` subcommand
+ *	combines the output files of shards (`--shard`).
+ */
+
+#define kMoonfirePortfolioBinaryMagic	"MFPORT01"
+
+/**
+ *	@brief	Load a CSV or binary portfolio file. On success, the arrays of
+ *		`portfolio` are allocated and must be freed with `moonfireFreePortfolio()`.
+ *
+ *	@param	path		: Path of the portfolio file.
+ *	@param	portfolio	: Pointer to store the portfolio.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+CommonConstantReturnType	moonfireLoadPortfolio(const char *  path, MoonfirePortfolio *  portfolio);
+
+/**
+ *	@brief	Free the arrays of a portfolio loaded with `moonfireLoadPortfolio()`.
+ *
+ *	@param	portfolio	: The portfolio.
+ */
+void				moonfireFreePortfolio(MoonfirePortfolio *  portfolio);
+
+/**
+ *	@brief	Load a correlation matrix file. On success, `*matrix` is allocated
+ *		and must be freed with `free()`.
+ *
+ *	@param	path	: Path of the correlation matrix file.
+ *	@param	matrix	: Pointer to store the row-major matrix.
+ *	@param	order	: Pointer to store the number of rows of the matrix.
+ *	@return		: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+CommonConstantReturnType	moonfireLoadCorrelationMatrix(const char *  path, double **  matrix, size_t *  order);
+
+/**
+ *	@brief	Load a multiples file. On success, `*multiples` is allocated and must
+ *		be freed with `free()`.
+ *
+ *	@param	path		: Path of the multiples file.
+ *	@param	multiples	: Pointer to store the multiples.
+ *	@param	count		: Pointer to store the number of multiples.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+CommonConstantReturnType	moonfireLoadMultiples(const char *  path, double **  multiples, size_t *  count);
+
+/**
+ *	@brief	Load a parameter draws file. On success, `*draws` is allocated,
+ *		row-major, and must be freed with `free()`.
+ *
+ *	@param	path	: Path of the parameter draws file.
+ *	@param	draws	: Pointer to store the draws.
+ *	@param	count	: Pointer to store the number of draws.
+ *	@return		: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+CommonConstantReturnType	moonfireLoadParameterDraws(const char *  path, double **  draws, size_t *  count);
+
+/**
+ *	@brief	Load an outcomes file. On success, `*outcomes` is allocated,
+ *		row-major, and must be freed with `free()`.
+ *
+ *	@param	path		: Path of the outcomes file.
+ *	@param	outcomes	: Pointer to store the outcome buckets.
+ *	@param	count		: Pointer to store the number of outcome buckets.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+CommonConstantReturnType	moonfireLoadOutcomes(const char *  path, double **  outcomes, size_t *  count);
+
+/**
+ *	@brief	Load a Monte Carlo output file. On success, `*samples` is allocated
+ *		and must be freed with `free()`.
+ *
+ *	@param	path			: Path of the Monte Carlo output file.
+ *	@param	samples			: Pointer to store the samples.
+ *	@param	count			: Pointer to store the number of samples.
+ *	@param	cpuTimeMicroseconds	: Pointer to store the CPU time of the run in microseconds.
+ *	@return				: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+CommonConstantReturnType	moonfireLoadMonteCarloOutput(const char *  path, double **  samples, size_t *  count, uint64_t *  cpuTimeMicroseconds);
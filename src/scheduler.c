@@ -0,0 +1,256 @@
+/*
+ *	Copyright (c) 2024, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#if defined(MOONFIRE_NATIVE)
+#include <pthread.h>
+#endif
+#include "scheduler.h"
+#include "topology.h"
+
+
+/*
+ *	Deque of a thread: the tasks `thread + k * numberOfThreads` for `k` in
+ *	[head, tail). The owner takes from the head and thieves from the tail.
+ */
+typedef struct
+{
+	size_t			head;
+	size_t			tail;
+#if defined(MOONFIRE_NATIVE)
+	pthread_mutex_t		lock;
+#endif
+} SchedulerDeque;
+
+typedef struct Scheduler	Scheduler;
+
+typedef struct
+{
+	Scheduler *			scheduler;
+	size_t				thread;
+	size_t				numberOfStolenTasks;
+	CommonConstantReturnType	result;
+} SchedulerWorker;
+
+struct Scheduler
+{
+	size_t			numberOfThreads;
+	SchedulerTask		task;
+	void *			state;
+	SchedulerDeque *	deques;
+	SchedulerWorker *	workers;
+};
+
+/**
+ *	@brief	Take a task from a deque, from its head for its owner and from its
+ *		tail for a thief.
+ *
+ *	@param	scheduler	: The scheduler.
+ *	@param	thread		: Index of the thread of the deque.
+ *	@param	isOwner		: `true` for the owner of the deque, else `false`.
+ *	@param	task		: Pointer to store the task.
+ *	@return			: `true` if a task was taken, else `false` if the deque is empty.
+ */
+static bool
+takeTask(Scheduler *  scheduler, size_t thread, bool isOwner, size_t *  task)
+{
+	SchedulerDeque *	deque = &scheduler->deques[thread];
+	bool			isTaken = false;
+
+#if defined(MOONFIRE_NATIVE)
+	pthread_mutex_lock(&deque->lock);
+#endif
+	if (deque->head < deque->tail)
+	{
+		size_t	k = isOwner ? deque->head++ : --deque->tail;
+
+		*task = thread + k * scheduler->numberOfThreads;
+		isTaken = true;
+	}
+#if defined(MOONFIRE_NATIVE)
+	pthread_mutex_unlock(&deque->lock);
+#endif
+
+	return isTaken;
+}
+
+/**
+ *	@brief	Run the tasks of the deque of a worker, then steal tasks until all
+ *		deques are empty. A worker whose task fails stops.
+ *
+ *	@param	argument	: The `SchedulerWorker`.
+ *	@return			: `NULL`.
+ */
+static void *
+runSchedulerWorker(void *  argument)
+{
+	SchedulerWorker *	worker = argument;
+	Scheduler *		scheduler = worker->scheduler;
+	size_t			task;
+
+	pinWorkerThread(worker->thread);
+
+	while (worker->result == kCommonConstantReturnTypeSuccess)
+	{
+		bool	isTaken = takeTask(scheduler, worker->thread, true, &task);
+
+		/*
+		 *	Visit the other deques in turn, starting after the own one, so
+		 *	that thieves spread over the victims.
+		 */
+		for (size_t i = 1; !isTaken && (i < scheduler->numberOfThreads); i++)
+		{
+			isTaken = takeTask(scheduler, (worker->thread + i) % scheduler->numberOfThreads, false, &task);
+			worker->numberOfStolenTasks += isTaken;
+		}
+
+		if (!isTaken)
+		{
+			break;
+		}
+
+		worker->result = scheduler->task(scheduler->state, worker->thread, task);
+	}
+
+	return NULL;
+}
+
+CommonConstantReturnType
+runWorkStealingTasks(
+	size_t			numberOfThreads,
+	size_t			numberOfTasks,
+	SchedulerTask		task,
+	void *			state,
+	SchedulerReport *	report)
+{
+	Scheduler			scheduler;
+	CommonConstantReturnType	result = kCommonConstantReturnTypeSuccess;
+
+	if ((numberOfThreads == 0) || (task == NULL))
+	{
+		fprintf(stderr, "Error: The scheduler needs at least one thread and a task.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+#if !defined(MOONFIRE_NATIVE)
+	numberOfThreads = 1;
+#endif
+	numberOfThreads = ((numberOfTasks > 0) && (numberOfThreads > numberOfTasks)) ? numberOfTasks : numberOfThreads;
+
+	scheduler = (Scheduler) {
+		.numberOfThreads	= numberOfThreads,
+		.task			= task,
+		.state			= state,
+		.deques			= calloc(numberOfThreads, sizeof(SchedulerDeque)),
+		.workers		= calloc(numberOfThreads, sizeof(SchedulerWorker)),
+	};
+	if ((scheduler.deques == NULL) || (scheduler.workers == NULL))
+	{
+		fprintf(stderr, "Error: Could not allocate the scheduler.\n");
+		free(scheduler.deques);
+		free(scheduler.workers);
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	for (size_t t = 0; t < numberOfThreads; t++)
+	{
+		scheduler.deques[t].tail = (numberOfTasks - t + numberOfThreads - 1) / numberOfThreads;
+#if defined(MOONFIRE_NATIVE)
+		pthread_mutex_init(&scheduler.deques[t].lock, NULL);
+#endif
+		scheduler.workers[t] = (SchedulerWorker) {
+			.scheduler	= &scheduler,
+			.thread		= t,
+			.result		= kCommonConstantReturnTypeSuccess,
+		};
+	}
+
+#if defined(MOONFIRE_NATIVE)
+	{
+		pthread_t *	threads = calloc(numberOfThreads, sizeof(pthread_t));
+		size_t		numberOfStarted = 0;
+
+		/*
+		 *	The calling thread is the first worker. The tasks of workers whose
+		 *	thread could not be started are stolen by the others.
+		 */
+		for (size_t t = 1; (threads != NULL) && (t < numberOfThreads); t++)
+		{
+			if (pthread_create(&threads[t], NULL, runSchedulerWorker, &scheduler.workers[t]) != 0)
+			{
+				break;
+			}
+			numberOfStarted = t;
+		}
+
+		runSchedulerWorker(&scheduler.workers[0]);
+		for (size_t t = 1; t <= numberOfStarted; t++)
+		{
+			pthread_join(threads[t], NULL);
+		}
+		free(threads);
+	}
+#else
+	runSchedulerWorker(&scheduler.workers[0]);
+#endif
+
+	if (report != NULL)
+	{
+		*report = (SchedulerReport) {
+			.numberOfThreads	= numberOfThreads,
+			.numberOfTasks		= numberOfTasks,
+		};
+	}
+
+	for (size_t t = 0; t < numberOfThreads; t++)
+	{
+		if (scheduler.workers[t].result != kCommonConstantReturnTypeSuccess)
+		{
+			result = kCommonConstantReturnTypeError;
+		}
+
+		/*
+		 *	Tasks left in a deque, after a failed task, did not run.
+		 */
+		if (scheduler.deques[t].head < scheduler.deques[t].tail)
+		{
+			result = kCommonConstantReturnTypeError;
+		}
+
+		if (report != NULL)
+		{
+			report->numberOfStolenTasks += scheduler.workers[t].numberOfStolenTasks;
+		}
+#if defined(MOONFIRE_NATIVE)
+		pthread_mutex_destroy(&scheduler.deques[t].lock);
+#endif
+	}
+
+	free(scheduler.deques);
+	free(scheduler.workers);
+
+	return result;
+}
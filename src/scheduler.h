@@ -0,0 +1,77 @@
+/*
+ *	Copyright (c) 2024, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#pragma once
+#include <stddef.h>
+#include "common.h"
+
+
+/*
+ *	Work-stealing scheduler for tasks of uneven cost, e.g., the points of a
+ *	parameter sweep (see `sweep.h`).
+ *
+ *	The tasks `0 .. numberOfTasks - 1` are dealt round-robin to one deque per
+ *	thread, so that callers list the most expensive tasks first. Each thread
+ *	runs the tasks of its own deque from the front and, once its deque is
+ *	empty, steals tasks from the back of the deques of the other threads, so
+ *	that no thread idles while another still has tasks queued. A deque is
+ *	only locked to take one task, so locks are held briefly and rarely
+ *	contended when tasks take milliseconds. Tasks write their results to
+ *	disjoint memory, so they need no further synchronization.
+ *
+ *	Without `MOONFIRE_NATIVE`, the calling thread runs all tasks.
+ */
+
+/**
+ *	@brief	A task of the scheduler.
+ *
+ *	@param	state	: The state of the caller.
+ *	@param	thread	: Index of the thread that runs the task, in [0, numberOfThreads), e.g., for per-thread buffers.
+ *	@param	task	: Index of the task.
+ *	@return		: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+typedef CommonConstantReturnType	(*SchedulerTask)(void *  state, size_t thread, size_t task);
+
+typedef struct
+{
+	size_t	numberOfThreads;
+	size_t	numberOfTasks;
+	size_t	numberOfStolenTasks;
+} SchedulerReport;
+
+/**
+ *	@brief	Run tasks on threads that steal work from each other, and return
+ *		once all tasks ran.
+ *
+ *	@param	numberOfThreads	: Number of threads, at least 1, including the calling thread.
+ *	@param	numberOfTasks	: Number of tasks.
+ *	@param	task		: The task function.
+ *	@param	state		: The state passed to the tasks.
+ *	@param	report		: Pointer to struct to store the threads and the stolen tasks, or `NULL`.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if all tasks were successful, else `kCommonConstantReturnTypeError`.
+ */
+CommonConstantReturnType	runWorkStealingTasks(
+					size_t			numberOfThreads,
+					size_t			numberOfTasks,
+					SchedulerTask		task,
+					void *			state,
+					SchedulerReport *	report);
@@ -0,0 +1,996 @@
+/*
+ *	Copyright (c) 2024, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "cache.h"
+#include "server.h"
+
+#if !defined(MSG_NOSIGNAL)
+#define MSG_NOSIGNAL	0
+#endif
+
+
+typedef enum
+{
+	kServerConstantMaximumIdLength		= 128,
+	kServerConstantMaximumResponseLength	= 4096,
+	kServerConstantListenBacklog		= 64,
+} ServerPrivateConstant;
+
+typedef struct
+{
+	int			fd;
+	pthread_mutex_t		lock;
+	pthread_cond_t		drained;
+	size_t			numberOfPendingResponses;
+} ServerConnection;
+
+typedef struct
+{
+	/*
+	 *	The `id` of the request as a JSON token, copied verbatim to the response.
+	 */
+	char			id[kServerConstantMaximumIdLength];
+	MoonfireParameters	parameters;
+	bool			isHistogramRequested;
+	ServerConnection *	connection;
+} ServerRequest;
+
+typedef struct
+{
+	ServerRequest		requests[kServerConstantQueueCapacity];
+	size_t			head;
+	size_t			count;
+	bool			isShuttingDown;
+	pthread_mutex_t		lock;
+	pthread_cond_t		notEmpty;
+} ServerQueue;
+
+typedef struct
+{
+	ServerQueue		queue;
+	MoonfireParameters	defaultParameters;
+
+	/*
+	 *	Directory of the result cache, or `NULL` if caching is disabled.
+	 */
+	const char *		cacheDirectory;
+} Server;
+
+typedef struct
+{
+	Server *		server;
+	ServerConnection *	connection;
+} ServerConnectionThreadArguments;
+
+static volatile sig_atomic_t	isServerStopRequested = 0;
+
+static void
+handleServerStopSignal(int signalNumber)
+{
+	(void) signalNumber;
+	isServerStopRequested = 1;
+
+	return;
+}
+
+/**
+ *	@brief	Write a complete line to a connection. Concurrent writers are serialized,
+ *		so lines are never interleaved.
+ *
+ *	@param	connection	: The connection.
+ *	@param	line		: The line, including its terminating newline.
+ */
+static void
+sendLine(ServerConnection *  connection, const char *  line)
+{
+	size_t	length = strlen(line);
+	size_t	sent = 0;
+
+	pthread_mutex_lock(&connection->lock);
+	while (sent < length)
+	{
+		ssize_t	ret = send(connection->fd, line + sent, length - sent, MSG_NOSIGNAL);
+
+		if (ret < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+
+			break;
+		}
+		sent += (size_t) ret;
+	}
+	pthread_mutex_unlock(&connection->lock);
+
+	return;
+}
+
+static void
+sendError(ServerConnection *  connection, const char *  id, const char *  message)
+{
+	char	response[kServerConstantMaximumResponseLength];
+
+	snprintf(response, sizeof(response), "{\"id\": %.*s, \"error\": \"%s\"}\n", (int) kServerConstantMaximumIdLength, id, message);
+	sendLine(connection, response);
+
+	return;
+}
+
+/**
+ *	@brief	Send the result of a request.
+ *
+ *	@param	connection	: The connection.
+ *	@param	request		: The request.
+ *	@param	statistics	: The statistics of the result.
+ *	@param	histogram	: The histogram of the result, sent if the request asked for it.
+ *	@param	isCached	: Whether the result came from the result cache.
+ */
+static void
+sendResult(
+	ServerConnection *		connection,
+	const ServerRequest *		request,
+	const MoonfireStatistics *	statistics,
+	const MoonfireHistogram *	histogram,
+	bool				isCached)
+{
+	char	response[kServerConstantMaximumResponseLength];
+	size_t	length;
+
+	length = (size_t) snprintf(
+		response,
+		sizeof(response),
+		"{\"id\": %.*s, \"mean\": %.17g, \"variance\": %.17g, \"probabilityOfLoss\": %.17g, \"lowQuantile\": %.17g, \"highQuantile\": %.17g, \"iterations\": %zu, \"cached\": %s",
+		(int) kServerConstantMaximumIdLength,
+		request->id,
+		statistics->mean,
+		statistics->variance,
+		statistics->probabilityOfLoss,
+		statistics->lowQuantile,
+		statistics->highQuantile,
+		request->parameters.numberOfIterations,
+		isCached ? "true" : "false");
+
+	if (request->isHistogramRequested)
+	{
+		length += (size_t) snprintf(
+			response + length,
+			sizeof(response) - length,
+			", \"histogram\": {\"lowerEdge\": %.17g, \"upperEdge\": %.17g, \"counts\": [",
+			histogram->lowerEdge,
+			histogram->upperEdge);
+		for (size_t i = 0; i < kMoonfireConstantHistogramNumberOfBins; i++)
+		{
+			length += (size_t) snprintf(response + length, sizeof(response) - length, (i == 0) ? "%" PRIu64 : ", %" PRIu64, histogram->counts[i]);
+		}
+		length += (size_t) snprintf(response + length, sizeof(response) - length, "]}");
+	}
+
+	snprintf(response + length, sizeof(response) - length, "}\n");
+	sendLine(connection, response);
+
+	return;
+}
+
+/**
+ *	@brief	Mark one response of a connection as sent.
+ *
+ *	@param	connection	: The connection.
+ */
+static void
+completeResponse(ServerConnection *  connection)
+{
+	pthread_mutex_lock(&connection->lock);
+	connection->numberOfPendingResponses--;
+	if (connection->numberOfPendingResponses == 0)
+	{
+		pthread_cond_signal(&connection->drained);
+	}
+	pthread_mutex_unlock(&connection->lock);
+
+	return;
+}
+
+static const char *
+skipWhitespace(const char *  cursor)
+{
+	while (isspace((unsigned char) *cursor))
+	{
+		cursor++;
+	}
+
+	return cursor;
+}
+
+/**
+ *	@brief	Parse one request line, a flat JSON object whose values are numbers or,
+ *		for `id`, strings without escapes.
+ *
+ *	@param	line			: The request line.
+ *	@param	defaultParameters	: Parameters used for missing fields.
+ *	@param	request			: Pointer to store the request. `id` is set even when parsing fails later.
+ *	@param	errorMessage		: Pointer to store a description of the error.
+ *	@return				: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+parseRequest(const char *  line, const MoonfireParameters *  defaultParameters, ServerRequest *  request, const char **  errorMessage)
+{
+	const char *	cursor = skipWhitespace(line);
+
+	strcpy(request->id, "null");
+	request->isHistogramRequested = false;
+	request->parameters = *defaultParameters;
+	request->parameters.engine = kMoonfireEngineKernels;
+
+	if (*cursor != '{')
+	{
+		*errorMessage = "request must be a JSON object";
+
+		return kCommonConstantReturnTypeError;
+	}
+	cursor = skipWhitespace(cursor + 1);
+
+	while (*cursor != '}')
+	{
+		char		key[32];
+		size_t		keyLength = 0;
+		const char *	valueStart;
+		const char *	valueEnd;
+		char *		numberEnd;
+
+		if (*cursor != '"')
+		{
+			*errorMessage = "expected a quoted key";
+
+			return kCommonConstantReturnTypeError;
+		}
+		for (cursor++; (*cursor != '"') && (*cursor != '\0'); cursor++)
+		{
+			if (keyLength + 1 < sizeof(key))
+			{
+				key[keyLength++] = *cursor;
+			}
+		}
+		key[keyLength] = '\0';
+		if (*cursor != '"')
+		{
+			*errorMessage = "unterminated key";
+
+			return kCommonConstantReturnTypeError;
+		}
+		cursor = skipWhitespace(cursor + 1);
+		if (*cursor != ':')
+		{
+			*errorMessage = "expected ':' after key";
+
+			return kCommonConstantReturnTypeError;
+		}
+		cursor = skipWhitespace(cursor + 1);
+
+		/*
+		 *	Find the extent of the value token.
+		 */
+		valueStart = cursor;
+		if (*cursor == '"')
+		{
+			for (cursor++; (*cursor != '"') && (*cursor != '\0') && (*cursor != '\\'); cursor++)
+			{
+			}
+			if (*cursor != '"')
+			{
+				*errorMessage = "unterminated or escaped string value";
+
+				return kCommonConstantReturnTypeError;
+			}
+			cursor++;
+		}
+		else
+		{
+			while ((*cursor != ',') && (*cursor != '}') && (*cursor != '\0') && !isspace((unsigned char) *cursor))
+			{
+				cursor++;
+			}
+		}
+		valueEnd = cursor;
+
+		if (valueEnd == valueStart)
+		{
+			*errorMessage = "missing value";
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		if (strcmp(key, "id") == 0)
+		{
+			size_t	idLength = (size_t)(valueEnd - valueStart);
+
+			if (idLength >= sizeof(request->id))
+			{
+				*errorMessage = "id too long";
+
+				return kCommonConstantReturnTypeError;
+			}
+
+			/*
+			 *	The id is echoed as is in the response, so it must be a
+			 *	JSON string without control characters or a JSON number.
+			 */
+			if (*valueStart == '"')
+			{
+				for (const char *  character = valueStart + 1; character < valueEnd - 1; character++)
+				{
+					if ((unsigned char) *character < 0x20)
+					{
+						*errorMessage = "invalid id";
+
+						return kCommonConstantReturnTypeError;
+					}
+				}
+			}
+			else
+			{
+				(void) strtod(valueStart, &numberEnd);
+				if ((numberEnd != valueEnd) || !((*valueStart == '-') || isdigit((unsigned char) *valueStart)) ||
+					(strspn(valueStart, "0123456789+-.eE") < idLength))
+				{
+					*errorMessage = "invalid id";
+
+					return kCommonConstantReturnTypeError;
+				}
+			}
+			memcpy(request->id, valueStart, idLength);
+			request->id[idLength] = '\0';
+		}
+		else if (strcmp(key, "copula") == 0)
+		{
+			size_t	valueLength = (size_t)(valueEnd - valueStart);
+
+			if ((valueLength == strlen("\"independent\"")) && (strncmp(valueStart, "\"independent\"", valueLength) == 0))
+			{
+				request->parameters.copula = kMoonfireCopulaIndependent;
+			}
+			else if ((valueLength == strlen("\"gaussian\"")) && (strncmp(valueStart, "\"gaussian\"", valueLength) == 0))
+			{
+				request->parameters.copula = kMoonfireCopulaGaussian;
+			}
+			else if ((valueLength == strlen("\"t\"")) && (strncmp(valueStart, "\"t\"", valueLength) == 0))
+			{
+				request->parameters.copula = kMoonfireCopulaStudentT;
+			}
+			else
+			{
+				*errorMessage = "`copula` must be independent, gaussian or t";
+
+				return kCommonConstantReturnTypeError;
+			}
+		}
+		else if (*valueStart == '"')
+		{
+			*errorMessage = "only `id` and `copula` may be strings";
+
+			return kCommonConstantReturnTypeError;
+		}
+		else if ((strcmp(key, "n") == 0) || (strcmp(key, "iterations") == 0) || (strcmp(key, "seed") == 0) || (strcmp(key, "histogram") == 0) ||
+			(strcmp(key, "degreesOfFreedom") == 0))
+		{
+			unsigned long long	value;
+
+			errno = 0;
+			value = strtoull(valueStart, &numberEnd, 10);
+			if ((errno != 0) || (numberEnd != valueEnd) || (*valueStart == '-'))
+			{
+				*errorMessage = "`n`, `iterations`, `seed`, `histogram` and `degreesOfFreedom` must be non-negative integers";
+
+				return kCommonConstantReturnTypeError;
+			}
+
+			if (strcmp(key, "n") == 0)
+			{
+				request->parameters.numberOfInvestments = (size_t) value;
+				request->parameters.portfolio = NULL;
+				request->parameters.classCorrelationMatrix = NULL;
+			}
+			else if (strcmp(key, "iterations") == 0)
+			{
+				request->parameters.numberOfIterations = (size_t) value;
+			}
+			else if (strcmp(key, "histogram") == 0)
+			{
+				request->isHistogramRequested = (value != 0);
+			}
+			else if (strcmp(key, "degreesOfFreedom") == 0)
+			{
+				request->parameters.degreesOfFreedom = (size_t) value;
+			}
+			else
+			{
+				request->parameters.seed = (uint64_t) value;
+			}
+		}
+		else
+		{
+			double	value = strtod(valueStart, &numberEnd);
+
+			if (numberEnd != valueEnd)
+			{
+				*errorMessage = "malformed number";
+
+				return kCommonConstantReturnTypeError;
+			}
+
+			if (strcmp(key, "alpha") == 0)
+			{
+				request->parameters.alpha = value;
+				request->parameters.portfolio = NULL;
+				request->parameters.classCorrelationMatrix = NULL;
+			}
+			else if (strcmp(key, "xMin") == 0)
+			{
+				request->parameters.xMin = value;
+				request->parameters.portfolio = NULL;
+				request->parameters.classCorrelationMatrix = NULL;
+			}
+			else if (strcmp(key, "xMax") == 0)
+			{
+				request->parameters.xMax = value;
+				request->parameters.portfolio = NULL;
+				request->parameters.classCorrelationMatrix = NULL;
+			}
+			else if ((strcmp(key, "q") == 0) || (strcmp(key, "lowQuantileProbability") == 0))
+			{
+				request->parameters.lowQuantileProbability = value;
+			}
+			else if ((strcmp(key, "Q") == 0) || (strcmp(key, "highQuantileProbability") == 0))
+			{
+				request->parameters.highQuantileProbability = value;
+			}
+			else if (strcmp(key, "marketCorrelation") == 0)
+			{
+				request->parameters.marketCorrelation = value;
+			}
+			else if (strcmp(key, "classCorrelation") == 0)
+			{
+				request->parameters.classCorrelation = value;
+			}
+			else
+			{
+				*errorMessage = "unknown key";
+
+				return kCommonConstantReturnTypeError;
+			}
+		}
+
+		cursor = skipWhitespace(cursor);
+		if (*cursor == ',')
+		{
+			cursor = skipWhitespace(cursor + 1);
+		}
+		else if (*cursor != '}')
+		{
+			*errorMessage = "expected ',' or '}'";
+
+			return kCommonConstantReturnTypeError;
+		}
+	}
+
+	/*
+	 *	The class correlation matrix of the command line only applies with a copula.
+	 */
+	if (request->parameters.copula == kMoonfireCopulaIndependent)
+	{
+		request->parameters.classCorrelationMatrix = NULL;
+	}
+
+	if (request->parameters.numberOfIterations > kServerConstantMaximumIterations)
+	{
+		*errorMessage = "iterations exceeds the server limit";
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if (moonfireValidateParameters(&request->parameters) != kCommonConstantReturnTypeSuccess)
+	{
+		*errorMessage = "invalid model parameters";
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+static bool
+areParametersEqual(const MoonfireParameters *  a, const MoonfireParameters *  b)
+{
+	return	(a->portfolio == b->portfolio) &&
+		(a->alpha == b->alpha) &&
+		(a->xMin == b->xMin) &&
+		(a->xMax == b->xMax) &&
+		(a->numberOfInvestments == b->numberOfInvestments) &&
+		(a->lowQuantileProbability == b->lowQuantileProbability) &&
+		(a->highQuantileProbability == b->highQuantileProbability) &&
+		(a->numberOfIterations == b->numberOfIterations) &&
+		(a->seed == b->seed) &&
+		(a->engine == b->engine) &&
+		(a->copula == b->copula) &&
+		(a->marketCorrelation == b->marketCorrelation) &&
+		(a->classCorrelation == b->classCorrelation) &&
+		(a->degreesOfFreedom == b->degreesOfFreedom) &&
+		(a->classCorrelationMatrix == b->classCorrelationMatrix);
+}
+
+/**
+ *	@brief	Try to add a request to the queue.
+ *
+ *	@param	queue	: The queue.
+ *	@param	request	: The request.
+ *	@return		: `kCommonConstantReturnTypeSuccess` if queued, else `kCommonConstantReturnTypeError` if the queue is full or shutting down.
+ */
+static CommonConstantReturnType
+enqueueRequest(ServerQueue *  queue, const ServerRequest *  request)
+{
+	pthread_mutex_lock(&queue->lock);
+	if ((queue->count == kServerConstantQueueCapacity) || queue->isShuttingDown)
+	{
+		pthread_mutex_unlock(&queue->lock);
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	pthread_mutex_lock(&request->connection->lock);
+	request->connection->numberOfPendingResponses++;
+	pthread_mutex_unlock(&request->connection->lock);
+
+	queue->requests[(queue->head + queue->count) % kServerConstantQueueCapacity] = *request;
+	queue->count++;
+	pthread_cond_signal(&queue->notEmpty);
+	pthread_mutex_unlock(&queue->lock);
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+/**
+ *	@brief	Remove up to `kServerConstantBatchSize` requests from the queue, blocking
+ *		while it is empty.
+ *
+ *	@param	queue	: The queue.
+ *	@param	batch	: Array to store the requests.
+ *	@return		: The number of requests removed, 0 when the server is shutting down.
+ */
+static size_t
+dequeueRequestBatch(ServerQueue *  queue, ServerRequest *  batch)
+{
+	size_t	batchSize = 0;
+
+	pthread_mutex_lock(&queue->lock);
+	while ((queue->count == 0) && !queue->isShuttingDown)
+	{
+		pthread_cond_wait(&queue->notEmpty, &queue->lock);
+	}
+
+	while ((queue->count > 0) && (batchSize < kServerConstantBatchSize))
+	{
+		batch[batchSize++] = queue->requests[queue->head];
+		queue->head = (queue->head + 1) % kServerConstantQueueCapacity;
+		queue->count--;
+	}
+	pthread_mutex_unlock(&queue->lock);
+
+	return batchSize;
+}
+
+static void *
+runServerWorker(void *  argument)
+{
+	Server *		server = argument;
+	MoonfireContext *	context = moonfireCreateContext(&server->defaultParameters);
+	ServerRequest		batch[kServerConstantBatchSize];
+	MoonfireStatistics	batchStatistics[kServerConstantBatchSize];
+	MoonfireHistogram	batchHistograms[kServerConstantBatchSize];
+	bool			isBatchResultAvailable[kServerConstantBatchSize];
+	bool			isBatchResultCached[kServerConstantBatchSize];
+	size_t			batchSize;
+
+	while ((batchSize = dequeueRequestBatch(&server->queue, batch)) > 0)
+	{
+		for (size_t i = 0; i < batchSize; i++)
+		{
+			size_t	sameParametersIndex = i;
+
+			/*
+			 *	Reuse the result of an identical request earlier in the batch.
+			 */
+			for (size_t j = 0; j < i; j++)
+			{
+				if (isBatchResultAvailable[j] && areParametersEqual(&batch[j].parameters, &batch[i].parameters))
+				{
+					sameParametersIndex = j;
+					break;
+				}
+			}
+
+			isBatchResultAvailable[i] = false;
+			isBatchResultCached[i] = false;
+			if (sameParametersIndex != i)
+			{
+				batchStatistics[i] = batchStatistics[sameParametersIndex];
+				batchHistograms[i] = batchHistograms[sameParametersIndex];
+				isBatchResultAvailable[i] = true;
+				isBatchResultCached[i] = isBatchResultCached[sameParametersIndex];
+			}
+			else if ((server->cacheDirectory != NULL) &&
+				(lookupCachedResult(server->cacheDirectory, &batch[i].parameters, &batchStatistics[i], &batchHistograms[i]) == kCommonConstantReturnTypeSuccess))
+			{
+				isBatchResultAvailable[i] = true;
+				isBatchResultCached[i] = true;
+			}
+			else if ((context != NULL) &&
+				(moonfireSetParameters(context, &batch[i].parameters) == kCommonConstantReturnTypeSuccess) &&
+				(moonfireSimulate(context) == kCommonConstantReturnTypeSuccess) &&
+				(moonfireGetStatistics(context, &batchStatistics[i]) == kCommonConstantReturnTypeSuccess) &&
+				(moonfireGetHistogram(context, &batchHistograms[i]) == kCommonConstantReturnTypeSuccess))
+			{
+				isBatchResultAvailable[i] = true;
+				if (server->cacheDirectory != NULL)
+				{
+					storeCachedResult(server->cacheDirectory, &batch[i].parameters, &batchStatistics[i], &batchHistograms[i]);
+				}
+			}
+
+			if (isBatchResultAvailable[i])
+			{
+				sendResult(batch[i].connection, &batch[i], &batchStatistics[i], &batchHistograms[i], isBatchResultCached[i]);
+			}
+			else
+			{
+				sendError(batch[i].connection, batch[i].id, "simulation failed");
+			}
+			completeResponse(batch[i].connection);
+		}
+	}
+
+	moonfireDestroyContext(context);
+
+	return NULL;
+}
+
+/**
+ *	@brief	Handle one request line of a connection.
+ *
+ *	@param	server		: The server.
+ *	@param	connection	: The connection.
+ *	@param	line		: The request line, without its newline.
+ */
+static void
+handleRequestLine(Server *  server, ServerConnection *  connection, const char *  line)
+{
+	ServerRequest	request;
+	const char *	errorMessage = NULL;
+
+	if (*skipWhitespace(line) == '\0')
+	{
+		return;
+	}
+
+	request.connection = connection;
+	if (parseRequest(line, &server->defaultParameters, &request, &errorMessage) != kCommonConstantReturnTypeSuccess)
+	{
+		sendError(connection, request.id, errorMessage);
+
+		return;
+	}
+
+	if (enqueueRequest(&server->queue, &request) != kCommonConstantReturnTypeSuccess)
+	{
+		sendError(connection, request.id, "server busy");
+	}
+
+	return;
+}
+
+static void *
+runServerConnection(void *  argument)
+{
+	ServerConnectionThreadArguments *	threadArguments = argument;
+	Server *				server = threadArguments->server;
+	ServerConnection *			connection = threadArguments->connection;
+	char					buffer[kServerConstantMaximumLineLength];
+	size_t					length = 0;
+	bool					isDiscardingLine = false;
+	ssize_t					bytesRead;
+
+	free(threadArguments);
+
+	while ((bytesRead = read(connection->fd, buffer + length, sizeof(buffer) - 1 - length)) != 0)
+	{
+		char *	lineStart = buffer;
+		char *	newline;
+
+		if (bytesRead < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+
+			break;
+		}
+
+		length += (size_t) bytesRead;
+		buffer[length] = '\0';
+
+		while ((newline = memchr(lineStart, '\n', length - (size_t)(lineStart - buffer))) != NULL)
+		{
+			*newline = '\0';
+			if (!isDiscardingLine)
+			{
+				handleRequestLine(server, connection, lineStart);
+			}
+			isDiscardingLine = false;
+			lineStart = newline + 1;
+		}
+
+		length -= (size_t)(lineStart - buffer);
+		memmove(buffer, lineStart, length);
+
+		/*
+		 *	Reject lines longer than the buffer, and skip the rest of them.
+		 */
+		if (length == sizeof(buffer) - 1)
+		{
+			if (!isDiscardingLine)
+			{
+				sendError(connection, "null", "request line too long");
+			}
+			isDiscardingLine = true;
+			length = 0;
+		}
+	}
+
+	/*
+	 *	Wait for the workers to answer all queued requests before closing.
+	 */
+	pthread_mutex_lock(&connection->lock);
+	while (connection->numberOfPendingResponses > 0)
+	{
+		pthread_cond_wait(&connection->drained, &connection->lock);
+	}
+	pthread_mutex_unlock(&connection->lock);
+
+	close(connection->fd);
+	pthread_cond_destroy(&connection->drained);
+	pthread_mutex_destroy(&connection->lock);
+	free(connection);
+
+	return NULL;
+}
+
+/**
+ *	@brief	Accept a connection and start its reader thread.
+ *
+ *	@param	server	: The server.
+ *	@param	fd	: The accepted socket.
+ */
+static void
+startConnection(Server *  server, int fd)
+{
+	ServerConnection *			connection = calloc(1, sizeof(ServerConnection));
+	ServerConnectionThreadArguments *	threadArguments = calloc(1, sizeof(ServerConnectionThreadArguments));
+	pthread_t				thread;
+	pthread_attr_t				attributes;
+
+	if ((connection == NULL) || (threadArguments == NULL))
+	{
+		fprintf(stderr, "Error: Could not allocate a connection.\n");
+		free(connection);
+		free(threadArguments);
+		close(fd);
+
+		return;
+	}
+
+	connection->fd = fd;
+	pthread_mutex_init(&connection->lock, NULL);
+	pthread_cond_init(&connection->drained, NULL);
+	*threadArguments = (ServerConnectionThreadArguments) {.server = server, .connection = connection};
+
+	pthread_attr_init(&attributes);
+	pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+	if (pthread_create(&thread, &attributes, runServerConnection, threadArguments) != 0)
+	{
+		fprintf(stderr, "Error: Could not create a connection thread.\n");
+		pthread_cond_destroy(&connection->drained);
+		pthread_mutex_destroy(&connection->lock);
+		free(connection);
+		free(threadArguments);
+		close(fd);
+	}
+	pthread_attr_destroy(&attributes);
+
+	return;
+}
+
+/**
+ *	@brief	Create, bind and listen on a Unix stream socket. A stale socket file at
+ *		`socketPath` is removed; any other existing file is an error.
+ *
+ *	@param	socketPath	: Filesystem path of the socket.
+ *	@return			: The listening socket, or -1 on error.
+ */
+static int
+listenOnUnixSocket(const char *  socketPath)
+{
+	struct sockaddr_un	address = {0};
+	struct stat		status;
+	int			fd;
+
+	if (strlen(socketPath) >= sizeof(address.sun_path))
+	{
+		fprintf(stderr, "Error: The socket path \"%s\" is too long.\n", socketPath);
+
+		return -1;
+	}
+
+	if (stat(socketPath, &status) == 0)
+	{
+		if (!S_ISSOCK(status.st_mode))
+		{
+			fprintf(stderr, "Error: \"%s\" exists and is not a socket.\n", socketPath);
+
+			return -1;
+		}
+		unlink(socketPath);
+	}
+
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0)
+	{
+		fprintf(stderr, "Error: Could not create socket: %s.\n", strerror(errno));
+
+		return -1;
+	}
+
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, socketPath);
+	if ((bind(fd, (struct sockaddr *) &address, sizeof(address)) != 0) || (listen(fd, kServerConstantListenBacklog) != 0))
+	{
+		fprintf(stderr, "Error: Could not listen on \"%s\": %s.\n", socketPath, strerror(errno));
+		close(fd);
+
+		return -1;
+	}
+
+	return fd;
+}
+
+CommonConstantReturnType
+runServer(const char *  socketPath, const MoonfireParameters *  defaultParameters, size_t numberOfWorkers, const char *  cacheDirectory)
+{
+	Server *		server;
+	pthread_t *		workers;
+	size_t			numberOfStartedWorkers = 0;
+	struct sigaction	stopAction = {0};
+	int			listenFd;
+
+	server = calloc(1, sizeof(Server));
+	workers = calloc(numberOfWorkers, sizeof(pthread_t));
+	if ((server == NULL) || (workers == NULL))
+	{
+		fprintf(stderr, "Error: Could not allocate the server.\n");
+		free(server);
+		free(workers);
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	server->defaultParameters = *defaultParameters;
+	server->defaultParameters.engine = kMoonfireEngineKernels;
+	server->cacheDirectory = cacheDirectory;
+	pthread_mutex_init(&server->queue.lock, NULL);
+	pthread_cond_init(&server->queue.notEmpty, NULL);
+
+	listenFd = listenOnUnixSocket(socketPath);
+	if (listenFd < 0)
+	{
+		free(server);
+		free(workers);
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	/*
+	 *	No SA_RESTART, so that a stop signal interrupts `accept()`.
+	 */
+	stopAction.sa_handler = handleServerStopSignal;
+	sigemptyset(&stopAction.sa_mask);
+	sigaction(SIGINT, &stopAction, NULL);
+	sigaction(SIGTERM, &stopAction, NULL);
+	signal(SIGPIPE, SIG_IGN);
+
+	for (; numberOfStartedWorkers < numberOfWorkers; numberOfStartedWorkers++)
+	{
+		if (pthread_create(&workers[numberOfStartedWorkers], NULL, runServerWorker, server) != 0)
+		{
+			fprintf(stderr, "Error: Could not create worker thread.\n");
+			isServerStopRequested = 1;
+			break;
+		}
+	}
+
+	fprintf(stderr, "Listening on %s with %zu workers.\n", socketPath, numberOfStartedWorkers);
+
+	while (!isServerStopRequested)
+	{
+		int	connectionFd = accept(listenFd, NULL, NULL);
+
+		if (connectionFd < 0)
+		{
+			if ((errno != EINTR) && (errno != ECONNABORTED))
+			{
+				fprintf(stderr, "Error: accept() failed: %s.\n", strerror(errno));
+				break;
+			}
+
+			continue;
+		}
+
+		startConnection(server, connectionFd);
+	}
+
+	/*
+	 *	Let the workers drain the queue, then stop them. Connection threads
+	 *	still blocked on reads end with the process.
+	 */
+	close(listenFd);
+	unlink(socketPath);
+
+	pthread_mutex_lock(&server->queue.lock);
+	server->queue.isShuttingDown = true;
+	pthread_cond_broadcast(&server->queue.notEmpty);
+	pthread_mutex_unlock(&server->queue.lock);
+
+	for (size_t i = 0; i < numberOfStartedWorkers; i++)
+	{
+		pthread_join(workers[i], NULL);
+	}
+
+	free(workers);
+
+	/*
+	 *	`server` is intentionally not freed: detached connection threads may
+	 *	still reference it until the process exits.
+	 */
+
+	return kCommonConstantReturnTypeSuccess;
+}
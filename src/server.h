@@ -0,0 +1,87 @@
+/*
+ *	Copyright (c) 2024, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#pragma once
+#include <stddef.h>
+#include "common.h"
+#include "moonfire.h"
+
+
+/*
+ *	Server mode (native builds only).
+ *
+ *	The server listens on a Unix stream socket and speaks line-delimited JSON.
+ *	Each request is a flat JSON object on one line, e.g.,
+ *
+ *		{"id": 7, "alpha": 1.05, "xMin": 0.35, "xMax": 1000, "n": 100, "q": 0.01, "Q": 0.99, "iterations": 100000, "seed": 0}
+ *
+ *	The `id` is a JSON number, or a JSON string without escapes, and is echoed
+ *	in the response. Requests may also set the fields `copula` ("independent", "gaussian" or
+ *	"t"), `marketCorrelation`, `classCorrelation` and `degreesOfFreedom` of
+ *	`MoonfireParameters`.
+ *
+ *	All fields are optional and default to the values given on the command
+ *	line. With a portfolio file (`-i`), requests use that portfolio, and the
+ *	class correlation matrix of `-m` if any, unless they give `alpha`, `xMin`,
+ *	`xMax` or `n`, which select a homogeneous portfolio with independent class
+ *	factors. `iterations` is the Monte Carlo budget of the request, which defaults
+ *	to `-M` if given, else to `kServerConstantDefaultIterations`. Each response
+ *	is one line, carrying the `id` of its request, e.g.,
+ *
+ *		{"id": 7, "mean": 2.06, "variance": 31.2, "probabilityOfLoss": 0.27, "lowQuantile": 0.54, "highQuantile": 8.4, "iterations": 100000, "cached": false}
+ *
+ *	or `{"id": 7, "error": "<message>"}`. A request with `"histogram": 1` also
+ *	gets a `histogram` object with `lowerEdge`, `upperEdge` and the
+ *	`kMoonfireConstantHistogramNumberOfBins` `counts` of `MoonfireHistogram`. Responses on a connection can arrive
+ *	in a different order than their requests.
+ *
+ *	Requests go into a bounded queue, which worker threads drain in batches.
+ *	Each worker keeps a `MoonfireContext` whose buffers stay allocated between
+ *	requests, and requests with identical parameters within a batch are
+ *	simulated once. When the queue is full, requests are rejected immediately.
+ *	With a cache directory, results are looked up in and stored to the result
+ *	cache of `cache.h`, and `cached` tells whether a result came from it.
+ */
+
+typedef enum
+{
+	kServerConstantDefaultIterations	= 100000,
+	kServerConstantQueueCapacity		= 1024,
+	kServerConstantBatchSize		= 16,
+	kServerConstantMaximumIterations	= 10000000,
+	kServerConstantMaximumLineLength	= 4096,
+} ServerConstant;
+
+/**
+ *	@brief	Run the server until it receives SIGINT or SIGTERM.
+ *
+ *	@param	socketPath		: Filesystem path of the Unix socket to listen on.
+ *	@param	defaultParameters	: Parameters used for fields missing from requests.
+ *	@param	numberOfWorkers		: Number of worker threads.
+ *	@param	cacheDirectory		: Directory of the result cache (see `cache.h`), or `NULL` to disable caching.
+ *	@return				: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+CommonConstantReturnType	runServer(
+					const char *			socketPath,
+					const MoonfireParameters *	defaultParameters,
+					size_t				numberOfWorkers,
+					const char *			cacheDirectory);
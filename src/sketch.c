@@ -0,0 +1,472 @@
+/*
+ *	Copyright (c) 2024, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sketch.h"
+
+
+/**
+ *	@brief	The scale function of the sketch (see `sketch.h`).
+ *
+ *	@param	compression	: The compression.
+ *	@param	probability	: Cumulative probability, in [0, 1].
+ *	@return			: The scale.
+ */
+static double
+scaleOfProbability(double compression, double probability)
+{
+	return compression / (2.0 * M_PI) * asin(2.0 * probability - 1.0);
+}
+
+/**
+ *	@brief	Inverse of `scaleOfProbability()`.
+ *
+ *	@param	compression	: The compression.
+ *	@param	scale		: The scale.
+ *	@return			: The cumulative probability, in [0, 1].
+ */
+static double
+probabilityOfScale(double compression, double scale)
+{
+	if (scale >= compression / 4.0)
+	{
+		return 1.0;
+	}
+
+	return (sin(2.0 * M_PI * scale / compression) + 1.0) / 2.0;
+}
+
+static int
+compareCentroids(const void *  a, const void *  b)
+{
+	double	meanA = ((const QuantileSketchCentroid *) a)->mean;
+	double	meanB = ((const QuantileSketchCentroid *) b)->mean;
+
+	return (meanA > meanB) - (meanA < meanB);
+}
+
+/**
+ *	@brief	Sort all centroids and merge neighbours while they span at most 1 of
+ *		the scale function.
+ *
+ *	@param	sketch	: The sketch.
+ */
+static void
+compressQuantileSketch(QuantileSketch *  sketch)
+{
+	QuantileSketchCentroid	current;
+	double			mergedWeight = 0.0;
+	double			weightLimit;
+	size_t			numberOfMerged = 0;
+
+	if (sketch->numberOfCentroids == sketch->numberOfMergedCentroids)
+	{
+		return;
+	}
+
+	qsort(sketch->centroids, sketch->numberOfCentroids, sizeof(QuantileSketchCentroid), compareCentroids);
+
+	current = sketch->centroids[0];
+	weightLimit = sketch->count * probabilityOfScale(sketch->compression, scaleOfProbability(sketch->compression, 0.0) + 1.0);
+	for (size_t i = 1; i < sketch->numberOfCentroids; i++)
+	{
+		const QuantileSketchCentroid *	next = &sketch->centroids[i];
+
+		if (mergedWeight + current.weight + next->weight <= weightLimit)
+		{
+			current.weight += next->weight;
+			current.mean += (next->mean - current.mean) * next->weight / current.weight;
+
+			continue;
+		}
+
+		sketch->centroids[numberOfMerged++] = current;
+		mergedWeight += current.weight;
+		weightLimit = sketch->count * probabilityOfScale(
+						sketch->compression,
+						scaleOfProbability(sketch->compression, mergedWeight / sketch->count) + 1.0);
+		current = *next;
+	}
+	sketch->centroids[numberOfMerged++] = current;
+
+	sketch->numberOfCentroids = numberOfMerged;
+	sketch->numberOfMergedCentroids = numberOfMerged;
+
+	return;
+}
+
+/**
+ *	@brief	Add a centroid to the buffer of a sketch, merging the buffer when it
+ *		is full. The count, sum, minimum and maximum are updated by the caller.
+ *
+ *	@param	sketch		: The sketch.
+ *	@param	centroid	: The centroid.
+ */
+static void
+addCentroid(QuantileSketch *  sketch, QuantileSketchCentroid centroid)
+{
+	if (sketch->numberOfCentroids == sketch->centroidsCapacity)
+	{
+		compressQuantileSketch(sketch);
+	}
+
+	sketch->centroids[sketch->numberOfCentroids++] = centroid;
+
+	return;
+}
+
+QuantileSketch *
+createQuantileSketch(double compression)
+{
+	QuantileSketch *	sketch;
+
+	if (!(compression >= kQuantileSketchConstantMinimumCompression) || !(compression <= kQuantileSketchConstantMaximumCompression))
+	{
+		fprintf(
+			stderr,
+			"Error: The compression of a quantile sketch must be in [%d, %d].\n",
+			(int) kQuantileSketchConstantMinimumCompression,
+			(int) kQuantileSketchConstantMaximumCompression);
+
+		return NULL;
+	}
+
+	sketch = calloc(1, sizeof(QuantileSketch));
+	if (sketch == NULL)
+	{
+		fprintf(stderr, "Error: Could not allocate the quantile sketch.\n");
+
+		return NULL;
+	}
+
+	/*
+	 *	Merged centroids span more than 1 of the scale function in pairs, so
+	 *	there are at most about `compression` of them besides the buffer.
+	 */
+	sketch->centroidsCapacity = (kQuantileSketchConstantBufferFactor + 1) * (size_t) ceil(compression) + 2;
+	sketch->centroids = malloc(sketch->centroidsCapacity * sizeof(QuantileSketchCentroid));
+	if (sketch->centroids == NULL)
+	{
+		fprintf(stderr, "Error: Could not allocate the quantile sketch.\n");
+		free(sketch);
+
+		return NULL;
+	}
+
+	sketch->compression = compression;
+	sketch->minimum = INFINITY;
+	sketch->maximum = -INFINITY;
+
+	return sketch;
+}
+
+void
+addQuantileSketchValues(QuantileSketch *  sketch, const double *  values, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		sketch->count += 1.0;
+		sketch->sum += values[i];
+		sketch->minimum = (values[i] < sketch->minimum) ? values[i] : sketch->minimum;
+		sketch->maximum = (values[i] > sketch->maximum) ? values[i] : sketch->maximum;
+		addCentroid(sketch, (QuantileSketchCentroid) {.mean = values[i], .weight = 1.0});
+	}
+
+	return;
+}
+
+void
+mergeQuantileSketch(QuantileSketch *  sketch, const QuantileSketch *  other)
+{
+	if (other->count == 0)
+	{
+		return;
+	}
+
+	sketch->sum += other->sum;
+	sketch->minimum = (other->minimum < sketch->minimum) ? other->minimum : sketch->minimum;
+	sketch->maximum = (other->maximum > sketch->maximum) ? other->maximum : sketch->maximum;
+	for (size_t i = 0; i < other->numberOfCentroids; i++)
+	{
+		addCentroid(sketch, other->centroids[i]);
+	}
+
+	/*
+	 *	The count is only updated now, as a compression during the merge must
+	 *	size the centroids by the weight that it merges, without that of the
+	 *	centroids not added yet.
+	 */
+	sketch->count += other->count;
+
+	return;
+}
+
+double
+estimateQuantileSketchQuantile(QuantileSketch *  sketch, double probability)
+{
+	const QuantileSketchCentroid *	centroids;
+	double				target = probability * sketch->count;
+	double				previousWeight = 0.0;
+	double				previousMean = sketch->minimum;
+
+	compressQuantileSketch(sketch);
+	centroids = sketch->centroids;
+
+	/*
+	 *	The quantile function is linear between the minimum at weight 0, the
+	 *	mean of each centroid at the middle of its weight, and the maximum at
+	 *	the count.
+	 */
+	for (size_t i = 0; i < sketch->numberOfCentroids; i++)
+	{
+		double	weight = previousWeight + ((i == 0) ? centroids[i].weight / 2.0 : (centroids[i - 1].weight + centroids[i].weight) / 2.0);
+
+		if (target < weight)
+		{
+			return previousMean + (centroids[i].mean - previousMean) * (target - previousWeight) / (weight - previousWeight);
+		}
+
+		previousWeight = weight;
+		previousMean = centroids[i].mean;
+	}
+
+	if (target >= sketch->count)
+	{
+		return sketch->maximum;
+	}
+
+	return previousMean + (sketch->maximum - previousMean) * (target - previousWeight) / (sketch->count - previousWeight);
+}
+
+double
+estimateQuantileSketchCumulativeProbability(QuantileSketch *  sketch, double value)
+{
+	const QuantileSketchCentroid *	centroids;
+	double				previousWeight = 0.0;
+	double				previousMean = sketch->minimum;
+
+	if (value < sketch->minimum)
+	{
+		return 0.0;
+	}
+
+	if (value >= sketch->maximum)
+	{
+		return 1.0;
+	}
+
+	compressQuantileSketch(sketch);
+	centroids = sketch->centroids;
+
+	/*
+	 *	The inverse of the quantile function of `estimateQuantileSketchQuantile()`.
+	 */
+	for (size_t i = 0; i < sketch->numberOfCentroids; i++)
+	{
+		double	weight = previousWeight + ((i == 0) ? centroids[i].weight / 2.0 : (centroids[i - 1].weight + centroids[i].weight) / 2.0);
+
+		if (value < centroids[i].mean)
+		{
+			return (previousWeight + (weight - previousWeight) * (value - previousMean) / (centroids[i].mean - previousMean)) / sketch->count;
+		}
+
+		previousWeight = weight;
+		previousMean = centroids[i].mean;
+	}
+
+	return (previousWeight + (sketch->count - previousWeight) * (value - previousMean) / (sketch->maximum - previousMean)) / sketch->count;
+}
+
+CommonConstantReturnType
+writeQuantileSketch(QuantileSketch *  sketch, const char *  path)
+{
+	double		header[] = {0.0, 0.0, 0.0, 0.0, 0.0};
+	uint64_t	numberOfCentroids;
+	FILE *		file;
+	bool		isWritten;
+
+	compressQuantileSketch(sketch);
+	header[0] = sketch->compression;
+	header[1] = sketch->count;
+	header[2] = sketch->sum;
+	header[3] = sketch->minimum;
+	header[4] = sketch->maximum;
+	numberOfCentroids = sketch->numberOfCentroids;
+
+	file = fopen(path, "wb");
+	if (file == NULL)
+	{
+		fprintf(stderr, "Error: Could not open the sketch file \"%s\": %s.\n", path, strerror(errno));
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	isWritten = (fwrite(kQuantileSketchBinaryMagic, sizeof(kQuantileSketchBinaryMagic) - 1, 1, file) == 1) &&
+			(fwrite(header, sizeof(header), 1, file) == 1) &&
+			(fwrite(&numberOfCentroids, sizeof(numberOfCentroids), 1, file) == 1) &&
+			(fwrite(sketch->centroids, sizeof(QuantileSketchCentroid), sketch->numberOfCentroids, file) == sketch->numberOfCentroids);
+	isWritten = (fclose(file) == 0) && isWritten;
+	if (!isWritten)
+	{
+		fprintf(stderr, "Error: Could not write the sketch file \"%s\".\n", path);
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+/**
+ *	@brief	Check that the centroids of a read sketch are sorted, within its minimum
+ *		and maximum, and weigh its count in total.
+ *
+ *	@param	sketch	: The sketch.
+ *	@return		: `true` if the sketch is valid, else `false`.
+ */
+static bool
+isQuantileSketchValid(const QuantileSketch *  sketch)
+{
+	double	totalWeight = 0.0;
+
+	if (!isfinite(sketch->count) || (sketch->count < 0) || !isfinite(sketch->sum) ||
+		((sketch->count > 0) && !(sketch->minimum <= sketch->maximum)) ||
+		((sketch->count > 0) == (sketch->numberOfCentroids == 0)))
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < sketch->numberOfCentroids; i++)
+	{
+		const QuantileSketchCentroid *	centroid = &sketch->centroids[i];
+
+		if (!(centroid->weight > 0) || !(centroid->mean >= sketch->minimum) || !(centroid->mean <= sketch->maximum) ||
+			((i > 0) && (centroid->mean < sketch->centroids[i - 1].mean)))
+		{
+			return false;
+		}
+
+		totalWeight += centroid->weight;
+	}
+
+	return fabs(totalWeight - sketch->count) <= 1e-9 * sketch->count;
+}
+
+QuantileSketch *
+readQuantileSketch(const char *  path)
+{
+	char			magic[sizeof(kQuantileSketchBinaryMagic) - 1];
+	double			header[5];
+	uint64_t		numberOfCentroids;
+	QuantileSketch *	sketch = NULL;
+	FILE *			file;
+
+	file = fopen(path, "rb");
+	if (file == NULL)
+	{
+		fprintf(stderr, "Error: Could not open the sketch file \"%s\": %s.\n", path, strerror(errno));
+
+		return NULL;
+	}
+
+	if ((fread(magic, sizeof(magic), 1, file) != 1) || (memcmp(magic, kQuantileSketchBinaryMagic, sizeof(magic)) != 0) ||
+		(fread(header, sizeof(header), 1, file) != 1) ||
+		(fread(&numberOfCentroids, sizeof(numberOfCentroids), 1, file) != 1))
+	{
+		fprintf(stderr, "Error: The file \"%s\" is not a sketch file.\n", path);
+		fclose(file);
+
+		return NULL;
+	}
+
+	sketch = createQuantileSketch(header[0]);
+	if (sketch == NULL)
+	{
+		fclose(file);
+
+		return NULL;
+	}
+
+	if ((numberOfCentroids > sketch->centroidsCapacity) ||
+		(fread(sketch->centroids, sizeof(QuantileSketchCentroid), (size_t) numberOfCentroids, file) != (size_t) numberOfCentroids))
+	{
+		fprintf(stderr, "Error: Could not read the centroids of the sketch file \"%s\".\n", path);
+		destroyQuantileSketch(sketch);
+		fclose(file);
+
+		return NULL;
+	}
+	fclose(file);
+
+	sketch->count = header[1];
+	sketch->sum = header[2];
+	sketch->minimum = (header[1] > 0) ? header[3] : INFINITY;
+	sketch->maximum = (header[1] > 0) ? header[4] : -INFINITY;
+	sketch->numberOfCentroids = (size_t) numberOfCentroids;
+	sketch->numberOfMergedCentroids = (size_t) numberOfCentroids;
+	if (!isQuantileSketchValid(sketch))
+	{
+		fprintf(stderr, "Error: The sketch file \"%s\" is invalid.\n", path);
+		destroyQuantileSketch(sketch);
+
+		return NULL;
+	}
+
+	return sketch;
+}
+
+bool
+isQuantileSketchFile(const char *  path)
+{
+	char	magic[sizeof(kQuantileSketchBinaryMagic) - 1];
+	FILE *	file = fopen(path, "rb");
+	bool	isSketch;
+
+	if (file == NULL)
+	{
+		return false;
+	}
+
+	isSketch = (fread(magic, sizeof(magic), 1, file) == 1) && (memcmp(magic, kQuantileSketchBinaryMagic, sizeof(magic)) == 0);
+	fclose(file);
+
+	return isSketch;
+}
+
+void
+destroyQuantileSketch(QuantileSketch *  sketch)
+{
+	if (sketch == NULL)
+	{
+		return;
+	}
+
+	free(sketch->centroids);
+	free(sketch);
+
+	return;
+}
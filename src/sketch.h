@@ -0,0 +1,175 @@
+/*
+ *	Copyright (c) 2024, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "common.h"
+
+
+/*
+ *	Mergeable quantile sketch of a sample (a merging t-digest), for quantiles
+ *	of simulations whose samples are not kept, e.g., because they are split
+ *	between threads, processes or hosts.
+ *
+ *	The sketch summarizes the sample by centroids, each the mean and the
+ *	number (weight) of a run of consecutive sorted values. Added values are
+ *	buffered, and the buffer is sorted and merged into the centroids when it
+ *	is full. Neighbouring centroids are merged while they span at most 1 of
+ *	the scale function
+ *
+ *		k(q) = compression / (2 pi) * asin(2 q - 1)
+ *
+ *	of the cumulative probability `q`, so that a centroid at probability `q`
+ *	holds at most about `2 pi sqrt(q (1 - q)) / compression` of the sample:
+ *	centroids are small in the tails, where the quantiles of the portfolio
+ *	return matter most, and there are at most about `compression` of them.
+ *	Quantiles interpolate linearly between the centroid means, so their
+ *	error in probability is at most about half the weight of a centroid,
+ *	e.g., 0.0006 at the 0.01 and 0.99 quantiles with the default compression.
+ *	Merging two sketches merges their centroids under the same bound, so
+ *	sketches of parts of a sample merge to a sketch of the whole sample with
+ *	the same order of error. The count, sum, minimum and maximum are exact.
+ *
+ *	A sketch file is `kQuantileSketchBinaryMagic`, the compression, count,
+ *	sum, minimum and maximum as `double`, the number of centroids as a
+ *	`uint64_t`, and the mean and weight of each centroid as `double`, in
+ *	increasing order of mean, all in the byte order of the host.
+ */
+
+typedef enum
+{
+	kQuantileSketchConstantDefaultCompression	= 500,
+	kQuantileSketchConstantMinimumCompression	= 10,
+	kQuantileSketchConstantMaximumCompression	= 100000,
+
+	/*
+	 *	Size of the buffer of added values, in multiples of the compression.
+	 */
+	kQuantileSketchConstantBufferFactor		= 8,
+} QuantileSketchConstant;
+
+#define kQuantileSketchBinaryMagic	"MFTDIG01"
+
+typedef struct
+{
+	double	mean;
+	double	weight;
+} QuantileSketchCentroid;
+
+typedef struct
+{
+	double				compression;
+	double				count;
+	double				sum;
+	double				minimum;
+	double				maximum;
+
+	/*
+	 *	The first `numberOfMergedCentroids` centroids are merged and sorted,
+	 *	and are followed by the buffered, unmerged ones.
+	 */
+	QuantileSketchCentroid *	centroids;
+	size_t				numberOfCentroids;
+	size_t				numberOfMergedCentroids;
+	size_t				centroidsCapacity;
+} QuantileSketch;
+
+/**
+ *	@brief	Create an empty sketch.
+ *
+ *	@param	compression	: The compression, in [kQuantileSketchConstantMinimumCompression, kQuantileSketchConstantMaximumCompression].
+ *	@return			: The new sketch, or `NULL` if the compression is invalid or allocation failed.
+ */
+QuantileSketch *		createQuantileSketch(double compression);
+
+/**
+ *	@brief	Add values to a sketch.
+ *
+ *	@param	sketch	: The sketch.
+ *	@param	values	: The `count` values, finite.
+ *	@param	count	: Number of values.
+ */
+void				addQuantileSketchValues(QuantileSketch *  sketch, const double *  values, size_t count);
+
+/**
+ *	@brief	Merge a sketch into another, e.g., the sketch of a worker into that of
+ *		the whole simulation. The merged sketch keeps its compression.
+ *
+ *	@param	sketch	: The sketch to merge into.
+ *	@param	other	: The sketch to merge, unchanged.
+ */
+void				mergeQuantileSketch(QuantileSketch *  sketch, const QuantileSketch *  other);
+
+/**
+ *	@brief	Estimate a quantile of the sample of a sketch.
+ *
+ *	@param	sketch		: The sketch, not empty.
+ *	@param	probability	: Probability of the quantile, in [0, 1].
+ *	@return			: The estimated quantile.
+ */
+double				estimateQuantileSketchQuantile(QuantileSketch *  sketch, double probability);
+
+/**
+ *	@brief	Estimate the fraction of the sample of a sketch that is at most a
+ *		value, e.g., the probability of loss of the portfolio return.
+ *
+ *	@param	sketch	: The sketch, not empty.
+ *	@param	value	: The value.
+ *	@return		: The estimated cumulative probability.
+ */
+double				estimateQuantileSketchCumulativeProbability(QuantileSketch *  sketch, double value);
+
+/**
+ *	@brief	Write a sketch to a sketch file.
+ *
+ *	@param	sketch	: The sketch.
+ *	@param	path	: Path of the sketch file.
+ *	@return		: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+CommonConstantReturnType	writeQuantileSketch(QuantileSketch *  sketch, const char *  path);
+
+/**
+ *	@brief	Read a sketch file.
+ *
+ *	@param	path	: Path of the sketch file.
+ *	@return		: The sketch, or `NULL` if the file could not be read or is invalid.
+ */
+QuantileSketch *		readQuantileSketch(const char *  path);
+
+/**
+ *	@brief	Check whether a file starts with `kQuantileSketchBinaryMagic`.
+ *
+ *	@param	path	: Path of the file.
+ *	@return		: `true` if the file is a sketch file, else `false`, also if it cannot be read.
+ */
+bool				isQuantileSketchFile(const char *  path);
+
+/**
+ *	@brief	Free a sketch.
+ *
+ *	@param	sketch	: The sketch. May be `NULL`.
+ */
+void				destroyQuantileSketch(QuantileSketch *  sketch);
@@ -0,0 +1,248 @@
+/*
+ *	Copyright (c) 2024, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+#include "sweep.h"
+
+
+/*
+ *	Task of a sweep: `numberOfIterations` iterations of a point from
+ *	`firstIteration`, relative to the first iteration of the parameters.
+ */
+typedef struct
+{
+	size_t	point;
+	size_t	firstIteration;
+	size_t	numberOfIterations;
+} SweepTask;
+
+typedef struct
+{
+	const MoonfireParameters *	parameters;
+	const size_t *			sizes;
+	SweepTask *			tasks;
+	double **			samples;
+	MoonfireContext **		contexts;
+	MoonfireStatistics *		statistics;
+} Sweep;
+
+/**
+ *	@brief	Simulate the iterations of a task with the context of its thread,
+ *		and store their samples.
+ *
+ *	@param	state	: The `Sweep`.
+ *	@param	thread	: Index of the thread.
+ *	@param	task	: Index of the task.
+ *	@return		: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+runSweepTask(void *  state, size_t thread, size_t task)
+{
+	Sweep *			sweep = state;
+	const SweepTask *	sweepTask = &sweep->tasks[task];
+	MoonfireParameters	parameters = *sweep->parameters;
+	const double *		samples;
+	size_t			numberOfSamples;
+
+	parameters.numberOfInvestments = sweep->sizes[sweepTask->point];
+	parameters.firstIteration += sweepTask->firstIteration;
+	parameters.numberOfIterations = sweepTask->numberOfIterations;
+
+	/*
+	 *	Each thread reuses its context, which only grows for tasks of more
+	 *	draws than before.
+	 */
+	if (sweep->contexts[thread] == NULL)
+	{
+		sweep->contexts[thread] = moonfireCreateContext(&parameters);
+		if (sweep->contexts[thread] == NULL)
+		{
+			return kCommonConstantReturnTypeError;
+		}
+	}
+	else if (moonfireSetParameters(sweep->contexts[thread], &parameters) != kCommonConstantReturnTypeSuccess)
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	if (moonfireSimulate(sweep->contexts[thread]) != kCommonConstantReturnTypeSuccess)
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	samples = moonfireGetSamples(sweep->contexts[thread], &numberOfSamples);
+	memcpy(sweep->samples[sweepTask->point] + sweepTask->firstIteration, samples, numberOfSamples * sizeof(double));
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+/**
+ *	@brief	Compute the statistics of the samples of a point.
+ *
+ *	@param	state	: The `Sweep`.
+ *	@param	thread	: Index of the thread.
+ *	@param	task	: Index of the point.
+ *	@return		: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+runSweepStatisticsTask(void *  state, size_t thread, size_t task)
+{
+	Sweep *	sweep = state;
+
+	(void) thread;
+
+	return moonfireCalculateSampleStatistics(
+			sweep->samples[task],
+			sweep->parameters->numberOfIterations,
+			sweep->parameters->lowQuantileProbability,
+			sweep->parameters->highQuantileProbability,
+			&sweep->statistics[task]);
+}
+
+/**
+ *	@brief	Number of iterations of the tasks of a point: at least one, and at
+ *		most `kSweepConstantTaskDraws` investment draws.
+ *
+ *	@param	numberOfInvestments	: Portfolio size of the point.
+ *	@return				: The number of iterations.
+ */
+static size_t
+getIterationsPerTask(size_t numberOfInvestments)
+{
+	return (numberOfInvestments < kSweepConstantTaskDraws) ? kSweepConstantTaskDraws / numberOfInvestments : 1;
+}
+
+CommonConstantReturnType
+simulateSweep(
+	const MoonfireParameters *	parameters,
+	const size_t *			sizes,
+	size_t				numberOfSizes,
+	size_t				numberOfThreads,
+	MoonfireStatistics *		statistics,
+	SchedulerReport *		report)
+{
+	Sweep				sweep = {
+						.parameters	= parameters,
+						.sizes		= sizes,
+						.statistics	= statistics,
+					};
+	size_t				order[kMoonfireConstantMaximumPortfolioSizes];
+	size_t				numberOfTasks = 0;
+	Arena *				arena;
+	CommonConstantReturnType	result = kCommonConstantReturnTypeSuccess;
+
+	if ((numberOfSizes < 1) || (numberOfSizes > kMoonfireConstantMaximumPortfolioSizes) || (numberOfThreads < 1) ||
+		(parameters->engine != kMoonfireEngineKernels) || (parameters->portfolio != NULL) || (parameters->fundLifeYears > 0) ||
+		(parameters->waterfall != kMoonfireWaterfallNone) || (parameters->numberOfReserveStrategies > 0) || (parameters->parameterDraws != NULL))
+	{
+		fprintf(
+			stderr,
+			"Error: A sweep needs 1 to %d portfolio sizes, at least one thread, the kernels engine, a homogeneous portfolio, "
+			"and no fund timeline, waterfall, reserve strategies or parameter uncertainty.\n",
+			(int) kMoonfireConstantMaximumPortfolioSizes);
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	/*
+	 *	Order the points by decreasing size, so that the scheduler deals the
+	 *	tasks of the largest points first.
+	 */
+	for (size_t p = 0; p < numberOfSizes; p++)
+	{
+		size_t	k = p;
+
+		if (sizes[p] < 1)
+		{
+			fprintf(stderr, "Error: The portfolio sizes of a sweep must be at least 1.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		for (; (k > 0) && (sizes[order[k - 1]] < sizes[p]); k--)
+		{
+			order[k] = order[k - 1];
+		}
+		order[k] = p;
+		numberOfTasks += (parameters->numberOfIterations + getIterationsPerTask(sizes[p]) - 1) / getIterationsPerTask(sizes[p]);
+	}
+
+	/*
+	 *	All buffers of the sweep come from one arena. The samples of the
+	 *	points are its bulk, and are first written by the tasks.
+	 */
+	arena = createArena(
+			getArenaAllocationSize(numberOfTasks * sizeof(SweepTask)) +
+			getArenaAllocationSize(numberOfSizes * sizeof(double *)) +
+			getArenaAllocationSize(numberOfThreads * sizeof(MoonfireContext *)) +
+			numberOfSizes * getArenaAllocationSize(parameters->numberOfIterations * sizeof(double)));
+	if (arena == NULL)
+	{
+		fprintf(stderr, "Error: Could not allocate the sweep.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	sweep.tasks = allocateFromArena(arena, numberOfTasks * sizeof(SweepTask));
+	sweep.samples = allocateFromArena(arena, numberOfSizes * sizeof(double *));
+	sweep.contexts = allocateFromArena(arena, numberOfThreads * sizeof(MoonfireContext *));
+	for (size_t t = 0; t < numberOfThreads; t++)
+	{
+		sweep.contexts[t] = NULL;
+	}
+
+	numberOfTasks = 0;
+	for (size_t i = 0; i < numberOfSizes; i++)
+	{
+		size_t	p = order[i];
+		size_t	iterationsPerTask = getIterationsPerTask(sizes[p]);
+
+		sweep.samples[p] = allocateFromArena(arena, parameters->numberOfIterations * sizeof(double));
+
+		for (size_t first = 0; first < parameters->numberOfIterations; first += iterationsPerTask)
+		{
+			sweep.tasks[numberOfTasks++] = (SweepTask) {
+				.point			= p,
+				.firstIteration		= first,
+				.numberOfIterations	= (parameters->numberOfIterations - first < iterationsPerTask) ?
+								parameters->numberOfIterations - first : iterationsPerTask,
+			};
+		}
+	}
+
+	if ((runWorkStealingTasks(numberOfThreads, numberOfTasks, runSweepTask, &sweep, report) != kCommonConstantReturnTypeSuccess) ||
+		(runWorkStealingTasks(numberOfThreads, numberOfSizes, runSweepStatisticsTask, &sweep, NULL) != kCommonConstantReturnTypeSuccess))
+	{
+		result = kCommonConstantReturnTypeError;
+	}
+
+	for (size_t t = 0; t < numberOfThreads; t++)
+	{
+		moonfireDestroyContext(sweep.contexts[t]);
+	}
+	destroyArena(arena);
+
+	return result;
+}
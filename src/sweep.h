@@ -0,0 +1,67 @@
+/*
+ *	Copyright (c) 2024, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#pragma once
+#include <stddef.h>
+#include "common.h"
+#include "moonfire.h"
+#include "scheduler.h"
+
+
+/*
+ *	Sweep over portfolio sizes (`-n` with several sizes).
+ *
+ *	Unlike the optimizer (see `optimizer.h`), each point of the sweep is an
+ *	independent simulation: the samples of the point of size `n` are those
+ *	of a single simulation with `n` investments and the same seed. The cost
+ *	of a point grows with its size, so the iterations of each point are split
+ *	into tasks of about `kSweepConstantTaskDraws` investment draws, i.e., into
+ *	fewer, longer tasks for small portfolios, which the work-stealing
+ *	scheduler of `scheduler.h` runs on all threads, largest points first.
+ *	Each task writes the samples of its iterations to their place in the
+ *	samples of its point, and the statistics of each point are computed once
+ *	all of its samples are simulated.
+ */
+
+typedef enum
+{
+	kSweepConstantTaskDraws		= 1 << 22,
+} SweepConstant;
+
+/**
+ *	@brief	Simulate a sweep over portfolio sizes.
+ *
+ *	@param	parameters	: The model parameters of a homogeneous portfolio, with the kernels engine. Their `numberOfInvestments` is ignored.
+ *	@param	sizes		: The portfolio sizes of the sweep, each at least 1.
+ *	@param	numberOfSizes	: Number of portfolio sizes, in [1, kMoonfireConstantMaximumPortfolioSizes].
+ *	@param	numberOfThreads	: Number of threads.
+ *	@param	statistics	: Array to store the statistics of the portfolio return of each size.
+ *	@param	report		: Pointer to struct to store the tasks of the scheduler, or `NULL`.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+CommonConstantReturnType	simulateSweep(
+					const MoonfireParameters *	parameters,
+					const size_t *			sizes,
+					size_t				numberOfSizes,
+					size_t				numberOfThreads,
+					MoonfireStatistics *		statistics,
+					SchedulerReport *		report);
@@ -0,0 +1,106 @@
+/*
+ *	Copyright (c) 2024, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#include "timeline.h"
+
+
+size_t
+timelineBatchIterations(size_t numberOfInvestments)
+{
+	size_t	numberOfIterations = kTimelineConstantBatchElements / numberOfInvestments;
+
+	return (numberOfIterations > 0) ? numberOfIterations : 1;
+}
+
+void
+computeTimelineEntryYears(const MoonfireParameters *  parameters, double *  entryYears)
+{
+	for (size_t i = 0; i < parameters->numberOfInvestments; i++)
+	{
+		entryYears[i] = (double)((i * parameters->deploymentYears) / parameters->numberOfInvestments);
+	}
+
+	return;
+}
+
+void
+simulateTimelineBatch(
+	const SamplingKernels *		kernels,
+	const TimelineSchedule *	schedule,
+	const double *			values,
+	size_t				numberOfIterations,
+	uint64_t			key,
+	uint64_t			counter,
+	size_t				firstIteration,
+	double *			exitYears,
+	size_t				stride,
+	double *			distributedToPaidIn,
+	double *			totalValueToPaidIn,
+	double *			netCashFlow)
+{
+	size_t		n = schedule->numberOfInvestments;
+	const double *	entryYears = schedule->entryYears;
+	const double *	capital = schedule->capital;
+	double		commitment = kernels->sum(capital, n);
+
+	/*
+	 *	Holding periods are uniform in [minimumHoldingYears,
+	 *	minimumHoldingYears + numberOfHoldingYears - 1] whole years, and
+	 *	independent of the investment returns.
+	 */
+	kernels->sampleUniforms(exitYears, numberOfIterations * n, key, counter);
+	for (size_t b = 0; b < numberOfIterations; b++)
+	{
+		double *	exitRow = exitYears + b * n;
+
+		for (size_t i = 0; i < n; i++)
+		{
+			exitRow[i] = entryYears[i] + (double) schedule->minimumHoldingYears +
+					(double)(int32_t)(exitRow[i] * (double) schedule->numberOfHoldingYears);
+		}
+	}
+
+	for (size_t year = 0; year < schedule->fundLifeYears; year++)
+	{
+		FundYearConstants	constants =
+		{
+			.year			= (double) year,
+			.followOnDelayYears	= schedule->followOnDelayYears,
+			.fundLifeYears		= (double) schedule->fundLifeYears,
+			.followOnFraction	= schedule->followOnFraction,
+		};
+
+		for (size_t b = 0; b < numberOfIterations; b++)
+		{
+			size_t		output = year * stride + firstIteration + b;
+			FundYearSums	sums;
+
+			kernels->sumFundYear(&sums, entryYears, exitYears + b * n, capital, values + b * n, n, &constants);
+
+			distributedToPaidIn[output] = (sums.paidIn > 0) ? sums.distributed / sums.paidIn : 0.0;
+			totalValueToPaidIn[output] = (sums.paidIn > 0) ? (sums.distributed + sums.netAssetValue) / sums.paidIn : 1.0;
+			netCashFlow[output] = (sums.distributed - sums.paidIn) / commitment;
+		}
+	}
+
+	return;
+}
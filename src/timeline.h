@@ -0,0 +1,110 @@
+/*
+ *	Copyright (c) 2024, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "kernels.h"
+#include "moonfire.h"
+
+
+/*
+ *	Fund timeline simulation (see `MoonfireTimelineYear`).
+ *
+ *	The state of a batch of iterations is laid out as (iteration x investment)
+ *	arrays, row `b` holding the investments of iteration `b` of the batch, so
+ *	that each year of the fund life is one contiguous, vectorizable pass over
+ *	the batch.
+ */
+
+typedef enum
+{
+	/*
+	 *	Target number of (iteration, investment) elements of a batch, so that
+	 *	the arrays of a batch stay in cache across the passes of all years.
+	 */
+	kTimelineConstantBatchElements	= 32768,
+} TimelineConstant;
+
+typedef struct
+{
+	size_t		numberOfInvestments;
+	size_t		fundLifeYears;
+	double		followOnFraction;
+	double		followOnDelayYears;
+	size_t		minimumHoldingYears;
+	size_t		numberOfHoldingYears;
+
+	/*
+	 *	Year of the initial investment and committed capital of each investment.
+	 */
+	const double *	entryYears;
+	const double *	capital;
+} TimelineSchedule;
+
+/**
+ *	@brief	Number of iterations of a timeline batch for a portfolio size.
+ *
+ *	@param	numberOfInvestments	: Number of investments.
+ *	@return				: The number of iterations, at least 1.
+ */
+size_t		timelineBatchIterations(size_t numberOfInvestments);
+
+/**
+ *	@brief	Stage the initial investments evenly over the deployment period, in
+ *		portfolio order.
+ *
+ *	@param	parameters	: The model parameters, with a fund timeline.
+ *	@param	entryYears	: Array to store the `numberOfInvestments` entry years.
+ */
+void		computeTimelineEntryYears(const MoonfireParameters *  parameters, double *  entryYears);
+
+/**
+ *	@brief	Simulate the fund timeline of a batch of iterations, and store the
+ *		DPI, TVPI and net cash flow of each iteration and year.
+ *
+ *	@param	kernels			: The sampling kernels.
+ *	@param	schedule		: The timeline schedule.
+ *	@param	values			: The `numberOfIterations` x `numberOfInvestments` exit values at full investment, i.e., the investment returns of `loadInvestmentReturnSamples()` in units of the total investment.
+ *	@param	numberOfIterations	: Number of iterations of the batch.
+ *	@param	key			: Key of the exit timing stream (see `deriveStreamKey()`).
+ *	@param	counter			: Index of the first uniform of the batch in the exit timing stream, `numberOfInvestments` per iteration.
+ *	@param	firstIteration		: Index of the first iteration of the batch in the outputs.
+ *	@param	exitYears		: Scratch array of `numberOfIterations` x `numberOfInvestments` elements.
+ *	@param	stride			: Total number of iterations, the stride between years of the outputs.
+ *	@param	distributedToPaidIn	: Array to store DPI, at `year * stride + iteration`.
+ *	@param	totalValueToPaidIn	: Array to store TVPI, at `year * stride + iteration`.
+ *	@param	netCashFlow		: Array to store the net cash flow, at `year * stride + iteration`.
+ */
+void		simulateTimelineBatch(
+			const SamplingKernels *		kernels,
+			const TimelineSchedule *	schedule,
+			const double *			values,
+			size_t				numberOfIterations,
+			uint64_t			key,
+			uint64_t			counter,
+			size_t				firstIteration,
+			double *			exitYears,
+			size_t				stride,
+			double *			distributedToPaidIn,
+			double *			totalValueToPaidIn,
+			double *			netCashFlow);
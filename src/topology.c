@@ -0,0 +1,249 @@
+/*
+ *	Copyright (c) 2024, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#if defined(MOONFIRE_NATIVE) && defined(__linux__)
+#define _GNU_SOURCE
+#include <sched.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#if defined(MOONFIRE_NATIVE)
+#include <pthread.h>
+#include <unistd.h>
+#endif
+#include "topology.h"
+
+
+#if defined(MOONFIRE_NATIVE) && defined(__linux__)
+#define kTopologyHaveAffinity
+#endif
+
+static bool	isPinningEnabled = false;
+
+#if defined(kTopologyHaveAffinity)
+/**
+ *	@brief	Read the CPU list of a NUMA node from sysfs, e.g., `0-15,32-47`.
+ *
+ *	@param	node	: Index of the node.
+ *	@param	cpus	: Set to store the CPUs of the node.
+ *	@return		: `true` if the node exists, else `false`.
+ */
+static bool
+readNodeCpus(size_t node, cpu_set_t *  cpus)
+{
+	char	path[64];
+	FILE *	file;
+	int	first;
+	int	last;
+	int	separator = ',';
+
+	snprintf(path, sizeof(path), "/sys/devices/system/node/node%zu/cpulist", node);
+	file = fopen(path, "r");
+	if (file == NULL)
+	{
+		return false;
+	}
+
+	CPU_ZERO(cpus);
+	while ((separator == ',') && (fscanf(file, "%d", &first) == 1))
+	{
+		last = first;
+		separator = fgetc(file);
+		if ((separator == '-') && (fscanf(file, "%d", &last) == 1))
+		{
+			separator = fgetc(file);
+		}
+
+		for (int cpu = first; (cpu <= last) && (cpu < CPU_SETSIZE); cpu++)
+		{
+			CPU_SET(cpu, cpus);
+		}
+	}
+	fclose(file);
+
+	return true;
+}
+
+/**
+ *	@brief	Read the topology of the CPUs in the affinity mask of the process.
+ *
+ *	@param	topology	: Pointer to struct to store the topology.
+ *	@return			: `true` if successful, else `false`.
+ */
+static bool
+readThreadTopology(ThreadTopology *  topology)
+{
+	cpu_set_t	allowedCpus;
+	cpu_set_t	nodeCpus[kTopologyConstantMaximumNodes];
+	size_t		nextCpuOfNode[kTopologyConstantMaximumNodes] = {0};
+	size_t		numberOfNodes = 0;
+	size_t		numberOfAllowedCpus = 0;
+
+	if (sched_getaffinity(0, sizeof(allowedCpus), &allowedCpus) != 0)
+	{
+		return false;
+	}
+
+	/*
+	 *	Keep the nodes with allowed CPUs. Without sysfs, e.g., in some
+	 *	containers, all allowed CPUs are one node.
+	 */
+	for (size_t node = 0; node < kTopologyConstantMaximumNodes; node++)
+	{
+		if (readNodeCpus(node, &nodeCpus[numberOfNodes]))
+		{
+			CPU_AND(&nodeCpus[numberOfNodes], &nodeCpus[numberOfNodes], &allowedCpus);
+			numberOfNodes += (CPU_COUNT(&nodeCpus[numberOfNodes]) > 0);
+		}
+	}
+	if (numberOfNodes == 0)
+	{
+		CPU_ZERO(&nodeCpus[0]);
+		CPU_OR(&nodeCpus[0], &nodeCpus[0], &allowedCpus);
+		numberOfNodes = 1;
+	}
+
+	for (size_t node = 0; node < numberOfNodes; node++)
+	{
+		numberOfAllowedCpus += (size_t) CPU_COUNT(&nodeCpus[node]);
+	}
+	numberOfAllowedCpus = (numberOfAllowedCpus < kTopologyConstantMaximumCpus) ? numberOfAllowedCpus : kTopologyConstantMaximumCpus;
+
+	/*
+	 *	Take the next CPU of each node in turn.
+	 */
+	topology->numberOfNodes = numberOfNodes;
+	topology->numberOfCpus = 0;
+	while (topology->numberOfCpus < numberOfAllowedCpus)
+	{
+		for (size_t node = 0; (node < numberOfNodes) && (topology->numberOfCpus < numberOfAllowedCpus); node++)
+		{
+			while ((nextCpuOfNode[node] < CPU_SETSIZE) && !CPU_ISSET(nextCpuOfNode[node], &nodeCpus[node]))
+			{
+				nextCpuOfNode[node]++;
+			}
+
+			if (nextCpuOfNode[node] < CPU_SETSIZE)
+			{
+				topology->cpus[topology->numberOfCpus] = (int) nextCpuOfNode[node]++;
+				topology->nodes[topology->numberOfCpus] = node;
+				topology->numberOfCpus++;
+			}
+		}
+	}
+
+	return true;
+}
+#endif
+
+static ThreadTopology	hostTopology;
+
+/**
+ *	@brief	Read the topology of the host, or fall back to one node of the
+ *		online processors.
+ */
+static void
+initializeThreadTopology(void)
+{
+#if defined(kTopologyHaveAffinity)
+	if (!readThreadTopology(&hostTopology))
+#endif
+	{
+		size_t	numberOfCpus = 1;
+
+#if defined(MOONFIRE_NATIVE)
+		long	numberOfProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+
+		numberOfCpus = (numberOfProcessors > 0) ? (size_t) numberOfProcessors : 1;
+#endif
+		hostTopology.numberOfNodes = 1;
+		hostTopology.numberOfCpus = (numberOfCpus < kTopologyConstantMaximumCpus) ? numberOfCpus : kTopologyConstantMaximumCpus;
+		for (size_t i = 0; i < hostTopology.numberOfCpus; i++)
+		{
+			hostTopology.cpus[i] = (int) i;
+			hostTopology.nodes[i] = 0;
+		}
+	}
+
+	return;
+}
+
+const ThreadTopology *
+getThreadTopology(void)
+{
+#if defined(MOONFIRE_NATIVE)
+	static pthread_once_t	readOnce = PTHREAD_ONCE_INIT;
+
+	pthread_once(&readOnce, initializeThreadTopology);
+#else
+	static bool		isTopologyRead = false;
+
+	if (!isTopologyRead)
+	{
+		initializeThreadTopology();
+		isTopologyRead = true;
+	}
+#endif
+
+	return &hostTopology;
+}
+
+void
+setThreadPinning(bool isEnabled)
+{
+	isPinningEnabled = isEnabled;
+
+	return;
+}
+
+bool
+isThreadPinningEnabled(void)
+{
+	return isPinningEnabled;
+}
+
+void
+pinWorkerThread(size_t thread)
+{
+#if defined(kTopologyHaveAffinity)
+	const ThreadTopology *	topology;
+	cpu_set_t		cpus;
+
+	if (!isPinningEnabled)
+	{
+		return;
+	}
+
+	topology = getThreadTopology();
+	CPU_ZERO(&cpus);
+	CPU_SET(topology->cpus[thread % topology->numberOfCpus], &cpus);
+
+	/*
+	 *	A failure leaves the thread unpinned, which only costs locality.
+	 */
+	(void) pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+#else
+	(void) thread;
+#endif
+
+	return;
+}
@@ -0,0 +1,93 @@
+/*
+ *	Copyright (c) 2024, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#pragma once
+#include <stddef.h>
+#include <stdbool.h>
+
+
+/*
+ *	CPU and NUMA topology of the host, and pinning of worker threads.
+ *
+ *	The topology lists the CPUs that the process may run on (its affinity
+ *	mask, e.g., as restricted by `taskset` or a batch scheduler) with the
+ *	NUMA node of each, from `/sys/devices/system/node`. The CPUs are listed
+ *	in pinning order, taking one CPU of each node in turn, so that worker
+ *	threads `0 .. numberOfCpus - 1` spread evenly over the nodes and, within
+ *	a node, fill the CPUs in the order of the kernel, physical cores first on
+ *	common hosts.
+ *
+ *	Pinning matters for memory placement: Linux places a page on the node of
+ *	the thread that first writes it, so the buffers that a worker allocates
+ *	and writes (its `MoonfireContext`, or the slices of the samples it
+ *	simulates) are local to it, but only while the worker stays on that node.
+ *	Pinned workers do not migrate away from their memory.
+ *
+ *	Without `MOONFIRE_NATIVE` or off Linux, the topology is one node of the
+ *	online CPUs and pinning does nothing.
+ */
+
+typedef enum
+{
+	kTopologyConstantMaximumCpus	= 1024,
+	kTopologyConstantMaximumNodes	= 64,
+} TopologyConstant;
+
+typedef struct
+{
+	size_t	numberOfCpus;
+	size_t	numberOfNodes;
+	int	cpus[kTopologyConstantMaximumCpus];
+	size_t	nodes[kTopologyConstantMaximumCpus];
+} ThreadTopology;
+
+/**
+ *	@brief	Get the topology of the host, read once on first use.
+ *
+ *	@return	: The topology.
+ */
+const ThreadTopology *	getThreadTopology(void);
+
+/**
+ *	@brief	Enable or disable the pinning of worker threads. Set it before
+ *		starting any workers.
+ *
+ *	@param	isEnabled	: `true` to pin workers to CPUs, else `false`.
+ */
+void			setThreadPinning(bool isEnabled);
+
+/**
+ *	@brief	Whether worker threads are pinned.
+ *
+ *	@return	: `true` if pinning is enabled, else `false`.
+ */
+bool			isThreadPinningEnabled(void);
+
+/**
+ *	@brief	Pin the calling worker thread to the CPU of its index in the
+ *		topology, wrapping around, if pinning is enabled. Workers call it
+ *		before allocating their buffers, so that the buffers are first
+ *		touched on their node.
+ *
+ *	@param	thread	: Index of the worker thread.
+ */
+void			pinWorkerThread(size_t thread);
@@ -30,6 +30,7 @@
 #include <errno.h>
 #include <inttypes.h>
 #include <uxhw.h>
+#include "topology.h"
 #include "utilities.h"
 
 
@@ -38,6 +39,43 @@ const double	kDefaultValuesXMin			= 0.35;
 const double	kDefaultValuesXMax			= 1000.0;
 const double	kDefaultValuesLowQuantileProbability	= 0.01;
 const double	kDefaultValuesHighQuantileProbability	= 0.99;
+const uint64_t	kDefaultValuesSeed			= 0;
+const double	kDefaultValuesMarketCorrelation		= 0.2;
+const double	kDefaultValuesClassCorrelation		= 0.0;
+const double	kDefaultValuesFollowOnFraction		= 0.5;
+const double	kDefaultValuesManagementFeeRate		= 0.02;
+const double	kDefaultValuesCarriedInterest		= 0.2;
+const double	kDefaultValuesHurdleRate		= 0.08;
+const double	kDefaultValuesCatchUp			= 1.0;
+const double	kDefaultValuesFollowOnThreshold		= 2.0;
+const double	kDefaultValuesFollowOnStepUp		= 2.0;
+const double	kDefaultValuesFollowOnSignalNoise	= 1.0;
+const double	kDefaultValuesOptimizerTolerance	= 0.005;
+
+/**
+ *	@brief	Parse an unsigned 64-bit integer.
+ *
+ *	@param	string	: The string to parse.
+ *	@param	value	: Pointer to store the parsed value.
+ *	@return		: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+parseUint64Checked(const char *  string, uint64_t *  value)
+{
+	char *			end;
+	unsigned long long	parsed;
+
+	errno = 0;
+	parsed = strtoull(string, &end, 10);
+	if ((errno != 0) || (end == string) || (*end != '\0') || (strchr(string, '-') != NULL))
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	*value = (uint64_t) parsed;
+
+	return kCommonConstantReturnTypeSuccess;
+}
 
 void
 printUsage(void)
@@ -48,6 +86,8 @@ printUsage(void)
 	fprintf(
 		stderr,
 		"\t[-o, --output <Path to output CSV file : str>] (Specify the output file.)\n"
+		"\t[-i, --input <Path to portfolio file, CSV of alpha,xMin,xMax,weight per investment or binary : str>] (Heterogeneous portfolio.)\n"
+		"\t[-4, --outcomes <Path to outcomes file, CSV of multiple,weight per outcome bucket : str>] (Discrete outcomes instead of -a, -x and -X.)\n"
 		"\t[-S, --select-output <output : int> (Default: 0)] (Compute 0-indexed output.)\n"
 		"\t[-M, --multiple-executions <Number of executions : int> (Default: 1)] (Repeated execute kernel for benchmarking.)\n"
 		"\t[-T, --time] (Timing mode: Times and prints the timing of the kernel execution.)\n"
@@ -57,15 +97,93 @@ printUsage(void)
 		"\t[-a, --alpha-pareto <Portfolio return bounded Pareto distribution parameter 'alpha': double in (0, inf)> (Default: %"SignaloidParticleModifier".2lf)]\n"
 		"\t[-x, --xMin-pareto <Portfolio return bounded Pareto distribution parameter 'xMin': double in (0, xMax]> (Default: %"SignaloidParticleModifier".2lf)]\n"
 		"\t[-X, --xMax-pareto <Portfolio return bounded Pareto distribution parameter 'xMax': double in [xMin, inf)> (Default: %"SignaloidParticleModifier".2lf)]\n"
-		"\t[-n, --number-of-investments <Number of investments in portfolio: size_t in [1, inf)> (Default: %zu)]\n"
+		"\t[-n, --number-of-investments <Number of investments in portfolio: size_t in [1, inf)> (Default: %zu)] (Comma-separated sizes, at most %d, sweep in Monte Carlo mode.)\n"
 		"\t[-q, --low-quantile-probability <Low quantile probability: double in (0, 1)> (Default: %"SignaloidParticleModifier".2lf)]\n"
-		"\t[-Q, --high-quantile-probability <High quantile probability: double in (0, 1)]> (Default: %"SignaloidParticleModifier".2lf)]\n",
+		"\t[-Q, --high-quantile-probability <High quantile probability: double in (0, 1)]> (Default: %"SignaloidParticleModifier".2lf)]\n"
+		"\t[-s, --seed <Seed of the Monte Carlo random stream: uint64_t> (Default: %" PRIu64 ")]\n"
+		"\t[-2, --precision <Precision of the sampling: double | mixed | float> (Default: double)] (Monte Carlo mode only.)\n"
+		"\t[-3, --sampler <Sampler of the bounded Pareto distribution: inverse-cdf | table> (Default: inverse-cdf)] (Monte Carlo mode only.)\n"
+		"\t[-c, --copula <Dependence between investments: independent | gaussian | t> (Default: independent)] (Monte Carlo mode only.)\n"
+		"\t[-r, --market-correlation <Latent correlation through the market factor: double in [0, 1]> (Default: %"SignaloidParticleModifier".2lf)]\n"
+		"\t[-R, --class-correlation <Additional latent correlation within a portfolio class: double in [0, 1 - market correlation]> (Default: %"SignaloidParticleModifier".2lf)]\n"
+		"\t[-d, --degrees-of-freedom <Degrees of freedom of the t copula: size_t in [1, %d]> (Default: %d)]\n"
+		"\t[-m, --class-correlation-matrix <Path to CSV correlation matrix of the class factors, one row per portfolio class : str>] (Scaled by -R.)\n"
+		"\t[-y, --fund-life-years <Fund life of the fund timeline: size_t in [1, %d]>] (Monte Carlo mode only. Prints DPI, TVPI and net cash flow per year.)\n"
+		"\t[-e, --deployment-years <Years over which initial investments are made: size_t in [1, fund life]> (Default: %d)]\n"
+		"\t[-H, --minimum-holding-years <Minimum holding period of an investment: size_t in [1, %d]> (Default: %d)]\n"
+		"\t[-G, --maximum-holding-years <Maximum holding period of an investment: size_t in [minimum holding period, %d]> (Default: %d)]\n"
+		"\t[-f, --follow-on-fraction <Fraction of the capital of each investment reserved for its follow-on: double in [0, 1)> (Default: %"SignaloidParticleModifier".2lf)]\n"
+		"\t[-F, --follow-on-delay-years <Years from an initial investment to its follow-on: size_t in [1, %d]> (Default: %d)]\n"
+		"\t[-w, --waterfall <Fee and carried-interest waterfall: none | european | american> (Default: none)] (Monte Carlo mode only. Prints the net multiple of the LPs.)\n"
+		"\t[-g, --management-fee <Annual management fee as a fraction of the commitment: double in [0, 1)> (Default: %"SignaloidParticleModifier".2lf)]\n"
+		"\t[-Y, --management-fee-years <Years of management fees: size_t in [0, %d]> (Default: %d)]\n"
+		"\t[-k, --carried-interest <Share of the profits of the GP: double in [0, 1)> (Default: %"SignaloidParticleModifier".2lf)]\n"
+		"\t[-u, --hurdle-rate <Annual preferred return of the LPs: double in [0, inf)> (Default: %"SignaloidParticleModifier".2lf)]\n"
+		"\t[-U, --hurdle-years <Years over which the preferred return compounds: size_t in [0, %d]> (Default: %d)]\n"
+		"\t[-z, --catch-up <Share of the GP in the catch-up: 0 (no catch-up) or double in (carried interest, 1]> (Default: %"SignaloidParticleModifier".2lf)]\n"
+		"\t[-V, --reserve-strategies <Comma-separated reserve ratios of the total investment, at most %d: double in [0, 1]>] (Monte Carlo mode only. Prints the return of each strategy.)\n"
+		"\t[-B, --follow-on-threshold <Return multiple of the investments that receive follow-ons from the reserve: double in [1e-100, 1e100]> (Default: %"SignaloidParticleModifier".2lf)]\n"
+		"\t[-P, --follow-on-step-up <Price of follow-ons relative to the initial investment: double in [1, inf)> (Default: %"SignaloidParticleModifier".2lf)]\n"
+		"\t[-N, --follow-on-signal-noise <Log-scale noise of the winner signal at the follow-on round: double in [0, %d]> (Default: %"SignaloidParticleModifier".2lf)] (0 is perfect information.)\n"
+		"\t[-O, --optimize <Search the portfolio size up to -n that optimizes a metric: loss | low-quantile | high-quantile>] (Monte Carlo mode only. Prints the candidate sizes.)\n"
+		"\t[-A, --optimize-minimum-investments <Smallest candidate portfolio size: size_t in [1, number of investments]> (Default: 1)]\n"
+		"\t[-E, --optimize-tolerance <Chooses the smallest size whose metric is within this tolerance of the best: double in [0, inf)> (Default: %"SignaloidParticleModifier".3lf)]\n"
+		"\t[-K, --calibrate <Path to CSV of observed exit multiples, one per line : str>] (Calibration mode: fits -a, -x and -X by maximum likelihood.)\n"
+		"\t[-D, --bootstrap-resamples <Number of bootstrap resamples of the calibration: size_t in [0, %d]> (Default: %d)] (Intervals at the -q and -Q quantiles.)\n"
+		"\t[-I, --parameter-draws <Path to CSV of alpha,xMin,xMax draws, one per line : str>] (Monte Carlo mode only. Parameter uncertainty.)\n"
+		"\t[-J, --iterations-per-draw <Iterations of each outer draw of the parameters: size_t in [1, inf)> (Default: %d)]\n"
+		"\t[-Z, --sketch <Path to write the quantile sketch of the portfolio return to : str>] (Monte Carlo mode only. Simulates on -t threads without keeping the samples.)\n"
+		"\t[-p, --shard <Shard k/N to simulate of the -M iterations: k in [0, N), N in [1, -M]> (Default: 0/1)] (Monte Carlo mode only. Combine shards with merge.)\n"
+		"\t[-t, --threads <Number of worker threads: size_t in [1, inf)> (Default: number of online processors)]\n"
+		"\t[-1, --pin-threads] (Pins the worker threads to CPUs, spread over the NUMA nodes. Defaults -t to one thread per CPU.)\n"
+		"\t[-L, --serve <Path of Unix socket to serve line-delimited JSON queries on: str>] (Server mode, native builds only.)\n"
+		"\t[-C, --cache <Directory of the result cache of server mode: str>] (Created if missing.)\n"
+		"\t[-W, --coordinator <Number of local worker processes: size_t in [0, inf)>] (Cluster mode, native builds only. Distributes the -M iterations between workers.)\n"
+		"\t[-l, --cluster-address <host:port of the coordinator : str>] (Listened on with -W, for remote workers. Without -W, runs as a worker of that coordinator.)\n",
 		kDefaultValuesAlpha,
 		kDefaultValuesXMin,
 		kDefaultValuesXMax,
 		(size_t)kDefaultValuesNumberOfInvestements,
+		(int)kMoonfireConstantMaximumPortfolioSizes,
 		kDefaultValuesLowQuantileProbability,
-		kDefaultValuesHighQuantileProbability);
+		kDefaultValuesHighQuantileProbability,
+		kDefaultValuesSeed,
+		kDefaultValuesMarketCorrelation,
+		kDefaultValuesClassCorrelation,
+		(int)kMoonfireConstantMaximumDegreesOfFreedom,
+		(int)kDefaultValuesDegreesOfFreedom,
+		(int)kMoonfireConstantMaximumFundLifeYears,
+		(int)kDefaultValuesDeploymentYears,
+		(int)kMoonfireConstantMaximumFundLifeYears,
+		(int)kDefaultValuesMinimumHoldingYears,
+		(int)kMoonfireConstantMaximumFundLifeYears,
+		(int)kDefaultValuesMaximumHoldingYears,
+		kDefaultValuesFollowOnFraction,
+		(int)kMoonfireConstantMaximumFundLifeYears,
+		(int)kDefaultValuesFollowOnDelayYears,
+		kDefaultValuesManagementFeeRate,
+		(int)kMoonfireConstantMaximumFundLifeYears,
+		(int)kDefaultValuesManagementFeeYears,
+		kDefaultValuesCarriedInterest,
+		kDefaultValuesHurdleRate,
+		(int)kMoonfireConstantMaximumFundLifeYears,
+		(int)kDefaultValuesHurdleYears,
+		kDefaultValuesCatchUp,
+		(int)kMoonfireConstantMaximumReserveStrategies,
+		kDefaultValuesFollowOnThreshold,
+		kDefaultValuesFollowOnStepUp,
+		(int)kMoonfireConstantMaximumFollowOnSignalNoise,
+		kDefaultValuesFollowOnSignalNoise,
+		kDefaultValuesOptimizerTolerance,
+		(int)kCalibrationConstantMaximumBootstrapResamples,
+		(int)kCalibrationConstantDefaultBootstrapResamples,
+		(int)kDefaultValuesIterationsPerParameterDraw);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Usage of the merge subcommand, which merges sketch files (-Z) or Monte Carlo output files (data.out) of shards into the statistics of their combined samples:\n");
+	fprintf(
+		stderr,
+		"\tmerge [-q <Low quantile probability: double in [0, 1]>] [-Q <High quantile probability: double in [0, 1]>] "
+		"[-Z <Path to write the merged sketch to : str>] <Path to sketch file or Monte Carlo output file : str>...\n");
 	fprintf(stderr, "\n");
 
 	return;
@@ -108,12 +226,247 @@ setDefaultCommandLineArguments(CommandLineArguments *  arguments)
 		.numberOfInvestments		= kDefaultValuesNumberOfInvestements,
 		.lowQuantileProbability		= kDefaultValuesLowQuantileProbability,
 		.highQuantileProbability	= kDefaultValuesHighQuantileProbability,
+		.seed				= kDefaultValuesSeed,
+		.precision			= kMoonfirePrecisionDouble,
+		.sampler			= kMoonfireSamplerInverseCdf,
+		.copula				= kMoonfireCopulaIndependent,
+		.marketCorrelation		= kDefaultValuesMarketCorrelation,
+		.classCorrelation		= kDefaultValuesClassCorrelation,
+		.degreesOfFreedom		= kDefaultValuesDegreesOfFreedom,
+		.numberOfThreads		= 1,
+		.isThreadPinningEnabled		= false,
+		.isServerModeEnabled		= false,
+		.isResultCacheEnabled		= false,
+		.isCoordinatorEnabled		= false,
+		.numberOfLocalWorkers		= 0,
+		.isClusterAddressEnabled	= false,
+		.isClassCorrelationMatrixEnabled	= false,
+		.fundLifeYears			= 0,
+		.deploymentYears		= kDefaultValuesDeploymentYears,
+		.minimumHoldingYears		= kDefaultValuesMinimumHoldingYears,
+		.maximumHoldingYears		= kDefaultValuesMaximumHoldingYears,
+		.followOnFraction		= kDefaultValuesFollowOnFraction,
+		.followOnDelayYears		= kDefaultValuesFollowOnDelayYears,
+		.waterfall			= kMoonfireWaterfallNone,
+		.managementFeeRate		= kDefaultValuesManagementFeeRate,
+		.managementFeeYears		= kDefaultValuesManagementFeeYears,
+		.carriedInterest		= kDefaultValuesCarriedInterest,
+		.hurdleRate			= kDefaultValuesHurdleRate,
+		.hurdleYears			= kDefaultValuesHurdleYears,
+		.catchUp			= kDefaultValuesCatchUp,
+		.numberOfReserveStrategies	= 0,
+		.followOnThreshold		= kDefaultValuesFollowOnThreshold,
+		.followOnStepUp			= kDefaultValuesFollowOnStepUp,
+		.followOnSignalNoise		= kDefaultValuesFollowOnSignalNoise,
+		.optimizerObjective		= kOptimizerObjectiveNone,
+		.minimumNumberOfInvestments	= 1,
+		.optimizerTolerance		= kDefaultValuesOptimizerTolerance,
+		.isCalibrationEnabled		= false,
+		.numberOfBootstrapResamples	= kCalibrationConstantDefaultBootstrapResamples,
+		.isParameterDrawsEnabled	= false,
+		.iterationsPerParameterDraw	= kDefaultValuesIterationsPerParameterDraw,
+		.isOutcomesEnabled		= false,
+		.isSketchEnabled		= false,
+		.numberOfSweepSizes		= 0,
+		.shardIndex			= 0,
+		.numberOfShards			= 1,
 	};
 #pragma GCC diagnostic pop
 
 	return kCommonConstantReturnTypeSuccess;
 }
 
+/**
+ *	@brief	Typecheck an argument that is a number of years.
+ *
+ *	@param	argument	: The argument.
+ *	@param	description	: Description of the argument for error messages, e.g., "fund life parameter(-y)".
+ *	@param	minimum		: Smallest valid value.
+ *	@param	maximum		: Largest valid value.
+ *	@param	years		: Pointer to store the number of years.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+parseYearsArgument(const char *  argument, const char *  description, size_t minimum, size_t maximum, size_t *  years)
+{
+	int	value;
+	int	ret = parseIntChecked(argument, &value);
+
+	if (ret != kCommonConstantReturnTypeSuccess)
+	{
+		fprintf(stderr, "Error: The %s must be an integer number.\n", description);
+		printUsage();
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((value < 0) || ((size_t) value < minimum) || ((size_t) value > maximum))
+	{
+		fprintf(stderr, "Error: The %s must be in [%zu, %zu]\n", description, minimum, maximum);
+		printUsage();
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	*years = (size_t) value;
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+/**
+ *	@brief	Typecheck an argument that is a real number in an interval.
+ *
+ *	@param	argument	: The argument.
+ *	@param	description	: Description of the argument for error messages, e.g., "carried interest parameter(-k)".
+ *	@param	minimum		: Smallest valid value.
+ *	@param	maximum		: Largest valid value.
+ *	@param	value		: Pointer to store the value.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+parseRealArgument(const char *  argument, const char *  description, double minimum, double maximum, double *  value)
+{
+	double	parsed;
+	int	ret = parseDoubleChecked(argument, &parsed);
+
+	if (ret != kCommonConstantReturnTypeSuccess)
+	{
+		fprintf(stderr, "Error: The %s must be a real number.\n", description);
+		printUsage();
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if (!(parsed >= minimum) || !(parsed <= maximum))
+	{
+		fprintf(stderr, "Error: The %s must be a value in [%g, %g]\n", description, minimum, maximum);
+		printUsage();
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	*value = parsed;
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+/**
+ *	@brief	Typecheck the comma-separated reserve ratios of the reserve strategies.
+ *
+ *	@param	argument	: The argument.
+ *	@param	arguments	: Pointer to struct to store the reserve ratios.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+parseReserveRatios(const char *  argument, CommandLineArguments *  arguments)
+{
+	char		ratio[kCommonConstantMaxCharsPerFilepath];
+	const char *	start = argument;
+
+	arguments->numberOfReserveStrategies = 0;
+	while (true)
+	{
+		const char *	end = strchr(start, ',');
+		size_t		length = (end != NULL) ? (size_t)(end - start) : strlen(start);
+
+		if (arguments->numberOfReserveStrategies == kMoonfireConstantMaximumReserveStrategies)
+		{
+			fprintf(stderr, "Error: At most %d reserve strategies(-V) are supported.\n", (int) kMoonfireConstantMaximumReserveStrategies);
+			printUsage();
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		if (length >= sizeof(ratio))
+		{
+			fprintf(stderr, "Error: The reserve strategies(-V) must be comma-separated real numbers.\n");
+			printUsage();
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		memcpy(ratio, start, length);
+		ratio[length] = '\0';
+		if (parseRealArgument(
+				ratio,
+				"reserve ratio of each reserve strategy(-V)",
+				0,
+				1,
+				&arguments->reserveRatios[arguments->numberOfReserveStrategies]) != kCommonConstantReturnTypeSuccess)
+		{
+			return kCommonConstantReturnTypeError;
+		}
+		arguments->numberOfReserveStrategies++;
+
+		if (end == NULL)
+		{
+			break;
+		}
+		start = end + 1;
+	}
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+/**
+ *	@brief	Typecheck the comma-separated portfolio sizes of a sweep.
+ *
+ *	@param	argument	: The argument.
+ *	@param	arguments	: Pointer to struct to store the sizes and the largest size.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`.
+ */
+static CommonConstantReturnType
+parseSweepSizes(const char *  argument, CommandLineArguments *  arguments)
+{
+	char		size[kCommonConstantMaxCharsPerFilepath];
+	const char *	start = argument;
+
+	arguments->numberOfSweepSizes = 0;
+	arguments->numberOfInvestments = 0;
+	while (true)
+	{
+		const char *	end = strchr(start, ',');
+		size_t		length = (end != NULL) ? (size_t)(end - start) : strlen(start);
+		int		numberOfInvestments;
+
+		if (arguments->numberOfSweepSizes == kMoonfireConstantMaximumPortfolioSizes)
+		{
+			fprintf(stderr, "Error: At most %d portfolio sizes(-n) are supported.\n", (int) kMoonfireConstantMaximumPortfolioSizes);
+			printUsage();
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		if (length < sizeof(size))
+		{
+			memcpy(size, start, length);
+			size[length] = '\0';
+		}
+
+		if ((length >= sizeof(size)) || (parseIntChecked(size, &numberOfInvestments) != kCommonConstantReturnTypeSuccess) || (numberOfInvestments < 1))
+		{
+			fprintf(stderr, "Error: The portfolio sizes(-n) must be comma-separated integers >= 1.\n");
+			printUsage();
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		arguments->sweepSizes[arguments->numberOfSweepSizes++] = (size_t) numberOfInvestments;
+		if ((size_t) numberOfInvestments > arguments->numberOfInvestments)
+		{
+			arguments->numberOfInvestments = (size_t) numberOfInvestments;
+		}
+
+		if (end == NULL)
+		{
+			break;
+		}
+		start = end + 1;
+	}
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
 CommonConstantReturnType
 getCommandLineArguments(int argc, char *  argv[], CommandLineArguments *  arguments)
 {
@@ -123,6 +476,47 @@ getCommandLineArguments(int argc, char *  argv[], CommandLineArguments *  argume
 	const char *	numberOfInvestmentsArg = NULL;
 	const char *	lowQuantileProbabilityArg = NULL;
 	const char *	highQuantileProbabilityArg = NULL;
+	const char *	seedArg = NULL;
+	const char *	copulaArg = NULL;
+	const char *	marketCorrelationArg = NULL;
+	const char *	classCorrelationArg = NULL;
+	const char *	degreesOfFreedomArg = NULL;
+	const char *	classCorrelationMatrixArg = NULL;
+	const char *	fundLifeYearsArg = NULL;
+	const char *	deploymentYearsArg = NULL;
+	const char *	minimumHoldingYearsArg = NULL;
+	const char *	maximumHoldingYearsArg = NULL;
+	const char *	followOnFractionArg = NULL;
+	const char *	followOnDelayYearsArg = NULL;
+	const char *	waterfallArg = NULL;
+	const char *	managementFeeRateArg = NULL;
+	const char *	managementFeeYearsArg = NULL;
+	const char *	carriedInterestArg = NULL;
+	const char *	hurdleRateArg = NULL;
+	const char *	hurdleYearsArg = NULL;
+	const char *	catchUpArg = NULL;
+	const char *	reserveStrategiesArg = NULL;
+	const char *	followOnThresholdArg = NULL;
+	const char *	followOnStepUpArg = NULL;
+	const char *	followOnSignalNoiseArg = NULL;
+	const char *	optimizeArg = NULL;
+	const char *	minimumNumberOfInvestmentsArg = NULL;
+	const char *	optimizerToleranceArg = NULL;
+	const char *	multiplesPathArg = NULL;
+	const char *	bootstrapResamplesArg = NULL;
+	const char *	parameterDrawsPathArg = NULL;
+	const char *	iterationsPerParameterDrawArg = NULL;
+	const char *	sketchPathArg = NULL;
+	const char *	shardArg = NULL;
+	const char *	threadsArg = NULL;
+	bool		isThreadPinningFound = false;
+	const char *	precisionArg = NULL;
+	const char *	samplerArg = NULL;
+	const char *	outcomesPathArg = NULL;
+	const char *	serverSocketPathArg = NULL;
+	const char *	resultCacheDirectoryArg = NULL;
+	const char *	coordinatorArg = NULL;
+	const char *	clusterAddressArg = NULL;
 
 	if (arguments == NULL)
 	{
@@ -144,6 +538,52 @@ getCommandLineArguments(int argc, char *  argv[], CommandLineArguments *  argume
 		{ .opt = "n", .optAlternative = "number-of-investments",	.hasArg = true, .foundArg = &numberOfInvestmentsArg,		.foundOpt = NULL },
 		{ .opt = "q", .optAlternative = "low-quantile-probability",	.hasArg = true, .foundArg = &lowQuantileProbabilityArg,		.foundOpt = NULL },
 		{ .opt = "Q", .optAlternative = "high-quantile-probability",	.hasArg = true, .foundArg = &highQuantileProbabilityArg,	.foundOpt = NULL },
+		{ .opt = "s", .optAlternative = "seed",				.hasArg = true, .foundArg = &seedArg,				.foundOpt = NULL },
+		{ .opt = "c", .optAlternative = "copula",			.hasArg = true, .foundArg = &copulaArg,				.foundOpt = NULL },
+		{ .opt = "r", .optAlternative = "market-correlation",		.hasArg = true, .foundArg = &marketCorrelationArg,		.foundOpt = NULL },
+		{ .opt = "R", .optAlternative = "class-correlation",		.hasArg = true, .foundArg = &classCorrelationArg,		.foundOpt = NULL },
+		{ .opt = "d", .optAlternative = "degrees-of-freedom",		.hasArg = true, .foundArg = &degreesOfFreedomArg,		.foundOpt = NULL },
+		{ .opt = "m", .optAlternative = "class-correlation-matrix",	.hasArg = true, .foundArg = &classCorrelationMatrixArg,		.foundOpt = NULL },
+		{ .opt = "y", .optAlternative = "fund-life-years",		.hasArg = true, .foundArg = &fundLifeYearsArg,			.foundOpt = NULL },
+		{ .opt = "e", .optAlternative = "deployment-years",		.hasArg = true, .foundArg = &deploymentYearsArg,		.foundOpt = NULL },
+		{ .opt = "H", .optAlternative = "minimum-holding-years",	.hasArg = true, .foundArg = &minimumHoldingYearsArg,		.foundOpt = NULL },
+		{ .opt = "G", .optAlternative = "maximum-holding-years",	.hasArg = true, .foundArg = &maximumHoldingYearsArg,		.foundOpt = NULL },
+		{ .opt = "f", .optAlternative = "follow-on-fraction",		.hasArg = true, .foundArg = &followOnFractionArg,		.foundOpt = NULL },
+		{ .opt = "F", .optAlternative = "follow-on-delay-years",	.hasArg = true, .foundArg = &followOnDelayYearsArg,		.foundOpt = NULL },
+		{ .opt = "w", .optAlternative = "waterfall",			.hasArg = true, .foundArg = &waterfallArg,			.foundOpt = NULL },
+		{ .opt = "g", .optAlternative = "management-fee",		.hasArg = true, .foundArg = &managementFeeRateArg,		.foundOpt = NULL },
+		{ .opt = "Y", .optAlternative = "management-fee-years",		.hasArg = true, .foundArg = &managementFeeYearsArg,		.foundOpt = NULL },
+		{ .opt = "k", .optAlternative = "carried-interest",		.hasArg = true, .foundArg = &carriedInterestArg,		.foundOpt = NULL },
+		{ .opt = "u", .optAlternative = "hurdle-rate",			.hasArg = true, .foundArg = &hurdleRateArg,			.foundOpt = NULL },
+		{ .opt = "U", .optAlternative = "hurdle-years",			.hasArg = true, .foundArg = &hurdleYearsArg,			.foundOpt = NULL },
+		{ .opt = "z", .optAlternative = "catch-up",			.hasArg = true, .foundArg = &catchUpArg,			.foundOpt = NULL },
+		{ .opt = "V", .optAlternative = "reserve-strategies",		.hasArg = true, .foundArg = &reserveStrategiesArg,		.foundOpt = NULL },
+		{ .opt = "B", .optAlternative = "follow-on-threshold",		.hasArg = true, .foundArg = &followOnThresholdArg,		.foundOpt = NULL },
+		{ .opt = "P", .optAlternative = "follow-on-step-up",		.hasArg = true, .foundArg = &followOnStepUpArg,			.foundOpt = NULL },
+		{ .opt = "N", .optAlternative = "follow-on-signal-noise",	.hasArg = true, .foundArg = &followOnSignalNoiseArg,		.foundOpt = NULL },
+		{ .opt = "O", .optAlternative = "optimize",			.hasArg = true, .foundArg = &optimizeArg,			.foundOpt = NULL },
+		{ .opt = "A", .optAlternative = "optimize-minimum-investments",	.hasArg = true, .foundArg = &minimumNumberOfInvestmentsArg,	.foundOpt = NULL },
+		{ .opt = "E", .optAlternative = "optimize-tolerance",		.hasArg = true, .foundArg = &optimizerToleranceArg,		.foundOpt = NULL },
+		{ .opt = "K", .optAlternative = "calibrate",			.hasArg = true, .foundArg = &multiplesPathArg,			.foundOpt = NULL },
+		{ .opt = "D", .optAlternative = "bootstrap-resamples",		.hasArg = true, .foundArg = &bootstrapResamplesArg,		.foundOpt = NULL },
+		{ .opt = "I", .optAlternative = "parameter-draws",		.hasArg = true, .foundArg = &parameterDrawsPathArg,		.foundOpt = NULL },
+		{ .opt = "J", .optAlternative = "iterations-per-draw",		.hasArg = true, .foundArg = &iterationsPerParameterDrawArg,	.foundOpt = NULL },
+		{ .opt = "Z", .optAlternative = "sketch",			.hasArg = true, .foundArg = &sketchPathArg,			.foundOpt = NULL },
+		{ .opt = "p", .optAlternative = "shard",			.hasArg = true, .foundArg = &shardArg,				.foundOpt = NULL },
+		{ .opt = "t", .optAlternative = "threads",			.hasArg = true, .foundArg = &threadsArg,			.foundOpt = NULL },
+		{ .opt = "L", .optAlternative = "serve",			.hasArg = true, .foundArg = &serverSocketPathArg,		.foundOpt = NULL },
+		{ .opt = "C", .optAlternative = "cache",			.hasArg = true, .foundArg = &resultCacheDirectoryArg,		.foundOpt = NULL },
+		{ .opt = "W", .optAlternative = "coordinator",			.hasArg = true, .foundArg = &coordinatorArg,			.foundOpt = NULL },
+		{ .opt = "l", .optAlternative = "cluster-address",		.hasArg = true, .foundArg = &clusterAddressArg,			.foundOpt = NULL },
+
+		/*
+		 *	All letters are taken, so the options below have a digit as
+		 *	their short option, which the usage lists with their long name.
+		 */
+		{ .opt = "1", .optAlternative = "pin-threads",			.hasArg = false, .foundArg = NULL,				.foundOpt = &isThreadPinningFound },
+		{ .opt = "2", .optAlternative = "precision",			.hasArg = true, .foundArg = &precisionArg,			.foundOpt = NULL },
+		{ .opt = "3", .optAlternative = "sampler",			.hasArg = true, .foundArg = &samplerArg,			.foundOpt = NULL },
+		{ .opt = "4", .optAlternative = "outcomes",			.hasArg = true, .foundArg = &outcomesPathArg,			.foundOpt = NULL },
 		{0},
 	};
 
@@ -169,9 +609,22 @@ getCommandLineArguments(int argc, char *  argv[], CommandLineArguments *  argume
 		return kCommonConstantReturnTypeError;
 	}
 
-	if (arguments->common.isInputFromFileEnabled)
+	/*
+	 *	A portfolio file replaces the parameters of the homogeneous portfolio,
+	 *	and an outcomes file its bounded Pareto distribution.
+	 */
+	if (arguments->common.isInputFromFileEnabled &&
+		((alphaArg != NULL) || (xMinArg != NULL) || (xMaxArg != NULL) || (numberOfInvestmentsArg != NULL)))
+	{
+		fprintf(stderr, "Error: The portfolio file(-i) cannot be combined with -a, -x, -X or -n.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((outcomesPathArg != NULL) &&
+		(arguments->common.isInputFromFileEnabled || (alphaArg != NULL) || (xMinArg != NULL) || (xMaxArg != NULL)))
 	{
-		fprintf(stderr, "Error: This application does not support reading inputs from file.\n");
+		fprintf(stderr, "Error: The outcomes file(--outcomes) cannot be combined with -i, -a, -x or -X.\n");
 
 		return kCommonConstantReturnTypeError;
 	}
@@ -280,9 +733,17 @@ getCommandLineArguments(int argc, char *  argv[], CommandLineArguments *  argume
 	}
 
 	/*
-	 *	Typecheck numberOfInvestments.
+	 *	Typecheck numberOfInvestments. Several comma-separated sizes are the
+	 *	points of a sweep, and the largest one is the number of investments.
 	 */
-	if (numberOfInvestmentsArg != NULL)
+	if ((numberOfInvestmentsArg != NULL) && (strchr(numberOfInvestmentsArg, ',') != NULL))
+	{
+		if (parseSweepSizes(numberOfInvestmentsArg, arguments) != kCommonConstantReturnTypeSuccess)
+		{
+			return kCommonConstantReturnTypeError;
+		}
+	}
+	else if (numberOfInvestmentsArg != NULL)
 	{
 		int	numberOfInvestments;
 		int	ret = parseIntChecked(numberOfInvestmentsArg, &numberOfInvestments);
@@ -368,5 +829,990 @@ getCommandLineArguments(int argc, char *  argv[], CommandLineArguments *  argume
 		return kCommonConstantReturnTypeError;
 	}
 
+	/*
+	 *	Typecheck seed.
+	 */
+	if (seedArg != NULL)
+	{
+		if (parseUint64Checked(seedArg, &arguments->seed) != kCommonConstantReturnTypeSuccess)
+		{
+			fprintf(stderr, "Error: The seed parameter(-s) must be a non-negative integer.\n");
+			printUsage();
+
+			return kCommonConstantReturnTypeError;
+		}
+	}
+
+	/*
+	 *	Check precision.
+	 */
+	if (precisionArg != NULL)
+	{
+		if (strcmp(precisionArg, "double") == 0)
+		{
+			arguments->precision = kMoonfirePrecisionDouble;
+		}
+		else if (strcmp(precisionArg, "mixed") == 0)
+		{
+			arguments->precision = kMoonfirePrecisionMixed;
+		}
+		else if (strcmp(precisionArg, "float") == 0)
+		{
+			arguments->precision = kMoonfirePrecisionFloat;
+		}
+		else
+		{
+			fprintf(stderr, "Error: The precision parameter(--precision) must be one of double, mixed or float.\n");
+			printUsage();
+
+			return kCommonConstantReturnTypeError;
+		}
+	}
+
+	/*
+	 *	Check sampler.
+	 */
+	if (samplerArg != NULL)
+	{
+		if (strcmp(samplerArg, "inverse-cdf") == 0)
+		{
+			arguments->sampler = kMoonfireSamplerInverseCdf;
+		}
+		else if (strcmp(samplerArg, "table") == 0)
+		{
+			arguments->sampler = kMoonfireSamplerTable;
+		}
+		else
+		{
+			fprintf(stderr, "Error: The sampler parameter(--sampler) must be one of inverse-cdf or table.\n");
+			printUsage();
+
+			return kCommonConstantReturnTypeError;
+		}
+	}
+
+	/*
+	 *	Check copula.
+	 */
+	if (copulaArg != NULL)
+	{
+		if (strcmp(copulaArg, "independent") == 0)
+		{
+			arguments->copula = kMoonfireCopulaIndependent;
+		}
+		else if (strcmp(copulaArg, "gaussian") == 0)
+		{
+			arguments->copula = kMoonfireCopulaGaussian;
+		}
+		else if (strcmp(copulaArg, "t") == 0)
+		{
+			arguments->copula = kMoonfireCopulaStudentT;
+		}
+		else
+		{
+			fprintf(stderr, "Error: The copula parameter(-c) must be one of independent, gaussian or t.\n");
+			printUsage();
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		if ((arguments->copula != kMoonfireCopulaIndependent) && !arguments->common.isMonteCarloMode && (serverSocketPathArg == NULL))
+		{
+			fprintf(stderr, "Error: The copula parameter(-c) needs Monte Carlo mode(-M) or server mode(-L).\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+	}
+
+	/*
+	 *	Typecheck marketCorrelation.
+	 */
+	if (marketCorrelationArg != NULL)
+	{
+		double	marketCorrelation;
+		int	ret = parseDoubleChecked(marketCorrelationArg, &marketCorrelation);
+
+		if (ret != kCommonConstantReturnTypeSuccess)
+		{
+			fprintf(stderr, "Error: The market correlation parameter(-r) must be a real number.\n");
+			printUsage();
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		if (!(marketCorrelation >= 0) || !(marketCorrelation <= 1))
+		{
+			fprintf(stderr, "Error: The market correlation parameter(-r) must be a value in [0, 1]\n");
+			printUsage();
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		arguments->marketCorrelation = marketCorrelation;
+	}
+
+	/*
+	 *	Typecheck classCorrelation.
+	 */
+	if (classCorrelationArg != NULL)
+	{
+		double	classCorrelation;
+		int	ret = parseDoubleChecked(classCorrelationArg, &classCorrelation);
+
+		if (ret != kCommonConstantReturnTypeSuccess)
+		{
+			fprintf(stderr, "Error: The class correlation parameter(-R) must be a real number.\n");
+			printUsage();
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		if (!(classCorrelation >= 0) || !(classCorrelation <= 1))
+		{
+			fprintf(stderr, "Error: The class correlation parameter(-R) must be a value in [0, 1]\n");
+			printUsage();
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		arguments->classCorrelation = classCorrelation;
+	}
+
+	if (arguments->marketCorrelation + arguments->classCorrelation > 1)
+	{
+		fprintf(stderr, "Error: The sum of the market(-r) and class(-R) correlations cannot be larger than 1.\n");
+		printUsage();
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	/*
+	 *	Typecheck degreesOfFreedom.
+	 */
+	if (degreesOfFreedomArg != NULL)
+	{
+		int	degreesOfFreedom;
+		int	ret = parseIntChecked(degreesOfFreedomArg, &degreesOfFreedom);
+
+		if (ret != kCommonConstantReturnTypeSuccess)
+		{
+			fprintf(stderr, "Error: The degrees of freedom parameter(-d) must be an integer number.\n");
+			printUsage();
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		if ((degreesOfFreedom < 1) || (degreesOfFreedom > kMoonfireConstantMaximumDegreesOfFreedom))
+		{
+			fprintf(stderr, "Error: The degrees of freedom parameter(-d) must be in [1, %d]\n", (int) kMoonfireConstantMaximumDegreesOfFreedom);
+			printUsage();
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		arguments->degreesOfFreedom = (size_t) degreesOfFreedom;
+	}
+
+	/*
+	 *	Check class correlation matrix path. The matrix is loaded, and checked
+	 *	against the portfolio, by the model.
+	 */
+	if (classCorrelationMatrixArg != NULL)
+	{
+		if ((arguments->copula == kMoonfireCopulaIndependent) || !(arguments->classCorrelation > 0))
+		{
+			fprintf(stderr, "Error: The class correlation matrix(-m) needs a copula(-c) and a class correlation(-R) above 0.\n");
+			printUsage();
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		if (strlen(classCorrelationMatrixArg) >= sizeof(arguments->classCorrelationMatrixPath))
+		{
+			fprintf(stderr, "Error: The class correlation matrix path(-m) is too long.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		strcpy(arguments->classCorrelationMatrixPath, classCorrelationMatrixArg);
+		arguments->isClassCorrelationMatrixEnabled = true;
+	}
+
+	/*
+	 *	Typecheck the fund timeline.
+	 */
+	if (fundLifeYearsArg != NULL)
+	{
+		if (!arguments->common.isMonteCarloMode || (serverSocketPathArg != NULL))
+		{
+			fprintf(stderr, "Error: The fund timeline(-y) needs Monte Carlo mode(-M) and is not available in server mode(-L).\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		if (parseYearsArgument(
+				fundLifeYearsArg,
+				"fund life parameter(-y)",
+				1,
+				kMoonfireConstantMaximumFundLifeYears,
+				&arguments->fundLifeYears) != kCommonConstantReturnTypeSuccess)
+		{
+			return kCommonConstantReturnTypeError;
+		}
+	}
+
+	if ((deploymentYearsArg != NULL) &&
+		(parseYearsArgument(
+			deploymentYearsArg,
+			"deployment years parameter(-e)",
+			1,
+			kMoonfireConstantMaximumFundLifeYears,
+			&arguments->deploymentYears) != kCommonConstantReturnTypeSuccess))
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((minimumHoldingYearsArg != NULL) &&
+		(parseYearsArgument(
+			minimumHoldingYearsArg,
+			"minimum holding years parameter(-H)",
+			1,
+			kMoonfireConstantMaximumFundLifeYears,
+			&arguments->minimumHoldingYears) != kCommonConstantReturnTypeSuccess))
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((maximumHoldingYearsArg != NULL) &&
+		(parseYearsArgument(
+			maximumHoldingYearsArg,
+			"maximum holding years parameter(-G)",
+			1,
+			kMoonfireConstantMaximumFundLifeYears,
+			&arguments->maximumHoldingYears) != kCommonConstantReturnTypeSuccess))
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((followOnDelayYearsArg != NULL) &&
+		(parseYearsArgument(
+			followOnDelayYearsArg,
+			"follow-on delay years parameter(-F)",
+			1,
+			kMoonfireConstantMaximumFundLifeYears,
+			&arguments->followOnDelayYears) != kCommonConstantReturnTypeSuccess))
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	if (followOnFractionArg != NULL)
+	{
+		double	followOnFraction;
+		int	ret = parseDoubleChecked(followOnFractionArg, &followOnFraction);
+
+		if (ret != kCommonConstantReturnTypeSuccess)
+		{
+			fprintf(stderr, "Error: The follow-on fraction parameter(-f) must be a real number.\n");
+			printUsage();
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		if (!(followOnFraction >= 0) || !(followOnFraction < 1))
+		{
+			fprintf(stderr, "Error: The follow-on fraction parameter(-f) must be a value in [0, 1)\n");
+			printUsage();
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		arguments->followOnFraction = followOnFraction;
+	}
+
+	if (arguments->minimumHoldingYears > arguments->maximumHoldingYears)
+	{
+		fprintf(stderr, "Error: The minimum holding years(-H) cannot be larger than the maximum holding years(-G).\n");
+		printUsage();
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((arguments->fundLifeYears > 0) && (arguments->deploymentYears > arguments->fundLifeYears))
+	{
+		fprintf(stderr, "Error: The deployment years(-e) cannot be larger than the fund life(-y).\n");
+		printUsage();
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	/*
+	 *	Check the waterfall.
+	 */
+	if (waterfallArg != NULL)
+	{
+		if (strcmp(waterfallArg, "none") == 0)
+		{
+			arguments->waterfall = kMoonfireWaterfallNone;
+		}
+		else if (strcmp(waterfallArg, "european") == 0)
+		{
+			arguments->waterfall = kMoonfireWaterfallEuropean;
+		}
+		else if (strcmp(waterfallArg, "american") == 0)
+		{
+			arguments->waterfall = kMoonfireWaterfallAmerican;
+		}
+		else
+		{
+			fprintf(stderr, "Error: The waterfall parameter(-w) must be one of none, european or american.\n");
+			printUsage();
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		if ((arguments->waterfall != kMoonfireWaterfallNone) && (!arguments->common.isMonteCarloMode || (serverSocketPathArg != NULL)))
+		{
+			fprintf(stderr, "Error: The waterfall(-w) needs Monte Carlo mode(-M) and is not available in server mode(-L).\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+	}
+
+	if (((managementFeeRateArg != NULL) &&
+		(parseRealArgument(managementFeeRateArg, "management fee parameter(-g)", 0, 1, &arguments->managementFeeRate) != kCommonConstantReturnTypeSuccess)) ||
+		((carriedInterestArg != NULL) &&
+		(parseRealArgument(carriedInterestArg, "carried interest parameter(-k)", 0, 1, &arguments->carriedInterest) != kCommonConstantReturnTypeSuccess)) ||
+		((hurdleRateArg != NULL) &&
+		(parseRealArgument(hurdleRateArg, "hurdle rate parameter(-u)", 0, HUGE_VAL, &arguments->hurdleRate) != kCommonConstantReturnTypeSuccess)) ||
+		((catchUpArg != NULL) &&
+		(parseRealArgument(catchUpArg, "catch-up parameter(-z)", 0, 1, &arguments->catchUp) != kCommonConstantReturnTypeSuccess)))
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((managementFeeYearsArg != NULL) &&
+		(parseYearsArgument(
+			managementFeeYearsArg,
+			"management fee years parameter(-Y)",
+			0,
+			kMoonfireConstantMaximumFundLifeYears,
+			&arguments->managementFeeYears) != kCommonConstantReturnTypeSuccess))
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((hurdleYearsArg != NULL) &&
+		(parseYearsArgument(
+			hurdleYearsArg,
+			"hurdle years parameter(-U)",
+			0,
+			kMoonfireConstantMaximumFundLifeYears,
+			&arguments->hurdleYears) != kCommonConstantReturnTypeSuccess))
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	if (!(arguments->managementFeeRate * (double) arguments->managementFeeYears < 1))
+	{
+		fprintf(stderr, "Error: The total management fees(-g times -Y) must be less than the commitment.\n");
+		printUsage();
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if (!(arguments->carriedInterest < 1))
+	{
+		fprintf(stderr, "Error: The carried interest parameter(-k) must be a value in [0, 1)\n");
+		printUsage();
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((arguments->catchUp != 0) && !(arguments->catchUp > arguments->carriedInterest))
+	{
+		fprintf(stderr, "Error: The catch-up(-z) must be 0 or larger than the carried interest(-k).\n");
+		printUsage();
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	/*
+	 *	Typecheck the reserve strategies.
+	 */
+	if (reserveStrategiesArg != NULL)
+	{
+		if (!arguments->common.isMonteCarloMode || (serverSocketPathArg != NULL))
+		{
+			fprintf(stderr, "Error: The reserve strategies(-V) need Monte Carlo mode(-M) and are not available in server mode(-L).\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		if (parseReserveRatios(reserveStrategiesArg, arguments) != kCommonConstantReturnTypeSuccess)
+		{
+			return kCommonConstantReturnTypeError;
+		}
+	}
+
+	if (((followOnThresholdArg != NULL) &&
+		(parseRealArgument(followOnThresholdArg, "follow-on threshold parameter(-B)", 1e-100, 1e100, &arguments->followOnThreshold) != kCommonConstantReturnTypeSuccess)) ||
+		((followOnStepUpArg != NULL) &&
+		(parseRealArgument(followOnStepUpArg, "follow-on step-up parameter(-P)", 1, HUGE_VAL, &arguments->followOnStepUp) != kCommonConstantReturnTypeSuccess)) ||
+		((followOnSignalNoiseArg != NULL) &&
+		(parseRealArgument(
+			followOnSignalNoiseArg,
+			"follow-on signal noise parameter(-N)",
+			0,
+			kMoonfireConstantMaximumFollowOnSignalNoise,
+			&arguments->followOnSignalNoise) != kCommonConstantReturnTypeSuccess)))
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	if (!isfinite(arguments->followOnStepUp))
+	{
+		fprintf(stderr, "Error: The follow-on step-up(-P) must be finite.\n");
+		printUsage();
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	/*
+	 *	Check the portfolio size optimizer.
+	 */
+	if (optimizeArg != NULL)
+	{
+		if (strcmp(optimizeArg, "loss") == 0)
+		{
+			arguments->optimizerObjective = kOptimizerObjectiveProbabilityOfLoss;
+		}
+		else if (strcmp(optimizeArg, "low-quantile") == 0)
+		{
+			arguments->optimizerObjective = kOptimizerObjectiveLowQuantile;
+		}
+		else if (strcmp(optimizeArg, "high-quantile") == 0)
+		{
+			arguments->optimizerObjective = kOptimizerObjectiveHighQuantile;
+		}
+		else
+		{
+			fprintf(stderr, "Error: The optimizer objective(-O) must be one of loss, low-quantile or high-quantile.\n");
+			printUsage();
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		if (!arguments->common.isMonteCarloMode || arguments->common.isInputFromFileEnabled || (serverSocketPathArg != NULL))
+		{
+			fprintf(stderr, "Error: The optimizer(-O) needs Monte Carlo mode(-M) and a homogeneous portfolio, and is not available in server mode(-L).\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+	}
+
+	if (minimumNumberOfInvestmentsArg != NULL)
+	{
+		int	minimumNumberOfInvestments;
+		int	ret = parseIntChecked(minimumNumberOfInvestmentsArg, &minimumNumberOfInvestments);
+
+		if ((ret != kCommonConstantReturnTypeSuccess) ||
+			(minimumNumberOfInvestments < 1) || ((size_t) minimumNumberOfInvestments > arguments->numberOfInvestments))
+		{
+			fprintf(stderr, "Error: The minimum number of investments of the optimizer(-A) must be an integer in [1, number of investments(-n)].\n");
+			printUsage();
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		arguments->minimumNumberOfInvestments = (size_t) minimumNumberOfInvestments;
+	}
+
+	if ((optimizerToleranceArg != NULL) &&
+		(parseRealArgument(optimizerToleranceArg, "optimizer tolerance parameter(-E)", 0, HUGE_VAL, &arguments->optimizerTolerance) != kCommonConstantReturnTypeSuccess))
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	/*
+	 *	Check the calibration.
+	 */
+	if (multiplesPathArg != NULL)
+	{
+		if ((optimizeArg != NULL) || (serverSocketPathArg != NULL))
+		{
+			fprintf(stderr, "Error: The calibration(-K) is not available with the optimizer(-O) or in server mode(-L).\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		if (strlen(multiplesPathArg) >= sizeof(arguments->multiplesPath))
+		{
+			fprintf(stderr, "Error: The multiples path(-K) is too long.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		strcpy(arguments->multiplesPath, multiplesPathArg);
+		arguments->isCalibrationEnabled = true;
+	}
+
+	if (bootstrapResamplesArg != NULL)
+	{
+		int	numberOfBootstrapResamples;
+		int	ret = parseIntChecked(bootstrapResamplesArg, &numberOfBootstrapResamples);
+
+		if ((ret != kCommonConstantReturnTypeSuccess) ||
+			(numberOfBootstrapResamples < 0) || (numberOfBootstrapResamples > kCalibrationConstantMaximumBootstrapResamples))
+		{
+			fprintf(stderr, "Error: The number of bootstrap resamples(-D) must be an integer in [0, %d].\n", (int) kCalibrationConstantMaximumBootstrapResamples);
+			printUsage();
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		arguments->numberOfBootstrapResamples = (size_t) numberOfBootstrapResamples;
+	}
+
+	/*
+	 *	Check the parameter draws. The draws are loaded, and checked, by the model.
+	 */
+	if (parameterDrawsPathArg != NULL)
+	{
+		if (!arguments->common.isMonteCarloMode || arguments->common.isInputFromFileEnabled ||
+			(multiplesPathArg != NULL) || (serverSocketPathArg != NULL))
+		{
+			fprintf(
+				stderr,
+				"Error: The parameter draws(-I) need Monte Carlo mode(-M) and a homogeneous portfolio, "
+				"and are not available in calibration(-K) or server mode(-L).\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		if (strlen(parameterDrawsPathArg) >= sizeof(arguments->parameterDrawsPath))
+		{
+			fprintf(stderr, "Error: The parameter draws path(-I) is too long.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		strcpy(arguments->parameterDrawsPath, parameterDrawsPathArg);
+		arguments->isParameterDrawsEnabled = true;
+	}
+
+	if (iterationsPerParameterDrawArg != NULL)
+	{
+		int	iterationsPerParameterDraw;
+		int	ret = parseIntChecked(iterationsPerParameterDrawArg, &iterationsPerParameterDraw);
+
+		if ((ret != kCommonConstantReturnTypeSuccess) || (iterationsPerParameterDraw < 1))
+		{
+			fprintf(stderr, "Error: The number of iterations per parameter draw(-J) must be an integer of at least 1.\n");
+			printUsage();
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		arguments->iterationsPerParameterDraw = (size_t) iterationsPerParameterDraw;
+	}
+
+	/*
+	 *	Check the quantile sketch. The sketch replaces the samples, so the
+	 *	outputs that need all samples are not available with it.
+	 */
+	if (sketchPathArg != NULL)
+	{
+		if (!arguments->common.isMonteCarloMode || arguments->common.isBenchmarkingMode || arguments->common.isOutputJSONMode ||
+			(arguments->fundLifeYears > 0) || (arguments->waterfall != kMoonfireWaterfallNone) || (arguments->numberOfReserveStrategies > 0) ||
+			(optimizeArg != NULL) || (multiplesPathArg != NULL) || (serverSocketPathArg != NULL))
+		{
+			fprintf(
+				stderr,
+				"Error: The quantile sketch(-Z) needs Monte Carlo mode(-M), and is not available with benchmarking(-b), JSON output(-j), "
+				"the fund timeline(-y), the waterfall(-w), reserve strategies(-V), the optimizer(-O), calibration(-K) or server mode(-L).\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		if (strlen(sketchPathArg) >= sizeof(arguments->sketchPath))
+		{
+			fprintf(stderr, "Error: The sketch path(-Z) is too long.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		strcpy(arguments->sketchPath, sketchPathArg);
+		arguments->isSketchEnabled = true;
+	}
+
+	/*
+	 *	Check the precision. Reduced precision only samples independent
+	 *	investments of a homogeneous portfolio into the portfolio return.
+	 */
+	if ((arguments->precision != kMoonfirePrecisionDouble) &&
+		(!arguments->common.isMonteCarloMode || arguments->common.isInputFromFileEnabled || (arguments->copula != kMoonfireCopulaIndependent) ||
+		(arguments->fundLifeYears > 0) || (arguments->waterfall != kMoonfireWaterfallNone) || (arguments->numberOfReserveStrategies > 0) ||
+		(optimizeArg != NULL) || (serverSocketPathArg != NULL)))
+	{
+		fprintf(
+			stderr,
+			"Error: Reduced precision(--precision mixed or float) needs Monte Carlo mode(-M), and is not available with a portfolio file(-i), "
+			"a copula(-c), the fund timeline(-y), the waterfall(-w), reserve strategies(-V), the optimizer(-O) or server mode(-L).\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	/*
+	 *	Check the sampler. The table is built in double precision for the
+	 *	parameters of a homogeneous portfolio.
+	 */
+	if ((arguments->sampler == kMoonfireSamplerTable) &&
+		(!arguments->common.isMonteCarloMode || arguments->common.isInputFromFileEnabled || (arguments->copula != kMoonfireCopulaIndependent) ||
+		(arguments->precision != kMoonfirePrecisionDouble)))
+	{
+		fprintf(
+			stderr,
+			"Error: The table sampler(--sampler table) needs Monte Carlo mode(-M), and is not available with a portfolio file(-i), a copula(-c) "
+			"or reduced precision(--precision).\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	/*
+	 *	Check the outcomes. The buckets replace the bounded Pareto distribution
+	 *	of independent investments with fixed parameters.
+	 */
+	if ((outcomesPathArg != NULL) &&
+		((arguments->copula != kMoonfireCopulaIndependent) || (arguments->precision != kMoonfirePrecisionDouble) ||
+		(arguments->sampler != kMoonfireSamplerInverseCdf) || (multiplesPathArg != NULL) || (parameterDrawsPathArg != NULL) ||
+		(serverSocketPathArg != NULL)))
+	{
+		fprintf(
+			stderr,
+			"Error: The outcomes file(--outcomes) is not available with a copula(-c), reduced precision(--precision), the table sampler(--sampler), "
+			"calibration(-K), parameter uncertainty(-I) or server mode(-L).\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if (outcomesPathArg != NULL)
+	{
+		if (strlen(outcomesPathArg) >= sizeof(arguments->outcomesPath))
+		{
+			fprintf(stderr, "Error: The outcomes path(--outcomes) is too long.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		strcpy(arguments->outcomesPath, outcomesPathArg);
+		arguments->isOutcomesEnabled = true;
+	}
+
+	/*
+	 *	Check the sweep. Its points are summarized by their statistics, so the
+	 *	modes that write or need the samples of one simulation are not
+	 *	available with it.
+	 */
+	if ((arguments->numberOfSweepSizes > 0) &&
+		(!arguments->common.isMonteCarloMode || arguments->common.isBenchmarkingMode || arguments->common.isOutputJSONMode ||
+		arguments->common.isInputFromFileEnabled || (classCorrelationMatrixArg != NULL) ||
+		(arguments->fundLifeYears > 0) || (arguments->waterfall != kMoonfireWaterfallNone) || (arguments->numberOfReserveStrategies > 0) ||
+		(optimizeArg != NULL) || (multiplesPathArg != NULL) || (parameterDrawsPathArg != NULL) || (sketchPathArg != NULL) || (shardArg != NULL) ||
+		(serverSocketPathArg != NULL) || (coordinatorArg != NULL) || (clusterAddressArg != NULL)))
+	{
+		fprintf(
+			stderr,
+			"Error: A sweep over several portfolio sizes(-n) needs Monte Carlo mode(-M), and is not available with benchmarking(-b), JSON output(-j), "
+			"a portfolio file(-i), a class correlation matrix(-m), the fund timeline(-y), the waterfall(-w), reserve strategies(-V), the optimizer(-O), "
+			"calibration(-K), parameter uncertainty(-I), the quantile sketch(-Z), shards(-p), server mode(-L) or cluster mode(-W, -l).\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	/*
+	 *	Check the shard. Each shard simulates a disjoint range of the
+	 *	iterations of the random stream, so all shards must have the same
+	 *	seed and number of iterations.
+	 */
+	if (shardArg != NULL)
+	{
+		char		shardIndex[32];
+		const char *	slash = strchr(shardArg, '/');
+		uint64_t	index;
+		uint64_t	count;
+
+		if ((slash == NULL) || ((size_t) (slash - shardArg) >= sizeof(shardIndex)))
+		{
+			fprintf(stderr, "Error: The shard(-p) must be of the form k/N.\n");
+			printUsage();
+
+			return kCommonConstantReturnTypeError;
+		}
+		memcpy(shardIndex, shardArg, (size_t) (slash - shardArg));
+		shardIndex[slash - shardArg] = '\0';
+
+		if ((parseUint64Checked(shardIndex, &index) != kCommonConstantReturnTypeSuccess) ||
+			(parseUint64Checked(slash + 1, &count) != kCommonConstantReturnTypeSuccess) ||
+			(count < 1) || (index >= count))
+		{
+			fprintf(stderr, "Error: The shard(-p) must be of the form k/N, with integers N >= 1 and 0 <= k < N.\n");
+			printUsage();
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		if (!arguments->common.isMonteCarloMode || (count > arguments->common.numberOfMonteCarloIterations) ||
+			(optimizeArg != NULL) || (multiplesPathArg != NULL) || (serverSocketPathArg != NULL))
+		{
+			fprintf(
+				stderr,
+				"Error: The shard(-p) needs Monte Carlo mode(-M) with at least N iterations, "
+				"and is not available with the optimizer(-O), calibration(-K) or server mode(-L).\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		arguments->shardIndex = (size_t) index;
+		arguments->numberOfShards = (size_t) count;
+	}
+
+	/*
+	 *	Typecheck numberOfThreads. Defaults to the number of online processors
+	 *	in native builds.
+	 */
+#if defined(MOONFIRE_NATIVE)
+	{
+		long	numberOfProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+
+		arguments->numberOfThreads = (numberOfProcessors > 0) ? (size_t) numberOfProcessors : 1;
+	}
+#endif
+	/*
+	 *	Pinned workers default to one per CPU that the process may run on.
+	 */
+	if (isThreadPinningFound)
+	{
+		arguments->isThreadPinningEnabled = true;
+		arguments->numberOfThreads = getThreadTopology()->numberOfCpus;
+	}
+
+	if (threadsArg != NULL)
+	{
+		int	numberOfThreads;
+		int	ret = parseIntChecked(threadsArg, &numberOfThreads);
+
+		if (ret != kCommonConstantReturnTypeSuccess)
+		{
+			fprintf(stderr, "Error: The number of threads parameter(-t) must be an integer number.\n");
+			printUsage();
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		if (numberOfThreads < 1)
+		{
+			fprintf(stderr, "Error: The number of threads parameter(-t) must be >= 1\n");
+			printUsage();
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		arguments->numberOfThreads = (size_t) numberOfThreads;
+	}
+
+	/*
+	 *	Check server socket path.
+	 */
+	if (serverSocketPathArg != NULL)
+	{
+#if defined(MOONFIRE_NATIVE)
+		if (strlen(serverSocketPathArg) >= sizeof(arguments->serverSocketPath))
+		{
+			fprintf(stderr, "Error: The server socket path(-L) is too long.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		strcpy(arguments->serverSocketPath, serverSocketPathArg);
+		arguments->isServerModeEnabled = true;
+#else
+		fprintf(stderr, "Error: Server mode(-L) is only supported in native builds.\n");
+
+		return kCommonConstantReturnTypeError;
+#endif
+	}
+
+	/*
+	 *	Check result cache directory.
+	 */
+	if (resultCacheDirectoryArg != NULL)
+	{
+		if (!arguments->isServerModeEnabled)
+		{
+			fprintf(stderr, "Error: The result cache(-C) is only used in server mode(-L).\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		if (strlen(resultCacheDirectoryArg) >= sizeof(arguments->resultCacheDirectory))
+		{
+			fprintf(stderr, "Error: The result cache directory(-C) is too long.\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		strcpy(arguments->resultCacheDirectory, resultCacheDirectoryArg);
+		arguments->isResultCacheEnabled = true;
+	}
+
+	/*
+	 *	Check cluster mode. The coordinator keeps all samples, as a single
+	 *	Monte Carlo run does, and its workers only return samples, so the
+	 *	outputs that need more of the simulation are not available.
+	 */
+	if ((coordinatorArg != NULL) || (clusterAddressArg != NULL))
+	{
+#if defined(MOONFIRE_NATIVE)
+		if (arguments->common.isBenchmarkingMode || arguments->common.isOutputJSONMode ||
+			(arguments->fundLifeYears > 0) || (arguments->waterfall != kMoonfireWaterfallNone) || (arguments->numberOfReserveStrategies > 0) ||
+			(optimizeArg != NULL) || (multiplesPathArg != NULL) || (sketchPathArg != NULL) || (serverSocketPathArg != NULL))
+		{
+			fprintf(
+				stderr,
+				"Error: Cluster mode(-W, -l) is not available with benchmarking(-b), JSON output(-j), the fund timeline(-y), the waterfall(-w), "
+				"reserve strategies(-V), the optimizer(-O), calibration(-K), the quantile sketch(-Z) or server mode(-L).\n");
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		if (clusterAddressArg != NULL)
+		{
+			if ((strchr(clusterAddressArg, ':') == NULL) || (strlen(clusterAddressArg) >= sizeof(arguments->clusterAddress)))
+			{
+				fprintf(stderr, "Error: The cluster address(-l) must be of the form host:port.\n");
+
+				return kCommonConstantReturnTypeError;
+			}
+
+			strcpy(arguments->clusterAddress, clusterAddressArg);
+			arguments->isClusterAddressEnabled = true;
+		}
+
+		if (coordinatorArg != NULL)
+		{
+			uint64_t	numberOfLocalWorkers;
+
+			if (parseUint64Checked(coordinatorArg, &numberOfLocalWorkers) != kCommonConstantReturnTypeSuccess)
+			{
+				fprintf(stderr, "Error: The number of local workers(-W) must be a non-negative integer.\n");
+				printUsage();
+
+				return kCommonConstantReturnTypeError;
+			}
+
+			if (!arguments->common.isMonteCarloMode || ((numberOfLocalWorkers == 0) && (clusterAddressArg == NULL)))
+			{
+				fprintf(stderr, "Error: The coordinator(-W) needs Monte Carlo mode(-M), and local workers or a cluster address(-l) for remote workers.\n");
+
+				return kCommonConstantReturnTypeError;
+			}
+
+			arguments->numberOfLocalWorkers = (size_t) numberOfLocalWorkers;
+			arguments->isCoordinatorEnabled = true;
+		}
+#else
+		fprintf(stderr, "Error: Cluster mode(-W, -l) is only supported in native builds.\n");
+
+		return kCommonConstantReturnTypeError;
+#endif
+	}
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+CommonConstantReturnType
+getMergeCommandLineArguments(int argc, char *  argv[], MergeCommandLineArguments *  arguments)
+{
+	if (arguments == NULL)
+	{
+		fprintf(stderr, "Error: The provided pointer to arguments is NULL.\n");
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	*arguments = (MergeCommandLineArguments)
+	{
+		.lowQuantileProbability		= kDefaultValuesLowQuantileProbability,
+		.highQuantileProbability	= kDefaultValuesHighQuantileProbability,
+		.isSketchEnabled		= false,
+		.inputPaths			= argv + 2,
+		.numberOfInputPaths		= 0,
+	};
+
+	/*
+	 *	Options precede the input files, which are the remaining arguments.
+	 */
+	for (int i = 2; i < argc; i++)
+	{
+		if ((strcmp(argv[i], "-q") != 0) && (strcmp(argv[i], "-Q") != 0) && (strcmp(argv[i], "-Z") != 0))
+		{
+			arguments->inputPaths = argv + i;
+			arguments->numberOfInputPaths = (size_t) (argc - i);
+
+			break;
+		}
+
+		if (i + 1 == argc)
+		{
+			fprintf(stderr, "Error: The option %s of the merge subcommand needs an argument.\n", argv[i]);
+			printUsage();
+
+			return kCommonConstantReturnTypeError;
+		}
+
+		if ((strcmp(argv[i], "-q") == 0) &&
+			(parseRealArgument(argv[i + 1], "low quantile probability parameter(-q)", 0.0, 1.0, &arguments->lowQuantileProbability) != kCommonConstantReturnTypeSuccess))
+		{
+			return kCommonConstantReturnTypeError;
+		}
+
+		if ((strcmp(argv[i], "-Q") == 0) &&
+			(parseRealArgument(argv[i + 1], "high quantile probability parameter(-Q)", 0.0, 1.0, &arguments->highQuantileProbability) != kCommonConstantReturnTypeSuccess))
+		{
+			return kCommonConstantReturnTypeError;
+		}
+
+		if (strcmp(argv[i], "-Z") == 0)
+		{
+			if (strlen(argv[i + 1]) >= sizeof(arguments->sketchPath))
+			{
+				fprintf(stderr, "Error: The sketch path(-Z) is too long.\n");
+
+				return kCommonConstantReturnTypeError;
+			}
+
+			strcpy(arguments->sketchPath, argv[i + 1]);
+			arguments->isSketchEnabled = true;
+		}
+
+		i++;
+	}
+
+	if (arguments->numberOfInputPaths == 0)
+	{
+		fprintf(stderr, "Error: The merge subcommand needs at least one sketch file or Monte Carlo output file.\n");
+		printUsage();
+
+		return kCommonConstantReturnTypeError;
+	}
+
+	if (arguments->highQuantileProbability < arguments->lowQuantileProbability)
+	{
+		fprintf(stderr, "Error: The high quantile probability parameter(-Q) cannot be smaller than the low quantile probability parameter(-q).\n");
+		printUsage();
+
+		return kCommonConstantReturnTypeError;
+	}
+
 	return kCommonConstantReturnTypeSuccess;
 }
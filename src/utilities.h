@@ -22,12 +22,24 @@
 
 #pragma once
 #include <stdbool.h>
+#include <stdint.h>
 #include "common.h"
+#include "moonfire.h"
+#include "optimizer.h"
+#include "calibration.h"
 
 
 typedef enum
 {
 	kDefaultValuesNumberOfInvestements	= 100,
+	kDefaultValuesDegreesOfFreedom		= 4,
+	kDefaultValuesDeploymentYears		= 3,
+	kDefaultValuesMinimumHoldingYears	= 3,
+	kDefaultValuesMaximumHoldingYears	= 8,
+	kDefaultValuesFollowOnDelayYears	= 2,
+	kDefaultValuesManagementFeeYears	= 10,
+	kDefaultValuesHurdleYears		= 5,
+	kDefaultValuesIterationsPerParameterDraw	= 1000,
 } DefaultValues;
 
 typedef struct
@@ -39,8 +51,76 @@ typedef struct
 	size_t				numberOfInvestments;
 	double				lowQuantileProbability;
 	double				highQuantileProbability;
+	uint64_t			seed;
+	MoonfirePrecision		precision;
+	MoonfireSampler			sampler;
+	MoonfireCopula			copula;
+	double				marketCorrelation;
+	double				classCorrelation;
+	size_t				degreesOfFreedom;
+	bool				isClassCorrelationMatrixEnabled;
+	char				classCorrelationMatrixPath[kCommonConstantMaxCharsPerFilepath];
+	size_t				fundLifeYears;
+	size_t				deploymentYears;
+	size_t				minimumHoldingYears;
+	size_t				maximumHoldingYears;
+	double				followOnFraction;
+	size_t				followOnDelayYears;
+	MoonfireWaterfall		waterfall;
+	double				managementFeeRate;
+	size_t				managementFeeYears;
+	double				carriedInterest;
+	double				hurdleRate;
+	size_t				hurdleYears;
+	double				catchUp;
+	double				reserveRatios[kMoonfireConstantMaximumReserveStrategies];
+	size_t				numberOfReserveStrategies;
+	double				followOnThreshold;
+	double				followOnStepUp;
+	double				followOnSignalNoise;
+	OptimizerObjective		optimizerObjective;
+	size_t				minimumNumberOfInvestments;
+	double				optimizerTolerance;
+	bool				isCalibrationEnabled;
+	char				multiplesPath[kCommonConstantMaxCharsPerFilepath];
+	size_t				numberOfBootstrapResamples;
+	bool				isParameterDrawsEnabled;
+	char				parameterDrawsPath[kCommonConstantMaxCharsPerFilepath];
+	size_t				iterationsPerParameterDraw;
+	bool				isOutcomesEnabled;
+	char				outcomesPath[kCommonConstantMaxCharsPerFilepath];
+	bool				isSketchEnabled;
+	char				sketchPath[kCommonConstantMaxCharsPerFilepath];
+	size_t				sweepSizes[kMoonfireConstantMaximumPortfolioSizes];
+	size_t				numberOfSweepSizes;
+	size_t				shardIndex;
+	size_t				numberOfShards;
+	size_t				numberOfThreads;
+	bool				isThreadPinningEnabled;
+	bool				isServerModeEnabled;
+	char				serverSocketPath[kCommonConstantMaxCharsPerFilepath];
+	bool				isResultCacheEnabled;
+	char				resultCacheDirectory[kCommonConstantMaxCharsPerFilepath];
+	bool				isCoordinatorEnabled;
+	size_t				numberOfLocalWorkers;
+	bool				isClusterAddressEnabled;
+	char				clusterAddress[kCommonConstantMaxCharsPerFilepath];
 } CommandLineArguments;
 
+/*
+ *	Arguments of the `merge` subcommand, which merges sketch files (`-Z`) or
+ *	Monte Carlo output files of shards (`--shard`).
+ */
+typedef struct
+{
+	double		lowQuantileProbability;
+	double		highQuantileProbability;
+	bool		isSketchEnabled;
+	char		sketchPath[kCommonConstantMaxCharsPerFilepath];
+	char **		inputPaths;
+	size_t		numberOfInputPaths;
+} MergeCommandLineArguments;
+
 /**
  *	@brief	Print out command-line usage.
  */
@@ -55,3 +135,13 @@ void	printUsage(void);
  *	@return			: `kCommonConstantSuccess` if successful, else `kCommonConstantError`.
  */
 CommonConstantReturnType	getCommandLineArguments(int argc, char *  argv[], CommandLineArguments *  arguments);
+
+/**
+ *	@brief	Get the arguments of the `merge` subcommand, `argv[1]`.
+ *
+ *	@param	argc		: Argument count from `main()`.
+ *	@param	argv		: Argument vector from `main()`.
+ *	@param	arguments	: Pointer to struct to store arguments. The input paths point into `argv`.
+ *	@return			: `kCommonConstantSuccess` if successful, else `kCommonConstantError`.
+ */
+CommonConstantReturnType	getMergeCommandLineArguments(int argc, char *  argv[], MergeCommandLineArguments *  arguments);
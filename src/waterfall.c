@@ -0,0 +1,96 @@
+/*
+ *	Copyright (c) 2024, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#include <math.h>
+#include "waterfall.h"
+
+
+WaterfallConstants
+computeWaterfallConstants(const MoonfireParameters *  parameters)
+{
+	double	hurdleMultiple = pow(1.0 + parameters->hurdleRate, (double) parameters->hurdleYears);
+	double	catchUpEndMultiple = hurdleMultiple;
+
+	/*
+	 *	The catch-up ends when the GP holds `carriedInterest` of the profits,
+	 *	i.e., when catchUp * (m - hurdleMultiple) = carriedInterest * (m - 1).
+	 */
+	if (parameters->catchUp > 0)
+	{
+		catchUpEndMultiple += parameters->carriedInterest * (hurdleMultiple - 1.0) / (parameters->catchUp - parameters->carriedInterest);
+	}
+
+	return (WaterfallConstants)
+	{
+		.investedFraction	= 1.0 - parameters->managementFeeRate * (double) parameters->managementFeeYears,
+		.carriedInterest	=
+		{
+			.hurdleMultiple		= hurdleMultiple,
+			.catchUpEndMultiple	= catchUpEndMultiple,
+			.catchUpShare		= parameters->catchUp,
+			.carryShare		= parameters->carriedInterest,
+		},
+	};
+}
+
+void
+applyEuropeanWaterfall(
+	const SamplingKernels *		kernels,
+	const WaterfallConstants *	constants,
+	const double *			portfolioReturns,
+	size_t				count,
+	double *			scratch,
+	double *			netMultiples)
+{
+	for (size_t j = 0; j < count; j++)
+	{
+		scratch[j] = portfolioReturns[j] * constants->investedFraction;
+	}
+
+	kernels->carriedInterest(scratch, count, &constants->carriedInterest);
+
+	for (size_t j = 0; j < count; j++)
+	{
+		netMultiples[j] = portfolioReturns[j] * constants->investedFraction - scratch[j];
+	}
+
+	return;
+}
+
+double
+applyAmericanWaterfall(
+	const SamplingKernels *		kernels,
+	const WaterfallConstants *	constants,
+	double *			multiples,
+	const double *			capital,
+	size_t				count,
+	double				portfolioReturn)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		multiples[i] *= constants->investedFraction;
+	}
+
+	kernels->carriedInterest(multiples, count, &constants->carriedInterest);
+
+	return portfolioReturn * constants->investedFraction - kernels->dot(multiples, capital, count);
+}
@@ -0,0 +1,90 @@
+/*
+ *	Copyright (c) 2024, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#pragma once
+#include <stddef.h>
+#include "kernels.h"
+#include "moonfire.h"
+
+
+/*
+ *	Fee and carried-interest waterfall (see `MoonfireWaterfall`).
+ *
+ *	The carried interest is homogeneous in the proceeds and the paid-in
+ *	capital, so the waterfall is evaluated on multiples of paid-in capital, and
+ *	the same `carriedInterest` kernel applies to the fund as a whole and to
+ *	each investment.
+ */
+
+typedef struct
+{
+	/*
+	 *	Fraction of the commitment that is invested, after management fees.
+	 */
+	double				investedFraction;
+	CarriedInterestConstants	carriedInterest;
+} WaterfallConstants;
+
+/**
+ *	@brief	Compute the waterfall constants of the model parameters.
+ *
+ *	@param	parameters	: The model parameters, with a waterfall.
+ *	@return			: The waterfall constants.
+ */
+WaterfallConstants	computeWaterfallConstants(const MoonfireParameters *  parameters);
+
+/**
+ *	@brief	Apply the whole-fund waterfall to the portfolio returns of all iterations.
+ *
+ *	@param	kernels			: The sampling kernels.
+ *	@param	constants		: The waterfall constants.
+ *	@param	portfolioReturns	: The `count` portfolio returns, in multiples of the invested capital.
+ *	@param	count			: Number of iterations.
+ *	@param	scratch			: Scratch array of `count` elements.
+ *	@param	netMultiples		: Array to store the `count` net multiples of the LPs.
+ */
+void			applyEuropeanWaterfall(
+				const SamplingKernels *		kernels,
+				const WaterfallConstants *	constants,
+				const double *			portfolioReturns,
+				size_t				count,
+				double *			scratch,
+				double *			netMultiples);
+
+/**
+ *	@brief	Apply the deal-by-deal waterfall to the investments of one iteration.
+ *
+ *	@param	kernels			: The sampling kernels.
+ *	@param	constants		: The waterfall constants.
+ *	@param	multiples		: The `count` investment returns, in multiples of the capital invested in each investment. Overwritten.
+ *	@param	capital			: The share of each investment in the commitment.
+ *	@param	count			: Number of investments.
+ *	@param	portfolioReturn		: The portfolio return of the iteration, in multiples of the invested capital.
+ *	@return				: The net multiple of the LPs.
+ */
+double			applyAmericanWaterfall(
+				const SamplingKernels *		kernels,
+				const WaterfallConstants *	constants,
+				double *			multiples,
+				const double *			capital,
+				size_t				count,
+				double				portfolioReturn);